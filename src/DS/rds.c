@@ -33,6 +33,7 @@
 #include "common/util.h"
 #include "common/list.h"
 #include "common/debug_priv.h"
+#include "common/xml_stream.h"
 
 #include "ds_common.h"
 #include "ds_rds_session.h"
@@ -216,13 +217,15 @@ xmlNodePtr ds_rds_create_report(xmlDocPtr target_doc, xmlNodePtr reports_node, x
 	xmlNodePtr report_content = xmlNewNode(arf_ns, BAD_CAST "content");
 	xmlAddChild(report, report_content);
 
-	xmlDOMWrapCtxtPtr wrap_ctxt = xmlDOMWrapNewCtxt();
-	xmlNodePtr res_node = NULL;
-	xmlDOMWrapCloneNode(wrap_ctxt, source_doc, xmlDocGetRootElement(source_doc),
-			&res_node, target_doc, NULL, 1, 0);
-	xmlAddChild(report_content, res_node);
-	xmlDOMWrapReconcileNamespaces(wrap_ctxt, res_node, 0);
-	xmlDOMWrapFreeCtxt(wrap_ctxt);
+	if (source_doc != NULL) {
+		xmlDOMWrapCtxtPtr wrap_ctxt = xmlDOMWrapNewCtxt();
+		xmlNodePtr res_node = NULL;
+		xmlDOMWrapCloneNode(wrap_ctxt, source_doc, xmlDocGetRootElement(source_doc),
+				&res_node, target_doc, NULL, 1, 0);
+		xmlAddChild(report_content, res_node);
+		xmlDOMWrapReconcileNamespaces(wrap_ctxt, res_node, 0);
+		xmlDOMWrapFreeCtxt(wrap_ctxt);
+	}
 
 	xmlAddChild(reports_node, report);
 
@@ -693,7 +696,16 @@ static void ds_rds_add_xccdf_test_results(xmlDocPtr doc, xmlNodePtr reports,
 	}
 }
 
-static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping, struct oscap_htable *arf_report_mapping)
+/*
+ * Content of an OVAL report which is streamed into the ARF instead of being
+ * copied into its DOM.
+ */
+struct ds_rds_report_stub {
+	xmlNodePtr content;
+	const char *report_file;
+};
+
+static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr xccdf_result_file_doc, struct oscap_htable* oval_result_sources, struct oscap_htable* oval_result_mapping, struct oscap_htable *arf_report_mapping, struct oscap_list *report_stubs)
 {
 	*ret = NULL;
 
@@ -745,6 +757,14 @@ static int ds_rds_create_from_dom(xmlDocPtr* ret, xmlDocPtr sds_doc, xmlDocPtr x
 		const char *oval_filename = report_mapping_item->key;
 		const char *report_id = report_mapping_item->value;
 		const char *report_file = oscap_htable_get(oval_result_mapping, oval_filename);
+		if (report_stubs != NULL) {
+			xmlNodePtr report = ds_rds_create_report(doc, reports, NULL, report_id);
+			struct ds_rds_report_stub *stub = malloc(sizeof(struct ds_rds_report_stub));
+			stub->content = report->children;
+			stub->report_file = report_file;
+			oscap_list_add(report_stubs, stub);
+			continue;
+		}
 		struct oscap_source *oval_source = oscap_htable_get(oval_result_sources, report_file);
 		xmlDoc *oval_result_doc = oscap_source_get_xmlDoc(oval_source);
 
@@ -771,12 +791,84 @@ struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struc
 
 	xmlDocPtr rds_doc = NULL;
 	if (ds_rds_create_from_dom(&rds_doc, sds_doc, result_file_doc,
-				oval_result_sources, oval_result_mapping, arf_report_mapping) != 0) {
+				oval_result_sources, oval_result_mapping, arf_report_mapping, NULL) != 0) {
 		return NULL;
 	}
 	return oscap_source_new_from_xmlDoc(rds_doc, target_file);
 }
 
+static struct ds_rds_report_stub *ds_rds_find_stub(struct oscap_list *report_stubs, xmlNodePtr node, bool descendants)
+{
+	struct ds_rds_report_stub *found = NULL;
+	struct oscap_iterator *it = oscap_iterator_new(report_stubs);
+	while (found == NULL && oscap_iterator_has_more(it)) {
+		struct ds_rds_report_stub *stub = oscap_iterator_next(it);
+		for (xmlNodePtr cur = stub->content; cur != NULL; cur = descendants ? cur->parent : NULL) {
+			if (cur == node) {
+				found = stub;
+				break;
+			}
+		}
+	}
+	oscap_iterator_free(it);
+	return found;
+}
+
+/*
+ * Write the ARF element by element. Only the elements containing report stubs
+ * are descended into, the reports are written by the writer in place of the
+ * stubs.
+ */
+static int ds_rds_stream_node(struct oscap_xml_stream *stream, xmlNodePtr node, struct oscap_list *report_stubs, ds_rds_report_writer writer, void *arg)
+{
+	int ret = 0;
+	oscap_xml_stream_open(stream, node);
+
+	struct ds_rds_report_stub *stub = ds_rds_find_stub(report_stubs, node, false);
+	if (stub != NULL) {
+		ret = writer(stream, stub->report_file, arg);
+	} else {
+		for (xmlNodePtr child = node->children; child != NULL && ret == 0; child = child->next) {
+			if (ds_rds_find_stub(report_stubs, child, true) != NULL)
+				ret = ds_rds_stream_node(stream, child, report_stubs, writer, arg);
+		}
+	}
+
+	oscap_xml_stream_close(stream);
+	return ret;
+}
+
+int ds_rds_export_stream(struct oscap_source *sds_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_mapping, struct oscap_htable *arf_report_mapping, ds_rds_report_writer writer, void *arg, const char *target_file)
+{
+	xmlDoc *sds_doc = oscap_source_get_xmlDoc(sds_source);
+	if (sds_doc == NULL) {
+		return -1;
+	}
+	xmlDoc *result_file_doc = oscap_source_get_xmlDoc(xccdf_result_source);
+	if (result_file_doc == NULL) {
+		return -1;
+	}
+
+	xmlDocPtr rds_doc = NULL;
+	struct oscap_list *report_stubs = oscap_list_new();
+	if (ds_rds_create_from_dom(&rds_doc, sds_doc, result_file_doc,
+				NULL, oval_result_mapping, arf_report_mapping, report_stubs) != 0) {
+		oscap_list_free(report_stubs, free);
+		return -1;
+	}
+
+	int ret = -1;
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(target_file);
+	if (stream != NULL) {
+		ret = ds_rds_stream_node(stream, xmlDocGetRootElement(rds_doc), report_stubs, writer, arg);
+		if (oscap_xml_stream_free(stream) != 0)
+			ret = -1;
+	}
+	oscap_list_free(report_stubs, free);
+	xmlFreeDoc(rds_doc);
+	return ret;
+}
+
 int ds_rds_create(const char* sds_file, const char* xccdf_result_file, const char** oval_result_files, const char* target_file)
 {
 	struct oscap_source *sds_source = oscap_source_new_from_file(sds_file);
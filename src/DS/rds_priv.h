@@ -29,6 +29,7 @@
 
 #include "common/public/oscap.h"
 #include "common/util.h"
+#include "common/xml_stream.h"
 #include "ds_rds_session.h"
 #include "source/public/oscap_source.h"
 
@@ -38,6 +39,21 @@ xmlNode *ds_rds_lookup_container(xmlDocPtr doc, const char *container_name);
 xmlNode *ds_rds_lookup_component(xmlDocPtr doc, const char *container_name, const char *component_name, const char *id);
 int ds_rds_dump_arf_content(struct ds_rds_session *session, const char *container_name, const char *component_name, const char *content_id);
 struct oscap_source *ds_rds_create_source(struct oscap_source *sds_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_sources, struct oscap_htable *oval_result_mapping, struct oscap_htable *arf_report_mapping, const char *target_file);
+
+/**
+ * Write the content of an OVAL report into the stream.
+ * @param report_file name of the OVAL results file the report stands for
+ * @returns 0 on success
+ */
+typedef int (*ds_rds_report_writer)(struct oscap_xml_stream *stream, const char *report_file, void *arg);
+
+/**
+ * Write the ARF to target_file without building the DOM of OVAL reports.
+ * The reports are written by the writer; the result is the same as that of
+ * saving the ARF returned by ds_rds_create_source().
+ * @returns 0 on success, -1 otherwise
+ */
+int ds_rds_export_stream(struct oscap_source *sds_source, struct oscap_source *xccdf_result_source, struct oscap_htable *oval_result_mapping, struct oscap_htable *arf_report_mapping, ds_rds_report_writer writer, void *arg, const char *target_file);
 xmlNodePtr ds_rds_create_report(xmlDocPtr target_doc, xmlNodePtr reports_node, xmlDocPtr source_doc, const char* report_id);
 
 OSCAP_HIDDEN_END;
@@ -42,30 +42,61 @@
 /* Variable definitions
  * */
 
-typedef struct _oval_collection_item_frame {
-	struct _oval_collection_item_frame *next;
-	void *item;
-} _oval_collection_item_frame_t;
+#define OVAL_COLLECTION_INITIAL_SIZE 4
 
+/*
+ * Items are kept in a contiguous array in the order they were added.
+ * The array is allocated on the first addition and doubled when full.
+ */
 typedef struct oval_collection {
-	struct _oval_collection_item_frame *item_collection_frame;
+	void **items;
+	size_t count;
+	size_t size;
 } oval_collection_t;
 
+/*
+ * An iterator is a cursor into the iterated collection; creating it does
+ * not copy the items. The collection must outlive the iterator. Items
+ * added to the collection after the iterator was created are not visited.
+ *
+ * Items added by oval_collection_iterator_add() are kept in the iterator's
+ * own stack and returned before the items of the collection, the last
+ * added first.
+ */
 typedef struct oval_iterator {
-	struct _oval_collection_item_frame *item_iterator_frame;
+	struct oval_collection *collection;
+	size_t cursor;
+	size_t end;
+	struct oval_collection stack;
 } oval_iterator_t;
 
 /* End of variable definitions
  * */
 /***************************************************************************/
 
+static inline bool _oval_collection_push(struct oval_collection *collection, void *item)
+{
+	if (collection->count == collection->size) {
+		size_t size = collection->size ? 2 * collection->size : OVAL_COLLECTION_INITIAL_SIZE;
+		void **items = realloc(collection->items, size * sizeof(void *));
+		if (items == NULL)
+			return false;
+		collection->items = items;
+		collection->size = size;
+	}
+	collection->items[collection->count++] = item;
+	return true;
+}
+
 struct oval_collection *oval_collection_new()
 {
 	struct oval_collection *collection = (struct oval_collection *)malloc(sizeof(oval_collection_t));
 	if (collection == NULL)
 		return NULL;
 
-	collection->item_collection_frame = NULL;
+	collection->items = NULL;
+	collection->count = 0;
+	collection->size = 0;
 	return collection;
 }
 
@@ -77,19 +108,14 @@ void oval_collection_free(struct oval_collection *collection)
 void oval_collection_free_items(struct oval_collection *collection, oscap_destruct_func free_func)
 {
 	if (collection) {
-		struct _oval_collection_item_frame *frame = collection->item_collection_frame;
-		while (frame != NULL) {
-			if (free_func != NULL) {
-				void *item = frame->item;
+		if (free_func != NULL) {
+			for (size_t i = 0; i < collection->count; i++) {
+				void *item = collection->items[i];
 				if (item)
 					(*free_func) (item);
-				frame->item = NULL;
 			}
-			struct _oval_collection_item_frame *temp = frame;
-			frame = frame->next;
-			temp->next = NULL;
-			free(temp);
 		}
+		free(collection->items);
 		free(collection);
 	}
 }
@@ -97,42 +123,34 @@ void oval_collection_free_items(struct oval_collection *collection, oscap_destru
 int oval_collection_is_empty(struct oval_collection *collection)
 {
 	__attribute__nonnull__(collection);
-	return collection->item_collection_frame == NULL;
+	return collection->count == 0;
 }
 
-void oval_collection_add(struct oval_collection *collection, void *item)
+void **oval_collection_items(struct oval_collection *collection, size_t *count)
 {
 	__attribute__nonnull__(collection);
 
-	struct _oval_collection_item_frame *next = malloc(sizeof(_oval_collection_item_frame_t));
-	if (next == NULL)
-		return;
+	*count = collection->count;
+	return collection->items;
+}
 
-	next->next = collection->item_collection_frame;
-	collection->item_collection_frame = next;
-	next->item = item;
+void oval_collection_add(struct oval_collection *collection, void *item)
+{
+	__attribute__nonnull__(collection);
+
+	_oval_collection_push(collection, item);
 }
 
 struct oval_iterator *oval_collection_iterator(struct oval_collection *collection)
 {
 	__attribute__nonnull__(collection);
 
-	struct oval_iterator *iterator = (struct oval_iterator *)malloc(sizeof(oval_iterator_t));
+	struct oval_iterator *iterator = oval_collection_iterator_new();
 	if (iterator == NULL)
 		return NULL;
 
-	iterator->item_iterator_frame = NULL;
-	struct _oval_collection_item_frame *collection_frame = collection->item_collection_frame;
-
-	while (collection_frame != NULL) {
-		struct _oval_collection_item_frame *iterator_frame =
-		    (struct _oval_collection_item_frame *)malloc(sizeof(_oval_collection_item_frame_t));
-
-		iterator_frame->next = iterator->item_iterator_frame;
-		iterator_frame->item = collection_frame->item;
-		iterator->item_iterator_frame = iterator_frame;
-		collection_frame = collection_frame->next;
-	}
+	iterator->collection = collection;
+	iterator->end = collection->count;
 	return iterator;
 }
 
@@ -140,79 +158,46 @@ bool oval_collection_iterator_has_more(struct oval_iterator * iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	return iterator->item_iterator_frame != NULL;
+	return iterator->stack.count > 0 || iterator->cursor < iterator->end;
 }
 
 int oval_collection_iterator_remaining(struct oval_iterator *iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	int remaining;
-	struct _oval_collection_item_frame *next = iterator->item_iterator_frame;
-
-	for (remaining = 0; next; remaining++)
-		next = next->next;
-
-	return remaining;
+	return iterator->stack.count + (iterator->end - iterator->cursor);
 }
 
 void *oval_collection_iterator_next(struct oval_iterator *iterator)
 {
 	__attribute__nonnull__(iterator);
 
-	struct _oval_collection_item_frame *oc_next = iterator->item_iterator_frame;
-	void *next;
-
-	if (oc_next == NULL) {
-		next = NULL;
-	} else {
-		next = oc_next->item;
-		iterator->item_iterator_frame = oc_next->next;
-		oc_next->item = NULL;
-		oc_next->next = NULL;
-		free(oc_next);
-	}
-	return next;
+	if (iterator->stack.count > 0)
+		return iterator->stack.items[--iterator->stack.count];
+	if (iterator->cursor < iterator->end)
+		return iterator->collection->items[iterator->cursor++];
+	return NULL;
 }
 
 void oval_collection_iterator_free(struct oval_iterator *iterator)
 {
 	if (iterator) {		//NOOP if iterator is NULL
-		while (iterator->item_iterator_frame) {
-			struct _oval_collection_item_frame *oc_this;
-			oc_this = iterator->item_iterator_frame;
-			iterator->item_iterator_frame = oc_this->next;
-			oc_this->item = NULL;
-			oc_this->next = NULL;
-			free(oc_this);
-		}
-		iterator->item_iterator_frame = NULL;
+		free(iterator->stack.items);
 		free(iterator);
 	}
 }
 
 struct oval_iterator *oval_collection_iterator_new()
 {
-	struct oval_iterator *iterator = (struct oval_iterator *)malloc(sizeof(oval_iterator_t));
-	if (iterator == NULL)
-		return NULL;
-
-	iterator->item_iterator_frame = NULL;
-	return iterator;
+	return (struct oval_iterator *)calloc(1, sizeof(oval_iterator_t));
 }
 
 void oval_collection_iterator_add(struct oval_iterator *iterator, void *item)
 {
 	__attribute__nonnull__(iterator);
 
-	struct _oval_collection_item_frame *newframe =
-	    (struct _oval_collection_item_frame *)malloc(sizeof(_oval_collection_item_frame_t));
-	if (newframe == NULL)	/* We don't have any information that error occured ! */
-		return;
-
-	newframe->next = iterator->item_iterator_frame;
-	newframe->item = item;
-	iterator->item_iterator_frame = newframe;
+	/* We don't have any information that error occured ! */
+	_oval_collection_push(&iterator->stack, item);
 }
 
 bool oval_string_iterator_has_more(struct oval_string_iterator * iterator)
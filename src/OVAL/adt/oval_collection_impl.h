@@ -41,6 +41,8 @@ void oval_collection_free(struct oval_collection *);
 void oval_collection_free_items(struct oval_collection *, oscap_destruct_func);
 int oval_collection_is_empty(struct oval_collection *collection);
 void oval_collection_add(struct oval_collection *, void *);
+/* the items in the order they were added, valid until an item is added */
+void **oval_collection_items(struct oval_collection *, size_t *count);
 struct oval_iterator *oval_collection_iterator(struct oval_collection *);
 struct oval_iterator *oval_collection_iterator_new(void);
 void oval_collection_iterator_add(struct oval_iterator *, void *);
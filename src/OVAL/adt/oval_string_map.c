@@ -191,7 +191,7 @@ void oval_string_map_free_string(struct oval_string_map *map)
 {
 	oval_string_map_free(map, free);
 }
-#else
+#elif defined(OVAL_STRINGMAP_RBT)
 # include <rbt/rbt.h>
 # include <assume.h>
 
@@ -330,4 +330,274 @@ struct oval_collection *oval_string_map_collect_values(struct oval_string_map *m
 	return (collection);
 }
 
-#endif /* OVAL_STRINGMAP_LINEAR */
+#else
+# include <stdint.h>
+# include <pthread.h>
+# include <assume.h>
+# include "../probes/SEAP/MurmurHash3.h"
+
+/*
+ * Open addressing hash table with linear probing. The hash of every key
+ * is kept in its slot so that the keys, which often share long prefixes
+ * (oval:org.example:def:...), are compared only when the hashes match
+ * and the table can be grown without hashing the keys again.
+ *
+ * Lookups don't modify the map, so they may run from several threads
+ * concurrently as long as nothing is being added.
+ *
+ * The keys and values are walked in the order of the keys, as they used
+ * to be when the map was a binary tree; the order is visible in the
+ * exported documents. The sorted view is built by the first walk after
+ * the map was changed and reused by the following ones.
+ */
+#define OVAL_STRING_MAP_INITIAL_SIZE 16 /* must be a power of 2 */
+
+struct oval_string_map_slot {
+	uint32_t hash;
+	char *key; /* NULL if the slot is free */
+	void *val;
+};
+
+struct oval_string_map {
+	struct oval_string_map_slot *slots;
+	size_t size;  /* number of slots, 0 or a power of 2 */
+	size_t count; /* number of used slots */
+
+	pthread_mutex_t sorted_lock;
+	struct oval_string_map_slot **sorted; /* used slots sorted by key, NULL if not built */
+};
+
+static inline uint32_t _oval_string_map_hash(const char *key)
+{
+	uint32_t hash;
+
+	MurmurHash3_x86_32(key, (int)strlen(key), 0, &hash);
+	return hash;
+}
+
+/* Returns the slot of the key, or the free slot where the key belongs */
+static struct oval_string_map_slot *_oval_string_map_lookup(struct oval_string_map *map, const char *key, uint32_t hash)
+{
+	size_t mask = map->size - 1;
+	size_t i = hash & mask;
+
+	for (;;) {
+		struct oval_string_map_slot *slot = map->slots + i;
+
+		if (slot->key == NULL ||
+		    (slot->hash == hash && strcmp(slot->key, key) == 0))
+			return slot;
+		i = (i + 1) & mask;
+	}
+}
+
+static int _oval_string_map_grow(struct oval_string_map *map)
+{
+	size_t size = map->size ? map->size * 2 : OVAL_STRING_MAP_INITIAL_SIZE;
+	struct oval_string_map_slot *slots = calloc(size, sizeof(struct oval_string_map_slot));
+
+	if (slots == NULL)
+		return -1;
+
+	for (size_t i = 0; i < map->size; ++i) {
+		struct oval_string_map_slot *slot = map->slots + i;
+
+		if (slot->key != NULL) {
+			size_t j = slot->hash & (size - 1);
+
+			while (slots[j].key != NULL)
+				j = (j + 1) & (size - 1);
+			slots[j] = *slot;
+		}
+	}
+
+	free(map->slots);
+	map->slots = slots;
+	map->size = size;
+	return 0;
+}
+
+/* Returns the new slot of the key, or NULL if the key is already in the map */
+static struct oval_string_map_slot *_oval_string_map_insert(struct oval_string_map *map, const char *key)
+{
+	/* keep the load factor below 3/4 */
+	if (4 * (map->count + 1) > 3 * map->size && _oval_string_map_grow(map) != 0)
+		return NULL;
+
+	uint32_t hash = _oval_string_map_hash(key);
+	struct oval_string_map_slot *slot = _oval_string_map_lookup(map, key, hash);
+
+	if (slot->key != NULL) {
+		dD("Key '%s' is already in the map", key);
+		return NULL;
+	}
+
+	slot->hash = hash;
+	slot->key = strdup(key);
+	++map->count;
+
+	free(map->sorted);
+	map->sorted = NULL;
+
+	return slot;
+}
+
+struct oval_string_map *oval_string_map_new(void)
+{
+	struct oval_string_map *map = calloc(1, sizeof(struct oval_string_map));
+
+	if (map != NULL)
+		pthread_mutex_init(&map->sorted_lock, NULL);
+
+	return map;
+}
+
+void oval_string_map_put(struct oval_string_map *map, const char *key, void *val)
+{
+	struct oval_string_map_slot *slot;
+
+	assume_d(map != NULL, /* void */);
+	assume_d(key != NULL, /* void */);
+
+	if ((slot = _oval_string_map_insert(map, key)) != NULL)
+		slot->val = val;
+}
+
+void oval_string_map_put_string(struct oval_string_map *map, const char *key, const char *val)
+{
+	struct oval_string_map_slot *slot;
+
+	assume_d(map != NULL, /* void */);
+	assume_d(key != NULL, /* void */);
+
+	if ((slot = _oval_string_map_insert(map, key)) != NULL)
+		slot->val = strdup(val);
+}
+
+void *oval_string_map_get_value(struct oval_string_map *map, const char *key)
+{
+	assume_d(map != NULL, NULL);
+	assume_d(key != NULL, NULL);
+
+	if (map->count == 0)
+		return NULL;
+
+	struct oval_string_map_slot *slot = _oval_string_map_lookup(map, key, _oval_string_map_hash(key));
+
+	return slot->key != NULL ? slot->val : NULL;
+}
+
+void oval_string_map_free(struct oval_string_map *map, oscap_destruct_func destroy)
+{
+	assume_d(map != NULL, /* void */);
+
+	for (size_t i = 0; i < map->size; ++i) {
+		struct oval_string_map_slot *slot = map->slots + i;
+
+		if (slot->key != NULL) {
+			if (destroy != NULL)
+				destroy(slot->val);
+			free(slot->key);
+		}
+	}
+
+	free(map->slots);
+	free(map->sorted);
+	pthread_mutex_destroy(&map->sorted_lock);
+	free(map);
+}
+
+void oval_string_map_free0(struct oval_string_map *map)
+{
+	oval_string_map_free(map, NULL);
+}
+
+void oval_string_map_free_string(struct oval_string_map *map)
+{
+	assume_d(map != NULL, /* void */);
+	oval_string_map_free(map, free);
+}
+
+static int _oval_string_map_slot_cmp(const void *a, const void *b)
+{
+	return strcmp((*(struct oval_string_map_slot **)a)->key, (*(struct oval_string_map_slot **)b)->key);
+}
+
+/* Returns the used slots sorted by key, NULL if the map is empty */
+static struct oval_string_map_slot **_oval_string_map_sorted(struct oval_string_map *map)
+{
+	struct oval_string_map_slot **sorted;
+
+	if (map->count == 0)
+		return NULL;
+
+	pthread_mutex_lock(&map->sorted_lock);
+
+	if ((sorted = map->sorted) == NULL &&
+	    (sorted = malloc(map->count * sizeof(struct oval_string_map_slot *))) != NULL)
+	{
+		for (size_t i = 0, n = 0; i < map->size; ++i) {
+			if (map->slots[i].key != NULL)
+				sorted[n++] = map->slots + i;
+		}
+		qsort(sorted, map->count, sizeof(struct oval_string_map_slot *), _oval_string_map_slot_cmp);
+		map->sorted = sorted;
+	}
+
+	pthread_mutex_unlock(&map->sorted_lock);
+
+	return sorted;
+}
+
+struct oval_iterator *oval_string_map_keys(struct oval_string_map *map)
+{
+	struct oval_iterator *it;
+	struct oval_string_map_slot **sorted;
+
+	assume_d(map != NULL, NULL);
+
+	it = oval_collection_iterator_new();
+	if ((sorted = _oval_string_map_sorted(map)) == NULL)
+		return (it);
+
+	for (size_t i = 0; i < map->count; ++i)
+		oval_collection_iterator_add(it, (void *)sorted[i]->key);
+
+	return (it);
+}
+
+struct oval_iterator *oval_string_map_values(struct oval_string_map *map)
+{
+	struct oval_iterator *it;
+	struct oval_string_map_slot **sorted;
+
+	assume_d(map != NULL, NULL);
+
+	it = oval_collection_iterator_new();
+	if ((sorted = _oval_string_map_sorted(map)) == NULL)
+		return (it);
+
+	for (size_t i = 0; i < map->count; ++i)
+		oval_collection_iterator_add(it, sorted[i]->val);
+
+	return (it);
+}
+
+struct oval_collection *oval_string_map_collect_values(struct oval_string_map *map, struct oval_collection *collection)
+{
+	struct oval_string_map_slot **sorted;
+
+	assume_d(map != NULL, NULL);
+
+	if (collection == NULL)
+		collection = oval_collection_new();
+	if ((sorted = _oval_string_map_sorted(map)) == NULL)
+		return (collection);
+
+	for (size_t i = 0; i < map->count; ++i)
+		oval_collection_add(collection, sorted[i]->val);
+
+	return (collection);
+}
+
+#endif /* OVAL_STRINGMAP_OLD */
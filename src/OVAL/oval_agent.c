@@ -60,6 +60,7 @@ struct oval_agent_session {
 	struct oval_syschar_model    * sys_models[2];
 	struct oval_results_model    * res_model;
 	oval_probe_session_t  * psess;
+	unsigned int eval_threads;
 };
 
 
@@ -125,6 +126,7 @@ oval_agent_session_t * oval_agent_new_session(struct oval_definition_model *mode
 
 
 	ag_sess->product_name = NULL;
+	ag_sess->eval_threads = 1;
 
 	return ag_sess;
 }
@@ -146,6 +148,63 @@ void oval_agent_set_product_name(oval_agent_session_t *ag_sess, char * product_n
 	oval_generator_set_product_name(generator, product_name);
 }
 
+void oval_agent_set_eval_threads(oval_agent_session_t *ag_sess, unsigned int threads)
+{
+	__attribute__nonnull__(ag_sess);
+
+	ag_sess->eval_threads = threads > 0 ? threads : 1;
+}
+
+int oval_agent_set_object_cache(oval_agent_session_t *ag_sess, const char *dir)
+{
+	__attribute__nonnull__(ag_sess);
+
+	return oval_probe_session_set_cache(ag_sess->psess, dir);
+}
+
+int oval_agent_prefetch_definitions(oval_agent_session_t *ag_sess, struct oscap_stringlist *ids)
+{
+	struct oval_definition **defs = NULL;
+	size_t count = 0, size = 0;
+	int ret;
+
+	__attribute__nonnull__(ag_sess);
+
+	if (ag_sess->eval_threads <= 1)
+		return 0;
+
+	if (ids == NULL) {
+		struct oval_definition_iterator *oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
+		while (oval_definition_iterator_has_more(oval_def_it)) {
+			if (count == size) {
+				size = size == 0 ? 32 : size * 2;
+				defs = realloc(defs, sizeof(struct oval_definition *) * size);
+			}
+			defs[count++] = oval_definition_iterator_next(oval_def_it);
+		}
+		oval_definition_iterator_free(oval_def_it);
+	} else {
+		struct oscap_string_iterator *id_it = oscap_stringlist_get_strings(ids);
+		while (oscap_string_iterator_has_more(id_it)) {
+			const char *id = oscap_string_iterator_next(id_it);
+			struct oval_definition *def = oval_definition_model_get_definition(ag_sess->def_model, id);
+			if (def == NULL)
+				continue;
+			if (count == size) {
+				size = size == 0 ? 32 : size * 2;
+				defs = realloc(defs, sizeof(struct oval_definition *) * size);
+			}
+			defs[count++] = def;
+		}
+		oscap_string_iterator_free(id_it);
+	}
+
+	ret = oval_probe_prefetch_definitions(ag_sess->psess, defs, count, ag_sess->eval_threads);
+	free(defs);
+
+	return ret == -2 ? 1 : 0;
+}
+
 static struct oval_result_system *_oval_agent_get_first_result_system(oval_agent_session_t *ag_sess)
 {
 	struct oval_results_model *rmodel = oval_agent_get_results_model(ag_sess);
@@ -251,6 +310,13 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 	int ret = 0;
 
 	dI("OVAL agent started to evaluate OVAL definitions on your system.");
+
+	/* collect independent objects in parallel, the rest is evaluated sequentially */
+	if (oval_agent_prefetch_definitions(ag_sess, NULL) != 0) {
+		dI("OVAL agent finished evaluation.");
+		return 1;
+	}
+
 	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
 	while (oval_definition_iterator_has_more(oval_def_it)) {
 		oval_def = oval_definition_iterator_next(oval_def_it);
@@ -533,6 +599,9 @@ oval_agent_eval_multi_check(oval_agent_session_t *sess)
 	xccdf_test_result_type_t xccdf_result;
 	xccdf_test_result_type_t final_result = 0;
 
+	if (oval_agent_prefetch_definitions(sess, NULL) != 0)
+		return XCCDF_RESULT_ERROR;
+
 	oval_def_it = oval_definition_model_get_definitions(sess->def_model);
 	if (!oval_definition_iterator_has_more(oval_def_it)) {
 		// We are evaluating oval, which has no definitions. We are in state
@@ -52,8 +52,10 @@
 #include "common/_error.h"
 #include "common/oscap_string.h"
 #include "oval_glob_to_regex.h"
+#include "probes/SEAP/MurmurHash3.h"
 #if defined USE_REGEX_PCRE
 #include <pcre.h>
+#include "common/oscap_pcre_cache.h"
 #elif defined USE_REGEX_POSIX
 #include <regex.h>
 #endif
@@ -194,6 +196,9 @@ typedef struct oval_component_REGEX_CAPTURE {
 	oval_component_type_t type;
 	struct oval_collection *function_components;	/*type==OVAL_COMPONENT_FUNCTION */
 	char *pattern;		/*type==OVAL_COMPONENT_REGEX_CAPTURE */
+#if defined USE_REGEX_PCRE
+	struct oscap_pcre *re;	/* the pattern compiled when it is set, NULL if it can't be */
+#endif
 } oval_component_REGEX_CAPTURE_t;
 
 void oval_component_to_print(struct oval_component *component, char *indent, int index);
@@ -589,6 +594,27 @@ void oval_component_set_timedif_format_2(struct oval_component *component, oval_
 	}
 }
 
+/*
+ * Compile the pattern once, when it is set, instead of on every evaluation.
+ * A pattern which can't be compiled is reported by the evaluation.
+ */
+static void _oval_component_REGEX_CAPTURE_compile(oval_component_REGEX_CAPTURE_t *regex)
+{
+#if defined USE_REGEX_PCRE
+	const char *error = NULL;
+	int erroffset = -1;
+
+	if (regex->re != NULL)
+		oscap_pcre_cache_put(regex->re);
+	regex->re = NULL;
+	if (regex->pattern == NULL)
+		return;
+	regex->re = oscap_pcre_cache_get(regex->pattern, PCRE_UTF8, &error, &erroffset);
+	if (regex->re == NULL)
+		dW("Can't compile pattern \"%s\" at offset %d: %s.", regex->pattern, erroffset, error);
+#endif
+}
+
 char *oval_component_get_regex_pattern(struct oval_component *component) {
 	__attribute__nonnull__(component);
 
@@ -608,7 +634,10 @@ void oval_component_set_regex_pattern(struct oval_component *component, char *pa
 	/* type == OVAL_COMPONENT_REGEX_CAPTURE */
 	if (component->type == OVAL_FUNCTION_REGEX_CAPTURE) {
 		oval_component_REGEX_CAPTURE_t *regex = (oval_component_REGEX_CAPTURE_t *) component;
+		char *old_pattern = regex->pattern;
 		regex->pattern = oscap_strdup(pattern);
+		free(old_pattern);
+		_oval_component_REGEX_CAPTURE_compile(regex);
 	}
 }
 
@@ -723,6 +752,9 @@ struct oval_component *oval_component_new(struct oval_definition_model *model, o
 						return NULL;
 
 					regex->pattern = NULL;
+#if defined USE_REGEX_PCRE
+					regex->re = NULL;
+#endif
 				};
 				break;
 			default:{
@@ -890,6 +922,11 @@ void oval_component_free(struct oval_component *component)
 			oval_component_REGEX_CAPTURE_t *regex = (oval_component_REGEX_CAPTURE_t *) component;
 			free(regex->pattern);
 			regex->pattern = NULL;
+#if defined USE_REGEX_PCRE
+			if (regex->re != NULL)
+				oscap_pcre_cache_put(regex->re);
+			regex->re = NULL;
+#endif
 		};
 		break;
 	case OVAL_FUNCTION_GLOB_TO_REGEX:
@@ -1107,6 +1144,7 @@ static int _oval_component_parse_REGEX_CAPTURE_tag(xmlTextReaderPtr reader,
 	oval_component_REGEX_CAPTURE_t *regex = (oval_component_REGEX_CAPTURE_t *) component;
 
 	regex->pattern = (char *)xmlTextReaderGetAttribute(reader, BAD_CAST "pattern");
+	_oval_component_REGEX_CAPTURE_compile(regex);
 
 	return _oval_component_parse_FUNCTION_tag(reader, context, component);
 }
@@ -1563,6 +1601,20 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_END(oval_argu_t *
 	return flag;
 }
 
+/*
+ * A string value with a copy of the first len characters of the text.
+ */
+static struct oval_value *_oval_component_string_value(const char *text, size_t len)
+{
+	char *copy = malloc(len + 1);
+	if (copy == NULL)
+		return NULL;
+
+	memcpy(copy, text, len);
+	copy[len] = '\0';
+	return oval_value_new_nocopy(OVAL_DATATYPE_STRING, copy);
+}
+
 static oval_syschar_collection_flag_t _oval_component_evaluate_CONCAT(oval_argu_t *argu,
 								      struct oval_component *component,
 								      struct oval_collection *value_collection)
@@ -1582,68 +1634,68 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_CONCAT(oval_argu_
 	}
 	bool not_finished = (len_subcomps > 0) && _HAS_VALUES(flag);
 	if (not_finished) {
-		struct oval_value_iterator *values[len_subcomps];
-		/* bool has_some[len_subcomps]; <-- unused variable */
-		not_finished = false;
-		char *texts[len_subcomps];
-		int counts[len_subcomps];
-		int catnum = 1;
+		/*
+		 * The values of every subcomponent are indexed and their lengths are
+		 * taken once; every combination is then copied straight into the text
+		 * of its value. Subcomponents without values are left out.
+		 */
+		struct oval_value **values[len_subcomps];
+		size_t *lengths[len_subcomps];
+		size_t counts[len_subcomps], current[len_subcomps];
+		size_t catnum = 1, len_cat = 0, count, idx;
+		int len_parts = 0;
+
 		for (idx0 = 0; idx0 < len_subcomps; idx0++) {
-			struct oval_value_iterator *comp_values =
-			    (struct oval_value_iterator *)oval_collection_iterator(component_colls[idx0]);
-			counts[idx0] = oval_value_iterator_remaining(comp_values);
-			if (counts[idx0]) {
-				/* int dbgnum = catnum; <-- unused variable */
-				catnum = catnum * counts[idx0];
-				values[idx0] = comp_values;
-				texts[idx0] = oval_value_get_text(oval_value_iterator_next(comp_values));
-				not_finished = true;
-			} else {
-				oval_collection_free_items(component_colls[idx0],
-							   (oscap_destruct_func) oval_value_free);
-				component_colls[idx0] = NULL;
-				values[idx0] = NULL;
-				texts[idx0] = NULL;
+			void **items = oval_collection_items(component_colls[idx0], &count);
+			if (count == 0)
+				continue;
+			values[len_parts] = (struct oval_value **) items;
+			lengths[len_parts] = malloc(count * sizeof(size_t));
+			if (lengths[len_parts] == NULL) {
+				flag = SYSCHAR_FLAG_ERROR;
+				break;
+			}
+			for (idx = 0; idx < count; idx++) {
+				char *text = oval_value_get_text(values[len_parts][idx]);
+				lengths[len_parts][idx] = text != NULL ? strlen(text) : 0;
 			}
+			counts[len_parts] = count;
+			current[len_parts] = 0;
+			len_cat += lengths[len_parts][0];
+			catnum *= count;
+			len_parts++;
 		}
-		for (int passnum = 1; passnum - 1 < catnum; passnum++) {
-			int len_cat = 1;
-			for (idx0 = 0; idx0 < len_subcomps; idx0++)
-				if (texts[idx0])
-					len_cat += strlen(texts[idx0]);
-			char concat[len_cat];
-			*concat = '\0';
-			for (idx0 = 0; idx0 < len_subcomps; idx0++)
-				if (texts[idx0])
-					strcat(concat, texts[idx0]);
-			struct oval_value *value = oval_value_new(OVAL_DATATYPE_STRING, concat);
-			oval_collection_add(value_collection, value);
-			bool rotate = true;
-			if (passnum < catnum) {
-				for (idx0 = 0; idx0 < len_subcomps && rotate; idx0++) {
-					if (texts[idx0]) {
-						if (oval_value_iterator_has_more(values[idx0])) {
-							rotate = false;
-						} else {
-							oval_value_iterator_free(values[idx0]);
-							values[idx0] =
-							    (struct oval_value_iterator *)
-							    oval_collection_iterator(component_colls[idx0]);
-						}
-						texts[idx0] =
-						    oval_value_get_text(oval_value_iterator_next(values[idx0]));
-					}
+		for (size_t passnum = 0; flag != SYSCHAR_FLAG_ERROR && passnum < catnum; passnum++) {
+			char *concat = malloc(len_cat + 1), *end = concat;
+			if (concat == NULL) {
+				flag = SYSCHAR_FLAG_ERROR;
+				break;
+			}
+			for (idx0 = 0; idx0 < len_parts; idx0++) {
+				size_t len = lengths[idx0][current[idx0]];
+				if (len > 0) {
+					memcpy(end, oval_value_get_text(values[idx0][current[idx0]]), len);
+					end += len;
 				}
 			}
-		}
-		for (idx0 = 0; idx0 < len_subcomps; idx0++) {
-			if (counts[idx0]) {
-				oval_value_iterator_free(values[idx0]);
-				oval_collection_free_items(component_colls[idx0],
-							   (oscap_destruct_func) oval_value_free);
+			*end = '\0';
+			struct oval_value *value = oval_value_new_nocopy(OVAL_DATATYPE_STRING, concat);
+			oval_collection_add(value_collection, value);
+			/* the values of the first subcomponent rotate the fastest */
+			for (idx0 = 0; idx0 < len_parts; idx0++) {
+				len_cat -= lengths[idx0][current[idx0]];
+				if (++current[idx0] == counts[idx0])
+					current[idx0] = 0;
+				len_cat += lengths[idx0][current[idx0]];
+				if (current[idx0] != 0)
+					break;
 			}
 		}
+		for (idx0 = 0; idx0 < len_parts; idx0++)
+			free(lengths[idx0]);
 	}
+	for (idx0 = 0; idx0 < len_subcomps; idx0++)
+		oval_collection_free_items(component_colls[idx0], (oscap_destruct_func) oval_value_free);
 	oval_component_iterator_free(subcomps);
 	return flag;
 }
@@ -1692,6 +1744,20 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_COUNT(oval_argu_t
 	return flag;
 }
 
+/*
+ * Slot of the open addressing set of value texts used by UNIQUE.
+ */
+struct _oval_component_unique_slot {
+	uint32_t hash;
+	struct oval_value *value;
+};
+
+static int _oval_component_value_text_cmp(const void *a, const void *b)
+{
+	return strcmp(oval_value_get_text(*(struct oval_value **) a),
+		      oval_value_get_text(*(struct oval_value **) b));
+}
+
 static oval_syschar_collection_flag_t _oval_component_evaluate_UNIQUE(oval_argu_t *argu,
 								      struct oval_component *component,
 								      struct oval_collection *value_collection)
@@ -1713,28 +1779,66 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_UNIQUE(oval_argu_
 	oval_component_iterator_free(subcomps);
 
 	bool not_finished = (len_subcomps > 0) && _HAS_VALUES(flag);
-	struct oval_string_map *valmap = oval_string_map_new();
 
 	if (not_finished) {
+		/*
+		 * The first value of every text is moved to the result, the texts
+		 * are hashed into a local set sized for all the values, so neither
+		 * the values nor their texts are copied. The result is sorted by
+		 * the text.
+		 */
+		size_t total = 0, size = 16, mask, count, idx, len_unique = 0;
+
 		for (idx0 = 0; idx0 < len_subcomps; idx0++) {
-			struct oval_value_iterator *comp_values =
-			    (struct oval_value_iterator *)oval_collection_iterator(component_colls[idx0]);
+			oval_collection_items(component_colls[idx0], &count);
+			total += count;
+		}
+		while (size < 2 * total)
+			size *= 2;
+		mask = size - 1;
 
-			while (oval_value_iterator_has_more(comp_values)) {
-				char *valtxt;
-				if ((valtxt = oval_value_get_text(oval_value_iterator_next(comp_values))) != NULL) {
-				  if (oval_string_map_get_value(valmap, valtxt) == NULL) {
-					struct oval_value *value = oval_value_new(OVAL_DATATYPE_STRING, valtxt);
-					oval_string_map_put(valmap, valtxt, value);
-				  }
+		struct _oval_component_unique_slot *set = calloc(size, sizeof(struct _oval_component_unique_slot));
+		struct oval_value **unique = malloc((total > 0 ? total : 1) * sizeof(struct oval_value *));
+
+		if (set == NULL || unique == NULL)
+			flag = SYSCHAR_FLAG_ERROR;
+
+		for (idx0 = 0; flag != SYSCHAR_FLAG_ERROR && idx0 < len_subcomps; idx0++) {
+			void **items = oval_collection_items(component_colls[idx0], &count);
+
+			for (idx = 0; idx < count; idx++) {
+				struct oval_value *value = items[idx];
+				char *valtxt = value != NULL ? oval_value_get_text(value) : NULL;
+				uint32_t hash;
+				size_t slot;
+
+				if (valtxt == NULL)
+					continue;
+				MurmurHash3_x86_32(valtxt, (int) strlen(valtxt), 0, &hash);
+				for (slot = hash & mask; set[slot].value != NULL; slot = (slot + 1) & mask) {
+					if (set[slot].hash == hash &&
+					    strcmp(oval_value_get_text(set[slot].value), valtxt) == 0)
+						break;
 				}
+				if (set[slot].value != NULL)
+					continue;
+
+				set[slot].hash = hash;
+				set[slot].value = value;
+				items[idx] = NULL;
+				oval_value_text_changed(value, OVAL_DATATYPE_STRING);
+				unique[len_unique++] = value;
 			}
-			oval_value_iterator_free(comp_values);
 		}
-	}
 
-	oval_string_map_collect_values(valmap, value_collection);
-	oval_string_map_free(valmap, NULL);
+		if (flag != SYSCHAR_FLAG_ERROR) {
+			qsort(unique, len_unique, sizeof(struct oval_value *), _oval_component_value_text_cmp);
+			for (idx = 0; idx < len_unique; idx++)
+				oval_collection_add(value_collection, unique[idx]);
+		}
+		free(unique);
+		free(set);
+	}
 
 	for (idx0 = 0; idx0 < len_subcomps; ++idx0)
 	  oval_collection_free_items(component_colls[idx0], (oscap_destruct_func) oval_value_free);
@@ -1755,35 +1859,33 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_SPLIT(oval_argu_t
 		struct oval_component *subcomp = oval_component_iterator_next(subcomps);
 		struct oval_collection *subcoll = oval_collection_new();
 		flag = oval_component_eval_common(argu, subcomp, subcoll);
-		struct oval_value_iterator *values = (struct oval_value_iterator *)oval_collection_iterator(subcoll);
+		size_t count, idx;
+		void **items = oval_collection_items(subcoll, &count);
 		struct oval_value *value;
-		while (oval_value_iterator_has_more(values)) {
-			char *text = oval_value_get_text(oval_value_iterator_next(values));
+		for (idx = 0; idx < count; idx++) {
+			char *text = oval_value_get_text(items[idx]);
+			if (text == NULL)
+				continue;
 			if (len_delim) {
-				char split[strlen(text) + 2], *split0 = split;
-				*split0 = '\0';
-				strcat(split0, text);
-				split0[strlen(text) + 1] = '\0';	/*last two characters are EOS */
-				char *split1;
+				char *split0 = text, *split1;
 				for (split1 = strstr(split0, delimiter); split1; split1 = strstr(split0, delimiter)) {
-					*split1 = '\0';	/*terminate the text at the delimeter */
-					value = oval_value_new(OVAL_DATATYPE_STRING, split0);
+					value = _oval_component_string_value(split0, split1 - split0);
 					oval_collection_add(value_collection, value);
 					split0 = split1 + len_delim;	/*advance split1 */
 				}
-				value = oval_value_new(OVAL_DATATYPE_STRING, split0);
-				oval_collection_add(value_collection, value);
+				/* the last piece is moved to the beginning of the text and the value is reused */
+				memmove(text, split0, strlen(split0) + 1);
+				oval_value_text_changed(items[idx], OVAL_DATATYPE_STRING);
+				oval_collection_add(value_collection, items[idx]);
+				items[idx] = NULL;
 			} else {	/*Empty delimiter, Split at every character */
-				char split[] = { '\0', '\0' };
-				int idx;
-				for (idx = 0; text[idx]; idx++) {
-					*split = text[idx];
-					value = oval_value_new(OVAL_DATATYPE_STRING, split);
+				int idx1;
+				for (idx1 = 0; text[idx1]; idx1++) {
+					value = _oval_component_string_value(text + idx1, 1);
 					oval_collection_add(value_collection, value);
 				}
 			}
 		}
-		oval_value_iterator_free(values);
 		oval_collection_free_items(subcoll, (oscap_destruct_func) oval_value_free);
 	}
 	oval_component_iterator_free(subcomps);
@@ -1805,28 +1907,29 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_SUBSTRING(oval_ar
 		struct oval_component *subcomp = oval_component_iterator_next(subcomps);
 		struct oval_collection *subcoll = oval_collection_new();
 		flag = oval_component_eval_common(argu, subcomp, subcoll);
-		struct oval_value_iterator *values = (struct oval_value_iterator *)oval_collection_iterator(subcoll);
-		struct oval_value *value;
+		size_t count, idx;
+		void **items = oval_collection_items(subcoll, &count);
 
-		while (oval_value_iterator_has_more(values)) {
-			char *text = oval_value_get_text(oval_value_iterator_next(values));
+		for (idx = 0; idx < count; idx++) {
+			char *text = oval_value_get_text(items[idx]);
 			size_t txtlen, sublen;
 
-			txtlen = strlen(text);
-			sublen = (len < 0 || (size_t) len > txtlen) ? txtlen : (size_t) len;
+			txtlen = text != NULL ? strlen(text) : 0;
 			if ((size_t) beg < txtlen) {
-				char substr[sublen + 1];
-
-				strncpy(substr, text + beg, sublen);
-				substr[sublen] = '\0';
-
-				value = oval_value_new(OVAL_DATATYPE_STRING, substr);
-				oval_collection_add(value_collection, value);
+				sublen = txtlen - beg;
+				if (len >= 0 && (size_t) len < sublen)
+					sublen = len;
+
+				/* the substring is cut out in place and the value is reused */
+				memmove(text, text + beg, sublen);
+				text[sublen] = '\0';
+				oval_value_text_changed(items[idx], OVAL_DATATYPE_STRING);
+				oval_collection_add(value_collection, items[idx]);
+				items[idx] = NULL;
 			} else {
 				flag = SYSCHAR_FLAG_ERROR;
 			}
 		}
-		oval_value_iterator_free(values);
 		oval_collection_free_items(subcoll, (oscap_destruct_func) oval_value_free);
 	}
 	oval_component_iterator_free(subcomps);
@@ -2182,14 +2285,11 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 	int rc;
 	char *pattern;
 #if defined USE_REGEX_PCRE
-	int erroffset = -1;
-	pcre *re = NULL;
-	const char *error;
+	struct oscap_pcre *re = ((oval_component_REGEX_CAPTURE_t *) component)->re;
 
 	pattern = oval_component_get_regex_pattern(component);
-	re = pcre_compile(pattern, PCRE_UTF8, &error, &erroffset, NULL);
 	if (re == NULL) {
-		dE("pcre_compile() failed: \"%s\".", error);
+		dE("pcre_compile() failed: \"%s\".", pattern != NULL ? pattern : "");
 		return SYSCHAR_FLAG_ERROR;
 	}
 #elif defined USE_REGEX_POSIX
@@ -2207,18 +2307,18 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 		struct oval_component *subcomp = oval_component_iterator_next(subcomps);
 		struct oval_collection *subcoll = oval_collection_new();
 		flag = oval_component_eval_common(argu, subcomp, subcoll);
-		struct oval_value_iterator *values = (struct oval_value_iterator *)oval_collection_iterator(subcoll);
-		while (oval_value_iterator_has_more(values)) {
-			struct oval_value *value = oval_value_iterator_next(values);
-			char *text = oval_value_get_text(value);
-			char *nval = NULL;
+		size_t count, idx;
+		void **items = oval_collection_items(subcoll, &count);
+		for (idx = 0; idx < count; idx++) {
+			char *text = oval_value_get_text(items[idx]);
+			int substr_beg = 0, substr_len = 0;
 #if defined USE_REGEX_PCRE
 			int i, ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
 
 			for (i = 0; i < ovector_len; ++i)
 				ovector[i] = -1;
 
-			rc = pcre_exec(re, NULL, text, strlen(text), 0, 0, ovector, ovector_len);
+			rc = oscap_pcre_exec(re, text, strlen(text), 0, 0, ovector, ovector_len);
 			if (rc < -1) {
 				dE("pcre_exec() failed: %d.", rc);
 				flag = SYSCHAR_FLAG_ERROR;
@@ -2226,13 +2326,8 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 			}
 
 			if (rc > 1 && ovector[2] != -1) {
-				int substr_len = ovector[3] - ovector[2];
-
-				nval = malloc(substr_len + 1);
-				memcpy(nval, text + ovector[2], substr_len);
-				nval[substr_len] = '\0';
-			} else {
-				nval = NULL;
+				substr_beg = ovector[2];
+				substr_len = ovector[3] - ovector[2];
 			}
 #elif defined USE_REGEX_POSIX
 			regmatch_t pmatch[40];
@@ -2240,31 +2335,24 @@ static oval_syschar_collection_flag_t _oval_component_evaluate_REGEX_CAPTURE(ova
 
 			rc = regexec(&re, text, pmatch_len, pmatch, 0);
 			if (rc != REG_NOMATCH && pmatch[1].rm_so != -1) {
-				int substr_len = pmatch[1].rm_eo - pmatch[1].rm_so;
-
-				nval = malloc(substr_len + 1);
-				memcpy(nval, text + pmatch[1].rm_so, substr_len);
-				nval[substr_len] = '\0';
-			} else {
-				nval = NULL;
+				substr_beg = pmatch[1].rm_so;
+				substr_len = pmatch[1].rm_eo - pmatch[1].rm_so;
 			}
 #endif
 			flag = SYSCHAR_FLAG_COMPLETE;
 
-			if (nval != NULL) {
-				value = oval_value_new(OVAL_DATATYPE_STRING, nval);
-				free(nval);
-			} else {
-				value = oval_value_new(OVAL_DATATYPE_STRING, "");
-			}
-			oval_collection_add(value_collection, value);
+			/* the first subexpression, or an empty string, is cut out in place and the value is reused */
+			memmove(text, text + substr_beg, substr_len);
+			text[substr_len] = '\0';
+			oval_value_text_changed(items[idx], OVAL_DATATYPE_STRING);
+			oval_collection_add(value_collection, items[idx]);
+			items[idx] = NULL;
 		}
-		oval_value_iterator_free(values);
 		oval_collection_free_items(subcoll, (oscap_destruct_func) oval_value_free);
 	}
 	oval_component_iterator_free(subcomps);
-#if defined USE_REGEX_PCRE
-        pcre_free(re);
+#if defined USE_REGEX_POSIX
+	regfree(&re);
 #endif
 	return flag;
 }
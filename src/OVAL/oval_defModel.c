@@ -480,7 +480,8 @@ struct oval_test *oval_definition_model_get_new_test(struct oval_definition_mode
 	return test;
 }
 
-xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent)
+xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent,
+				      struct oscap_xml_stream *stream)
 {
 
 	xmlNodePtr root_node = NULL;
@@ -491,6 +492,7 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 		root_node = xmlNewNode(NULL, BAD_CAST OVAL_ROOT_ELM_DEFINITIONS);
 		xmlDocSetRootElement(doc, root_node);
 	}
+	oscap_xml_stream_open(stream, root_node);
 	xmlNewNsProp(root_node, lookup_xsi_ns(doc), BAD_CAST "schemaLocation", BAD_CAST definition_model->schema);
 
 	xmlNs *ns_common = xmlNewNs(root_node, OVAL_COMMON_NAMESPACE, BAD_CAST "oval");
@@ -518,9 +520,12 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 			struct oval_definition *definition = oval_definition_iterator_next(definitions);
 			if (definitions_node == NULL) {
 				definitions_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "definitions", NULL);
+				oscap_xml_stream_open(stream, definitions_node);
 			}
 			oval_definition_to_dom(definition, doc, definitions_node);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_close(stream);
 	}
         oval_definition_iterator_free(definitions);
 
@@ -528,10 +533,13 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 	struct oval_test_iterator *tests = oval_definition_model_get_tests(definition_model);
 	if (oval_test_iterator_has_more(tests)) {
 		xmlNode *tests_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "tests", NULL);
+		oscap_xml_stream_open(stream, tests_node);
 		while (oval_test_iterator_has_more(tests)) {
 			struct oval_test *test = oval_test_iterator_next(tests);
 			oval_test_to_dom(test, doc, tests_node);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_close(stream);
 	}
 	oval_test_iterator_free(tests);
 
@@ -539,13 +547,16 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 	struct oval_object_iterator *objects = oval_definition_model_get_objects(definition_model);
 	if (oval_object_iterator_has_more(objects)) {
 		xmlNode *objects_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "objects", NULL);
+		oscap_xml_stream_open(stream, objects_node);
 		while(oval_object_iterator_has_more(objects)) {
 			struct oval_object *object = oval_object_iterator_next(objects);
 			if (oval_object_get_base_obj(object))
 				/* Skip internal objects */
 				continue;
 			oval_object_to_dom(object, doc, objects_node);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_close(stream);
 	}
 	oval_object_iterator_free(objects);
 
@@ -553,10 +564,13 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 	struct oval_state_iterator *states = oval_definition_model_get_states(definition_model);
 	if (oval_state_iterator_has_more(states)) {
 		xmlNode *states_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "states", NULL);
+		oscap_xml_stream_open(stream, states_node);
 		while (oval_state_iterator_has_more(states)) {
 			struct oval_state *state = oval_state_iterator_next(states);
 			oval_state_to_dom(state, doc, states_node);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_close(stream);
 	}
 	oval_state_iterator_free(states);
 
@@ -564,13 +578,17 @@ xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_m
 	struct oval_variable_iterator *variables = oval_definition_model_get_variables(definition_model);
 	if (oval_variable_iterator_has_more(variables)) {
 		xmlNode *variables_node = xmlNewTextChild(root_node, ns_defntns, BAD_CAST "variables", NULL);
+		oscap_xml_stream_open(stream, variables_node);
 		while (oval_variable_iterator_has_more(variables)) {
 			struct oval_variable *variable = oval_variable_iterator_next(variables);
 			oval_variable_to_dom(variable, doc, variables_node);
+			oscap_xml_stream_flush(stream);
 		}
+		oscap_xml_stream_close(stream);
 	}
 	oval_variable_iterator_free(variables);
 
+	oscap_xml_stream_close(stream);
 	return root_node;
 }
 
@@ -587,7 +605,7 @@ int oval_definition_model_export(struct oval_definition_model *model, const char
 		return -1;
 	}
 
-	oval_definition_model_to_dom(model, doc, NULL);
+	oval_definition_model_to_dom(model, doc, NULL, NULL);
 	return oscap_xml_save_filename_free(file, doc);
 }
 
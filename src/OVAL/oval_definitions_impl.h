@@ -36,6 +36,7 @@
 #include "oval_parser_impl.h"
 #include "adt/oval_string_map_impl.h"
 #include "../common/util.h"
+#include "../common/xml_stream.h"
 
 OSCAP_HIDDEN_START;
 
@@ -135,6 +136,12 @@ typedef void (*oval_value_consumer) (struct oval_value *, void *);
 int oval_value_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, oval_value_consumer, void *);
 xmlNode *oval_value_to_dom(struct oval_value *, xmlDoc *, xmlNode *);
 int oval_value_cast(struct oval_value *value, oval_datatype_t new_dt);
+/* the value takes the text, which is not copied */
+struct oval_value *oval_value_new_nocopy(oval_datatype_t datatype, char *text_value);
+/* the text of the value has been changed in place, drop what was parsed from the old one */
+void oval_value_text_changed(struct oval_value *value, oval_datatype_t datatype);
+/* the value parsed as evr_string, debian_evr_string or version, parsed only once */
+struct oval_evr *oval_value_get_evr(struct oval_value *value);
 
 oval_syschar_collection_flag_t oval_component_compute(struct oval_syschar_model *sysmod, struct oval_component *component,
 						      struct oval_collection *value_collection);
@@ -157,7 +164,7 @@ int oval_generator_parse_tag(xmlTextReader *, struct oval_parser_context *, void
 xmlNode *oval_generator_to_dom(struct oval_generator *, xmlDocPtr, xmlNode *);
 
 /* definition_model */
-xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent);
+xmlNode *oval_definition_model_to_dom(struct oval_definition_model *definition_model, xmlDocPtr doc, xmlNode * parent, struct oscap_xml_stream *stream);
 void oval_definition_model_optimize_by_filter_propagation(struct oval_definition_model *);
 
 struct oval_definition *oval_definition_model_get_new_definition(struct oval_definition_model *, const char *);
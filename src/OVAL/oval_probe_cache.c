@@ -0,0 +1,706 @@
+/**
+ * @file oval_probe_cache.c
+ * \brief Persistent cache of collected OVAL objects
+ *
+ * The replies of the probes are kept in a directory across scans, one file
+ * per object. An entry is keyed by the object as it is sent to the probe,
+ * which includes the values of the variables the object references, and
+ * holds a validity stamp describing the state of the system the reply was
+ * collected from. A later scan uses the stored reply instead of querying
+ * the probe if the object and its stamp are still the same.
+ *
+ * Only objects whose results depend on a known set of files qualify:
+ *  - file based objects (file, filehash, textfilecontent, ...) whose path,
+ *    filename and filepath entities are all compared for equality and
+ *    which don't recurse into subdirectories; they are stamped with the
+ *    inode metadata of every file they name, including the missing ones,
+ *  - rpminfo and dpkginfo objects, stamped with the metadata of the
+ *    package database files; the rpm database is looked for where
+ *    OSCAP_PROBE_RPMDB_PATH points to, as the rpm probes do.
+ * The states used by the filters of an object are part of its key, as the
+ * request refers to them only by their IDs. Objects with sets are never
+ * cached, as they depend on other objects which are not part of the key.
+ *
+ * Item IDs of stored replies are rewritten when the replies are used, so
+ * that they never clash with the IDs given out by the running probes.
+ */
+
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <sexp.h>
+#include <strbuf.h>
+#include <oscap.h>
+
+#include "public/oval_definitions.h"
+#include "public/oval_system_characteristics.h"
+#include "oval_probe_cache.h"
+#include "probes/public/probe-api.h"
+#include "common/_error.h"
+#include "common/debug_priv.h"
+#include "common/list.h"
+#include "common/oscap_string.h"
+#include "common/util.h"
+
+#define CACHE_MAGIC "oscap object cache"
+
+static unsigned int cache_next_id = 0;
+
+struct oval_probe_cache {
+	char *dir;
+	char *run;                   /**< identifies the replies stored by this process */
+	pthread_mutex_t lock;
+	struct oscap_htable *ids;    /**< "<run> <stored item ID>" -> item ID used in this process */
+	unsigned int hits;
+	unsigned int misses;
+	unsigned int stores;
+};
+
+struct oval_probe_cache *oval_probe_cache_new(const char *dir)
+{
+	struct oval_probe_cache *cache;
+	struct timespec ts;
+	struct stat st;
+	char run[64];
+
+	if (stat(dir, &st) != 0) {
+		if (errno != ENOENT || mkdir(dir, 0700) != 0 || stat(dir, &st) != 0) {
+			oscap_seterr(OSCAP_EFAMILY_OVAL, "Can't use object cache directory '%s': %s",
+			             dir, strerror(errno));
+			return NULL;
+		}
+	}
+
+	/* the stored replies are trusted, nobody else may write them */
+	if (!S_ISDIR(st.st_mode) || st.st_uid != geteuid() || (st.st_mode & (S_IWGRP|S_IWOTH)) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_OVAL, "Object cache directory '%s' must be a directory "
+		             "owned by the current user and writable only by its owner.", dir);
+		return NULL;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	snprintf(run, sizeof run, "%ld.%09ld.%ld", (long)ts.tv_sec, ts.tv_nsec, (long)getpid());
+
+	cache = oscap_talloc(struct oval_probe_cache);
+	cache->dir = oscap_strdup(dir);
+	cache->run = oscap_strdup(run);
+	pthread_mutex_init(&cache->lock, NULL);
+	cache->ids = oscap_htable_new();
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->stores = 0;
+
+	dI("Object cache '%s' opened.", dir);
+
+	return cache;
+}
+
+void oval_probe_cache_free(struct oval_probe_cache *cache)
+{
+	if (cache == NULL)
+		return;
+
+	dI("Object cache '%s': %u hits, %u misses, %u replies stored.",
+	   cache->dir, cache->hits, cache->misses, cache->stores);
+
+	oscap_htable_free(cache->ids, free);
+	pthread_mutex_destroy(&cache->lock);
+	free(cache->run);
+	free(cache->dir);
+	free(cache);
+}
+
+/*
+ * Validity stamps
+ */
+
+static void cache_stamp_stat(struct oscap_string *stamp, const struct stat *st, bool atime)
+{
+	char buf[256];
+
+	snprintf(buf, sizeof buf, " %" PRIu64 ":%" PRIu64 ":%o:%u:%u:%lld:%lld.%09ld:%lld.%09ld",
+	         (uint64_t)st->st_dev, (uint64_t)st->st_ino, (unsigned int)st->st_mode,
+	         (unsigned int)st->st_uid, (unsigned int)st->st_gid, (long long)st->st_size,
+	         (long long)st->st_mtim.tv_sec, st->st_mtim.tv_nsec,
+	         (long long)st->st_ctim.tv_sec, st->st_ctim.tv_nsec);
+	oscap_string_append_string(stamp, buf);
+
+	if (atime) {
+		snprintf(buf, sizeof buf, ":%lld.%09ld", (long long)st->st_atim.tv_sec, st->st_atim.tv_nsec);
+		oscap_string_append_string(stamp, buf);
+	}
+}
+
+/*
+ * Stamp a file with its own metadata and, if it is a symbolic link, with
+ * the metadata of the file it points to.
+ */
+static void cache_stamp_path(struct oscap_string *stamp, const char *dir, const char *name, bool atime)
+{
+	const char *root = getenv("OSCAP_PROBE_ROOT");
+	char path[PATH_MAX];
+	struct stat st;
+	int len;
+
+	if (name == NULL)
+		len = snprintf(path, sizeof path, "%s%s", root ? root : "", dir);
+	else
+		len = snprintf(path, sizeof path, "%s%s%s%s", root ? root : "", dir,
+		               dir[0] != '\0' && dir[strlen(dir) - 1] == '/' ? "" : "/", name);
+
+	oscap_string_append_string(stamp, path);
+
+	if (len < 0 || (size_t)len >= sizeof path) {
+		oscap_string_append_string(stamp, " ?\n");
+		return;
+	}
+
+	if (lstat(path, &st) != 0) {
+		oscap_string_append_string(stamp, " -\n");
+		return;
+	}
+	cache_stamp_stat(stamp, &st, atime);
+
+	if (S_ISLNK(st.st_mode)) {
+		if (stat(path, &st) != 0)
+			oscap_string_append_string(stamp, " -");
+		else
+			cache_stamp_stat(stamp, &st, atime);
+	}
+
+	oscap_string_append_char(stamp, '\n');
+}
+
+/*
+ * Collect the values of an entity which is compared for equality.
+ * @return -1 if the entity matches files by other means
+ */
+static int cache_entity_values(struct oval_entity *entity, const char ***values, size_t *count)
+{
+	if (oval_entity_get_operation(entity) != OVAL_OPERATION_EQUALS)
+		return -1;
+
+	if (oval_entity_get_varref_type(entity) != OVAL_ENTITY_VARREF_NONE) {
+		struct oval_variable *var = oval_entity_get_variable(entity);
+		struct oval_value_iterator *val_itr;
+
+		if (var == NULL || oval_variable_get_collection_flag(var) != SYSCHAR_FLAG_COMPLETE)
+			return -1;
+
+		val_itr = oval_variable_get_values(var);
+		while (oval_value_iterator_has_more(val_itr)) {
+			struct oval_value *val = oval_value_iterator_next(val_itr);
+
+			*values = realloc(*values, sizeof(char *) * (*count + 1));
+			(*values)[(*count)++] = oval_value_get_text(val);
+		}
+		oval_value_iterator_free(val_itr);
+	} else {
+		struct oval_value *val = oval_entity_get_value(entity);
+
+		*values = realloc(*values, sizeof(char *) * (*count + 1));
+		(*values)[(*count)++] = val != NULL ? oval_value_get_text(val) : NULL;
+	}
+
+	return 0;
+}
+
+static char *cache_stamp_files(struct oval_object *object, bool atime)
+{
+	struct oval_object_content_iterator *cit;
+	struct oval_behavior_iterator *bit;
+	struct oscap_string *stamp;
+	const char **paths = NULL, **names = NULL, **filepaths = NULL;
+	size_t path_cnt = 0, name_cnt = 0, filepath_cnt = 0, i, j;
+	bool have_names = false;
+	int ret = 0;
+
+	cit = oval_object_get_object_contents(object);
+	while (ret == 0 && oval_object_content_iterator_has_more(cit)) {
+		struct oval_object_content *content = oval_object_content_iterator_next(cit);
+		struct oval_entity *entity;
+		const char *name;
+
+		/* the filters don't change the files the object names */
+		if (oval_object_content_get_type(content) == OVAL_OBJECTCONTENT_FILTER)
+			continue;
+		if (oval_object_content_get_type(content) != OVAL_OBJECTCONTENT_ENTITY) {
+			ret = -1;
+			break;
+		}
+
+		entity = oval_object_content_get_entity(content);
+		name = oval_entity_get_name(entity);
+
+		if (oscap_streq(name, "path")) {
+			ret = cache_entity_values(entity, &paths, &path_cnt);
+		} else if (oscap_streq(name, "filename")) {
+			ret = cache_entity_values(entity, &names, &name_cnt);
+			have_names = true;
+		} else if (oscap_streq(name, "filepath")) {
+			ret = cache_entity_values(entity, &filepaths, &filepath_cnt);
+		}
+	}
+	oval_object_content_iterator_free(cit);
+
+	bit = oval_object_get_behaviors(object);
+	while (ret == 0 && oval_behavior_iterator_has_more(bit)) {
+		struct oval_behavior *behavior = oval_behavior_iterator_next(bit);
+
+		if (oscap_streq(oval_behavior_get_key(behavior), "recurse_direction") &&
+		    !oscap_streq(oval_behavior_get_value(behavior), "none"))
+			ret = -1;
+	}
+	oval_behavior_iterator_free(bit);
+
+	if (ret != 0 || path_cnt + filepath_cnt == 0) {
+		free(paths);
+		free(names);
+		free(filepaths);
+		return NULL;
+	}
+
+	stamp = oscap_string_new();
+
+	for (i = 0; i < filepath_cnt; ++i) {
+		if (filepaths[i] != NULL)
+			cache_stamp_path(stamp, filepaths[i], NULL, atime);
+	}
+
+	for (i = 0; i < path_cnt; ++i) {
+		if (paths[i] == NULL)
+			continue;
+
+		/* a nil filename stands for the directory itself */
+		if (!have_names) {
+			cache_stamp_path(stamp, paths[i], NULL, atime);
+			continue;
+		}
+
+		for (j = 0; j < name_cnt; ++j) {
+			if (names[j] == NULL || names[j][0] == '\0')
+				cache_stamp_path(stamp, paths[i], NULL, atime);
+			else
+				cache_stamp_path(stamp, paths[i], names[j], atime);
+		}
+	}
+
+	free(paths);
+	free(names);
+	free(filepaths);
+
+	return oscap_string_bequeath(stamp);
+}
+
+/* an empty name stands for the database directory itself */
+static const char *rpm_db_files[] = {
+	"",
+	"Packages",
+	"Packages.db",
+	"rpmdb.sqlite",
+	"rpmdb.sqlite-wal",
+	NULL
+};
+
+static const char *dpkg_db_files[] = {
+	"status",
+	NULL
+};
+
+static char *cache_stamp_db(struct oval_object *object, const char *dir, const char **names)
+{
+	struct oval_object_content_iterator *cit;
+	struct oscap_string *stamp;
+	bool have_set = false;
+
+	cit = oval_object_get_object_contents(object);
+	while (!have_set && oval_object_content_iterator_has_more(cit)) {
+		struct oval_object_content *content = oval_object_content_iterator_next(cit);
+
+		have_set = oval_object_content_get_type(content) == OVAL_OBJECTCONTENT_SET;
+	}
+	oval_object_content_iterator_free(cit);
+
+	if (have_set)
+		return NULL;
+
+	stamp = oscap_string_new();
+
+	for (; *names != NULL; ++names)
+		cache_stamp_path(stamp, dir, (*names)[0] != '\0' ? *names : NULL, false);
+
+	return oscap_string_bequeath(stamp);
+}
+
+char *oval_probe_cache_stamp(struct oval_object *object)
+{
+	const char *rpmdb;
+
+	switch ((int)oval_object_get_subtype(object)) {
+	case OVAL_UNIX_FILE:
+		/* file items report the access time */
+		return cache_stamp_files(object, true);
+	case OVAL_INDEPENDENT_FILE_MD5:
+	case OVAL_INDEPENDENT_FILE_HASH:
+	case OVAL_INDEPENDENT_FILE_HASH58:
+	case OVAL_INDEPENDENT_TEXT_FILE_CONTENT:
+	case OVAL_INDEPENDENT_TEXT_FILE_CONTENT_54:
+	case OVAL_INDEPENDENT_XML_FILE_CONTENT:
+	case OVAL_UNIX_FILEEXTENDEDATTRIBUTE:
+	case OVAL_UNIX_SYMLINK:
+		return cache_stamp_files(object, false);
+	case OVAL_LINUX_RPM_INFO:
+		rpmdb = getenv("OSCAP_PROBE_RPMDB_PATH");
+		return cache_stamp_db(object, rpmdb != NULL ? rpmdb : "/var/lib/rpm", rpm_db_files);
+	case OVAL_LINUX_DPKG_INFO:
+		return cache_stamp_db(object, "/var/lib/dpkg", dpkg_db_files);
+	default:
+		return NULL;
+	}
+}
+
+/*
+ * Entries
+ */
+
+static char *cache_sexp_str(const SEXP_t *sexp, size_t *len)
+{
+	strbuf_t *sb;
+	char *str = NULL;
+
+	sb = strbuf_new(SEAP_STRBUF_MAX);
+
+	if (SEXP_sbprintf_t((SEXP_t *)sexp, sb) == 0) {
+		*len = strbuf_length(sb);
+		str = malloc(*len + 1);
+		strbuf_copy(sb, str, *len);
+		str[*len] = '\0';
+	}
+
+	strbuf_free(sb);
+
+	return str;
+}
+
+static SEXP_t *cache_str_sexp(char *str, size_t len)
+{
+	SEXP_psetup_t *psetup;
+	SEXP_pstate_t *pstate = NULL;
+	SEXP_t *list, *sexp = NULL;
+
+	psetup = SEXP_psetup_new();
+	list = SEXP_parse(psetup, str, len, &pstate);
+
+	if (pstate != NULL)
+		SEXP_pstate_free(pstate);
+	else if (list != NULL && SEXP_list_length(list) == 1)
+		sexp = SEXP_list_first(list);
+
+	if (list != NULL)
+		SEXP_free(list);
+	SEXP_psetup_free(psetup);
+
+	return sexp;
+}
+
+static void cache_entry_path(struct oval_probe_cache *cache, const char *key, size_t len, char *path, size_t size)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	size_t i;
+
+	/* FNV-1a; entries sharing a file name replace each other */
+	for (i = 0; i < len; ++i) {
+		h ^= (unsigned char)key[i];
+		h *= 0x100000001b3ULL;
+	}
+
+	snprintf(path, size, "%s/%016" PRIx64, cache->dir, h);
+}
+
+/*
+ * Read the field "<name> <length>\n<data>\n" of an entry.
+ */
+static char *cache_entry_field(char **pos, char *end, const char *name, size_t *len)
+{
+	size_t name_len = strlen(name);
+	char *p = *pos, *data, *nl;
+	unsigned long long n;
+
+	if ((size_t)(end - p) <= name_len || memcmp(p, name, name_len) != 0 || p[name_len] != ' ')
+		return NULL;
+
+	nl = memchr(p, '\n', end - p);
+	if (nl == NULL || sscanf(p + name_len + 1, "%llu", &n) != 1)
+		return NULL;
+
+	data = nl + 1;
+	if ((unsigned long long)(end - data) < n + 1 || data[n] != '\n')
+		return NULL;
+
+	data[n] = '\0';
+	*len = n;
+	*pos = data + n + 1;
+
+	return data;
+}
+
+static char *cache_entry_read(const char *path, size_t *size)
+{
+	struct stat st;
+	char *buf;
+	ssize_t n;
+	size_t off = 0;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid()) {
+		close(fd);
+		return NULL;
+	}
+
+	buf = malloc(st.st_size + 1);
+
+	while (off < (size_t)st.st_size) {
+		n = read(fd, buf + off, st.st_size - off);
+		if (n <= 0) {
+			if (n < 0 && errno == EINTR)
+				continue;
+			break;
+		}
+		off += n;
+	}
+	close(fd);
+
+	if (off != (size_t)st.st_size) {
+		free(buf);
+		return NULL;
+	}
+
+	buf[off] = '\0';
+	*size = off;
+
+	return buf;
+}
+
+/*
+ * Give the items of a stored reply IDs which can't clash with the IDs of
+ * the items collected by the probes (those start with 1). Items stored by
+ * the same run keep sharing their IDs.
+ */
+static void cache_renumber_items(struct oval_probe_cache *cache, const char *run, SEXP_t *s_sys)
+{
+	SEXP_t *items, *item, *name_ref, *s_id, *prev_id, new_id;
+	char key[256], id[128], *new;
+
+	items = probe_cobj_get_items(s_sys);
+	if (items == NULL)
+		return;
+
+	pthread_mutex_lock(&cache->lock);
+
+	SEXP_list_foreach(item, items) {
+		name_ref = SEXP_listref_first(item);
+		s_id = probe_ent_getattrval(item, "id");
+
+		if (name_ref == NULL || s_id == NULL || !SEXP_stringp(s_id)) {
+			SEXP_free(name_ref);
+			SEXP_free(s_id);
+			continue;
+		}
+
+		SEXP_string_cstr_r(s_id, id, sizeof id);
+		snprintf(key, sizeof key, "%s %s", run, id);
+		SEXP_free(s_id);
+
+		new = oscap_htable_get(cache->ids, key);
+		if (new == NULL) {
+			snprintf(id, sizeof id, "2%05u%u", (unsigned int)getpid(), __sync_add_and_fetch(&cache_next_id, 1));
+			new = oscap_strdup(id);
+			oscap_htable_add(cache->ids, key, new);
+		}
+
+		SEXP_string_new_r(&new_id, new, strlen(new));
+		prev_id = SEXP_list_replace(name_ref, 3, &new_id);
+		SEXP_free(prev_id);
+		SEXP_free_r(&new_id);
+		SEXP_free(name_ref);
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	SEXP_free(items);
+}
+
+SEXP_t *oval_probe_cache_get(struct oval_probe_cache *cache, const SEXP_t *s_key, const char *stamp)
+{
+	char path[PATH_MAX], *key, *buf, *pos, *end, *version, *run, *e_key, *e_stamp, *e_reply;
+	size_t key_len, size, version_len, run_len, e_key_len, e_stamp_len, e_reply_len;
+	SEXP_t *s_sys = NULL;
+
+	key = cache_sexp_str(s_key, &key_len);
+	if (key == NULL)
+		return NULL;
+
+	cache_entry_path(cache, key, key_len, path, sizeof path);
+	buf = cache_entry_read(path, &size);
+
+	if (buf != NULL) {
+		pos = buf;
+		end = buf + size;
+
+		/* entries written by other versions of the library are ignored */
+		if ((version = cache_entry_field(&pos, end, CACHE_MAGIC, &version_len)) != NULL &&
+		    oscap_streq(version, oscap_get_version()) &&
+		    (run = cache_entry_field(&pos, end, "run", &run_len)) != NULL &&
+		    (e_key = cache_entry_field(&pos, end, "key", &e_key_len)) != NULL &&
+		    (e_stamp = cache_entry_field(&pos, end, "stamp", &e_stamp_len)) != NULL &&
+		    (e_reply = cache_entry_field(&pos, end, "reply", &e_reply_len)) != NULL &&
+		    e_key_len == key_len && memcmp(e_key, key, key_len) == 0 &&
+		    e_stamp_len == strlen(stamp) && memcmp(e_stamp, stamp, e_stamp_len) == 0) {
+			s_sys = cache_str_sexp(e_reply, e_reply_len);
+
+			if (s_sys != NULL)
+				cache_renumber_items(cache, run, s_sys);
+		}
+
+		free(buf);
+	}
+
+	free(key);
+
+	if (s_sys != NULL)
+		__sync_fetch_and_add(&cache->hits, 1);
+	else
+		__sync_fetch_and_add(&cache->misses, 1);
+
+	return s_sys;
+}
+
+static int cache_write(int fd, const char *data, size_t len)
+{
+	ssize_t n;
+
+	while (len > 0) {
+		n = write(fd, data, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		data += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static int cache_write_field(int fd, const char *name, const char *data, size_t len)
+{
+	char hdr[128];
+
+	snprintf(hdr, sizeof hdr, "%s %zu\n", name, len);
+
+	if (cache_write(fd, hdr, strlen(hdr)) != 0 ||
+	    cache_write(fd, data, len) != 0 ||
+	    cache_write(fd, "\n", 1) != 0)
+		return -1;
+
+	return 0;
+}
+
+void oval_probe_cache_put(struct oval_probe_cache *cache, const SEXP_t *s_key, const char *stamp, const SEXP_t *s_sys)
+{
+	char path[PATH_MAX], tmp[PATH_MAX + 16], *key, *reply;
+	const char *version;
+	size_t key_len, reply_len;
+	int fd, ret;
+
+	switch (probe_cobj_get_flag(s_sys)) {
+	case SYSCHAR_FLAG_COMPLETE:
+	case SYSCHAR_FLAG_DOES_NOT_EXIST:
+		break;
+	default:
+		return;
+	}
+
+	key = cache_sexp_str(s_key, &key_len);
+	reply = cache_sexp_str(s_sys, &reply_len);
+
+	if (key == NULL || reply == NULL) {
+		free(key);
+		free(reply);
+		return;
+	}
+
+	cache_entry_path(cache, key, key_len, path, sizeof path);
+	snprintf(tmp, sizeof tmp, "%s.XXXXXX", path);
+
+	/* write a new file and move it over the old entry */
+	fd = mkstemp(tmp);
+	if (fd < 0) {
+		dW("Can't create object cache entry '%s': %s", tmp, strerror(errno));
+		free(key);
+		free(reply);
+		return;
+	}
+
+	version = oscap_get_version();
+	ret = cache_write_field(fd, CACHE_MAGIC, version, strlen(version));
+	if (ret == 0)
+		ret = cache_write_field(fd, "run", cache->run, strlen(cache->run));
+	if (ret == 0)
+		ret = cache_write_field(fd, "key", key, key_len);
+	if (ret == 0)
+		ret = cache_write_field(fd, "stamp", stamp, strlen(stamp));
+	if (ret == 0)
+		ret = cache_write_field(fd, "reply", reply, reply_len);
+	if (close(fd) != 0)
+		ret = -1;
+
+	if (ret != 0 || rename(tmp, path) != 0) {
+		dW("Can't write object cache entry '%s': %s", path, strerror(errno));
+		unlink(tmp);
+	} else {
+		__sync_fetch_and_add(&cache->stores, 1);
+	}
+
+	free(key);
+	free(reply);
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef OVAL_PROBE_CACHE_H
+#define OVAL_PROBE_CACHE_H
+
+#include <sexp.h>
+#include "public/oval_definitions.h"
+
+struct oval_probe_cache;
+
+/**
+ * Open the object cache kept in the directory dir. The directory is
+ * created if it doesn't exist; it must be owned by the effective user
+ * and must not be writable by anybody else.
+ * @return the cache, NULL if the directory can't be used
+ */
+struct oval_probe_cache *oval_probe_cache_new(const char *dir);
+void oval_probe_cache_free(struct oval_probe_cache *cache);
+
+/**
+ * Describe the state of the files or databases the object is collected
+ * from. The object must be converted to an S-exp first so that the
+ * variables it references are evaluated.
+ * @return validity stamp of the object (to be freed by the caller),
+ * NULL if the object can't be cached
+ */
+char *oval_probe_cache_stamp(struct oval_object *object);
+
+/**
+ * Look up the probe reply stored for the object.
+ * @param s_key the object as sent to the probe, followed by the states
+ * used by its filters
+ * @param stamp current validity stamp of the object
+ * @return the reply, NULL if there is none or if it was stored with
+ * a different stamp
+ */
+SEXP_t *oval_probe_cache_get(struct oval_probe_cache *cache, const SEXP_t *s_key, const char *stamp);
+
+/**
+ * Store the probe reply for the object. Replies of objects which were
+ * not fully collected are not stored.
+ * @param stamp validity stamp taken before the object was sent to the probe
+ */
+void oval_probe_cache_put(struct oval_probe_cache *cache, const SEXP_t *s_key, const char *stamp, const SEXP_t *s_sys);
+
+#endif /* OVAL_PROBE_CACHE_H */
@@ -41,6 +41,7 @@
 #include "common/debug_priv.h"
 #include "probes/public/probe-api.h"
 #include "oval_probe_ext.h"
+#include "oval_probe_cache.h"
 #include "oval_sexp.h"
 #include "oval_probe_meta.h"
 
@@ -55,18 +56,33 @@ static void          oval_pdtbl_free(oval_pdtbl_t *table);
 static int           oval_pdtbl_add(oval_pdtbl_t *table, oval_subtype_t type, int sd, const char *uri);
 static oval_pd_t    *oval_pdtbl_get(oval_pdtbl_t *table, oval_subtype_t type);
 
+static bool oval_pext_pool_put(oval_pext_t *pext);
+static bool oval_pext_pool_get(oval_pext_t *pext);
+
 /*
  * oval_pext_
  */
 oval_pext_t *oval_pext_new(void)
 {
         oval_pext_t *pext;
+        pthread_mutexattr_t mutex_attr;
 
         pext = oscap_talloc(oval_pext_t);
 
         pext->do_init = true;
+        pext->aborted = false;
         pthread_mutex_init(&pext->lock, NULL);
 
+        /*
+         * The model lock may be re-acquired by the same thread when a probe
+         * asks the library to evaluate an object or a state while the reply
+         * to another object is being processed.
+         */
+        pthread_mutexattr_init(&mutex_attr);
+        pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&pext->model_lock, &mutex_attr);
+        pthread_mutexattr_destroy(&mutex_attr);
+
 #if defined(OVAL_PROBEDIR_ENV)
         pext->probe_dir = getenv("OVAL_PROBE_DIR");
 #else
@@ -78,6 +94,7 @@ oval_pext_t *oval_pext_new(void)
         pext->pdtbl     = NULL;
         pext->pdsc      = NULL;
         pext->pdsc_cnt  = 0;
+        pext->cache     = NULL;
 
         return(pext);
 }
@@ -85,14 +102,18 @@ oval_pext_t *oval_pext_new(void)
 void oval_pext_free(oval_pext_t *pext)
 {
         if (!pext->do_init) {
-                /* free structs */
-		free(pext->pdsc);
+                /* keep the probes running if requested, free structs otherwise */
+                if (!oval_pext_pool_put(pext)) {
+                        free(pext->pdsc);
+                        oval_pdtbl_free(pext->pdtbl);
+                }
 		pext->pdsc     = NULL;
 		pext->pdsc_cnt = 0;
-                oval_pdtbl_free(pext->pdtbl);
+                pext->pdtbl    = NULL;
         }
 
         pthread_mutex_destroy(&pext->lock);
+        pthread_mutex_destroy(&pext->model_lock);
         free(pext);
 }
 
@@ -107,6 +128,7 @@ static oval_pdtbl_t *oval_pdtbl_new(void)
 	p_tbl->memb = NULL;
 	p_tbl->count = 0;
 	p_tbl->ctx = SEAP_CTX_new();
+	p_tbl->pext = NULL;
 
 	return (p_tbl);
 }
@@ -187,15 +209,22 @@ static int oval_probe_cmd_init(oval_pext_t *pext)
 {
         assume_d (pext != NULL, -1);
 
+	/*
+	 * The commands get the probe descriptor table rather than the session,
+	 * as the table and the running probes may be handed over to another
+	 * session, see oval_pext_pool_get.
+	 */
+	pext->pdtbl->pext = pext;
+
 	if (SEAP_cmd_register(pext->pdtbl->ctx, PROBECMD_OBJ_EVAL, SEAP_CMDREG_USEARG,
-                              &oval_probe_cmd_obj_eval, (void *)pext) != 0)
+                              &oval_probe_cmd_obj_eval, (void *)pext->pdtbl) != 0)
         {
 		dE("Can't register command: %s: errno=%u, %s.", "obj_eval", errno, strerror(errno));
 		return (-1);
 	}
 
 	if (SEAP_cmd_register(pext->pdtbl->ctx, PROBECMD_STE_FETCH, SEAP_CMDREG_USEARG,
-			      &oval_probe_cmd_ste_fetch, (void *)pext) != 0) {
+			      &oval_probe_cmd_ste_fetch, (void *)pext->pdtbl) != 0) {
 		dE("Can't register command: %s: errno=%u, %s.", "ste_fetch", errno, strerror(errno));
 
 		/* FIXME: unregister the first command */
@@ -212,7 +241,7 @@ static SEXP_t *oval_probe_cmd_obj_eval(SEXP_t *sexp, void *arg)
 	struct oval_definition_model *defs;
 	struct oval_object  *obj;
 	struct oval_syschar *res;
-	oval_pext_t *pext = (oval_pext_t *) arg;
+	oval_pext_t *pext = ((oval_pdtbl_t *) arg)->pext;
 	SEXP_t *ret, *ret_code;
 	int r;
 
@@ -240,7 +269,9 @@ static SEXP_t *oval_probe_cmd_obj_eval(SEXP_t *sexp, void *arg)
 	}
 
 	oscap_clearerr();
+	pthread_mutex_lock(&pext->model_lock);
 	r = oval_probe_query_object(pext->sess_ptr, obj, OVAL_PDFLAG_NOREPLY|OVAL_PDFLAG_SLAVE, &res);
+	pthread_mutex_unlock(&pext->model_lock);
 	if (r < 0)
 		ret_code = SEXP_number_newu((unsigned int) SYSCHAR_FLAG_COMPLETE);
 	else
@@ -270,7 +301,7 @@ static SEXP_t *oval_probe_cmd_ste_fetch(SEXP_t *sexp, void *arg)
 	char *id_str;
 	struct oval_state *ste;
 	struct oval_definition_model *definition_model;
-	oval_pext_t *pext = (oval_pext_t *)arg;
+	oval_pext_t *pext = ((oval_pdtbl_t *)arg)->pext;
 	int ret;
 
         assume_d (sexp != NULL, NULL);
@@ -293,7 +324,9 @@ static SEXP_t *oval_probe_cmd_ste_fetch(SEXP_t *sexp, void *arg)
 				return (NULL);
 			}
 
+			pthread_mutex_lock(&pext->model_lock);
 			ret = oval_state_to_sexp(pext->sess_ptr, ste, &ste_sexp);
+			pthread_mutex_unlock(&pext->model_lock);
 			if (ret !=0) {
 				dE("Failed to convert OVAL state to SEXP, id: %s.",
 					       id_str);
@@ -612,6 +645,37 @@ static oval_pdsc_t *oval_pdsc_lookup(oval_pdsc_t pdsc[], int count, oval_subtype
                            (int (*)(void *, void *))oval_pdsc_typecmp);
 }
 
+/*
+ * The probes named in OSCAP_PROBE_SHM (a comma separated list, or "all")
+ * exchange data with the library through shared memory instead of a pipe.
+ */
+static const char *oval_probe_scheme(const oval_pdsc_t *dsc)
+{
+	const char *list, *end;
+	size_t len, name_len;
+
+	list = getenv("OSCAP_PROBE_SHM");
+
+	if (list == NULL)
+		return OVAL_PROBE_SCHEME;
+	if (strcmp(list, "all") == 0)
+		return OVAL_PROBE_SCHEME_SHM;
+
+	name_len = strlen(dsc->name);
+
+	for (;;) {
+		end = strchr(list, ',');
+		len = end != NULL ? (size_t)(end - list) : strlen(list);
+
+		if (len == name_len && strncmp(list, dsc->name, len) == 0)
+			return OVAL_PROBE_SCHEME_SHM;
+		if (end == NULL)
+			return OVAL_PROBE_SCHEME;
+
+		list = end + 1;
+	}
+}
+
 static int oval_probe_sys_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, struct oval_syschar_model *model, struct oval_sysinfo **out_sysinf)
 {
 	struct oval_sysinfo *sysinf;
@@ -788,7 +852,7 @@ int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...)
 		}
 
                 probe_urilen = snprintf(probe_uri, sizeof probe_uri,
-                                        "%s://%s/%s", OVAL_PROBE_SCHEME, probe_dir, probe_dsc->file);
+                                        "%s://%s/%s", oval_probe_scheme(probe_dsc), probe_dir, probe_dsc->file);
 
                 if (probe_urilen >= sizeof probe_uri) {
                         oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
@@ -817,6 +881,137 @@ int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...)
         return(ret);
 }
 
+/*
+ * Register the probe of the given subtype unless it's already registered.
+ * The probe process is started by the first connection to it and becomes
+ * a child of the connecting thread, see PR_SET_PDEATHSIG in
+ * probes/probe/signal_handler.c.
+ * @return 0 on success, 1 if the subtype is not supported, -1 on error
+ */
+static int oval_probe_ext_open(oval_pext_t *pext, oval_subtype_t type)
+{
+	char         probe_uri[PATH_MAX + 1];
+	size_t       probe_urilen;
+	oval_pdsc_t *probe_dsc;
+
+	if (oval_pdtbl_get(pext->pdtbl, type) != NULL)
+		return (0);
+
+	probe_dsc = oval_pdsc_lookup(pext->pdsc, pext->pdsc_cnt, type);
+
+	if (probe_dsc == NULL)
+		return (1);
+
+	probe_urilen = snprintf(probe_uri, sizeof probe_uri,
+	                        "%s://%s/%s", oval_probe_scheme(probe_dsc), pext->probe_dir, probe_dsc->file);
+
+	if (probe_urilen >= sizeof probe_uri) {
+		oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
+		return (-1);
+	}
+
+	dI("Starting probe on URI '%s'.", probe_uri);
+
+	if (oval_pdtbl_add(pext->pdtbl, type, -1, probe_uri) != 0)
+		return (1);
+
+	return (0);
+}
+
+/*
+ * The probe fetches the states of the filters by their IDs, so the states
+ * are added to the object to form its key in the object cache. The caller
+ * must hold the model lock.
+ * @return the key, NULL if a state can't be converted
+ */
+static SEXP_t *oval_probe_ext_cache_key(oval_pext_t *pext, struct oval_object *object, SEXP_t *s_obj)
+{
+	struct oval_object_content_iterator *cit;
+	struct oval_filter *filter;
+	SEXP_t *s_key, *s_ste;
+
+	s_key = SEXP_list_new(s_obj, NULL);
+
+	cit = oval_object_get_object_contents(object);
+	while (oval_object_content_iterator_has_more(cit)) {
+		struct oval_object_content *content = oval_object_content_iterator_next(cit);
+
+		if (oval_object_content_get_type(content) != OVAL_OBJECTCONTENT_FILTER)
+			continue;
+
+		filter = oval_object_content_get_filter(content);
+
+		if (oval_state_to_sexp(pext->sess_ptr, oval_filter_get_state(filter), &s_ste) != 0) {
+			SEXP_free(s_key);
+			s_key = NULL;
+			break;
+		}
+
+		SEXP_list_add(s_key, s_ste);
+		SEXP_free(s_ste);
+	}
+	oval_object_content_iterator_free(cit);
+
+	return (s_key);
+}
+
+/*
+ * Look the object up in the object cache. On a miss, the object converted
+ * to an S-exp and its validity stamp are passed on to oval_probe_ext_eval.
+ * @return 0 if the syschar was filled in, 1 if the probe has to be queried
+ */
+static int oval_probe_ext_cached(oval_pext_t *pext, struct oval_syschar *syschar, SEXP_t **out_obj, char **out_stamp)
+{
+	struct oval_object *object;
+	SEXP_t *s_obj, *s_sys, *s_skip, *s_key = NULL;
+	char *stamp;
+	int ret;
+
+	object = oval_syschar_get_object(syschar);
+
+	pthread_mutex_lock(&pext->model_lock);
+	ret = oval_object_to_sexp(pext->sess_ptr, oval_subtype_to_str(oval_object_get_subtype(object)), syschar, &s_obj);
+
+	if (ret != 0) {
+		pthread_mutex_unlock(&pext->model_lock);
+		return (0);
+	}
+
+	/* objects referencing variables without values are not collected */
+	s_skip = probe_obj_getattrval(s_obj, "skip_eval");
+	stamp  = s_skip == NULL ? oval_probe_cache_stamp(object) : NULL;
+	SEXP_free(s_skip);
+
+	if (stamp != NULL && (s_key = oval_probe_ext_cache_key(pext, object, s_obj)) == NULL) {
+		free(stamp);
+		stamp = NULL;
+	}
+	pthread_mutex_unlock(&pext->model_lock);
+
+	if (stamp != NULL) {
+		s_sys = oval_probe_cache_get(pext->cache, s_key, stamp);
+		SEXP_free(s_key);
+
+		if (s_sys != NULL) {
+			dI("Using the object cache for object '%s'.", oval_object_get_id(object));
+
+			pthread_mutex_lock(&pext->model_lock);
+			ret = oval_sexp_to_sysch(s_sys, syschar);
+			pthread_mutex_unlock(&pext->model_lock);
+
+			SEXP_vfree(s_obj, s_sys, NULL);
+			free(stamp);
+
+			return (ret == 0 ? 0 : -1);
+		}
+	}
+
+	*out_obj   = s_obj;
+	*out_stamp = stamp;
+
+	return (1);
+}
+
 int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 {
         int          ret = 0;
@@ -831,63 +1026,62 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
         {
 		struct oval_object *obj;
 		struct oval_syschar *sys;
+		SEXP_t *s_obj = NULL;
+		char *stamp = NULL;
 		int flags;
 
 		sys = va_arg(ap, struct oval_syschar *);
 		flags = va_arg(ap, int);
 		obj = oval_syschar_get_object(sys);
-                pd = oval_pdtbl_get(pext->pdtbl, oval_object_get_subtype(obj));
 
-                if (pd == NULL) {
-                        char         probe_uri[PATH_MAX + 1];
-                        size_t       probe_urilen;
-                        char        *probe_dir;
-                        oval_pdsc_t *probe_dsc;
-
-                        probe_dir = pext->probe_dir;
-                        probe_dsc = oval_pdsc_lookup(pext->pdsc, pext->pdsc_cnt, oval_object_get_subtype(obj));
+		/* objects found in the object cache don't need their probe */
+		if (pext->cache != NULL && !(flags & OVAL_PDFLAG_NOREPLY)) {
+			ret = oval_probe_ext_cached(pext, sys, &s_obj, &stamp);
 
-			if (probe_dsc == NULL) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
+			if (ret <= 0) {
 				va_end(ap);
-				return (1);
+				return (ret);
 			}
+		}
 
-                        probe_urilen = snprintf(probe_uri, sizeof probe_uri,
-                                                "%s://%s/%s", OVAL_PROBE_SCHEME, probe_dir, probe_dsc->file);
-
-                        if (probe_urilen >= sizeof probe_uri) {
-                                oscap_seterr (OSCAP_EFAMILY_GLIBC, "probe URI too long");
-				va_end(ap);
-                                return (-1);
-                        }
-
-                        dI("Starting probe on URI '%s'.", probe_uri);
+		/*
+		 * The probe descriptor table is shared by all threads collecting
+		 * objects on behalf of this session, see oval_probe_prefetch.c
+		 */
+		pthread_mutex_lock(&pext->lock);
+		ret = oval_probe_ext_open(pext, oval_object_get_subtype(obj));
+
+		if (ret == 1) {
+			oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
+			oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
+			pthread_mutex_unlock(&pext->lock);
+			SEXP_free(s_obj);
+			free(stamp);
+			va_end(ap);
+			return (1);
+		}
 
-                        if (oval_pdtbl_add(pext->pdtbl, oval_object_get_subtype(obj), -1, probe_uri) != 0) {
-				oval_syschar_add_new_message(sys, "OVAL object not supported", OVAL_MESSAGE_LEVEL_WARNING);
-				oval_syschar_set_flag(sys, SYSCHAR_FLAG_NOT_COLLECTED);
-				va_end(ap);
-                                return (1);
-			}
+		pd = ret == 0 ? oval_pdtbl_get(pext->pdtbl, oval_object_get_subtype(obj)) : NULL;
 
-			pd = oval_pdtbl_get(pext->pdtbl, oval_object_get_subtype(obj));
+		if (pd == NULL) {
+			if (ret == 0)
+				oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
+			pthread_mutex_unlock(&pext->lock);
+			SEXP_free(s_obj);
+			free(stamp);
+			va_end(ap);
+			return (-1);
+		}
 
-                        if (pd == NULL) {
-                                oscap_seterr (OSCAP_EFAMILY_OVAL, "internal error");
-				va_end(ap);
-                                return (-1);
-                        }
-                }
+		pthread_mutex_unlock(&pext->lock);
 
-		ret = oval_probe_ext_eval(pext->pdtbl->ctx, pd, pext, sys, flags);
+		ret = oval_probe_ext_eval(pext->pdtbl->ctx, pd, pext, sys, s_obj, stamp, flags);
 
 		if (ret >= 0)
 			ret = 0;
 
 		if (ret < 0 && errno == ECONNABORTED) {
-			if (!(flags & OVAL_PDFLAG_SLAVE)) {
+			if (!(flags & (OVAL_PDFLAG_SLAVE|OVAL_PDFLAG_NORECONN))) {
 				if (!pext->do_init) {
 					oval_pdtbl_free(pext->pdtbl);
 				}
@@ -907,6 +1101,26 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
 		return ret;
         }
         case PROBE_HANDLER_ACT_OPEN:
+		/* start the probe and connect to it right away */
+		pthread_mutex_lock(&pext->lock);
+		ret = oval_probe_ext_open(pext, type);
+
+		if (ret == 0) {
+			pd = oval_pdtbl_get(pext->pdtbl, type);
+
+			if (pd != NULL && pd->sd == -1) {
+				pd->sd = SEAP_connect(pext->pdtbl->ctx, pd->uri, 0);
+
+				if (pd->sd < 0) {
+					protect_errno {
+						dW("Can't connect: %u, %s.", errno, strerror(errno));
+					}
+					pd->sd = -1;
+					ret = -1;
+				}
+			}
+		}
+		pthread_mutex_unlock(&pext->lock);
                 break;
         case PROBE_HANDLER_ACT_INIT:
                 ret = oval_probe_ext_init(pext);
@@ -914,6 +1128,9 @@ int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...)
         case PROBE_HANDLER_ACT_RESET:
 	case PROBE_HANDLER_ACT_ABORT:
         {
+		if (act == PROBE_HANDLER_ACT_ABORT)
+			pext->aborted = true;
+
                 if (type == OVAL_SUBTYPE_ALL) {
                         /*
                          * Iterate thru probe descriptor table and execute the reset operation
@@ -980,6 +1197,11 @@ int oval_probe_ext_init(oval_pext_t *pext)
 		struct stat st;
 		register unsigned int i, r;
 
+		if (oval_pext_pool_get(pext)) {
+			pext->do_init = false;
+			goto _ret;
+		}
+
 		if (getcwd(curdir, PATH_MAX) == NULL) {
 			dE("getcwd() failed");
                         ret = -1;
@@ -1047,25 +1269,56 @@ _ret:
         return(ret);
 }
 
-int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags)
+/*
+ * Send the object to its probe and fill in the syschar from the reply.
+ * The object is converted here unless oval_probe_ext_cached already did
+ * it (s_obj != NULL); the reply is stored in the object cache if a stamp
+ * is given. Both s_obj and stamp are freed.
+ */
+int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar,
+			SEXP_t *s_obj, char *stamp, int flags)
 {
-        SEXP_t *s_obj, *s_sys;
+        SEXP_t *s_sys;
 	struct oval_object *object;
 	int ret;
 
 	if (syschar == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OVAL, "Internal error: syschar == NULL");
+		SEXP_free(s_obj);
+		free(stamp);
 		return (-1);
 	}
 
 	object = oval_syschar_get_object(syschar);
-	ret = oval_object_to_sexp(pext->sess_ptr, oval_subtype_to_str(oval_object_get_subtype(object)), syschar, &s_obj);
 
-	if (ret != 0)
-		return (1);
+	if (s_obj == NULL) {
+		pthread_mutex_lock(&pext->model_lock);
+		ret = oval_object_to_sexp(pext->sess_ptr, oval_subtype_to_str(oval_object_get_subtype(object)), syschar, &s_obj);
+		pthread_mutex_unlock(&pext->model_lock);
+
+		if (ret != 0) {
+			free(stamp);
+			return (1);
+		}
+	}
 
 	ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+
+	if (ret == 0 && stamp != NULL && s_sys != NULL) {
+		SEXP_t *s_key;
+
+		pthread_mutex_lock(&pext->model_lock);
+		s_key = oval_probe_ext_cache_key(pext, object, s_obj);
+		pthread_mutex_unlock(&pext->model_lock);
+
+		if (s_key != NULL) {
+			oval_probe_cache_put(pext->cache, s_key, stamp, s_sys);
+			SEXP_free(s_key);
+		}
+	}
+
 	SEXP_free(s_obj);
+	free(stamp);
 
 	if (ret != 0) {
 		switch (errno) {
@@ -1094,24 +1347,54 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
         /*
 	 * Convert the received S-exp to OVAL system characteristic.
 	 */
+	pthread_mutex_lock(&pext->model_lock);
 	ret = oval_sexp_to_sysch(s_sys, syschar);
+	pthread_mutex_unlock(&pext->model_lock);
 	SEXP_free(s_sys);
 
 	return (ret);
 }
 
+static int oval_probe_ext_send_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, uint32_t flags)
+{
+        SEXP_t *res;
+
+        if (pd->sd == -1)
+                return (0);
+
+        res = SEAP_cmd_exec(ctx, pd->sd, flags, PROBECMD_RESET, NULL, SEAP_CMDTYPE_SYNC, NULL, NULL);
+
+        /* the probe acknowledges the reset with a non-NULL reply */
+        if (res == NULL) {
+                dW("Reset of the probe at sd=%d failed", pd->sd);
+                return (-1);
+        }
+
+        SEXP_free(res);
+        return (0);
+}
+
+/*
+ * The reset succeeds even if the probe doesn't acknowledge it, as it always
+ * did. Such a probe is replaced by the health check once its table is taken
+ * from the keepalive pool, see oval_pext_pool_get().
+ */
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 {
-        SEAP_cmd_exec(ctx, pd->sd, SEAP_EXEC_RECV, PROBECMD_RESET, NULL, SEAP_CMDTYPE_SYNC, NULL, NULL);
+        if (oval_probe_ext_send_reset(ctx, pd, SEAP_EXEC_RECV) != 0)
+                dW("Probe %s at sd=%d didn't acknowledge the reset, it will be replaced when reused.",
+                   oval_subtype_to_str(pd->subtype), pd->sd);
 
         return (0);
 }
 
 #include <signal.h>
+#include <sys/wait.h>
 #include "SEAP/_seap-types.h"
 #include "SEAP/seap-descriptor.h"
 #include "SEAP/_seap-scheme.h"
 #include "SEAP/sch_pipe.h"
+#include "SEAP/sch_shm.h"
 
 int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 {
@@ -1150,6 +1433,224 @@ int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 	return (0);
 }
 
+/*
+ * Returns the pid of the probe process, 0 if it isn't known and -1 if
+ * there's no such descriptor.
+ */
+static pid_t oval_probe_ext_pid(SEAP_CTX_t *ctx, oval_pd_t *pd)
+{
+	SEAP_desc_t *dsc;
+
+	dsc = SEAP_desc_get(ctx->sd_table, pd->sd);
+
+	if (dsc == NULL)
+		return (-1);
+
+	switch (dsc->scheme) {
+	case SCH_PIPE:
+		return (((sch_pipedata_t *)dsc->scheme_data)->pid);
+	case SCH_SHM:
+		return (((sch_shmdata_t *)dsc->scheme_data)->pipe.pid);
+	default:
+		return (0);
+	}
+}
+
+/*
+ * Returns false if the process of the probe is known to have exited.
+ */
+static bool oval_probe_ext_alive(SEAP_CTX_t *ctx, oval_pd_t *pd)
+{
+	siginfo_t info;
+	pid_t pid;
+
+	pid = oval_probe_ext_pid(ctx, pd);
+
+	if (pid < 0)
+		return (false);
+	if (pid == 0)
+		return (true);
+
+	/* don't reap the child, SEAP_close does that */
+	info.si_pid = 0;
+	if (waitid(P_PID, pid, &info, WEXITED|WNOHANG|WNOWAIT) != 0 ||
+	    info.si_pid != 0)
+		return (false);
+
+	return (true);
+}
+
+/*
+ * Replace a pooled probe which exited or doesn't respond by a fresh one.
+ * The probe is killed first, a hung probe might not react to SIGTERM sent
+ * by SEAP_close. If the new probe can't be started, it's started again
+ * on demand.
+ */
+static void oval_probe_ext_respawn(SEAP_CTX_t *ctx, oval_pd_t *pd)
+{
+	pid_t pid;
+
+	pid = oval_probe_ext_pid(ctx, pd);
+
+	if (pid > 0 && kill(pid, SIGKILL) != 0)
+		dW("kill(%ld, SIGKILL): %u, %s", (long)pid, errno, strerror(errno));
+
+	SEAP_close(ctx, pd->sd);
+	pd->sd = SEAP_connect(ctx, pd->uri, 0);
+
+	if (pd->sd < 0) {
+		dW("Can't restart the probe %s: %u, %s",
+		   oval_subtype_to_str(pd->subtype), errno, strerror(errno));
+		pd->sd = -1;
+	}
+}
+
+/*
+ * Probe keepalive pool. When enabled, the probe descriptor table of a
+ * destroyed session is not closed, the probes are kept running and the
+ * table is handed over to the next session which is initialized with the
+ * same probe directory and the same OSCAP_PROBE_ROOT. Sessions don't have
+ * to start the probe processes and go through the SEAP handshakes again.
+ *
+ * The probes are still terminated once the thread which started them
+ * exits, see PR_SET_PDEATHSIG in probes/probe/signal_handler.c. Such
+ * probes are detected when the table is taken from the pool and they
+ * are started again on demand.
+ */
+#define OVAL_PEXT_POOL_MAX 8
+
+typedef struct {
+	oval_pdtbl_t *pdtbl;
+	oval_pdsc_t  *pdsc;
+	size_t        pdsc_cnt;
+	char         *probe_dir;
+	char         *probe_root;
+} oval_pext_idle_t;
+
+static struct {
+	pthread_mutex_t  lock;
+	bool             keepalive;
+	size_t           count;
+	oval_pext_idle_t idle[OVAL_PEXT_POOL_MAX];
+} oval_pext_pool = { PTHREAD_MUTEX_INITIALIZER, false, 0, {{ NULL, NULL, 0, NULL, NULL }} };
+
+static void oval_pext_idle_free(oval_pext_idle_t *idle)
+{
+	oval_pdtbl_free(idle->pdtbl);
+	free(idle->pdsc);
+	free(idle->probe_dir);
+	free(idle->probe_root);
+}
+
+static bool oval_pext_pool_put(oval_pext_t *pext)
+{
+	oval_pext_idle_t *idle;
+	bool ret = false;
+
+	pthread_mutex_lock(&oval_pext_pool.lock);
+
+	if (oval_pext_pool.keepalive && !pext->aborted && pext->pdtbl != NULL &&
+	    oval_pext_pool.count < OVAL_PEXT_POOL_MAX)
+	{
+		idle = oval_pext_pool.idle + oval_pext_pool.count++;
+		idle->pdtbl      = pext->pdtbl;
+		idle->pdsc       = pext->pdsc;
+		idle->pdsc_cnt   = pext->pdsc_cnt;
+		idle->probe_dir  = oscap_strdup(pext->probe_dir);
+		idle->probe_root = oscap_strdup(getenv("OSCAP_PROBE_ROOT"));
+		idle->pdtbl->pext = NULL;
+
+		dI("Keeping %zu probes alive, %zu idle tables.", idle->pdtbl->count, oval_pext_pool.count);
+		ret = true;
+	}
+
+	pthread_mutex_unlock(&oval_pext_pool.lock);
+
+	return (ret);
+}
+
+static bool oval_pext_pool_get(oval_pext_t *pext)
+{
+	oval_pext_idle_t idle;
+	size_t i;
+
+	pthread_mutex_lock(&oval_pext_pool.lock);
+
+	/* the most recently released table first */
+	for (i = oval_pext_pool.count; i > 0; --i) {
+		if (oscap_streq(oval_pext_pool.idle[i - 1].probe_dir, pext->probe_dir) &&
+		    oscap_streq(oval_pext_pool.idle[i - 1].probe_root, getenv("OSCAP_PROBE_ROOT")))
+			break;
+	}
+
+	if (i == 0) {
+		pthread_mutex_unlock(&oval_pext_pool.lock);
+		return (false);
+	}
+
+	idle = oval_pext_pool.idle[i - 1];
+	oval_pext_pool.idle[i - 1] = oval_pext_pool.idle[--oval_pext_pool.count];
+
+	pthread_mutex_unlock(&oval_pext_pool.lock);
+
+	pext->pdtbl       = idle.pdtbl;
+	pext->pdsc        = idle.pdsc;
+	pext->pdsc_cnt    = idle.pdsc_cnt;
+	pext->pdtbl->pext = pext;
+
+	/*
+	 * Health check: replace the probes which exited or don't respond
+	 * and clear the state left by the previous session in the others.
+	 * A pooled probe is idle, so it has to acknowledge the reset within
+	 * the receive timeout of the SEAP context.
+	 */
+	for (i = 0; i < pext->pdtbl->count; ++i) {
+		oval_pd_t *pd = pext->pdtbl->memb[i];
+
+		if (pd->sd == -1)
+			continue;
+
+		if (!oval_probe_ext_alive(pext->pdtbl->ctx, pd) ||
+		    oval_probe_ext_send_reset(pext->pdtbl->ctx, pd, SEAP_EXEC_RECV|SEAP_EXEC_TIMEOUT) != 0)
+		{
+			dI("Probe %s at sd=%d is not alive, restarting it.",
+			   oval_subtype_to_str(pd->subtype), pd->sd);
+			oval_probe_ext_respawn(pext->pdtbl->ctx, pd);
+		}
+	}
+
+	free(idle.probe_dir);
+	free(idle.probe_root);
+
+	dI("Reusing %zu running probes.", pext->pdtbl->count);
+	return (true);
+}
+
+void oval_probe_ext_set_keepalive(bool keepalive)
+{
+	pthread_mutex_lock(&oval_pext_pool.lock);
+	oval_pext_pool.keepalive = keepalive;
+	pthread_mutex_unlock(&oval_pext_pool.lock);
+
+	if (!keepalive)
+		oval_probe_ext_close_idle();
+}
+
+void oval_probe_ext_close_idle(void)
+{
+	oval_pext_idle_t idle[OVAL_PEXT_POOL_MAX];
+	size_t i, count;
+
+	pthread_mutex_lock(&oval_pext_pool.lock);
+	count = oval_pext_pool.count;
+	memcpy(idle, oval_pext_pool.idle, count * sizeof(oval_pext_idle_t));
+	oval_pext_pool.count = 0;
+	pthread_mutex_unlock(&oval_pext_pool.lock);
+
+	for (i = 0; i < count; ++i)
+		oval_pext_idle_free(idle + i);
+}
+
 const char *oval_probe_ext_getdir(void)
 {
     const char *probe_dir;
@@ -35,10 +35,14 @@ typedef struct {
 	char *uri;
 } oval_pd_t;
 
+struct oval_pext;
+struct oval_probe_cache;
+
 typedef struct {
 	oval_pd_t **memb;
 	size_t      count;
 	SEAP_CTX_t *ctx;
+	struct oval_pext *pext; /**< current owner, passed to the command handlers */
 } oval_pdtbl_t;
 
 struct oval_pdsc {
@@ -51,7 +55,9 @@ typedef struct oval_pdsc oval_pdsc_t;
 
 struct oval_pext {
         pthread_mutex_t lock;
+        pthread_mutex_t model_lock; /**< serializes updates of the system characteristics model */
         bool            do_init;
+        bool            aborted;  /**< the probes were aborted, don't keep them alive */
 
         SEAP_CTX_t   *sctx;
         oval_pdsc_t  *pdsc;
@@ -61,6 +67,7 @@ struct oval_pext {
 
         void *sess_ptr;
         struct oval_syschar_model **model;
+        struct oval_probe_cache *cache; /**< object cache of the probe session, NULL if disabled */
 };
 
 typedef struct oval_pext oval_pext_t;
@@ -68,10 +75,14 @@ typedef struct oval_pext oval_pext_t;
 oval_pext_t *oval_pext_new(void);
 void oval_pext_free(oval_pext_t *pext);
 int oval_probe_ext_init(oval_pext_t *pext);
-int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags);
+int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar,
+			SEXP_t *s_obj, char *stamp, int flags);
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 int oval_probe_ext_abort(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext);
 
+void oval_probe_ext_set_keepalive(bool keepalive);
+void oval_probe_ext_close_idle(void);
+
 int oval_probe_ext_handler(oval_subtype_t type, void *ptr, int act, ...);
 int oval_probe_sys_handler(oval_subtype_t type, void *ptr, int act, ...);
 
@@ -48,6 +48,7 @@
 OSCAP_HIDDEN_START;
 
 #define OVAL_PROBE_SCHEME "pipe"
+#define OVAL_PROBE_SCHEME_SHM "shm"
 
 #ifndef OVAL_PROBE_DIR
 # define OVAL_PROBE_DIR    "/usr/libexec/openscap"
@@ -72,5 +73,12 @@ oval_subtype_t oval_str_to_subtype(const char *str);
 
 int oval_probe_hint_definition(oval_probe_session_t *sess, struct oval_definition *definition, int variable_instance_hint);
 
+/**
+ * Collect the objects of the given definitions which don't depend on any variable
+ * ahead of the evaluation, using up to the given number of threads.
+ * @return 0 on success, -2 if the collection was aborted
+ */
+int oval_probe_prefetch_definitions(oval_probe_session_t *sess, struct oval_definition **defs, size_t count, unsigned int threads);
+
 #endif /* OVAL_PROBE_IMPL_H */
 /// @}
@@ -0,0 +1,468 @@
+/**
+ * @file oval_probe_prefetch.c
+ * \brief Parallel collection of independent OVAL objects
+ *
+ * Before a set of definitions is evaluated, the objects referenced by
+ * their tests can be collected ahead of time. Objects which do not
+ * depend on any variable are grouped by their subtype and each group
+ * is sent to its probe from a separate thread, so that several probe
+ * processes work at once. The regular (sequential) evaluation then
+ * finds these objects already collected.
+ *
+ * Each probe still receives its queries in the same order as during the
+ * sequential evaluation: once a query of a subtype can not be predicted
+ * (an object referencing a variable, a set object, a variable used in a
+ * state, ...), no further objects of that subtype are collected ahead.
+ */
+
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "public/oval_definitions.h"
+#include "public/oval_system_characteristics.h"
+#include "oval_system_characteristics_impl.h"
+#include "oval_probe_impl.h"
+#include "_oval_probe_session.h"
+#include "_oval_probe_handler.h"
+#include "collectVarRefs_impl.h"
+#include "adt/oval_string_map_impl.h"
+#include "common/_error.h"
+#include "common/debug_priv.h"
+
+/* Objects of one subtype, in the order in which they are sent to the probe */
+struct oval_prefetch_queue {
+	oval_subtype_t type;
+	bool closed;                    /* no further objects of this subtype may be queued */
+	oval_ph_t *ph;
+	struct oval_syschar **syschars;
+	size_t count;
+	size_t size;
+};
+
+struct oval_prefetch {
+	oval_probe_session_t *sess;
+	struct oval_string_map *definitions; /* definitions already walked */
+	struct oval_string_map *objects;     /* objects already walked */
+	struct oval_string_map *variables;   /* variables already walked */
+	struct oval_prefetch_queue *queues;
+	size_t queue_count;
+
+	pthread_mutex_t lock;
+	size_t next_queue;
+	bool aborted;
+};
+
+static struct oval_prefetch_queue *_prefetch_queue(struct oval_prefetch *pf, oval_subtype_t type)
+{
+	for (size_t i = 0; i < pf->queue_count; ++i) {
+		if (pf->queues[i].type == type)
+			return &pf->queues[i];
+	}
+
+	pf->queues = realloc(pf->queues, sizeof(struct oval_prefetch_queue) * (pf->queue_count + 1));
+
+	struct oval_prefetch_queue *q = &pf->queues[pf->queue_count++];
+	q->type = type;
+	q->closed = false;
+	q->ph = oval_probe_handler_get(pf->sess->ph, type);
+	q->syschars = NULL;
+	q->count = 0;
+	q->size = 0;
+
+	return q;
+}
+
+static void _prefetch_close_type(struct oval_prefetch *pf, oval_subtype_t type)
+{
+	struct oval_prefetch_queue *q = _prefetch_queue(pf, type);
+
+	if (!q->closed) {
+		dD("No more %s objects can be collected ahead.", oval_subtype_get_text(type));
+		q->closed = true;
+	}
+}
+
+static void _prefetch_close_variable(struct oval_prefetch *pf, struct oval_variable *var);
+
+static void _prefetch_close_object(struct oval_prefetch *pf, struct oval_object *obj)
+{
+	struct oval_string_map *vm;
+	struct oval_iterator *var_itr;
+
+	_prefetch_close_type(pf, oval_object_get_subtype(obj));
+
+	vm = oval_string_map_new();
+	oval_obj_collect_var_refs(obj, vm);
+	var_itr = oval_string_map_values(vm);
+	while (oval_collection_iterator_has_more(var_itr)) {
+		struct oval_variable *var = oval_collection_iterator_next(var_itr);
+		_prefetch_close_variable(pf, var);
+	}
+	oval_collection_iterator_free(var_itr);
+	oval_string_map_free(vm, NULL);
+}
+
+static void _prefetch_close_component(struct oval_prefetch *pf, struct oval_component *comp)
+{
+	struct oval_component_iterator *cmp_itr;
+
+	switch (oval_component_get_type(comp)) {
+	case OVAL_COMPONENT_OBJECTREF:
+		_prefetch_close_object(pf, oval_component_get_object(comp));
+		break;
+	case OVAL_COMPONENT_VARREF:
+		_prefetch_close_variable(pf, oval_component_get_variable(comp));
+		break;
+	default:
+		cmp_itr = oval_component_get_function_components(comp);
+		if (cmp_itr == NULL)
+			break;
+		while (oval_component_iterator_has_more(cmp_itr))
+			_prefetch_close_component(pf, oval_component_iterator_next(cmp_itr));
+		oval_component_iterator_free(cmp_itr);
+		break;
+	}
+}
+
+/*
+ * Evaluation of a variable queries all the objects it refers to (directly
+ * or through other variables) at a point which is not known in advance.
+ */
+static void _prefetch_close_variable(struct oval_prefetch *pf, struct oval_variable *var)
+{
+	const char *var_id = oval_variable_get_id(var);
+
+	if (oval_string_map_get_value(pf->variables, var_id) != NULL)
+		return;
+	oval_string_map_put(pf->variables, var_id, var);
+
+	if (oval_variable_get_type(var) == OVAL_VARIABLE_LOCAL) {
+		struct oval_component *comp = oval_variable_get_component(var);
+		if (comp != NULL)
+			_prefetch_close_component(pf, comp);
+	}
+}
+
+static bool _prefetch_object_is_independent(struct oval_object *obj)
+{
+	struct oval_object_content_iterator *cont_itr;
+	struct oval_string_map *vm;
+	struct oval_iterator *var_itr;
+	bool independent = true;
+
+	/* Set objects make the probe query the library back for their subobjects */
+	cont_itr = oval_object_get_object_contents(obj);
+	while (independent && oval_object_content_iterator_has_more(cont_itr)) {
+		struct oval_object_content *cont = oval_object_content_iterator_next(cont_itr);
+		if (oval_object_content_get_type(cont) == OVAL_OBJECTCONTENT_SET)
+			independent = false;
+	}
+	oval_object_content_iterator_free(cont_itr);
+
+	if (!independent)
+		return false;
+
+	vm = oval_string_map_new();
+	oval_obj_collect_var_refs(obj, vm);
+	var_itr = oval_string_map_values(vm);
+	independent = !oval_collection_iterator_has_more(var_itr);
+	oval_collection_iterator_free(var_itr);
+	oval_string_map_free(vm, NULL);
+
+	return independent;
+}
+
+static void _prefetch_object(struct oval_prefetch *pf, struct oval_object *obj)
+{
+	const char *obj_id = oval_object_get_id(obj);
+	oval_subtype_t type = oval_object_get_subtype(obj);
+	struct oval_prefetch_queue *q;
+	struct oval_syschar *sysc;
+
+	if (oval_string_map_get_value(pf->objects, obj_id) != NULL)
+		return;
+	oval_string_map_put(pf->objects, obj_id, obj);
+
+	if (!_prefetch_object_is_independent(obj)) {
+		_prefetch_close_object(pf, obj);
+		return;
+	}
+
+	q = _prefetch_queue(pf, type);
+	if (q->closed)
+		return;
+
+	sysc = oval_syschar_model_get_syschar(pf->sess->sys_model, obj_id);
+	if (sysc != NULL) {
+		if (oval_syschar_get_variable_instance_hint(sysc) == oval_syschar_get_variable_instance(sysc)
+		    && oval_syschar_get_flag(sysc) != SYSCHAR_FLAG_UNKNOWN) {
+			/* already collected, it won't be sent to the probe again */
+			return;
+		}
+		q->closed = true;
+		return;
+	}
+
+	if (q->ph == NULL) {
+		/* leave the reporting of unsupported objects to the sequential evaluation */
+		q->closed = true;
+		return;
+	}
+
+	/*
+	 * Probes are started here, by the calling thread, as they are
+	 * terminated once the thread which started them exits.
+	 */
+	if (q->count == 0 && q->ph->func(type, q->ph->uptr, PROBE_HANDLER_ACT_OPEN) != 0) {
+		q->closed = true;
+		return;
+	}
+
+	if (q->count == q->size) {
+		q->size = q->size == 0 ? 8 : q->size * 2;
+		q->syschars = realloc(q->syschars, sizeof(struct oval_syschar *) * q->size);
+	}
+	q->syschars[q->count++] = oval_syschar_new(pf->sess->sys_model, obj);
+}
+
+static void _prefetch_test(struct oval_prefetch *pf, struct oval_test *test)
+{
+	struct oval_object *object;
+	struct oval_state_iterator *ste_itr;
+
+	if ((oval_independent_subtype_t)oval_test_get_subtype(test) == OVAL_INDEPENDENT_UNKNOWN)
+		return;
+
+	object = oval_test_get_object(test);
+	if (object == NULL)
+		return;
+	if (oval_test_get_subtype(test) != oval_object_get_subtype(object))
+		return;
+
+	_prefetch_object(pf, object);
+
+	/* objects referenced like this: test->state->variable->object */
+	ste_itr = oval_test_get_states(test);
+	while (oval_state_iterator_has_more(ste_itr)) {
+		struct oval_state *state = oval_state_iterator_next(ste_itr);
+		struct oval_string_map *vm = oval_string_map_new();
+		struct oval_iterator *var_itr;
+
+		oval_ste_collect_var_refs(state, vm);
+		var_itr = oval_string_map_values(vm);
+		while (oval_collection_iterator_has_more(var_itr))
+			_prefetch_close_variable(pf, oval_collection_iterator_next(var_itr));
+		oval_collection_iterator_free(var_itr);
+		oval_string_map_free(vm, NULL);
+	}
+	oval_state_iterator_free(ste_itr);
+}
+
+static void _prefetch_definition(struct oval_prefetch *pf, struct oval_definition *def);
+
+static void _prefetch_criteria(struct oval_prefetch *pf, struct oval_criteria_node *cnode)
+{
+	struct oval_criteria_node_iterator *cnode_it;
+
+	switch (oval_criteria_node_get_type(cnode)) {
+	case OVAL_NODETYPE_CRITERION: {
+		struct oval_test *test = oval_criteria_node_get_test(cnode);
+		if (test != NULL)
+			_prefetch_test(pf, test);
+		break;
+	}
+	case OVAL_NODETYPE_CRITERIA:
+		cnode_it = oval_criteria_node_get_subnodes(cnode);
+		if (cnode_it == NULL)
+			break;
+		while (oval_criteria_node_iterator_has_more(cnode_it))
+			_prefetch_criteria(pf, oval_criteria_node_iterator_next(cnode_it));
+		oval_criteria_node_iterator_free(cnode_it);
+		break;
+	case OVAL_NODETYPE_EXTENDDEF: {
+		struct oval_definition *def = oval_criteria_node_get_definition(cnode);
+		if (def != NULL)
+			_prefetch_definition(pf, def);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void _prefetch_definition(struct oval_prefetch *pf, struct oval_definition *def)
+{
+	const char *def_id = oval_definition_get_id(def);
+	struct oval_criteria_node *cnode;
+
+	if (oval_string_map_get_value(pf->definitions, def_id) != NULL)
+		return;
+	oval_string_map_put(pf->definitions, def_id, def);
+
+	cnode = oval_definition_get_criteria(def);
+	if (cnode != NULL)
+		_prefetch_criteria(pf, cnode);
+}
+
+static bool _prefetch_next_queue(struct oval_prefetch *pf, struct oval_prefetch_queue **q)
+{
+	bool ret = false;
+
+	pthread_mutex_lock(&pf->lock);
+	while (!pf->aborted && pf->next_queue < pf->queue_count) {
+		*q = &pf->queues[pf->next_queue++];
+		if ((*q)->count > 0) {
+			ret = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&pf->lock);
+
+	return ret;
+}
+
+static bool _prefetch_is_aborted(struct oval_prefetch *pf)
+{
+	bool aborted;
+
+	pthread_mutex_lock(&pf->lock);
+	aborted = pf->aborted;
+	pthread_mutex_unlock(&pf->lock);
+
+	return aborted;
+}
+
+static void *_prefetch_worker(void *arg)
+{
+	struct oval_prefetch *pf = arg;
+	struct oval_prefetch_queue *q;
+
+	while (_prefetch_next_queue(pf, &q)) {
+		for (size_t i = 0; i < q->count && !_prefetch_is_aborted(pf); ++i) {
+			struct oval_syschar *sysc = q->syschars[i];
+			int ret;
+
+			ret = q->ph->func(q->type, q->ph->uptr, PROBE_HANDLER_ACT_EVAL, sysc, OVAL_PDFLAG_NORECONN);
+			if (ret == -2 || (ret < 0 && errno == ECONNABORTED)) {
+				pthread_mutex_lock(&pf->lock);
+				pf->aborted = true;
+				pthread_mutex_unlock(&pf->lock);
+				break;
+			}
+			if (ret < 0) {
+				/*
+				 * The syschar is left uncollected, the sequential evaluation
+				 * will query it again and report the error properly.
+				 */
+				dW("Failed to collect %s_object '%s' ahead, %zu remaining %s objects left for sequential evaluation.",
+				   oval_subtype_get_text(q->type), oval_object_get_id(oval_syschar_get_object(sysc)),
+				   q->count - i - 1, oval_subtype_get_text(q->type));
+				oscap_clearerr();
+				break;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+static int _prefetch_run(struct oval_prefetch *pf, unsigned int threads)
+{
+	pthread_t *tids;
+	size_t objects = 0, busy = 0;
+	unsigned int i, started;
+
+	for (size_t q = 0; q < pf->queue_count; ++q) {
+		objects += pf->queues[q].count;
+		if (pf->queues[q].count > 0)
+			++busy;
+	}
+
+	if (objects == 0)
+		return 0;
+
+	if (threads > busy)
+		threads = busy;
+
+	dI("Collecting %zu objects of %zu types ahead using %u threads.", objects, busy, threads);
+
+	if (threads <= 1) {
+		_prefetch_worker(pf);
+		return pf->aborted ? -2 : 0;
+	}
+
+	tids = malloc(sizeof(pthread_t) * threads);
+	for (started = 0; started < threads; ++started) {
+		if (pthread_create(&tids[started], NULL, _prefetch_worker, pf) != 0) {
+			dW("Can't start a collection thread: %u, %s.", errno, strerror(errno));
+			break;
+		}
+	}
+
+	/* should no thread start, collect everything in this one */
+	if (started == 0)
+		_prefetch_worker(pf);
+
+	for (i = 0; i < started; ++i)
+		pthread_join(tids[i], NULL);
+	free(tids);
+
+	return pf->aborted ? -2 : 0;
+}
+
+int oval_probe_prefetch_definitions(oval_probe_session_t *sess, struct oval_definition **defs, size_t count, unsigned int threads)
+{
+	struct oval_prefetch pf;
+	int ret;
+
+	if (sess == NULL || threads <= 1 || count == 0)
+		return 0;
+
+	memset(&pf, 0, sizeof pf);
+	pf.sess = sess;
+	pf.definitions = oval_string_map_new();
+	pf.objects = oval_string_map_new();
+	pf.variables = oval_string_map_new();
+	pthread_mutex_init(&pf.lock, NULL);
+
+	for (size_t i = 0; i < count; ++i)
+		_prefetch_definition(&pf, defs[i]);
+
+	ret = _prefetch_run(&pf, threads);
+
+	for (size_t i = 0; i < pf.queue_count; ++i)
+		free(pf.queues[i].syschars);
+	free(pf.queues);
+	pthread_mutex_destroy(&pf.lock);
+	oval_string_map_free(pf.variables, NULL);
+	oval_string_map_free(pf.objects, NULL);
+	oval_string_map_free(pf.definitions, NULL);
+
+	return ret;
+}
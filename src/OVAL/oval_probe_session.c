@@ -47,6 +47,7 @@
 #include "_oval_probe_handler.h"
 #include "oval_probe_impl.h"
 #include "oval_probe_ext.h"
+#include "oval_probe_cache.h"
 #include "oval_probe_meta.h"
 
 #if defined(OSCAP_THREAD_SAFE)
@@ -129,6 +130,7 @@ static void oval_probe_session_init(oval_probe_session_t *sess, struct oval_sysc
         sess->pext = oval_pext_new();
         sess->pext->model    = &sess->sys_model;
         sess->pext->sess_ptr = sess;
+        sess->pext->cache    = sess->cache;
 
         __init_once();
 
@@ -151,6 +153,7 @@ static void oval_probe_session_init(oval_probe_session_t *sess, struct oval_sysc
 oval_probe_session_t *oval_probe_session_new(struct oval_syschar_model *model)
 {
         oval_probe_session_t *sess = oscap_talloc(oval_probe_session_t);
+        sess->cache = NULL;
         oval_probe_session_init(sess, model);
         return sess;
 }
@@ -176,6 +179,7 @@ void oval_probe_session_reinit(oval_probe_session_t *sess, struct oval_syschar_m
 void oval_probe_session_destroy(oval_probe_session_t *sess)
 {
 	oval_probe_session_free(sess);
+	oval_probe_cache_free(sess->cache);
 	free(sess);
 }
 
@@ -221,6 +225,30 @@ int oval_probe_session_sethandler(oval_probe_session_t *sess, oval_subtype_t typ
         return(-1);
 }
 
+void oval_probe_session_set_keepalive(bool keepalive)
+{
+	oval_probe_ext_set_keepalive(keepalive);
+}
+
+void oval_probe_session_close_idle(void)
+{
+	oval_probe_ext_close_idle();
+}
+
+int oval_probe_session_set_cache(oval_probe_session_t *sess, const char *dir)
+{
+	struct oval_probe_cache *cache = NULL;
+
+	if (dir != NULL && (cache = oval_probe_cache_new(dir)) == NULL)
+		return (-1);
+
+	oval_probe_cache_free(sess->cache);
+	sess->cache       = cache;
+	sess->pext->cache = cache;
+
+	return (0);
+}
+
 struct oval_syschar_model *oval_probe_session_getmodel(oval_probe_session_t *sess)
 {
 	if (sess == NULL) {
@@ -80,6 +80,8 @@ struct oval_session {
 	bool full_validation;
 	bool fetch_remote_resources;
 	download_progress_calllback_t progress;
+	unsigned int eval_threads;
+	char *object_cache;
 };
 
 struct oval_session *oval_session_new(const char *filename)
@@ -103,6 +105,7 @@ struct oval_session *oval_session_new(const char *filename)
 	}
 
 	session->export_sys_chars = true;
+	session->eval_threads = 1;
 
 	dI("Created a new OVAL session from input file '%s'.", filename);
 	return session;
@@ -179,6 +182,21 @@ void oval_session_set_xml_reporter(struct oval_session *session, xml_reporter fn
 	session->reporter.xml_fn = fn;
 }
 
+void oval_session_set_eval_threads(struct oval_session *session, unsigned int threads)
+{
+	__attribute__nonnull__(session);
+
+	session->eval_threads = threads;
+}
+
+void oval_session_set_object_cache(struct oval_session *session, const char *dir)
+{
+	__attribute__nonnull__(session);
+
+	free(session->object_cache);
+	session->object_cache = oscap_strdup(dir);
+}
+
 static bool oval_session_validate(struct oval_session *session, struct oscap_source *source, oscap_document_type_t type)
 {
 	if (oscap_source_get_scap_type(source) == type) {
@@ -326,6 +344,12 @@ static int oval_session_setup_agent(struct oval_session *session)
 	free(path_clone);
 
 	oval_agent_set_product_name(session->sess, (char *)oscap_productname);
+	oval_agent_set_eval_threads(session->sess, session->eval_threads);
+
+	if (session->object_cache != NULL &&
+	    oval_agent_set_object_cache(session->sess, session->object_cache) != 0)
+		return 1;
+
 	return 0;
 }
 
@@ -395,6 +419,7 @@ int oval_session_export(struct oval_session *session)
 	struct oval_directives_model *dir_model = NULL;
 	struct oscap_source *result = NULL;		/* OVAL Results */
 	const char *filename = NULL;
+	bool saved = false;
 	int ret = 0;
 
 	/* Import OVAL Directives if any */
@@ -411,8 +436,17 @@ int oval_session_export(struct oval_session *session)
 	 * directives to them */
 	if (session->res_model && (session->export.results || session->export.report)) {
 		oval_results_model_set_export_system_characteristics(session->res_model, session->export_sys_chars);
-		result = oval_results_model_export_source(session->res_model, dir_model, NULL);
 		filename = session->export.results;
+		if (!session->export.report && strcmp(filename, "-") != 0) {
+			/* Nothing needs the DOM, stream the results to the file and
+			 * read them back only if they are validated */
+			if (oval_results_model_export(session->res_model, dir_model, filename) != 0)
+				goto cleanup;
+			result = oscap_source_new_from_file(filename);
+			saved = true;
+		} else {
+			result = oval_results_model_export_source(session->res_model, dir_model, NULL);
+		}
 	}
 
 	/* Validate OVAL Results. The 'result' in condition will make sure that there is
@@ -422,7 +456,7 @@ int oval_session_export(struct oval_session *session)
 			goto cleanup;
 	}
 
-	if (session->export.results && result) {	/* export to XML */
+	if (session->export.results && result && !saved) {	/* export to XML */
 		if (oscap_source_save_as(result, filename) != 0)
 			goto cleanup;
 	}
@@ -478,6 +512,7 @@ void oval_session_free(struct oval_session *session)
 	free(session->component_id);
 	free(session->export.results);
 	free(session->export.report);
+	free(session->object_cache);
 	if (session->sess)
 		oval_agent_destroy_session(session->sess);
 	if (session->def_model)
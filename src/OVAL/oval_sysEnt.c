@@ -40,6 +40,7 @@
 #include "adt/oval_collection_impl.h"
 #include "oval_parser_impl.h"
 #include "oval_definitions_impl.h"
+#include "results/oval_cmp_evr_string_impl.h"
 
 #include "common/util.h"
 #include "common/debug_priv.h"
@@ -49,6 +50,7 @@ typedef struct oval_sysent {
 	struct oval_syschar_model *model;
 	char *name;
 	char *value;
+	struct oval_evr *evr;
 	struct oval_collection *record_fields;
 	int mask;
 	oval_datatype_t datatype;
@@ -63,6 +65,7 @@ struct oval_sysent *oval_sysent_new(struct oval_syschar_model *model)
 
 	sysent->name = NULL;
 	sysent->value = NULL;
+	sysent->evr = NULL;
 	sysent->record_fields = NULL;
 	sysent->status = SYSCHAR_STATUS_UNKNOWN;
 	sysent->datatype = OVAL_DATATYPE_UNKNOWN;
@@ -101,6 +104,7 @@ void oval_sysent_free(struct oval_sysent *sysent)
 		free(sysent->name);
 	if (sysent->value != NULL)
 		free(sysent->value);
+	oval_evr_free(sysent->evr);
 	if (sysent->record_fields)
 		oval_collection_free_items(sysent->record_fields, (oscap_destruct_func) oval_record_field_free);
 
@@ -203,6 +207,23 @@ void oval_sysent_set_value(struct oval_sysent *sysent, char *value)
 	if (sysent->value != NULL)
 		free(sysent->value);
 	sysent->value = oscap_strdup(value);
+	oval_evr_free(sysent->evr);
+	sysent->evr = NULL;
+}
+
+struct oval_evr *oval_sysent_get_evr(struct oval_sysent *sysent, oval_datatype_t datatype)
+{
+	__attribute__nonnull__(sysent);
+
+	if (sysent->value == NULL)
+		return NULL;
+	if (sysent->evr != NULL && oval_evr_get_datatype(sysent->evr) != datatype) {
+		oval_evr_free(sysent->evr);
+		sysent->evr = NULL;
+	}
+	if (sysent->evr == NULL)
+		sysent->evr = oval_evr_new(datatype, sysent->value);
+	return sysent->evr;
 }
 
 void oval_sysent_add_record_field(struct oval_sysent *sysent, struct oval_record_field *rf)
@@ -0,0 +1,2 @@
+#define OVAL_PROBEDIR_ENV 1
+#include <oval_probe_ext.c>
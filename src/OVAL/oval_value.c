@@ -38,6 +38,7 @@
 
 #include "oval_definitions_impl.h"
 #include "adt/oval_collection_impl.h"
+#include "results/oval_cmp_evr_string_impl.h"
 #include "common/util.h"
 #include "common/debug_priv.h"
 #include "common/elements.h"
@@ -45,6 +46,7 @@
 typedef struct oval_value {
 	oval_datatype_t datatype;
 	char *text;
+	struct oval_evr *evr;
 } oval_value_t;
 
 bool oval_value_iterator_has_more(struct oval_value_iterator *oc_value)
@@ -124,10 +126,34 @@ struct oval_value *oval_value_new(oval_datatype_t datatype, char *text_value)
 
 	value->datatype = datatype;
 	value->text = oscap_strdup(text_value);
+	value->evr = NULL;
 	return value;
 }
 
 
+struct oval_value *oval_value_new_nocopy(oval_datatype_t datatype, char *text_value)
+{
+	oval_value_t *value = (oval_value_t *) malloc(sizeof(oval_value_t));
+	if (value == NULL) {
+		free(text_value);
+		return NULL;
+	}
+
+	value->datatype = datatype;
+	value->text = text_value;
+	value->evr = NULL;
+	return value;
+}
+
+void oval_value_text_changed(struct oval_value *value, oval_datatype_t datatype)
+{
+	__attribute__nonnull__(value);
+
+	value->datatype = datatype;
+	oval_evr_free(value->evr);
+	value->evr = NULL;
+}
+
 struct oval_value *oval_value_clone(struct oval_value *old_value)
 {
 	__attribute__nonnull__(old_value);
@@ -141,6 +167,7 @@ void oval_value_free(struct oval_value *value)
     if (value == NULL)
         return;
 
+    oval_evr_free(value->evr);
     free(value->text);
     free(value);
 }
@@ -198,3 +225,19 @@ int oval_value_parse_tag(xmlTextReaderPtr reader,
 xmlNode *oval_value_to_dom(struct oval_value *value, xmlDoc * doc, xmlNode * parent) {
 	return NULL;		//TODO: implement oval_value_to_dom
 }
+
+struct oval_evr *oval_value_get_evr(struct oval_value *value)
+{
+	__attribute__nonnull__(value);
+
+	if (value->text == NULL)
+		return NULL;
+	/* the datatype may have been changed since the value was parsed */
+	if (value->evr != NULL && oval_evr_get_datatype(value->evr) != value->datatype) {
+		oval_evr_free(value->evr);
+		value->evr = NULL;
+	}
+	if (value->evr == NULL)
+		value->evr = oval_evr_new(value->datatype, value->text);
+	return value->evr;
+}
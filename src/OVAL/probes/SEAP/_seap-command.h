@@ -103,6 +103,10 @@ typedef uint8_t SEAP_cflags_t;
 
 #define SEAP_CFLG_THREAD 0x01
 #define SEAP_CFLG_WATCH  0x02
+#define SEAP_CFLG_BINARY 0x04 /* negotiate binary frames on new connections */
+
+/* Internal command codes (SEAP_CMDCLASS_INT) */
+#define SEAP_CMDINT_BINARY 0xfffe /* switch the connection to binary frames */
 
 /* Backends */
 #include "seap-command-backendT.h"
@@ -83,6 +83,10 @@ SEAP_scheme_t SEAP_scheme_search (const SEAP_schemefn_t fntable[], const char *s
 #include "sch_pipe.h"
 #define SCH_PIPE    3
 
+/* shared memory */
+#include "sch_shm.h"
+#define SCH_SHM     4
+
 #define SCH_NONE    255
 
 OSCAP_HIDDEN_END;
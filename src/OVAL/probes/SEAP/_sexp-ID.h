@@ -3,9 +3,4 @@
 
 #include "public/sexp-ID.h"
 
-typedef struct {
-	SEXP_ID_t hash;
-	int       part;
-} __IDres_pair;
-
 #endif /* _SEXP_ID_H */
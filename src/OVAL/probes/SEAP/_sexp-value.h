@@ -57,6 +57,7 @@ typedef struct {
 #define SEXP_VALP_HDR(p) ((SEXP_valhdr_t *)(((uintptr_t)(p)) & SEXP_VALP_MASK))
 
 int       SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_valtype_t type);
+void      SEXP_val_free (SEXP_val_t *dsc);
 void      SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr);
 uintptr_t SEXP_val_ptr (SEXP_val_t *dsc);
 
@@ -87,8 +88,18 @@ SEXP_DEFNUM(u64, uint64_t);
 struct SEXP_val_list {
         void    *b_addr;
         uint16_t offset;
+        uint8_t  flags;
+        uint32_t length; /* number of members from offset on */
+        void    *b_last; /* last block of the chain */
 } __attribute__ ((packed));
 
+/*
+ * Some block of the chain may be referenced from another list (see
+ * SEXP_list_rest), so the chain has to be walked and the shared part
+ * copied before appending. Lists without this flag append to b_last.
+ */
+#define SEXP_LIST_SHARED 0x01
+
 #define SEXP_LCASTP(p) ((struct SEXP_val_list *)(p))
 
 struct SEXP_val_lblk {
@@ -99,6 +110,9 @@ struct SEXP_val_lblk {
 } __attribute__ ((packed));
 
 size_t    SEXP_rawval_list_length (struct SEXP_val_list *list);
+SEXP_t   *SEXP_rawval_list_nth (struct SEXP_val_list *list, uint32_t n);
+void      SEXP_rawval_list_add (struct SEXP_val_list *list, const SEXP_t *s_exp);
+void      SEXP_rawval_list_sync (struct SEXP_val_list *list);
 uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp);
 
 uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip);
@@ -114,13 +128,14 @@ SEXP_t   *SEXP_rawval_lblk_nth  (uintptr_t lblkp, uint32_t n);
 uintptr_t SEXP_rawval_lblk_replace (uintptr_t lblkp, uint32_t n, const SEXP_t *n_val, SEXP_t **o_val);
 int       SEXP_rawval_lblk_cb   (uintptr_t lblkp, int  (*func) (SEXP_t *, void *), void *arg, uint32_t n);
 void      SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *));
-void      SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *));
+int       SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *));
 
 #define SEXP_LBLK_ALIGN (16 > sizeof(void *) ? 16 : sizeof(void *))
 #define SEXP_LBLKP_MASK (UINTPTR_MAX << 4)
 #define SEXP_LBLKS_MASK 0x0f
 
 #define SEXP_VALP_LBLK(valp) ((struct SEXP_val_lblk *)((uintptr_t)(valp) & SEXP_LBLKP_MASK))
+#define SEXP_LBLK_SIZE(sz)   (sizeof (uintptr_t) + (2 * sizeof (uint16_t)) + (sizeof (SEXP_t) * (1 << (sz))))
 
 uintptr_t SEXP_rawval_copy(uintptr_t s_valp);
 
@@ -55,6 +55,8 @@ int SEAP_cmd_unregister (SEAP_CTX_t *ctx, SEAP_cmdcode_t code);
 #define SEAP_EXEC_THREAD 0x08
 #define SEAP_EXEC_WQUEUE 0x10
 #define SEAP_EXEC_RECV   0x20
+/* with SEAP_EXEC_RECV: give up if no data arrives within the receive timeout */
+#define SEAP_EXEC_TIMEOUT 0x40
 
 SEXP_t *SEAP_cmd_exec (SEAP_CTX_t    *ctx,
                        int            sd,
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#pragma once
+#ifndef SEXP_BINARY_H
+#define SEXP_BINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sexp-types.h>
+#include <strbuf.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Binary encoding of S-expressions
+ *
+ * Every S-exp starts with a tag byte:
+ *
+ *   STRING  varint length, bytes
+ *   NUMBER  number type (SEXP_NUM_*), the value in host byte order
+ *   LIST    the members, terminated by the END tag
+ *   DTYPE   varint length, datatype name, the S-exp the datatype belongs to
+ *
+ * Numbers are stored in host byte order because both ends of a SEAP
+ * connection always run on the same host.
+ */
+#define SEXP_BTAG_END    0x00
+#define SEXP_BTAG_STRING 0x01
+#define SEXP_BTAG_NUMBER 0x02
+#define SEXP_BTAG_LIST   0x03
+#define SEXP_BTAG_DTYPE  0x04
+
+/*
+ * A frame carries one encoded S-exp: magic byte, payload length
+ * (uint32_t, host byte order) and the payload.
+ */
+#define SEXP_BFRAME_MAGIC   0xb5
+#define SEXP_BFRAME_HDRSIZE 5
+
+/* Maximal depth of nested lists accepted by the decoder */
+#define SEXP_BDECODE_MAXDEPTH 256
+
+int SEXP_bencode (const SEXP_t *s_exp, strbuf_t *sb);
+SEXP_t *SEXP_bdecode (const void *buf, size_t len);
+
+int SEXP_bframe_sbprint (const SEXP_t *s_exp, strbuf_t *sb);
+int SEXP_bframe_hdrparse (const void *hdr, uint32_t *len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SEXP_BINARY_H */
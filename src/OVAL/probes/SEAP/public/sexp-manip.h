@@ -326,6 +326,16 @@ bool SEXP_string_getb (const SEXP_t *s_exp);
  */
 SEXP_t *SEXP_list_new (SEXP_t *memb, ...);
 
+/**
+ * Create a new sexp list containing the sexp objects from an array.
+ * The storage for all the elements is allocated at once, so this is
+ * cheaper than adding the elements one by one when their number is known.
+ * This function increments elements' reference count.
+ * @param memb array of sexp objects to be inserted into the new list
+ * @param count number of elements in the array
+ */
+SEXP_t *SEXP_list_new_array (SEXP_t *memb[], size_t count);
+
 /**
  * Free the specified sexp object.
  * @param s_exp the object to be freed
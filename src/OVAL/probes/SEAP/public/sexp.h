@@ -29,6 +29,7 @@
 #include <sexp-manip_r.h>
 #include <sexp-parser.h>
 #include <sexp-output.h>
+#include <sexp-binary.h>
 #include <sexp-ID.h>
 
 #endif /* SEXP_H */
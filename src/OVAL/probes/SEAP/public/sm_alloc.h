@@ -25,6 +25,8 @@
 #define SM_ALLOC_H
 
 #include "config.h"
+#include <stddef.h>
+#include <stdint.h>
 #include "src/common/debug_priv.h"
 
 #ifdef __cplusplus
@@ -77,6 +79,29 @@ __ATTRIB void sm_free     (void *p) { __sm_free_dbg (p, __FUNCTION__, 0); }
 #define  sm_talloc(T) ((T *) sm_alloc(sizeof(T)))
 #define  sm_valloc(v) ((typeof(v) *) sm_alloc(sizeof v))
 
+/*
+ * Slab allocator for small objects. The size passed to sm_slab_free
+ * must be the size that was passed to sm_slab_alloc; memory is aligned
+ * to 16 bytes.
+ */
+struct sm_slab_stats {
+        uint64_t alloc;       /* objects allocated from slabs */
+        uint64_t free;        /* objects given back to slabs */
+        uint64_t large;       /* allocations too large for a slab */
+        uint64_t slabs;       /* slabs currently allocated */
+        uint64_t slabs_total; /* slabs allocated so far */
+};
+
+void *sm_slab_alloc (size_t s);
+void  sm_slab_free (void *p, size_t s);
+
+/*
+ * Give the free objects cached by the calling thread back to the slabs
+ * and fold its counters into the statistics.
+ */
+void  sm_slab_flush (void);
+void  sm_slab_stats (struct sm_slab_stats *stats);
+
 #include <assert.h>
 
 #ifdef __cplusplus
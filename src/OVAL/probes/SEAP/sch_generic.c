@@ -39,6 +39,7 @@
 #include "public/strbuf.h"
 #include "_sexp-types.h"
 #include "_sexp-output.h"
+#include "public/sexp-binary.h"
 #include "_seap-types.h"
 #include "_seap-scheme.h"
 #include "sch_generic.h"
@@ -101,7 +102,12 @@ ssize_t sch_generic_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
         ret = 0;
         sb  = strbuf_new (SEAP_STRBUF_MAX);
 
-        if (SEXP_sbprintf_t (sexp, sb) != 0)
+        if (desc->flags & SEAP_DESCFLG_BSEND)
+                ret = SEXP_bframe_sbprint (sexp, sb);
+        else
+                ret = SEXP_sbprintf_t (sexp, sb);
+
+        if (ret != 0)
                 ret = -1;
         else
                 ret = strbuf_write (sb, DATA(desc->scheme_data)->ofd);
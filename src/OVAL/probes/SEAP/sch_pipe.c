@@ -47,6 +47,7 @@
 #include "_sexp-types.h"
 #include "_seap-types.h"
 #include "_sexp-output.h"
+#include "public/sexp-binary.h"
 #include "_seap-scheme.h"
 #include "sch_pipe.h"
 #include "seap-descriptor.h"
@@ -190,17 +191,19 @@ static int check_child (pid_t pid, int waitf)
         return (1);
 }
 
-int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
+/*
+ * Start the program at `uri' connected by a socket to data->pfd. The
+ * descriptors in `keepfds' are passed on to it even if they are marked
+ * close-on-exec.
+ */
+int sch_pipe_spawn (sch_pipedata_t *data, const char *uri, uint32_t flags,
+                    const int *keepfds, size_t keepcnt, char *const envp[])
 {
-        sch_pipedata_t *data;
-        pid_t pid;
-        int   pfd[2] = { -1, -1 };
-
-        assume_r (desc != NULL, -1, errno = EFAULT;);
-        assume_r (uri  != NULL, -1, errno = EFAULT;);
-        assume_r (desc->scheme_data == NULL, -1, errno = EALREADY;);
+        pid_t  pid;
+        int    pfd[2] = { -1, -1 };
+        char  *argv[2];
+        size_t i;
 
-        data = (sch_pipedata_t *) sm_talloc (sch_pipedata_t);
         data->execpath = get_exec_path (uri, flags);
 
         if (data->execpath == NULL) {
@@ -231,7 +234,13 @@ int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
                         _exit (errno);
                 if (dup2 (pfd[1], STDOUT_FILENO) != STDOUT_FILENO)
                         _exit (errno);
-                execl (data->execpath, data->execpath, NULL);
+                for (i = 0; i < keepcnt; ++i) {
+                        if (fcntl (keepfds[i], F_SETFD, 0) != 0)
+                                _exit (errno);
+                }
+                argv[0] = data->execpath;
+                argv[1] = NULL;
+                execve (data->execpath, argv, envp);
                 _exit (errno);
         default: /* parent */
                 close (pfd[1]);
@@ -243,8 +252,6 @@ int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
                         goto fail2;
         }
 
-        desc->scheme_data = (void *)data;
-
         return (0);
 fail2:
         protect_errno {
@@ -254,11 +261,38 @@ fail1:
         protect_errno {
                 if (data->execpath != NULL)
                         sm_free (data->execpath);
-                sm_free (data);
+                data->execpath = NULL;
         }
         return (-1);
 }
 
+int sch_pipe_alive (sch_pipedata_t *data)
+{
+        return check_child (data->pid, 0);
+}
+
+int sch_pipe_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
+{
+        sch_pipedata_t *data;
+
+        assume_r (desc != NULL, -1, errno = EFAULT;);
+        assume_r (uri  != NULL, -1, errno = EFAULT;);
+        assume_r (desc->scheme_data == NULL, -1, errno = EALREADY;);
+
+        data = (sch_pipedata_t *) sm_talloc (sch_pipedata_t);
+
+        if (sch_pipe_spawn (data, uri, flags, NULL, 0, environ) != 0) {
+                protect_errno {
+                        sm_free (data);
+                }
+                return (-1);
+        }
+
+        desc->scheme_data = (void *)data;
+
+        return (0);
+}
+
 int sch_pipe_openfd (SEAP_desc_t *desc, int fd, uint32_t flags)
 {
         errno = EOPNOTSUPP;
@@ -330,7 +364,12 @@ ssize_t sch_pipe_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
                 ret = 0;
                 sb  = strbuf_new (SEAP_STRBUF_MAX);
 
-                if (SEXP_sbprintf_t (sexp, sb) != 0)
+                if (desc->flags & SEAP_DESCFLG_BSEND)
+                        ret = SEXP_bframe_sbprint (sexp, sb);
+                else
+                        ret = SEXP_sbprintf_t (sexp, sb);
+
+                if (ret != 0)
                         ret = -1;
                 else
                         ret = strbuf_write (sb, data->pfd);
@@ -341,16 +380,13 @@ ssize_t sch_pipe_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
         }
 }
 
-int sch_pipe_close (SEAP_desc_t *desc, uint32_t flags)
+/*
+ * Terminate the program started by sch_pipe_spawn and release its data,
+ * except for the structure itself.
+ */
+int sch_pipe_reap (sch_pipedata_t *data)
 {
         int try;
-        sch_pipedata_t *data;
-
-        assume_d (desc != NULL, -1, errno = EFAULT;);
-
-        data = (sch_pipedata_t *)desc->scheme_data;
-
-        assume_r (data != NULL, -1, errno = EBADF;);
 
         kill (data->pid, SIGTERM);
 
@@ -381,6 +417,24 @@ clean:
         close (data->pfd);
 
         sm_free (data->execpath);
+        data->execpath = NULL;
+
+        return (0);
+}
+
+int sch_pipe_close (SEAP_desc_t *desc, uint32_t flags)
+{
+        sch_pipedata_t *data;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+
+        data = (sch_pipedata_t *)desc->scheme_data;
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        if (sch_pipe_reap (data) != 0)
+                return (-1);
+
         sm_free (data);
 
         desc->scheme_data = NULL;
@@ -0,0 +1,625 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_SYS_EVENTFD_H)
+#include <sys/eventfd.h>
+#endif
+#include <common/assume.h>
+
+#include "generic/common.h"
+#include "public/sm_alloc.h"
+#include "public/strbuf.h"
+#include "_sexp-types.h"
+#include "_sexp-output.h"
+#include "public/sexp-binary.h"
+#include "_seap-types.h"
+#include "_seap-scheme.h"
+#include "sch_shm.h"
+#include "seap-descriptor.h"
+
+#if defined(HAVE_MEMFD_CREATE) && defined(HAVE_SYS_EVENTFD_H)
+
+extern char **environ;
+
+#define DATA(ptr) ((sch_shmdata_t *)(ptr))
+#define RDATA(r)  ((uint8_t *)(r) + sizeof (sch_shmring_t))
+
+#define SCH_SHM_EVCNT 4
+
+/* the library writes to the first ring and reads from the second one */
+static int sch_shm_map (sch_shmdata_t *data, int mfd, bool peer)
+{
+        sch_shmring_t *r0, *r1;
+
+        data->mfd     = mfd;
+        data->mapsize = 2 * (sizeof (sch_shmring_t) + SCH_SHM_RINGSIZE);
+        data->map     = mmap (NULL, data->mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, mfd, 0);
+
+        if (data->map == MAP_FAILED) {
+                data->map = NULL;
+                return (-1);
+        }
+
+        r0 = (sch_shmring_t *)data->map;
+        r1 = (sch_shmring_t *)((uint8_t *)data->map + sizeof (sch_shmring_t) + SCH_SHM_RINGSIZE);
+
+        data->tx = peer ? r1 : r0;
+        data->rx = peer ? r0 : r1;
+
+        return (0);
+}
+
+static void sch_shm_unmap (sch_shmdata_t *data)
+{
+        int *fds[] = { &data->rx_data, &data->rx_space, &data->tx_data, &data->tx_space, &data->mfd };
+        size_t i;
+
+        if (data->map != NULL)
+                munmap (data->map, data->mapsize);
+
+        for (i = 0; i < sizeof fds / sizeof fds[0]; ++i) {
+                if (*fds[i] != -1)
+                        close (*fds[i]);
+                *fds[i] = -1;
+        }
+
+        data->map = NULL;
+}
+
+/*
+ * The shared memory is writable by the peer, so the ring positions are
+ * checked before they are used to index the data area.
+ */
+static int sch_shm_check (const sch_shmdata_t *data, uint64_t head, uint64_t tail)
+{
+        if (head - tail > data->ringsize) {
+                dE("Corrupted shm ring: head=%"PRIu64", tail=%"PRIu64, head, tail);
+                errno = EPROTO;
+                return (-1);
+        }
+
+        return (0);
+}
+
+/*
+ * Sleep on the eventfd `efd' until it's signaled or until the peer hangs
+ * up. The caller must set the wait flag and check the ring once more
+ * before calling this, otherwise a wakeup could be lost.
+ * @return 0 if signaled, 1 if the peer hung up, -1 on error or timeout
+ */
+static int sch_shm_wait (sch_shmdata_t *data, int efd, uint16_t timeout)
+{
+        struct pollfd pfd[2];
+        uint64_t      cnt;
+
+        pfd[0].fd     = efd;
+        pfd[0].events = POLLIN;
+        pfd[1].fd     = data->hfd;
+        pfd[1].events = POLLIN;
+
+        for (;;) {
+                switch (poll (pfd, 2, timeout > 0 ? timeout * 1000 : -1)) {
+                case -1:
+                        if (errno == EINTR)
+                                continue;
+                        return (-1);
+                case  0:
+                        errno = ETIMEDOUT;
+                        return (-1);
+                }
+
+                if (pfd[0].revents & POLLIN) {
+                        if (read (efd, &cnt, sizeof cnt) != sizeof cnt && errno != EAGAIN)
+                                return (-1);
+                        return (0);
+                }
+
+                /* nothing is written to the socket, any event means EOF */
+                return (1);
+        }
+}
+
+static void sch_shm_signal (uint32_t *flag, int efd)
+{
+        uint64_t one = 1;
+
+        __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+        if (__atomic_load_n (flag, __ATOMIC_RELAXED) != 0) {
+                __atomic_store_n (flag, 0, __ATOMIC_RELAXED);
+
+                if (write (efd, &one, sizeof one) != sizeof one)
+                        dI("eventfd write failed: errno=%u, %s.", errno, strerror (errno));
+        }
+}
+
+/*
+ * Wait until the consumer can read (`rx') or the producer can write.
+ * @return 0 if ready, 1 if the peer hung up, -1 on error or timeout
+ */
+static int sch_shm_wait_ring (sch_shmdata_t *data, bool rx, uint16_t timeout)
+{
+        sch_shmring_t *r = rx ? data->rx : data->tx;
+        uint32_t      *flag = rx ? &r->rwait : &r->wwait;
+        uint64_t       head, tail;
+        int ret;
+
+        for (;;) {
+                head = __atomic_load_n (&r->head, __ATOMIC_ACQUIRE);
+                tail = __atomic_load_n (&r->tail, __ATOMIC_ACQUIRE);
+
+                if (sch_shm_check (data, head, tail) != 0)
+                        return (-1);
+                if (rx ? head != tail : head - tail < data->ringsize)
+                        return (0);
+
+                __atomic_store_n (flag, 1, __ATOMIC_RELAXED);
+                __atomic_thread_fence (__ATOMIC_SEQ_CST);
+
+                head = __atomic_load_n (&r->head, __ATOMIC_ACQUIRE);
+                tail = __atomic_load_n (&r->tail, __ATOMIC_ACQUIRE);
+
+                if (sch_shm_check (data, head, tail) != 0)
+                        return (-1);
+                if (rx ? head != tail : head - tail < data->ringsize) {
+                        __atomic_store_n (flag, 0, __ATOMIC_RELAXED);
+                        return (0);
+                }
+
+                if (data->pipe.pid > 0 && sch_pipe_alive (&data->pipe) != 0)
+                        return (1);
+
+                ret = sch_shm_wait (data, rx ? data->rx_data : data->tx_space, timeout);
+
+                if (ret != 0)
+                        return (ret);
+        }
+}
+
+/*
+ * Copy `len' bytes to the tx ring, waiting for free space if needed.
+ * The new data is published to the consumer every time the ring gets
+ * full, so messages larger than the ring are streamed through it.
+ */
+static int sch_shm_put (sch_shmdata_t *data, const void *buf, size_t len)
+{
+        sch_shmring_t *r = data->tx;
+        const uint8_t *src = buf;
+        uint64_t head, tail, off;
+        size_t   n, part;
+
+        head = __atomic_load_n (&r->head, __ATOMIC_RELAXED);
+
+        while (len > 0) {
+                tail = __atomic_load_n (&r->tail, __ATOMIC_ACQUIRE);
+
+                if (sch_shm_check (data, head, tail) != 0)
+                        return (-1);
+                if (head - tail == data->ringsize) {
+                        __atomic_store_n (&r->head, head, __ATOMIC_RELEASE);
+                        sch_shm_signal (&r->rwait, data->tx_data);
+
+                        switch (sch_shm_wait_ring (data, false, 0)) {
+                        case 0:
+                                continue;
+                        case 1:
+                                errno = EPIPE;
+                        }
+                        return (-1);
+                }
+
+                n    = (size_t)(data->ringsize - (head - tail));
+                n    = n < len ? n : len;
+                off  = head % data->ringsize;
+                part = (size_t)(data->ringsize - off);
+                part = part < n ? part : n;
+
+                memcpy (RDATA(r) + off, src, part);
+                memcpy (RDATA(r), src + part, n - part);
+
+                head += n;
+                src  += n;
+                len  -= n;
+        }
+
+        __atomic_store_n (&r->head, head, __ATOMIC_RELEASE);
+
+        return (0);
+}
+
+static char *sch_shm_envstr (const int fds[SCH_SHM_EVCNT + 1])
+{
+        char *str = sm_alloc (sizeof SCH_SHM_ENV + 1 + (SCH_SHM_EVCNT + 1) * 12);
+
+        /* the peer reads and writes the other way round */
+        sprintf (str, "%s=%d,%d,%d,%d,%d", SCH_SHM_ENV, fds[0], fds[3], fds[4], fds[1], fds[2]);
+
+        return (str);
+}
+
+int sch_shm_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
+{
+        sch_shmdata_t *data;
+        int    fds[SCH_SHM_EVCNT + 1], i;
+        size_t envc;
+        char **envp;
+
+        assume_r (desc != NULL, -1, errno = EFAULT;);
+        assume_r (uri  != NULL, -1, errno = EFAULT;);
+        assume_r (desc->scheme_data == NULL, -1, errno = EALREADY;);
+
+        data = sm_talloc (sch_shmdata_t);
+        memset (data, 0, sizeof (sch_shmdata_t));
+        data->mfd = data->rx_data = data->rx_space = data->tx_data = data->tx_space = -1;
+        data->pipe.pfd = -1;
+
+        /* fds[0] is the shared memory file, then tx data, tx space, rx data and rx space */
+        for (i = 0; i < SCH_SHM_EVCNT + 1; ++i)
+                fds[i] = -1;
+
+        fds[0] = memfd_create ("seap-shm", MFD_CLOEXEC);
+
+        if (fds[0] < 0 || ftruncate (fds[0], 2 * (sizeof (sch_shmring_t) + SCH_SHM_RINGSIZE)) != 0)
+                goto fail;
+
+        for (i = 1; i < SCH_SHM_EVCNT + 1; ++i) {
+                if ((fds[i] = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0)
+                        goto fail;
+        }
+
+        if (sch_shm_map (data, fds[0], false) != 0)
+                goto fail;
+
+        data->tx_data  = fds[1];
+        data->tx_space = fds[2];
+        data->rx_data  = fds[3];
+        data->rx_space = fds[4];
+        data->ringsize = data->tx->size = data->rx->size = SCH_SHM_RINGSIZE;
+
+        /* the peer inherits the environment with the descriptors added */
+        for (envc = 0; environ[envc] != NULL; ++envc);
+
+        envp = sm_alloc (sizeof (char *) * (envc + 2));
+        memcpy (envp, environ, sizeof (char *) * envc);
+        envp[envc]     = sch_shm_envstr (fds);
+        envp[envc + 1] = NULL;
+
+        i = sch_pipe_spawn (&data->pipe, uri, flags, fds, SCH_SHM_EVCNT + 1, envp);
+
+        protect_errno {
+                sm_free (envp[envc]);
+                sm_free (envp);
+        }
+
+        if (i != 0)
+                goto fail;
+
+        data->hfd = data->pipe.pfd;
+        desc->scheme_data = (void *)data;
+
+        return (0);
+fail:
+        protect_errno {
+                if (data->map == NULL) {
+                        for (i = 0; i < SCH_SHM_EVCNT + 1; ++i) {
+                                if (fds[i] != -1)
+                                        close (fds[i]);
+                        }
+                } else
+                        sch_shm_unmap (data);
+
+                sm_free (data);
+        }
+        return (-1);
+}
+
+int sch_shm_openfd (SEAP_desc_t *desc, int fd, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+/*
+ * Peer side: `ifd' is only watched for hangups and `ofd' is not used,
+ * the data is passed through the shared memory described by SCH_SHM_ENV.
+ */
+int sch_shm_openfd2 (SEAP_desc_t *desc, int ifd, int ofd, uint32_t flags)
+{
+        sch_shmdata_t *data;
+        const char *env;
+        int fds[SCH_SHM_EVCNT + 1], i;
+
+        env = getenv (SCH_SHM_ENV);
+
+        if (env == NULL ||
+            sscanf (env, "%d,%d,%d,%d,%d", &fds[0], &fds[1], &fds[2], &fds[3], &fds[4]) != SCH_SHM_EVCNT + 1) {
+                errno = EINVAL;
+                return (-1);
+        }
+
+        data = sm_talloc (sch_shmdata_t);
+        memset (data, 0, sizeof (sch_shmdata_t));
+        data->pipe.pfd = -1;
+
+        if (sch_shm_map (data, fds[0], true) != 0) {
+                protect_errno {
+                        sm_free (data);
+                }
+                return (-1);
+        }
+
+        data->tx_data  = fds[1];
+        data->tx_space = fds[2];
+        data->rx_data  = fds[3];
+        data->rx_space = fds[4];
+        data->hfd      = ifd;
+
+        /* the size is read only once, the peer can't change it afterwards */
+        data->ringsize = __atomic_load_n (&data->rx->size, __ATOMIC_RELAXED);
+
+        if (data->ringsize == 0 || data->ringsize > SCH_SHM_RINGSIZE ||
+            data->ringsize != __atomic_load_n (&data->tx->size, __ATOMIC_RELAXED))
+        {
+                dE("Invalid shm ring size: %"PRIu32, data->ringsize);
+                sch_shm_unmap (data);
+                sm_free (data);
+                errno = EINVAL;
+                return (-1);
+        }
+
+        /* don't pass the descriptors on to processes started by the peer */
+        unsetenv (SCH_SHM_ENV);
+
+        for (i = 0; i < SCH_SHM_EVCNT + 1; ++i)
+                fcntl (fds[i], F_SETFD, FD_CLOEXEC);
+
+        desc->scheme_data = (void *)data;
+
+        return (0);
+}
+
+ssize_t sch_shm_recv (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
+{
+        sch_shmdata_t *data;
+        sch_shmring_t *r;
+        uint64_t head, tail, off;
+        size_t   n, part;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+        assume_d (buf  != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        r = data->rx;
+
+        switch (sch_shm_wait_ring (data, true, 0)) {
+        case 0:
+                break;
+        case 1:
+                /* EOF, but drain whatever the peer managed to write */
+                if (__atomic_load_n (&r->head, __ATOMIC_ACQUIRE) == r->tail)
+                        return (0);
+                break;
+        default:
+                return (-1);
+        }
+
+        head = __atomic_load_n (&r->head, __ATOMIC_ACQUIRE);
+        tail = __atomic_load_n (&r->tail, __ATOMIC_RELAXED);
+
+        if (sch_shm_check (data, head, tail) != 0)
+                return (-1);
+
+        n    = (size_t)(head - tail);
+        n    = n < len ? n : len;
+        off  = tail % data->ringsize;
+        part = (size_t)(data->ringsize - off);
+        part = part < n ? part : n;
+
+        memcpy (buf, RDATA(r) + off, part);
+        memcpy ((uint8_t *)buf + part, RDATA(r), n - part);
+
+        __atomic_store_n (&r->tail, tail + n, __ATOMIC_RELEASE);
+        sch_shm_signal (&r->wwait, data->rx_space);
+
+        return ((ssize_t)n);
+}
+
+ssize_t sch_shm_send (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
+{
+        sch_shmdata_t *data;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+        assume_d (buf  != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        if (sch_shm_put (data, buf, len) != 0)
+                return (-1);
+
+        sch_shm_signal (&data->tx->rwait, data->tx_data);
+
+        return ((ssize_t)len);
+}
+
+ssize_t sch_shm_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
+{
+        sch_shmdata_t *data;
+        struct strblk *blk;
+        ssize_t   ret;
+        strbuf_t *sb;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+        assume_d (sexp != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        sb = strbuf_new (SEAP_STRBUF_MAX);
+
+        if (desc->flags & SEAP_DESCFLG_BSEND)
+                ret = SEXP_bframe_sbprint (sexp, sb);
+        else
+                ret = SEXP_sbprintf_t (sexp, sb);
+
+        if (ret != 0)
+                ret = -1;
+        else {
+                for (blk = sb->beg; blk != NULL; blk = blk->next) {
+                        if (sch_shm_put (data, blk->data, blk->size) != 0) {
+                                ret = -1;
+                                break;
+                        }
+                        ret += blk->size;
+                }
+
+                /* the consumer is woken up once per message */
+                sch_shm_signal (&data->tx->rwait, data->tx_data);
+        }
+
+        protect_errno {
+                strbuf_free (sb);
+        }
+
+        return (ret);
+}
+
+int sch_shm_close (SEAP_desc_t *desc, uint32_t flags)
+{
+        sch_shmdata_t *data;
+        int ret = 0;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        if (data->pipe.pid > 0)
+                ret = sch_pipe_reap (&data->pipe);
+        else if (data->hfd != -1)
+                close (data->hfd);
+
+        if (ret != 0)
+                return (-1);
+
+        sch_shm_unmap (data);
+        sm_free (data);
+
+        desc->scheme_data = NULL;
+
+        return (0);
+}
+
+int sch_shm_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags)
+{
+        sch_shmdata_t *data;
+
+        assume_d (desc != NULL, -1, errno = EFAULT;);
+
+        data = DATA(desc->scheme_data);
+
+        assume_r (data != NULL, -1, errno = EBADF;);
+
+        switch (ev) {
+        case SEAP_IO_EVREAD:
+                /* a hangup is reported as readable, recv returns EOF then */
+                return (sch_shm_wait_ring (data, true, timeout) < 0 ? -1 : 0);
+        case SEAP_IO_EVWRITE:
+                return (sch_shm_wait_ring (data, false, timeout) == 0 ? 0 : -1);
+        default:
+                abort ();
+        }
+
+        /* NOTREACHED */
+        return (-1);
+}
+
+#else /* HAVE_MEMFD_CREATE && HAVE_SYS_EVENTFD_H */
+
+int sch_shm_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+int sch_shm_openfd (SEAP_desc_t *desc, int fd, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+int sch_shm_openfd2 (SEAP_desc_t *desc, int ifd, int ofd, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+ssize_t sch_shm_recv (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+ssize_t sch_shm_send (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+ssize_t sch_shm_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+int sch_shm_close (SEAP_desc_t *desc, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+int sch_shm_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags)
+{
+        errno = EOPNOTSUPP;
+        return (-1);
+}
+
+#endif /* HAVE_MEMFD_CREATE && HAVE_SYS_EVENTFD_H */
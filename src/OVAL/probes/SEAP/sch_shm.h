@@ -0,0 +1,81 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+#ifndef SCH_SHM_H
+#define SCH_SHM_H
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "sch_pipe.h"
+#include "../../../common/util.h"
+
+OSCAP_HIDDEN_START;
+
+/*
+ * The shm scheme starts the peer the same way as the pipe scheme, but the
+ * data is passed through two single producer/single consumer ring buffers
+ * placed in a shared memory file. The socket connecting both processes is
+ * kept only to detect that the peer went away. A consumer waiting for data
+ * and a producer waiting for free space sleep on an eventfd which is
+ * signaled by the other side only if the wait flag in the ring is set.
+ *
+ * The peer finds the shared memory file and the eventfds in the
+ * environment variable SCH_SHM_ENV, which also makes SEAP_openfd2 use
+ * this scheme instead of the generic one.
+ */
+#define SCH_SHM_ENV      "SEAP_SHM_FDS"
+#define SCH_SHM_RINGSIZE (1024 * 1024)
+
+typedef struct {
+        uint64_t head;  /* bytes written, updated by the producer */
+        uint64_t tail;  /* bytes read, updated by the consumer */
+        uint32_t rwait; /* the consumer waits for data */
+        uint32_t wwait; /* the producer waits for free space */
+        uint32_t size;  /* size of the data area */
+        uint8_t  _pad[64 - 2 * sizeof(uint64_t) - 3 * sizeof(uint32_t)];
+} sch_shmring_t;
+
+typedef struct {
+        sch_pipedata_t  pipe;     /* peer process; unused on the peer's side */
+        int             hfd;      /* hangup of this fd means the peer is gone */
+        int             mfd;      /* shared memory file */
+        void           *map;
+        size_t          mapsize;
+        sch_shmring_t  *rx;
+        sch_shmring_t  *tx;
+        int             rx_data;  /* signaled when rx has new data */
+        int             rx_space; /* signal when rx was consumed */
+        int             tx_data;  /* signal when tx has new data */
+        int             tx_space; /* signaled when tx was consumed */
+        uint32_t        ringsize; /* size of both data areas, checked at attach */
+} sch_shmdata_t;
+
+int sch_shm_connect (SEAP_desc_t *desc, const char *uri, uint32_t flags);
+int sch_shm_openfd (SEAP_desc_t *desc, int fd, uint32_t flags);
+int sch_shm_openfd2 (SEAP_desc_t *desc, int ifd, int ofd, uint32_t flags);
+ssize_t sch_shm_recv (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags);
+ssize_t sch_shm_send (SEAP_desc_t *desc, void *buf, size_t len, uint32_t flags);
+ssize_t sch_shm_sendsexp (SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags);
+int sch_shm_close (SEAP_desc_t *desc, uint32_t flags);
+int sch_shm_select (SEAP_desc_t *desc, int ev, uint16_t timeout, uint32_t flags);
+
+OSCAP_HIDDEN_END;
+
+#endif /* SCH_SHM_H */
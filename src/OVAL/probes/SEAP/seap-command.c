@@ -387,6 +387,20 @@ SEXP_t *SEAP_cmd_exec (SEAP_CTX_t    *ctx,
                                 for (;;) {
                                         pthread_mutex_unlock(&h.mtx);
 
+                                        if ((flags & SEAP_EXEC_TIMEOUT) &&
+                                            SEAP_packetq_count(&dsc->pck_queue) == 0 &&
+                                            SCH_SELECT(dsc->scheme, dsc, SEAP_IO_EVREAD, ctx->recv_timeout, 0) != 0)
+                                        {
+                                                protect_errno {
+                                                        dI("FAIL: no reply: ctx=%p, sd=%d, errno=%u, %s.", ctx, sd, errno, strerror(errno));
+                                                        SEAP_cmdtbl_del(dsc->cmd_w_table, rec);
+                                                        pthread_cond_destroy(&h.cond);
+                                                        pthread_mutex_destroy(&h.mtx);
+                                                        SEAP_packet_free(packet);
+                                                }
+                                                return(NULL);
+                                        }
+
                                         if (SEAP_packet_recv(ctx, sd, &packet_rcv) != 0) {
                                                 dI("FAIL: ctx=%p, sd=%d, errno=%u, %s.", ctx, sd, errno, strerror(errno));
                                                 return(NULL);
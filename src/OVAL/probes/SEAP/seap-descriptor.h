@@ -51,6 +51,7 @@ typedef struct {
         SEXP_pstate_t *pstate; /* Parser state */
         SEAP_scheme_t  scheme; /* Protocol/Scheme used for this descriptor */
         void          *scheme_data; /* Protocol/Scheme related data */
+        uint32_t       flags; /* SEAP_DESCFLG_* */
 
         SEXP_t *msg_queue;
 	rbt_t  *err_queue;
@@ -70,6 +71,9 @@ typedef struct {
 #define SEAP_DESC_FDOUT 0x00000002
 #define SEAP_DESC_SELF  -1
 
+#define SEAP_DESCFLG_BSEND 0x00000001 /* send binary frames (see public/sexp-binary.h) */
+#define SEAP_DESCFLG_BRECV 0x00000002 /* receive binary frames */
+
 typedef struct {
         rbt_t       *tree;
         bitmap_t    *bmap;
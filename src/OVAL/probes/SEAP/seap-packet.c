@@ -27,10 +27,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
 
 #include "generic/common.h"
 #include "public/sexp-manip.h"
 #include "_sexp-parser.h"
+#include "public/sexp-binary.h"
 #include "_seap-packetq.h"
 #include "_seap-packet.h"
 #include "_seap-scheme.h"
@@ -589,6 +592,87 @@ static SEXP_t *SEAP_packet2sexp (SEAP_packet_t *packet)
         return (sexp);
 }
 
+/*
+ * Read exactly `len' bytes. The returned count is less than `len' only
+ * if the peer closed the connection.
+ */
+static ssize_t SEAP_packet_recvn (SEAP_CTX_t *ctx, SEAP_desc_t *dsc, void *buf, size_t len, bool wait)
+{
+        size_t  off = 0;
+        ssize_t ret;
+
+        while (off < len) {
+                if (wait && SCH_SELECT(dsc->scheme, dsc, SEAP_IO_EVREAD, ctx->recv_timeout, 0) != 0)
+                        return (-1);
+
+                ret = SCH_RECV(dsc->scheme, dsc, (uint8_t *)buf + off, len - off, 0);
+
+                if (ret < 0)
+                        return (-1);
+                else if (ret == 0)
+                        break;
+
+                off += ret;
+                wait = true;
+        }
+
+        return ((ssize_t)off);
+}
+
+/*
+ * Receive one binary frame (see public/sexp-binary.h). The caller holds the
+ * read lock and a read event was already signaled.
+ */
+static SEXP_t *SEAP_packet_recv_bframe (SEAP_CTX_t *ctx, SEAP_desc_t *dsc)
+{
+        uint8_t  hdr[SEXP_BFRAME_HDRSIZE];
+        uint32_t len;
+        ssize_t  ret;
+        void    *payload;
+        SEXP_t  *sexp;
+
+        ret = SEAP_packet_recvn (ctx, dsc, hdr, sizeof hdr, false);
+
+        if (ret < 0)
+                return (NULL);
+        else if (ret == 0) {
+                dI("zero bytes received -> EOF");
+                errno = ECONNABORTED;
+                return (NULL);
+        } else if ((size_t)ret < sizeof hdr) {
+                dI("FAIL: incomplete frame header received");
+                errno = ENETRESET;
+                return (NULL);
+        }
+
+        if (SEXP_bframe_hdrparse (hdr, &len) != 0 || len == 0) {
+                dI("FAIL: invalid frame header received");
+                errno = EILSEQ;
+                return (NULL);
+        }
+
+        payload = sm_alloc (len);
+        ret = SEAP_packet_recvn (ctx, dsc, payload, len, true);
+
+        if (ret != (ssize_t)len) {
+                protect_errno {
+                        dI("FAIL: incomplete frame received: %zd of %" PRIu32 " bytes", ret, len);
+                        sm_free (payload);
+                }
+                if (ret >= 0)
+                        errno = ENETRESET;
+                return (NULL);
+        }
+
+        sexp = SEXP_bdecode (payload, len);
+
+        protect_errno {
+                sm_free (payload);
+        }
+
+        return (sexp);
+}
+
 int SEAP_packet_recv (SEAP_CTX_t *ctx, int sd, SEAP_packet_t **packet)
 {
         SEAP_desc_t *dsc;
@@ -664,6 +748,29 @@ eloop_start:
         }
 eloop_exit:
 
+        if (dsc->flags & SEAP_DESCFLG_BRECV) {
+                /*
+                 * A binary frame carries exactly one packet and its
+                 * length is known in advance, no parsing loop needed.
+                 */
+                sexp_packet = SEAP_packet_recv_bframe (ctx, dsc);
+
+                if (sexp_packet == NULL) {
+                        protect_errno {
+                                DESC_RUNLOCK(dsc);
+                                dI("FAIL: recv failed: dsc=%p, errno=%u, %s.", dsc, errno, strerror (errno));
+                        }
+                        return (-1);
+                }
+
+                DESC_RUNLOCK(dsc);
+
+                sexp_buffer = SEXP_list_new (sexp_packet, NULL);
+                SEXP_free (sexp_packet);
+
+                goto packet_dispatch;
+        }
+
         /*
          * Receive loop
          * The read mutex is locked during execution of this loop and
@@ -770,6 +877,7 @@ eloop_exit:
         }
 
         SEXP_psetup_free (psetup);
+packet_dispatch:
 	SEXP_VALIDATE(sexp_buffer);
 	(*packet) = NULL;
 
@@ -61,6 +61,9 @@ static void SEAP_CTX_initdefault (SEAP_CTX_t *ctx)
         ctx->send_timeout = 5;
         ctx->cflags       = 0;
 
+        if (getenv ("SEAP_BINARY_DISABLE") == NULL)
+                ctx->cflags |= SEAP_CFLG_BINARY;
+
         return;
 }
 
@@ -91,6 +94,79 @@ void SEAP_CTX_free (SEAP_CTX_t *ctx)
         return;
 }
 
+/*
+ * Ask the peer to switch the connection to binary frames. The request
+ * itself is sent as text and the peer starts to accept binary frames
+ * before it replies, so any packet sent after the reply may be binary.
+ * A peer which doesn't support binary frames replies without arguments
+ * and the connection stays textual.
+ */
+static int SEAP_negotiate_binary (SEAP_CTX_t *ctx, int sd, SEAP_desc_t *dsc)
+{
+        SEAP_packet_t *packet;
+        SEAP_packetq_t queue;
+        SEAP_cmd_t    *cmd;
+        SEAP_cmdid_t   id;
+        int ret = 0;
+
+        packet = SEAP_packet_new ();
+        cmd    = SEAP_packet_settype (packet, SEAP_PACKET_CMD);
+
+        cmd->id    = id = SEAP_desc_gencmdid (ctx->sd_table, sd);
+        cmd->rid   = 0;
+        cmd->class = SEAP_CMDCLASS_INT;
+        cmd->code  = SEAP_CMDINT_BINARY;
+        cmd->args  = NULL;
+        cmd->flags = SEAP_CMDFLAG_SYNC;
+
+        if (SEAP_packet_send (ctx, sd, packet) != 0) {
+                protect_errno {
+                        SEAP_packet_free (packet);
+                }
+                return (-1);
+        }
+
+        SEAP_packet_free (packet);
+
+        /*
+         * Packets received before the reply are put back to the
+         * descriptor's queue once the reply arrives.
+         */
+        SEAP_packetq_init (&queue);
+
+        for (;;) {
+                packet = NULL;
+
+                if (SEAP_packet_recv (ctx, sd, &packet) != 0) {
+                        ret = -1;
+                        break;
+                }
+
+                if (SEAP_packet_gettype (packet) == SEAP_PACKET_CMD) {
+                        cmd = SEAP_packet_cmd (packet);
+
+                        if ((cmd->flags & SEAP_CMDFLAG_REPLY) && cmd->rid == id) {
+                                if (cmd->args != NULL) {
+                                        dsc->flags |= SEAP_DESCFLG_BSEND | SEAP_DESCFLG_BRECV;
+                                        SEXP_free (cmd->args);
+                                }
+
+                                SEAP_packet_free (packet);
+                                break;
+                        }
+                }
+
+                SEAP_packetq_put (&queue, packet);
+        }
+
+        while (SEAP_packetq_get (&queue, &packet) != -1)
+                SEAP_packetq_put (&dsc->pck_queue, packet);
+
+        SEAP_packetq_free (&queue);
+
+        return (ret);
+}
+
 int SEAP_connect (SEAP_CTX_t *ctx, const char *uri, uint32_t flags)
 {
         SEAP_desc_t  *dsc;
@@ -134,6 +210,11 @@ int SEAP_connect (SEAP_CTX_t *ctx, const char *uri, uint32_t flags)
                 return (-1);
         }
 
+        if (ctx->cflags & SEAP_CFLG_BINARY) {
+                if (SEAP_negotiate_binary (ctx, sd, dsc) != 0)
+                        dI("Binary frames not negotiated: errno=%u, %s.", errno, strerror (errno));
+        }
+
         return (sd);
 }
 
@@ -151,10 +232,18 @@ int SEAP_openfd (SEAP_CTX_t *ctx, int fd, uint32_t flags)
 
 int SEAP_openfd2 (SEAP_CTX_t *ctx, int ifd, int ofd, uint32_t flags)
 {
-        SEAP_desc_t *dsc;
+        SEAP_desc_t  *dsc;
+        SEAP_scheme_t scheme;
         int sd;
 
-        sd = SEAP_desc_add (ctx->sd_table, NULL, SCH_GENERIC, NULL);
+        /*
+         * A peer started by the shm scheme finds the shared memory
+         * in its environment, the descriptors are used only to detect
+         * that the other side went away.
+         */
+        scheme = getenv (SCH_SHM_ENV) != NULL ? SCH_SHM : SCH_GENERIC;
+
+        sd = SEAP_desc_add (ctx->sd_table, NULL, scheme, NULL);
 
         if (sd < 0) {
                 dI("Can't create/add new SEAP descriptor");
@@ -168,7 +257,7 @@ int SEAP_openfd2 (SEAP_CTX_t *ctx, int ifd, int ofd, uint32_t flags)
                 return(-1);
         }
 
-        if (SCH_OPENFD2(SCH_GENERIC, dsc, ifd, ofd, flags) != 0) {
+        if (SCH_OPENFD2(scheme, dsc, ifd, ofd, flags) != 0) {
                 dI("FAIL: errno=%u, %s.", errno, strerror (errno));
                 return (-1);
         }
@@ -203,9 +292,20 @@ static int __SEAP_cmdexec_reply (SEAP_CTX_t *ctx, int sd, SEAP_cmd_t *cmd)
         if (dsc == NULL)
                 return (-1);
 
-        res = SEAP_cmd_exec (ctx, sd, SEAP_EXEC_LOCAL,
-                             cmd->code, cmd->args,
-                             SEAP_CMDCLASS_USR, NULL, NULL);
+        if (cmd->class == SEAP_CMDCLASS_INT) {
+                /*
+                 * Binary frames are accepted right away, but the
+                 * reply is still sent as text (see SEAP_negotiate_binary)
+                 */
+                if (cmd->code == SEAP_CMDINT_BINARY && (ctx->cflags & SEAP_CFLG_BINARY)) {
+                        dsc->flags |= SEAP_DESCFLG_BRECV;
+                        res = SEXP_number_newb (true);
+                } else
+                        res = NULL;
+        } else
+                res = SEAP_cmd_exec (ctx, sd, SEAP_EXEC_LOCAL,
+                                     cmd->code, cmd->args,
+                                     SEAP_CMDCLASS_USR, NULL, NULL);
 
         packet = SEAP_packet_new ();
         cmdrep = SEAP_packet_settype (packet, SEAP_PACKET_CMD);
@@ -225,9 +325,13 @@ static int __SEAP_cmdexec_reply (SEAP_CTX_t *ctx, int sd, SEAP_cmd_t *cmd)
                 return (-1);
         }
 
-        if (res != NULL)
+        if (res != NULL) {
+                if (cmd->class == SEAP_CMDCLASS_INT)
+                        dsc->flags |= SEAP_DESCFLG_BSEND;
+
                 SEXP_free(res);
-        
+        }
+
         SEAP_packet_free (packet);
 
         return (0);
@@ -34,6 +34,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -48,80 +49,121 @@
 #include "_sexp-rawptr.h"
 #include "_sexp-ID.h"
 
-#include "MurmurHash3.h"
+/*
+ * The ID is a 64-bit hash of the whole S-exp computed in a single pass:
+ * every value is mixed into one running state together with a tag that
+ * keeps the structure of the lists, and the state is finalized once.
+ * Mixing is done 8 bytes at a time (the MurmurHash64A step).
+ */
+#define SEXP_ID_M 0xc6a4a7935bd1e995ULL
+#define SEXP_ID_R 47
 
-static SEXP_ID_t SEXP_ID_hash(void *buf, size_t len, SEXP_ID_t seed, int part)
-{
-        uint64_t resbuf[2];
+#define SEXP_ID_TAG_EMPTY 0x01
+#define SEXP_ID_TAG_LIST  0x02
+#define SEXP_ID_TAG_END   0x03
 
-	assume_d(part == 0 || part == 1, -1);
+static inline uint64_t SEXP_ID_mix(uint64_t h, uint64_t k)
+{
+        k *= SEXP_ID_M;
+        k ^= k >> SEXP_ID_R;
+        k *= SEXP_ID_M;
 
-        MurmurHash3_x86_128(buf, (int)len, (uint32_t)((0x7C0FFEE7 ^ seed) ^ (seed >> 32)), resbuf);
+        h ^= k;
+        h *= SEXP_ID_M;
 
-        return (resbuf[part]);
+        return (h);
 }
 
-static int SEXP_ID_v_callback(const SEXP_t *sexp, __IDres_pair *pair)
+static uint64_t SEXP_ID_bytes(uint64_t h, const uint8_t *buf, size_t len)
 {
-        SEXP_val_t v_dsc;
+        uint64_t k;
+
+        h ^= len * SEXP_ID_M;
+
+        while (len >= sizeof k) {
+                memcpy(&k, buf, sizeof k);
+                h    = SEXP_ID_mix(h, k);
+                buf += sizeof k;
+                len -= sizeof k;
+        }
+
+        if (len > 0) {
+                k = 0;
+                memcpy(&k, buf, len);
+                h = SEXP_ID_mix(h, k);
+        }
 
-        assume_d(sexp != NULL, -1);
-        assume_d(pair != NULL, -1);
+        return (h);
+}
 
-        /*
-         * Fill v_dsc with metainformation
-         */
-        SEXP_val_dsc(&v_dsc, sexp->s_valp);
+static uint64_t SEXP_ID_value(uint64_t h, uintptr_t valp)
+{
+        SEXP_valhdr_t *hdr  = SEXP_VALP_HDR(valp);
+        SEXP_valtype_t type = valp & SEXP_VALT_MASK;
 
-        switch (v_dsc.type) {
+        switch (type) {
         case SEXP_VALTYPE_NUMBER:
         case SEXP_VALTYPE_STRING:
-                pair->hash = SEXP_ID_hash(v_dsc.mem, v_dsc.hdr->size, pair->hash, pair->part);
+                h = SEXP_ID_mix(h, type);
+                h = SEXP_ID_bytes(h, (const uint8_t *)(hdr + 1), hdr->size);
                 break;
         case SEXP_VALTYPE_LIST:
         {
-                SEXP_rawval_lblk_cb ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
-                                     (int (*)(SEXP_t *, void *)) SEXP_ID_v_callback,
-                                     (void *) pair,
-                                     SEXP_LCASTP(v_dsc.mem)->offset + 1);
-
-                pair->hash = SEXP_ID_hash(&pair->hash, 1,
-					  pair->hash + SEXP_LCASTP(v_dsc.mem)->offset, pair->part);
+                struct SEXP_val_list *list = SEXP_LCASTP(hdr + 1);
+                struct SEXP_val_lblk *lblk = SEXP_VALP_LBLK(list->b_addr);
+                uint32_t skip = list->offset;
+                uint32_t left = list->length;
+                uint16_t i;
+
+                h = SEXP_ID_mix(h, SEXP_ID_TAG_LIST);
+
+                while (lblk != NULL && left > 0) {
+                        if (skip >= lblk->real) {
+                                skip -= lblk->real;
+                        } else {
+                                for (i = skip; i < lblk->real && left > 0; ++i, --left)
+                                        h = SEXP_ID_value(h, lblk->memb[i].s_valp);
+                                skip = 0;
+                        }
+
+                        lblk = SEXP_VALP_LBLK(lblk->nxsz);
+                }
+
+                h = SEXP_ID_mix(h, SEXP_ID_TAG_END ^ ((uint64_t)list->length << 8));
                 break;
         }
         case SEXP_VALTYPE_EMPTY:
-                pair->hash = SEXP_ID_hash(&pair->hash, 1, pair->hash, pair->part);
+                h = SEXP_ID_mix(h, SEXP_ID_TAG_EMPTY);
                 break;
         default:
                 /* Unknown S-exp value type */
                 abort ();
         }
 
-        return (0);
+        return (h);
 }
 
-SEXP_ID_t SEXP_ID_v(const SEXP_t *s)
+static SEXP_ID_t SEXP_ID_final(uint64_t h)
 {
-	__IDres_pair pair;
+        h ^= h >> SEXP_ID_R;
+        h *= SEXP_ID_M;
+        h ^= h >> SEXP_ID_R;
 
-        pair.hash = 0xAD30917100C0FFEE;
-	pair.part = 0;
+        return (h);
+}
 
-        SEXP_ID_v_callback(s, &pair);
+SEXP_ID_t SEXP_ID_v(const SEXP_t *s)
+{
+        assume_d(s != NULL, 0);
 
-        return (pair.hash);
+        return SEXP_ID_final(SEXP_ID_value(0xAD30917100C0FFEE, s->s_valp));
 }
 
 SEXP_ID_t SEXP_ID_v2(const SEXP_t *s)
 {
-	__IDres_pair pair;
-
-        pair.hash = 0xAD309171FFC0FFEE;
-	pair.part = 1;
-
-        SEXP_ID_v_callback(s, &pair);
+        assume_d(s != NULL, 0);
 
-        return (pair.hash);
+        return SEXP_ID_final(SEXP_ID_value(0xAD309171FFC0FFEE, s->s_valp));
 }
 
 /// @}
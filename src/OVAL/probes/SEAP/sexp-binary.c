@@ -0,0 +1,355 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "generic/common.h"
+#include "public/strbuf.h"
+#include "public/sm_alloc.h"
+#include "public/sexp-manip.h"
+#include "_sexp-types.h"
+#include "_sexp-value.h"
+#include "_sexp-datatype.h"
+#include "_sexp-rawptr.h"
+#include "public/sexp-binary.h"
+
+static int SEXP_bencode_varint (strbuf_t *sb, uint8_t tag, size_t n)
+{
+        uint8_t buffer[1 + (sizeof (size_t) * 8 + 6) / 7];
+        size_t  l = 0;
+
+        buffer[l++] = tag;
+
+        do {
+                buffer[l] = n & 0x7f;
+                n >>= 7;
+
+                if (n != 0)
+                        buffer[l] |= 0x80;
+                ++l;
+        } while (n != 0);
+
+        return strbuf_add (sb, (const char *)buffer, l);
+}
+
+static int SEXP_bencode_lmemb (SEXP_t *s_exp, void *arg)
+{
+        return SEXP_bencode (s_exp, (strbuf_t *)arg);
+}
+
+int SEXP_bencode (const SEXP_t *s_exp, strbuf_t *sb)
+{
+        SEXP_val_t v_dsc;
+
+        if (SEXP_rawptr_mask(s_exp->s_type, SEXP_DATATYPEPTR_MASK) != NULL) {
+                const char *name;
+                size_t      len;
+
+                name = SEXP_datatype_name(s_exp->s_type);
+                len  = strlen (name);
+
+                if (SEXP_bencode_varint (sb, SEXP_BTAG_DTYPE, len) != 0 ||
+                    strbuf_add (sb, name, len) != 0)
+                        return (-1);
+        }
+
+        SEXP_val_dsc (&v_dsc, s_exp->s_valp);
+
+        switch (v_dsc.type) {
+        case SEXP_VALTYPE_NUMBER:
+        {
+                uint8_t buffer[2 + sizeof (uint64_t)];
+                size_t  size;
+
+                /* the value is stored as { n, t }, see SEXP_DEFNUM */
+                size = v_dsc.hdr->size - sizeof (SEXP_numtype_t);
+
+                _A(size <= sizeof (uint64_t));
+
+                buffer[0] = SEXP_BTAG_NUMBER;
+                buffer[1] = SEXP_NTYPEP(v_dsc.hdr->size, v_dsc.mem);
+                memcpy (buffer + 2, v_dsc.mem, size);
+
+                return strbuf_add (sb, (const char *)buffer, size + 2);
+        }
+        case SEXP_VALTYPE_STRING:
+                if (SEXP_bencode_varint (sb, SEXP_BTAG_STRING, v_dsc.hdr->size) != 0)
+                        return (-1);
+
+                return strbuf_add (sb, (const char *)v_dsc.mem, v_dsc.hdr->size);
+        case SEXP_VALTYPE_LIST:
+                if (strbuf_addc (sb, SEXP_BTAG_LIST) != 0)
+                        return (-1);
+                if (SEXP_rawval_lblk_cb ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, &SEXP_bencode_lmemb, (void *)sb,
+                                         SEXP_LCASTP(v_dsc.mem)->offset + 1) != 0)
+                        return (-1);
+
+                return strbuf_addc (sb, SEXP_BTAG_END);
+        default:
+                errno = EINVAL;
+                return (-1);
+        }
+}
+
+typedef struct {
+        const uint8_t *cur;
+        const uint8_t *end;
+        unsigned int   depth;
+} SEXP_bdecoder_t;
+
+static int SEXP_bdecode_varint (SEXP_bdecoder_t *d, size_t *n)
+{
+        size_t       v = 0;
+        unsigned int s = 0;
+
+        while (d->cur < d->end && s < sizeof (size_t) * 8) {
+                uint8_t b = *d->cur++;
+
+                v |= (size_t)(b & 0x7f) << s;
+
+                if ((b & 0x80) == 0) {
+                        *n = v;
+                        return (0);
+                }
+
+                s += 7;
+        }
+
+        return (-1);
+}
+
+static SEXP_datatypePtr_t *SEXP_bdecode_datatype (SEXP_bdecoder_t *d)
+{
+        SEXP_datatypePtr_t *dt;
+        char   name_static[64];
+        char  *name;
+        size_t len;
+
+        if (SEXP_bdecode_varint (d, &len) != 0 || len > (size_t)(d->end - d->cur))
+                return (NULL);
+
+        name = len < sizeof name_static ? name_static : sm_alloc (len + 1);
+        memcpy (name, d->cur, len);
+        name[len] = '\0';
+        d->cur += len;
+
+        dt = SEXP_datatype_get (&g_datatypes, name);
+
+        if (dt == NULL) {
+                if (name == name_static) {
+                        name = sm_alloc (len + 1);
+                        memcpy (name, name_static, len + 1);
+                }
+
+                dt = SEXP_datatype_add (&g_datatypes, name, NULL, NULL);
+
+                if (dt == NULL)
+                        sm_free (name);
+        } else if (name != name_static)
+                sm_free (name);
+
+        return (dt);
+}
+
+static SEXP_t *SEXP_bdecode_number (SEXP_bdecoder_t *d)
+{
+        SEXP_numtype_t t;
+        SEXP_val_t     v_dsc;
+        SEXP_t        *s_exp;
+        size_t         size;
+
+        if (d->cur >= d->end)
+                return (NULL);
+
+        switch (t = *d->cur++) {
+        case SEXP_NUM_BOOL:
+                size = sizeof (struct SEXP_val_num_b);
+                break;
+        case SEXP_NUM_INT8:
+        case SEXP_NUM_UINT8:
+                size = sizeof (struct SEXP_val_num_i8);
+                break;
+        case SEXP_NUM_INT16:
+        case SEXP_NUM_UINT16:
+                size = sizeof (struct SEXP_val_num_i16);
+                break;
+        case SEXP_NUM_INT32:
+        case SEXP_NUM_UINT32:
+                size = sizeof (struct SEXP_val_num_i32);
+                break;
+        case SEXP_NUM_INT64:
+        case SEXP_NUM_UINT64:
+                size = sizeof (struct SEXP_val_num_i64);
+                break;
+        case SEXP_NUM_DOUBLE:
+                size = sizeof (struct SEXP_val_num_f);
+                break;
+        default:
+                return (NULL);
+        }
+
+        if (size - sizeof (SEXP_numtype_t) > (size_t)(d->end - d->cur))
+                return (NULL);
+        if (SEXP_val_new (&v_dsc, size, SEXP_VALTYPE_NUMBER) != 0)
+                return (NULL);
+
+        memcpy (v_dsc.mem, d->cur, size - sizeof (SEXP_numtype_t));
+        SEXP_NTYPEP(size, v_dsc.mem) = t;
+        d->cur += size - sizeof (SEXP_numtype_t);
+
+        s_exp = SEXP_new ();
+        s_exp->s_valp = SEXP_val_ptr (&v_dsc);
+
+        return (s_exp);
+}
+
+static SEXP_t *SEXP_bdecode_sexp (SEXP_bdecoder_t *d)
+{
+        SEXP_datatypePtr_t *dt = NULL;
+        SEXP_t *s_exp, *memb;
+        size_t  len;
+
+        if (d->cur < d->end && *d->cur == SEXP_BTAG_DTYPE) {
+                ++d->cur;
+
+                if ((dt = SEXP_bdecode_datatype (d)) == NULL)
+                        return (NULL);
+        }
+
+        if (d->cur >= d->end)
+                return (NULL);
+
+        switch (*d->cur++) {
+        case SEXP_BTAG_STRING:
+                if (SEXP_bdecode_varint (d, &len) != 0 || len > (size_t)(d->end - d->cur))
+                        return (NULL);
+
+                s_exp = SEXP_string_new (d->cur, len);
+                d->cur += len;
+                break;
+        case SEXP_BTAG_NUMBER:
+                s_exp = SEXP_bdecode_number (d);
+                break;
+        case SEXP_BTAG_LIST:
+                if (++d->depth > SEXP_BDECODE_MAXDEPTH)
+                        return (NULL);
+
+                s_exp = SEXP_list_new (NULL);
+
+                for (;;) {
+                        if (d->cur >= d->end) {
+                                SEXP_free (s_exp);
+                                return (NULL);
+                        }
+
+                        if (*d->cur == SEXP_BTAG_END) {
+                                ++d->cur;
+                                break;
+                        }
+
+                        if ((memb = SEXP_bdecode_sexp (d)) == NULL) {
+                                SEXP_free (s_exp);
+                                return (NULL);
+                        }
+
+                        SEXP_list_add (s_exp, memb);
+                        SEXP_free (memb);
+                }
+
+                --d->depth;
+                break;
+        default:
+                return (NULL);
+        }
+
+        if (s_exp != NULL)
+                s_exp->s_type = dt;
+
+        return (s_exp);
+}
+
+SEXP_t *SEXP_bdecode (const void *buf, size_t len)
+{
+        SEXP_bdecoder_t d;
+        SEXP_t *s_exp;
+
+        d.cur   = (const uint8_t *)buf;
+        d.end   = d.cur + len;
+        d.depth = 0;
+
+        s_exp = SEXP_bdecode_sexp (&d);
+
+        if (s_exp != NULL && d.cur != d.end) {
+                SEXP_free (s_exp);
+                s_exp = NULL;
+        }
+
+        if (s_exp == NULL)
+                errno = EILSEQ;
+
+        return (s_exp);
+}
+
+int SEXP_bframe_sbprint (const SEXP_t *s_exp, strbuf_t *sb)
+{
+        uint8_t  hdr[SEXP_BFRAME_HDRSIZE] = { SEXP_BFRAME_MAGIC, 0, 0, 0, 0 };
+        uint32_t len;
+        size_t   size;
+
+        /* the length is filled in after the payload is written */
+        if (strbuf_size (sb) != 0 || sb->blkmax < SEXP_BFRAME_HDRSIZE) {
+                errno = EINVAL;
+                return (-1);
+        }
+
+        if (strbuf_add (sb, (const char *)hdr, sizeof hdr) != 0 ||
+            SEXP_bencode (s_exp, sb) != 0)
+                return (-1);
+
+        size = strbuf_size (sb) - SEXP_BFRAME_HDRSIZE;
+
+        if (size > UINT32_MAX) {
+                errno = EFBIG;
+                return (-1);
+        }
+
+        len = (uint32_t)size;
+        memcpy (sb->beg->data + 1, &len, sizeof len);
+
+        return (0);
+}
+
+int SEXP_bframe_hdrparse (const void *hdr, uint32_t *len)
+{
+        const uint8_t *h = (const uint8_t *)hdr;
+
+        if (h[0] != SEXP_BFRAME_MAGIC) {
+                errno = EILSEQ;
+                return (-1);
+        }
+
+        memcpy (len, h + 1, sizeof *len);
+
+        return (0);
+}
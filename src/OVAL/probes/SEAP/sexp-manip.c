@@ -938,6 +938,49 @@ SEXP_t *SEXP_list_new (SEXP_t *memb, ...)
         return (list);
 }
 
+SEXP_t *SEXP_list_new_array (SEXP_t *memb[], size_t count)
+{
+        SEXP_t    *list;
+        SEXP_val_t v_dsc;
+        uintptr_t  lblk, prev;
+        uint8_t    b_exp;
+        size_t     n;
+
+        if (memb == NULL && count > 0) {
+                errno = EFAULT;
+                return (NULL);
+        }
+
+        list = SEXP_list_new (NULL);
+        SEXP_val_dsc (&v_dsc, list->s_valp);
+        prev = 0;
+
+        /*
+         * The number of members in a block is 16-bit, so
+         * chain as many of the largest blocks as needed.
+         */
+        while (count > 0) {
+                for (b_exp = 0; b_exp < 15 && ((size_t)1 << b_exp) < count; ++b_exp);
+
+                n    = count < ((size_t)1 << b_exp) ? count : ((size_t)1 << b_exp);
+                lblk = SEXP_rawval_lblk_new (b_exp);
+                SEXP_rawval_lblk_fill (lblk, memb, (uint16_t)n);
+
+                if (prev == 0)
+                        SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)lblk;
+                else
+                        SEXP_VALP_LBLK(prev)->nxsz = (lblk & SEXP_LBLKP_MASK) | (SEXP_VALP_LBLK(prev)->nxsz & SEXP_LBLKS_MASK);
+
+                prev   = lblk;
+                memb  += n;
+                count -= n;
+        }
+
+        SEXP_rawval_list_sync (SEXP_LCASTP(v_dsc.mem));
+
+        return (list);
+}
+
 void SEXP_list_free (SEXP_t *s_exp)
 {
         SEXP_VALIDATE(s_exp);
@@ -996,8 +1039,7 @@ SEXP_t *SEXP_list_first (const SEXP_t *list)
                 return (NULL);
         }
 
-        s_exp = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
-                                      SEXP_LCASTP(v_dsc.mem)->offset + 1);
+        s_exp = SEXP_rawval_list_nth (SEXP_LCASTP(v_dsc.mem), 1);
 
         return (s_exp == NULL ? NULL : SEXP_ref (s_exp));
 }
@@ -1024,8 +1066,7 @@ SEXP_t *SEXP_listref_first (SEXP_t *list)
                 return (NULL);
         }
 
-        s_exp = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
-                                      SEXP_LCASTP(v_dsc.mem)->offset + 1);
+        s_exp = SEXP_rawval_list_nth (SEXP_LCASTP(v_dsc.mem), 1);
 
         return (s_exp == NULL ? NULL : SEXP_softref (s_exp));
 }
@@ -1065,9 +1106,9 @@ SEXP_t *SEXP_list_last (const SEXP_t *list)
                 return (NULL);
         }
 
-        l_blk = SEXP_VALP_LBLK(SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr));
+        l_blk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_last);
 
-        if (l_blk == NULL)
+        if (l_blk == NULL || SEXP_LCASTP(v_dsc.mem)->length == 0)
                 return (NULL);
 
         return (SEXP_ref (l_blk->memb + (l_blk->real - 1)));
@@ -1109,6 +1150,12 @@ SEXP_t *SEXP_list_replace (SEXP_t *list, uint32_t n, const SEXP_t *n_val)
         SEXP_LCASTP(v_dsc.mem)->b_addr = (void *) SEXP_rawval_lblk_replace ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
                                                                             SEXP_LCASTP(v_dsc.mem)->offset + n,
                                                                             n_val, &o_val);
+        /*
+         * A shared part of the chain might have been replaced
+         * by a copy, the last block with it.
+         */
+        if (SEXP_LCASTP(v_dsc.mem)->flags & SEXP_LIST_SHARED)
+                SEXP_rawval_list_sync (SEXP_LCASTP(v_dsc.mem));
 
         return (o_val);
 }
@@ -1138,8 +1185,7 @@ SEXP_t *SEXP_list_nth (const SEXP_t *list, uint32_t n)
                 return (NULL);
         }
 
-        s_exp = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
-                                      SEXP_LCASTP(v_dsc.mem)->offset + n);
+        s_exp = SEXP_rawval_list_nth (SEXP_LCASTP(v_dsc.mem), n);
 
 #if !defined(NDEBUG)
         if (s_exp != NULL)
@@ -1168,8 +1214,7 @@ SEXP_t *SEXP_listref_nth (SEXP_t *list, uint32_t n)
                 return (NULL);
         }
 
-        s_exp = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
-                                      SEXP_LCASTP(v_dsc.mem)->offset + n);
+        s_exp = SEXP_rawval_list_nth (SEXP_LCASTP(v_dsc.mem), n);
 
 #if !defined(NDEBUG)
         if (s_exp != NULL)
@@ -1213,20 +1258,17 @@ SEXP_t *SEXP_list_add (SEXP_t *list, const SEXP_t *s_exp)
 
                 list->s_valp = uptr;
                 SEXP_val_dsc (&v_dsc, list->s_valp);
-
-                uptr = SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr);
-                SEXP_rawval_lblk_add1 (uptr, s_exp);
-        } else {
-                /*
-                 * Only one reference exists to the value.
-                 * However, list blocks have their own
-                 * reference counter and some blocks can
-                 * be shared. This case is handled by the
-                 * function SEXP_rawval_list_add.
-                 */
-                SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_add ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, s_exp);
         }
 
+        /*
+         * Only one reference exists to the value now.
+         * However, list blocks have their own
+         * reference counter and some blocks can
+         * be shared. This case is handled by the
+         * function SEXP_rawval_list_add.
+         */
+        SEXP_rawval_list_add (SEXP_LCASTP(v_dsc.mem), s_exp);
+
         return (list);
 }
 
@@ -1293,12 +1335,27 @@ SEXP_t *SEXP_list_pop (SEXP_t *list)
         lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc.mem)->b_addr);
 
         if (lblk != NULL) {
+                --SEXP_LCASTP(v_dsc.mem)->length;
+
+                /*
+                 * The block is released once the list moves past it.
+                 * If another list still uses it, the next block gains
+                 * a reference from this list.
+                 */
                 if (++SEXP_LCASTP(v_dsc.mem)->offset == lblk->real) {
+                        struct SEXP_val_lblk *next = SEXP_VALP_LBLK(lblk->nxsz);
+
                         SEXP_LCASTP(v_dsc.mem)->offset = 0;
-                        SEXP_LCASTP(v_dsc.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
-                }
+                        SEXP_LCASTP(v_dsc.mem)->b_addr = next;
 
-                SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
+                        if (!SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb) && next != NULL) {
+                                SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_incref ((uintptr_t)next);
+                                SEXP_rawval_list_sync (SEXP_LCASTP(v_dsc.mem));
+                        }
+
+                        if (next == NULL)
+                                SEXP_LCASTP(v_dsc.mem)->b_last = NULL;
+                }
         }
 
 #if !defined(NDEBUG)
@@ -1590,7 +1647,7 @@ SEXP_t *SEXP_new (void)
 {
         SEXP_t *s_exp;
 
-        s_exp = sm_talloc (SEXP_t);
+        s_exp = sm_slab_alloc (sizeof (SEXP_t));
         s_exp->s_type = NULL;
         s_exp->s_valp = 0;
 
@@ -1638,16 +1695,16 @@ SEXP_t *SEXP_unref (SEXP_t *s_exp_o)
 
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -1659,7 +1716,7 @@ SEXP_t *SEXP_unref (SEXP_t *s_exp_o)
                         s_exp_o->__magic0 = SEXP_MAGIC0_INV;
                         s_exp_o->__magic1 = SEXP_MAGIC1_INV;
 #endif
-                        sm_free (s_exp_o);
+                        sm_slab_free (s_exp_o, sizeof (SEXP_t));
 			return (NULL);
                 }
 
@@ -1749,6 +1806,9 @@ bool SEXP_deepcmp(const SEXP_t *a, const SEXP_t *b)
 
         if (a == NULL || b == NULL)
                 return (a == b);
+        /* handles sharing one value are equal without walking it */
+        if (a->s_valp == b->s_valp)
+                return (true);
         if ((type = SEXP_typeof(a)) != SEXP_typeof(b))
                 return (false);
         if (!SEXP_listp(a)) {
@@ -1833,16 +1893,16 @@ static void SEXP_free_lmemb (SEXP_t *s_exp)
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -1865,7 +1925,7 @@ void SEXP_free (SEXP_t *s_exp)
 {
         if (s_exp != NULL) {
                 SEXP_free_r(s_exp);
-                sm_free(s_exp);
+                sm_slab_free (s_exp, sizeof (SEXP_t));
         }
         return;
 }
@@ -1874,7 +1934,7 @@ void __SEXP_free (SEXP_t *s_exp, const char *file, uint32_t line, const char *fu
 {
         if (s_exp != NULL) {
                 __SEXP_free_r(s_exp, file, line, func);
-                sm_free (s_exp);
+                sm_slab_free (s_exp, sizeof (SEXP_t));
         }
         return;
 }
@@ -1966,7 +2026,7 @@ int SEXP_datatype_set_nth (SEXP_t *list, uint32_t n, const char *name)
         if (v_dsc.type != SEXP_VALTYPE_LIST)
                 return (-1);
 
-        s_nth = SEXP_rawval_lblk_nth ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, n);
+        s_nth = SEXP_rawval_list_nth (SEXP_LCASTP(v_dsc.mem), n);
 
         if (s_nth == NULL)
                 return (-1);
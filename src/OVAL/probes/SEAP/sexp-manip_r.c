@@ -293,7 +293,7 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
                 s_ptr[++s_cur] = va_arg (alist, SEXP_t *);
         }
 
-        if (SEXP_val_new (&v_dsc, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
@@ -304,7 +304,10 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
                 for (b_exp = 0; (size_t)(1 << b_exp) < s_cur; ++b_exp);
 
                 SEXP_LCASTP(v_dsc.mem)->offset = 0;
+                SEXP_LCASTP(v_dsc.mem)->flags  = 0;
+                SEXP_LCASTP(v_dsc.mem)->length = s_cur;
                 SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_new (b_exp);
+                SEXP_LCASTP(v_dsc.mem)->b_last = SEXP_LCASTP(v_dsc.mem)->b_addr;
 
                 if (SEXP_rawval_lblk_fill ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
                                            s_ptr, s_cur) != ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr))
@@ -314,7 +317,10 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
                 }
         } else {
                 SEXP_LCASTP(v_dsc.mem)->offset = 0;
+                SEXP_LCASTP(v_dsc.mem)->flags  = 0;
+                SEXP_LCASTP(v_dsc.mem)->length = 0;
                 SEXP_LCASTP(v_dsc.mem)->b_addr = NULL;
+                SEXP_LCASTP(v_dsc.mem)->b_last = NULL;
         }
 
         SEXP_init(sexp_mem);
@@ -362,7 +368,7 @@ SEXP_t *SEXP_list_rest_r (SEXP_t *rest, const SEXP_t *list)
                 return (NULL);
         }
 
-        if (SEXP_val_new (&v_dsc_r, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc_r, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
@@ -371,6 +377,9 @@ SEXP_t *SEXP_list_rest_r (SEXP_t *rest, const SEXP_t *list)
 
         SEXP_LCASTP(v_dsc_r.mem)->offset = SEXP_LCASTP(v_dsc_o.mem)->offset + 1;
         SEXP_LCASTP(v_dsc_r.mem)->b_addr = SEXP_LCASTP(v_dsc_o.mem)->b_addr;
+        SEXP_LCASTP(v_dsc_r.mem)->b_last = NULL;
+        SEXP_LCASTP(v_dsc_r.mem)->length = 0;
+        SEXP_LCASTP(v_dsc_r.mem)->flags  = 0;
 
         lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr);
 
@@ -380,8 +389,24 @@ SEXP_t *SEXP_list_rest_r (SEXP_t *rest, const SEXP_t *list)
                         SEXP_LCASTP(v_dsc_r.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
                 }
 
-                if (SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr) != NULL)
-                        SEXP_LCASTP(v_dsc_r.mem)->b_addr = (void *)SEXP_rawval_lblk_incref ((uintptr_t) SEXP_LCASTP(v_dsc_r.mem)->b_addr);
+                if (SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr) != NULL) {
+                        uintptr_t b_addr = (uintptr_t) SEXP_LCASTP(v_dsc_r.mem)->b_addr;
+
+                        SEXP_LCASTP(v_dsc_r.mem)->b_addr = (void *)SEXP_rawval_lblk_incref (b_addr);
+
+                        if ((uintptr_t)SEXP_LCASTP(v_dsc_r.mem)->b_addr == b_addr) {
+                                /*
+                                 * Both lists now share the tail of the chain
+                                 */
+                                SEXP_LCASTP(v_dsc_r.mem)->flags  = SEXP_LIST_SHARED;
+                                SEXP_LCASTP(v_dsc_r.mem)->length = SEXP_LCASTP(v_dsc_o.mem)->length - 1;
+                                SEXP_LCASTP(v_dsc_r.mem)->b_last = SEXP_LCASTP(v_dsc_o.mem)->b_last;
+                                SEXP_LCASTP(v_dsc_o.mem)->flags |= SEXP_LIST_SHARED;
+                        } else {
+                                /* the reference counter is full, it's a copy */
+                                SEXP_rawval_list_sync (SEXP_LCASTP(v_dsc_r.mem));
+                        }
+                }
         }
 
         SEXP_init(rest);
@@ -423,16 +448,16 @@ void __SEXP_free_r (SEXP_t *s_exp, const char *file, uint32_t line, const char *
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_r);
 
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -119,7 +119,7 @@ void SEXP_pstate_free (SEXP_pstate_t *pstate)
                                 SEXP_val_t v_dsc;
 
                                 SEXP_val_dsc (&v_dsc, pstate->v_bool[i]);
-                                sm_free (v_dsc.hdr);
+                                SEXP_val_free (&v_dsc);
                         }
                 }
         }
@@ -35,11 +35,10 @@ int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
 {
         void *s_val;
 
-        if (sm_memalign (&s_val, SEXP_VALP_ALIGN,
-                         sizeof (SEXP_valhdr_t) + vmemsize) != 0)
-        {
+        s_val = sm_slab_alloc (sizeof (SEXP_valhdr_t) + vmemsize);
+
+        if (s_val == NULL)
                 return (-1);
-        }
 
         SEXP_val_dsc (dst, (uintptr_t) s_val);
 
@@ -54,6 +53,11 @@ int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
         return (0);
 }
 
+void SEXP_val_free (SEXP_val_t *dsc)
+{
+        sm_slab_free (dsc->hdr, sizeof (SEXP_valhdr_t) + dsc->hdr->size);
+}
+
 void SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr)
 {
         dst->ptr  = ptr;
@@ -93,19 +97,64 @@ SEXP_numtype_t SEXP_rawval_number_type (SEXP_val_t *dsc)
 }
 
 size_t SEXP_rawval_list_length (struct SEXP_val_list *list)
+{
+        return (list->length);
+}
+
+SEXP_t *SEXP_rawval_list_nth (struct SEXP_val_list *list, uint32_t n)
+{
+        struct SEXP_val_lblk *last;
+        uint32_t from_end;
+
+        if (n < 1 || n > list->length)
+                return (NULL);
+
+        /*
+         * Members of the last block are addressed from the end
+         * of the list, the rest needs to walk the chain.
+         */
+        last     = SEXP_VALP_LBLK(list->b_last);
+        from_end = list->length - n;
+
+        if (from_end < last->real)
+                return (last->memb + (last->real - 1 - from_end));
+
+        return SEXP_rawval_lblk_nth ((uintptr_t)list->b_addr, list->offset + n);
+}
+
+void SEXP_rawval_list_add (struct SEXP_val_list *list, const SEXP_t *s_exp)
+{
+        if (list->b_last != NULL && !(list->flags & SEXP_LIST_SHARED)) {
+                list->b_last = (void *)SEXP_rawval_lblk_add1 ((uintptr_t)list->b_last, s_exp);
+        } else {
+                list->b_addr = (void *)SEXP_rawval_lblk_add ((uintptr_t)list->b_addr, s_exp);
+                /*
+                 * SEXP_rawval_lblk_add has made a private copy of
+                 * any shared part of the chain.
+                 */
+                list->b_last = SEXP_VALP_LBLK(SEXP_rawval_lblk_last ((uintptr_t)list->b_addr));
+                list->flags &= ~SEXP_LIST_SHARED;
+        }
+
+        ++list->length;
+}
+
+void SEXP_rawval_list_sync (struct SEXP_val_list *list)
 {
         size_t length;
-        register struct SEXP_val_lblk *lblk;
+        struct SEXP_val_lblk *lblk;
 
-        length = 0;
-        lblk   = SEXP_VALP_LBLK(list->b_addr);
+        length       = 0;
+        lblk         = SEXP_VALP_LBLK(list->b_addr);
+        list->b_last = NULL;
 
         while (lblk != NULL) {
-                length += lblk->real;
-                lblk    = SEXP_VALP_LBLK(lblk->nxsz);
+                length      += lblk->real;
+                list->b_last = lblk;
+                lblk         = SEXP_VALP_LBLK(lblk->nxsz);
         }
 
-        return (length - list->offset);
+        list->length = list->b_last != NULL ? length - list->offset : 0;
 }
 
 uintptr_t SEXP_rawval_lblk_new (uint8_t sz)
@@ -114,8 +163,9 @@ uintptr_t SEXP_rawval_lblk_new (uint8_t sz)
 
         _A(sz < 16);
 
-        if (sm_memalign ((void **)(void *)&lblk, SEXP_LBLK_ALIGN,
-                         sizeof (uintptr_t) + (2 * sizeof (uint16_t)) + (sizeof (SEXP_t) * (1 << sz))) != 0) {
+        lblk = sm_slab_alloc (SEXP_LBLK_SIZE(sz));
+
+        if (lblk == NULL) {
                 /* TODO: handle this */
                 abort ();
                 return ((uintptr_t) NULL);
@@ -209,7 +259,7 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
                                  * than one list so we have to create a copy of the
                                  * rest of the list.
                                  */
-                                lb_ptr = SEXP_rawval_lblk_copy (lblkp, 0);
+                                lb_ptr = SEXP_rawval_lblk_copy ((uintptr_t)lblk, 0);
 
                                 if (lb_prev == 0)
                                         lb_head = lb_ptr;
@@ -222,7 +272,7 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
                                 if (lb_prev != 0)
                                         SEXP_VALP_LBLK(lb_prev)->nxsz = (lb_ptr & SEXP_LBLKP_MASK) | (SEXP_VALP_LBLK(lb_prev)->nxsz & SEXP_LBLKS_MASK);
 
-                                SEXP_rawval_lblk_decref (lblkp);
+                                SEXP_rawval_lblk_decref ((uintptr_t)lblk);
 
                                 /*
                                  * Get the last block without checking refs
@@ -242,6 +292,10 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
         return (lb_head);
 }
 
+/*
+ * Returns the block the S-exp was stored in, which is either
+ * the given block or a new one appended after it.
+ */
 uintptr_t SEXP_rawval_lblk_add1 (uintptr_t lblkp, const SEXP_t *s_exp)
 {
         struct SEXP_val_lblk *lblk = SEXP_VALP_LBLK(lblkp);
@@ -261,8 +315,12 @@ uintptr_t SEXP_rawval_lblk_add1 (uintptr_t lblkp, const SEXP_t *s_exp)
                 uint8_t   new_sz;
                 uintptr_t new_lb;
 
+		/*
+		 * Blocks double in size up to the largest one, so that
+		 * long lists consist of a few large blocks.
+		 */
 		new_sz = lblk->nxsz & SEXP_LBLKS_MASK;
-		new_sz = new_sz == 15 ? 6 : new_sz + 1;
+		new_sz = new_sz == 15 ? 15 : new_sz + 1;
 
                 new_lb     = SEXP_rawval_lblk_new (new_sz);
                 lblk->nxsz = (new_lb & SEXP_LBLKP_MASK) | (lblk->nxsz & SEXP_LBLKS_MASK);
@@ -273,9 +331,7 @@ uintptr_t SEXP_rawval_lblk_add1 (uintptr_t lblkp, const SEXP_t *s_exp)
                  * a newly allocated block and there is at
                  * least one free slot.
                  */
-                SEXP_rawval_lblk_add1 (new_lb, s_exp);
-
-                return (lblkp);
+                return SEXP_rawval_lblk_add1 (new_lb, s_exp);
         }
 
         /* NOTREACHED */
@@ -436,7 +492,7 @@ uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp)
 {
         SEXP_val_t v_dsc_o, v_dsc_c;
 
-        if (SEXP_val_new (&v_dsc_c, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc_c, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
@@ -448,6 +504,8 @@ uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp)
         SEXP_LCASTP(v_dsc_c.mem)->b_addr = (void *) SEXP_rawval_lblk_copy ((uintptr_t)SEXP_LCASTP(v_dsc_o.mem)->b_addr,
                                                                            (uintptr_t)SEXP_LCASTP(v_dsc_o.mem)->offset);
         SEXP_LCASTP(v_dsc_c.mem)->offset = 0;
+        SEXP_LCASTP(v_dsc_c.mem)->flags  = 0;
+        SEXP_rawval_list_sync (SEXP_LCASTP(v_dsc_c.mem));
 
         return (SEXP_val_ptr (&v_dsc_c));
 }
@@ -490,7 +548,10 @@ uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip)
                  * allocate new block
                  */
                 if (lb_new->real >= (1 << (cur_sz))) {
-                        lb_next = SEXP_rawval_lblk_new (++cur_sz);
+                        if (cur_sz < 15)
+                                ++cur_sz;
+
+                        lb_next = SEXP_rawval_lblk_new (cur_sz);
                         lb_new->nxsz = (lb_next & SEXP_LBLKP_MASK) | (lb_new->nxsz & SEXP_LBLKS_MASK);
                         lb_new  = SEXP_VALP_LBLK(lb_next);
                         off_n   = 0;
@@ -529,7 +590,7 @@ void SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-                sm_free (lblk);
+                sm_slab_free (lblk, SEXP_LBLK_SIZE(lblk->nxsz & SEXP_LBLKS_MASK));
 
                 if (next != NULL)
                         SEXP_rawval_lblk_free ((uintptr_t)next, func);
@@ -538,7 +599,7 @@ void SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *))
         return;
 }
 
-void SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *))
+int SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *))
 {
         if (SEXP_rawval_lblk_decref (lblkp)) {
                 struct SEXP_val_lblk *lblk;
@@ -550,10 +611,11 @@ void SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-                sm_free (lblk);
+                sm_slab_free (lblk, SEXP_LBLK_SIZE(lblk->nxsz & SEXP_LBLKS_MASK));
+                return (1);
         }
 
-        return;
+        return (0);
 }
 
 uintptr_t SEXP_rawval_copy(uintptr_t s_valp)
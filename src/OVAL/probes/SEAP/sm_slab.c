@@ -0,0 +1,356 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "public/sm_alloc.h"
+
+/*
+ * Small objects of the S-exp library (S-exp handles, value headers
+ * and short list blocks) are allocated from 64 KiB slabs, one set of
+ * slabs per size class. Each thread keeps a short list of free objects
+ * per class so that most allocations and frees don't take any lock;
+ * the list is refilled from, and drained back to, the slabs in batches.
+ *
+ * A slab is aligned to its size, so the slab owning an object is found
+ * by masking the object address. Slabs with no object in use are
+ * released, except for one spare slab per class.
+ */
+
+#define SM_SLAB_SIZE    (64 * 1024)
+#define SM_SLAB_QUANTUM 16
+#define SM_SLAB_MAX     256
+#define SM_SLAB_CLASSES (SM_SLAB_MAX / SM_SLAB_QUANTUM)
+#define SM_SLAB_BATCH   32
+#define SM_SLAB_CACHE   (2 * SM_SLAB_BATCH)
+
+#define SM_SLAB_CLASS(s) (((s) - 1) / SM_SLAB_QUANTUM)
+#define SM_SLAB_OF(p)    ((struct sm_slab *)((uintptr_t)(p) & ~((uintptr_t)SM_SLAB_SIZE - 1)))
+
+struct sm_slab_obj {
+        struct sm_slab_obj *next;
+};
+
+struct sm_slab {
+        struct sm_slab     *next;
+        struct sm_slab     *prev;
+        struct sm_slab_obj *free; /* free objects not held by any thread */
+        uint32_t            used; /* objects allocated or held by threads */
+        uint32_t            size;
+        uint8_t             partial;
+};
+
+#define SM_SLAB_HDRSIZE ((sizeof (struct sm_slab) + SM_SLAB_QUANTUM - 1) & ~(SM_SLAB_QUANTUM - 1))
+
+struct sm_slab_class {
+        pthread_mutex_t  lock;
+        struct sm_slab  *partial; /* slabs with free objects */
+        struct sm_slab  *spare;
+};
+
+struct sm_slab_cache {
+        struct sm_slab_obj *head[SM_SLAB_CLASSES];
+        uint16_t            count[SM_SLAB_CLASSES];
+        uint64_t            alloc;
+        uint64_t            free;
+        uint64_t            large;
+        int                 registered;
+};
+
+static struct sm_slab_class __sm_slab_class[SM_SLAB_CLASSES];
+static struct sm_slab_stats __sm_slab_stats;
+static pthread_once_t       __sm_slab_once = PTHREAD_ONCE_INIT;
+static pthread_key_t        __sm_slab_key;
+static __thread struct sm_slab_cache __sm_slab_cache;
+
+static void sm_slab_cache_free (void *arg);
+
+static void sm_slab_init (void)
+{
+        size_t i;
+
+        for (i = 0; i < SM_SLAB_CLASSES; ++i)
+                pthread_mutex_init (&__sm_slab_class[i].lock, NULL);
+
+        pthread_key_create (&__sm_slab_key, &sm_slab_cache_free);
+}
+
+/*
+ * Objects left in the cache of an exiting thread are given back to
+ * the slabs by the key destructor.
+ */
+static void sm_slab_cache_register (struct sm_slab_cache *cache)
+{
+        pthread_once (&__sm_slab_once, &sm_slab_init);
+        pthread_setspecific (__sm_slab_key, cache);
+        cache->registered = 1;
+}
+
+static void sm_slab_stats_sync (struct sm_slab_cache *cache)
+{
+        __sync_fetch_and_add (&__sm_slab_stats.alloc, cache->alloc);
+        __sync_fetch_and_add (&__sm_slab_stats.free,  cache->free);
+        __sync_fetch_and_add (&__sm_slab_stats.large, cache->large);
+
+        cache->alloc = 0;
+        cache->free  = 0;
+        cache->large = 0;
+}
+
+static void sm_slab_unlink (struct sm_slab_class *class, struct sm_slab *slab)
+{
+        if (slab->prev != NULL)
+                slab->prev->next = slab->next;
+        else
+                class->partial = slab->next;
+
+        if (slab->next != NULL)
+                slab->next->prev = slab->prev;
+
+        slab->partial = 0;
+}
+
+static void sm_slab_link (struct sm_slab_class *class, struct sm_slab *slab)
+{
+        slab->prev = NULL;
+        slab->next = class->partial;
+
+        if (class->partial != NULL)
+                class->partial->prev = slab;
+
+        class->partial = slab;
+        slab->partial  = 1;
+}
+
+static struct sm_slab *sm_slab_new (struct sm_slab_class *class, uint32_t size)
+{
+        struct sm_slab     *slab;
+        struct sm_slab_obj *obj;
+        uint8_t            *p, *end;
+
+        if (class->spare != NULL) {
+                slab = class->spare;
+                class->spare = NULL;
+        } else {
+                if (sm_memalign ((void **)(void *)&slab, SM_SLAB_SIZE, SM_SLAB_SIZE) != 0)
+                        return (NULL);
+
+                __sync_fetch_and_add (&__sm_slab_stats.slabs, 1);
+                __sync_fetch_and_add (&__sm_slab_stats.slabs_total, 1);
+        }
+
+        slab->free = NULL;
+        slab->used = 0;
+        slab->size = size;
+
+        /*
+         * Build the free list backwards so that objects are handed out
+         * in address order.
+         */
+        p   = (uint8_t *)slab + SM_SLAB_HDRSIZE;
+        end = p + ((SM_SLAB_SIZE - SM_SLAB_HDRSIZE) / size) * size;
+
+        while (end > p) {
+                end -= size;
+                obj  = (struct sm_slab_obj *)end;
+                obj->next  = slab->free;
+                slab->free = obj;
+        }
+
+        sm_slab_link (class, slab);
+
+        return (slab);
+}
+
+static void sm_slab_release (struct sm_slab_class *class, struct sm_slab *slab)
+{
+        if (slab->partial)
+                sm_slab_unlink (class, slab);
+
+        if (class->spare == NULL) {
+                class->spare = slab;
+        } else {
+                sm_free (slab);
+                __sync_fetch_and_sub (&__sm_slab_stats.slabs, 1);
+        }
+}
+
+static int sm_slab_refill (struct sm_slab_cache *cache, size_t c)
+{
+        struct sm_slab_class *class = &__sm_slab_class[c];
+        struct sm_slab       *slab;
+        struct sm_slab_obj   *obj;
+        uint16_t n;
+
+        if (!cache->registered)
+                sm_slab_cache_register (cache);
+
+        pthread_mutex_lock (&class->lock);
+
+        for (n = 0; n < SM_SLAB_BATCH; ++n) {
+                slab = class->partial;
+
+                if (slab == NULL) {
+                        slab = sm_slab_new (class, (c + 1) * SM_SLAB_QUANTUM);
+
+                        if (slab == NULL)
+                                break;
+                }
+
+                obj = slab->free;
+                slab->free = obj->next;
+                slab->used++;
+
+                if (slab->free == NULL)
+                        sm_slab_unlink (class, slab);
+
+                obj->next = cache->head[c];
+                cache->head[c] = obj;
+        }
+
+        pthread_mutex_unlock (&class->lock);
+
+        cache->count[c] += n;
+
+        return (n > 0 ? 0 : -1);
+}
+
+static void sm_slab_drain (struct sm_slab_cache *cache, size_t c, uint16_t n)
+{
+        struct sm_slab_class *class = &__sm_slab_class[c];
+        struct sm_slab       *slab;
+        struct sm_slab_obj   *obj;
+
+        pthread_mutex_lock (&class->lock);
+
+        while (n-- > 0 && cache->head[c] != NULL) {
+                obj  = cache->head[c];
+                cache->head[c] = obj->next;
+                cache->count[c]--;
+
+                slab = SM_SLAB_OF(obj);
+                obj->next  = slab->free;
+                slab->free = obj;
+
+                if (--slab->used == 0)
+                        sm_slab_release (class, slab);
+                else if (!slab->partial)
+                        sm_slab_link (class, slab);
+        }
+
+        pthread_mutex_unlock (&class->lock);
+
+        sm_slab_stats_sync (cache);
+}
+
+static void sm_slab_cache_free (void *arg)
+{
+        struct sm_slab_cache *cache = arg;
+        size_t c;
+
+        for (c = 0; c < SM_SLAB_CLASSES; ++c)
+                if (cache->count[c] > 0)
+                        sm_slab_drain (cache, c, cache->count[c]);
+
+        sm_slab_stats_sync (cache);
+}
+
+void *sm_slab_alloc (size_t s)
+{
+#if !defined(SEAP_NO_SLAB)
+        struct sm_slab_cache *cache = &__sm_slab_cache;
+        struct sm_slab_obj   *obj;
+        size_t c;
+
+        if (s > 0 && s <= SM_SLAB_MAX) {
+                c = SM_SLAB_CLASS(s);
+
+                if (cache->head[c] != NULL || sm_slab_refill (cache, c) == 0) {
+                        obj = cache->head[c];
+                        cache->head[c] = obj->next;
+                        cache->count[c]--;
+                        cache->alloc++;
+
+                        return (obj);
+                }
+
+                return (NULL);
+        }
+
+        cache->large++;
+#endif
+        {
+                void *m;
+
+                if (sm_memalign (&m, SM_SLAB_QUANTUM, s) != 0)
+                        return (NULL);
+
+                return (m);
+        }
+}
+
+void sm_slab_free (void *p, size_t s)
+{
+#if !defined(SEAP_NO_SLAB)
+        struct sm_slab_cache *cache = &__sm_slab_cache;
+        struct sm_slab_obj   *obj;
+        size_t c;
+
+        if (p == NULL)
+                return;
+
+        if (s > 0 && s <= SM_SLAB_MAX) {
+                if (!cache->registered)
+                        sm_slab_cache_register (cache);
+
+                c   = SM_SLAB_CLASS(s);
+                obj = p;
+                obj->next = cache->head[c];
+                cache->head[c] = obj;
+                cache->free++;
+
+                if (++cache->count[c] > SM_SLAB_CACHE)
+                        sm_slab_drain (cache, c, SM_SLAB_BATCH);
+
+                return;
+        }
+#endif
+        sm_free (p);
+}
+
+void sm_slab_flush (void)
+{
+        sm_slab_cache_free (&__sm_slab_cache);
+}
+
+void sm_slab_stats (struct sm_slab_stats *stats)
+{
+        stats->alloc       = __sync_fetch_and_add (&__sm_slab_stats.alloc, 0);
+        stats->free        = __sync_fetch_and_add (&__sm_slab_stats.free, 0);
+        stats->large       = __sync_fetch_and_add (&__sm_slab_stats.large, 0);
+        stats->slabs       = __sync_fetch_and_add (&__sm_slab_stats.slabs, 0);
+        stats->slabs_total = __sync_fetch_and_add (&__sm_slab_stats.slabs_total, 0);
+}
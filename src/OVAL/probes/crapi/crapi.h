@@ -25,6 +25,9 @@
 
 #define CRAPI_IO_BUFSZ 4096
 
+/* Size of the blocks crapi_mdigest_fd() reads large files in */
+#define CRAPI_MDIGEST_BUFSZ (256 * 1024)
+
 #ifndef _FILE_OFFSET_BITS
 # define _FILE_OFFSET_BITS 32
 #endif
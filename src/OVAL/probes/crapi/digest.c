@@ -27,7 +27,12 @@
 #include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <assume.h>
 #include <errno.h>
 
@@ -64,17 +69,66 @@ int crapi_digest_fd (int fd, crapi_alg_t alg, void *dst, size_t *size)
         return (-1);
 }
 
-int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
+static int crapi_ctbl_set (struct digest_ctbl_t *ctbl, crapi_alg_t alg)
+{
+        switch (alg) {
+        case CRAPI_DIGEST_MD5:
+                ctbl->init   = &crapi_md5_init;
+                ctbl->update = &crapi_md5_update;
+                ctbl->fini   = &crapi_md5_fini;
+                ctbl->free   = &crapi_md5_free;
+                break;
+        case CRAPI_DIGEST_SHA1:
+                ctbl->init   = &crapi_sha1_init;
+                ctbl->update = &crapi_sha1_update;
+                ctbl->fini   = &crapi_sha1_fini;
+                ctbl->free   = &crapi_sha1_free;
+                break;
+        case CRAPI_DIGEST_SHA224:
+                ctbl->init   = &crapi_sha224_init;
+                ctbl->update = &crapi_sha224_update;
+                ctbl->fini   = &crapi_sha224_fini;
+                ctbl->free   = &crapi_sha224_free;
+                break;
+        case CRAPI_DIGEST_SHA256:
+                ctbl->init   = &crapi_sha256_init;
+                ctbl->update = &crapi_sha256_update;
+                ctbl->fini   = &crapi_sha256_fini;
+                ctbl->free   = &crapi_sha256_free;
+                break;
+        case CRAPI_DIGEST_SHA384:
+                ctbl->init   = &crapi_sha384_init;
+                ctbl->update = &crapi_sha384_update;
+                ctbl->fini   = &crapi_sha384_fini;
+                ctbl->free   = &crapi_sha384_free;
+                break;
+        case CRAPI_DIGEST_SHA512:
+                ctbl->init   = &crapi_sha512_init;
+                ctbl->update = &crapi_sha512_update;
+                ctbl->fini   = &crapi_sha512_fini;
+                ctbl->free   = &crapi_sha512_free;
+                break;
+        case CRAPI_DIGEST_RMD160:
+                ctbl->init   = &crapi_rmd160_init;
+                ctbl->update = &crapi_rmd160_update;
+                ctbl->fini   = &crapi_rmd160_fini;
+                ctbl->free   = &crapi_rmd160_free;
+                break;
+        default:
+                return (-1);
+        }
+
+        return (0);
+}
+
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[])
 {
         register int i;
-        va_list ap;
         struct digest_ctbl_t ctbl[num];
 
-        crapi_alg_t alg;
-        void       *dst;
-        size_t     *size;
-
-        uint8_t fd_buf[CRAPI_IO_BUFSZ];
+        uint8_t  fd_sbuf[CRAPI_IO_BUFSZ], *fd_buf = fd_sbuf;
+        size_t   fd_bufsz = sizeof fd_sbuf;
+        struct stat st;
         ssize_t ret;
 
         assume_r (num > 0, -1, errno = EINVAL;);
@@ -83,84 +137,43 @@ int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t
         for (i = 0; i < num; ++i)
                 ctbl[i].ctx = NULL;
 
-        va_start (ap, num);
-
         for (i = 0; i < num; ++i) {
-                alg  = va_arg (ap, crapi_alg_t);
-                dst  = va_arg (ap, void *);
-                size = va_arg (ap, size_t *);
-
-                switch (alg) {
-                case CRAPI_DIGEST_MD5:
-                        ctbl[i].init   = &crapi_md5_init;
-                        ctbl[i].update = &crapi_md5_update;
-                        ctbl[i].fini   = &crapi_md5_fini;
-                        ctbl[i].free   = &crapi_md5_free;
-                        break;
-                case CRAPI_DIGEST_SHA1:
-                        ctbl[i].init   = &crapi_sha1_init;
-                        ctbl[i].update = &crapi_sha1_update;
-                        ctbl[i].fini   = &crapi_sha1_fini;
-                        ctbl[i].free   = &crapi_sha1_free;
-                        break;
-                case CRAPI_DIGEST_SHA224:
-                        ctbl[i].init   = &crapi_sha224_init;
-                        ctbl[i].update = &crapi_sha224_update;
-                        ctbl[i].fini   = &crapi_sha224_fini;
-                        ctbl[i].free   = &crapi_sha224_free;
-                        break;
-                case CRAPI_DIGEST_SHA256:
-                        ctbl[i].init   = &crapi_sha256_init;
-                        ctbl[i].update = &crapi_sha256_update;
-                        ctbl[i].fini   = &crapi_sha256_fini;
-                        ctbl[i].free   = &crapi_sha256_free;
-                        break;
-                case CRAPI_DIGEST_SHA384:
-                        ctbl[i].init   = &crapi_sha384_init;
-                        ctbl[i].update = &crapi_sha384_update;
-                        ctbl[i].fini   = &crapi_sha384_fini;
-                        ctbl[i].free   = &crapi_sha384_free;
-                        break;
-                case CRAPI_DIGEST_SHA512:
-                        ctbl[i].init   = &crapi_sha512_init;
-                        ctbl[i].update = &crapi_sha512_update;
-                        ctbl[i].fini   = &crapi_sha512_fini;
-                        ctbl[i].free   = &crapi_sha512_free;
-                        break;
-                case CRAPI_DIGEST_RMD160:
-                        ctbl[i].init   = &crapi_rmd160_init;
-                        ctbl[i].update = &crapi_rmd160_update;
-                        ctbl[i].fini   = &crapi_rmd160_fini;
-                        ctbl[i].free   = &crapi_rmd160_free;
-                        break;
-                default:
-                        va_end (ap);
+                if (crapi_ctbl_set (&ctbl[i], alg[i]) != 0) {
+                        errno = EINVAL;
                         goto fail;
                 }
 
-                if ((ctbl[i].ctx = ctbl[i].init (dst, size)) == NULL)
-			*size = 0;
+                if ((ctbl[i].ctx = ctbl[i].init (dst[i], size[i])) == NULL)
+			*size[i] = 0;
         }
 
-        va_end (ap);
+        /*
+         * Read the file in one pass for all the algorithms. Files larger
+         * than the stack buffer are read in page aligned blocks of up to
+         * CRAPI_MDIGEST_BUFSZ bytes, sized to the file.
+         */
+        if (fstat (fd, &st) == 0 && S_ISREG(st.st_mode)) {
+                if ((size_t)st.st_size >= sizeof fd_sbuf) {
+                        fd_bufsz = (size_t)st.st_size < CRAPI_MDIGEST_BUFSZ ?
+                                ((size_t)st.st_size + CRAPI_IO_BUFSZ) & ~((size_t)CRAPI_IO_BUFSZ - 1) :
+                                CRAPI_MDIGEST_BUFSZ;
 
-        while ((ret = read (fd, fd_buf, sizeof fd_buf)) == sizeof fd_buf) {
-                for (i = 0; i < num; ++i) {
-			if (ctbl[i].ctx == NULL)
-				continue;
-                        if (ctbl[i].update (ctbl[i].ctx, fd_buf, sizeof fd_buf) != 0) {
-                                goto fail;
+                        if (posix_memalign ((void **)&fd_buf, CRAPI_IO_BUFSZ, fd_bufsz) != 0) {
+                                fd_buf   = fd_sbuf;
+                                fd_bufsz = sizeof fd_sbuf;
                         }
                 }
+#if defined(POSIX_FADV_SEQUENTIAL)
+                (void) posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
         }
 
-        switch (ret) {
-        case 0:
-                break;
-        case -1:
-                goto fail;
-        default:
-                assume_r (ret > 0, -1, goto fail;);
+        while ((ret = read (fd, fd_buf, fd_bufsz)) != 0) {
+                if (ret < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        goto fail;
+                }
 
                 for (i = 0; i < num; ++i) {
 			if (ctbl[i].ctx == NULL)
@@ -177,11 +190,143 @@ int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t
                 ctbl[i].fini (ctbl[i].ctx);
 	}
 
+        if (fd_buf != fd_sbuf)
+                free (fd_buf);
+
         return (0);
 fail:
         for (i = 0; i < num; ++i)
                 if (ctbl[i].ctx != NULL)
                         ctbl[i].free (ctbl[i].ctx);
 
+        if (fd_buf != fd_sbuf)
+                free (fd_buf);
+
         return (-1);
 }
+
+int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
+{
+        register int i;
+        va_list ap;
+
+        assume_r (num > 0, -1, errno = EINVAL;);
+
+        crapi_alg_t alg[num];
+        void       *dst[num];
+        size_t     *size[num];
+
+        va_start (ap, num);
+
+        for (i = 0; i < num; ++i) {
+                alg[i]  = va_arg (ap, crapi_alg_t);
+                dst[i]  = va_arg (ap, void *);
+                size[i] = va_arg (ap, size_t *);
+        }
+
+        va_end (ap);
+
+        return crapi_mdigest_fdv (fd, num, alg, dst, size);
+}
+
+static size_t crapi_digest_len (crapi_alg_t alg)
+{
+        switch (alg) {
+        case CRAPI_DIGEST_MD5:
+                return (16);
+        case CRAPI_DIGEST_SHA1:
+        case CRAPI_DIGEST_RMD160:
+                return (20);
+        case CRAPI_DIGEST_SHA224:
+                return (28);
+        case CRAPI_DIGEST_SHA256:
+                return (32);
+        case CRAPI_DIGEST_SHA384:
+                return (48);
+        case CRAPI_DIGEST_SHA512:
+                return (64);
+        }
+
+        return (0);
+}
+
+static void crapi_mdigest_file (struct crapi_file_digest *file)
+{
+        void   *dst[CRAPI_DIGEST_CNT];
+        size_t *size[CRAPI_DIGEST_CNT];
+        int i, fd;
+
+        for (i = 0; i < file->num; ++i) {
+                file->size[i] = crapi_digest_len (file->alg[i]);
+                dst[i]  = file->dst[i];
+                size[i] = &file->size[i];
+        }
+
+        fd = open (file->path, O_RDONLY);
+
+        if (fd < 0) {
+                file->error = errno;
+                return;
+        }
+
+        if (crapi_mdigest_fdv (fd, file->num, file->alg, dst, size) != 0)
+                file->error = errno != 0 ? errno : EIO;
+        else
+                file->error = 0;
+
+        close (fd);
+}
+
+struct crapi_mdigest_pool {
+        struct crapi_file_digest *files;
+        size_t count;
+        size_t next;
+};
+
+static void *crapi_mdigest_worker (void *arg)
+{
+        struct crapi_mdigest_pool *pool = (struct crapi_mdigest_pool *)arg;
+        size_t i;
+
+        while ((i = __sync_fetch_and_add (&pool->next, 1)) < pool->count)
+                crapi_mdigest_file (&pool->files[i]);
+
+        return (NULL);
+}
+
+int crapi_mdigest_files (struct crapi_file_digest *files, size_t count, int threads)
+{
+        struct crapi_mdigest_pool pool;
+        pthread_t tids[CRAPI_MDIGEST_THREADS_MAX];
+        int i, started = 0;
+
+        assume_r (files != NULL || count == 0, -1, errno = EFAULT;);
+
+        if (threads <= 0) {
+                long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+                threads = cpus > 0 ? (int)cpus : 1;
+        }
+
+        if (threads > CRAPI_MDIGEST_THREADS_MAX)
+                threads = CRAPI_MDIGEST_THREADS_MAX;
+        if ((size_t)threads > count)
+                threads = count > 0 ? (int)count : 1;
+
+        pool.files = files;
+        pool.count = count;
+        pool.next  = 0;
+
+        /* the calling thread is one of the workers */
+        for (i = 1; i < threads; ++i) {
+                if (pthread_create (&tids[started], NULL, crapi_mdigest_worker, &pool) != 0)
+                        break;
+                ++started;
+        }
+
+        crapi_mdigest_worker (&pool);
+
+        for (i = 0; i < started; ++i)
+                pthread_join (tids[i], NULL);
+
+        return (0);
+}
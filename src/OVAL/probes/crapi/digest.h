@@ -25,6 +25,7 @@
 
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef enum {
         CRAPI_DIGEST_MD5    = 0x01,
@@ -55,4 +56,32 @@ struct digest_ctbl_t {
 
 int crapi_mdigest_fd (int fd, int num, ... /*crapi_alg_t alg, void *dst, size_t *size, ...*/);
 
+/*
+ * Same as crapi_mdigest_fd() with the algorithms, destinations and
+ * sizes passed in arrays of num items.
+ */
+int crapi_mdigest_fdv (int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[]);
+
+/* The longest digest, SHA-512 */
+#define CRAPI_DIGEST_MAXLEN 64
+
+/* Upper limit of the number of threads used by crapi_mdigest_files() */
+#define CRAPI_MDIGEST_THREADS_MAX 16
+
+struct crapi_file_digest {
+        const char  *path;                    /* in: file to hash */
+        int          num;                     /* in: number of algorithms */
+        crapi_alg_t  alg[CRAPI_DIGEST_CNT];   /* in: algorithms */
+        uint8_t      dst[CRAPI_DIGEST_CNT][CRAPI_DIGEST_MAXLEN]; /* out: digests */
+        size_t       size[CRAPI_DIGEST_CNT];  /* out: digest lengths, 0 if the algorithm isn't available */
+        int          error;                   /* out: errno of the failure, 0 on success */
+};
+
+/*
+ * Compute the digests of count files, each file is read once for all its
+ * algorithms. The files are distributed among threads (the number of
+ * online CPUs if threads <= 0) and the calling thread.
+ */
+int crapi_mdigest_files (struct crapi_file_digest *files, size_t count, int threads);
+
 #endif /* CRAPI_DIGEST_H */
@@ -60,6 +60,9 @@ static pthread_mutex_t __filehash58_probe_mutex;
 
 #define CRAPI_INVALID -1
 
+/* Number of files hashed in parallel */
+#define FILEHASH58_BATCH 64
+
 static const struct oscap_string_map CRAPI_ALG_MAP[] = {
 	{CRAPI_DIGEST_MD5, "MD5"},
 	{CRAPI_DIGEST_SHA1, "SHA-1"},
@@ -71,17 +74,6 @@ static const struct oscap_string_map CRAPI_ALG_MAP[] = {
 	{CRAPI_INVALID, NULL}
 };
 
-static const struct oscap_string_map CRAPI_ALG_MAP_SIZE[] = {
-	{16, "MD5"},
-	{20, "SHA-1"},
-	{28, "SHA-224"},
-	{32, "SHA-256"},
-	{48, "SHA-384"},
-	{64, "SHA-512"},
-	/* {20, "RMD-160"}, OVAL doesn't support this */
-	{0, NULL}
-};
-
 
 static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 {
@@ -103,21 +95,10 @@ static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 	return (0);
 }
 
-static int filehash58_cb (const char *p, const char *f, const char *h, probe_ctx *ctx)
+static int filehash58_path (const char *p, const char *f, char *pbuf)
 {
-	SEXP_t *itm;
-
-	char   pbuf[PATH_MAX+1];
 	size_t plen, flen;
 
-	int fd;
-
-	if (f == NULL)
-		return (0);
-
-	/*
-	 * Prepare path
-	 */
 	plen = strlen (p);
 	flen = strlen (f);
 
@@ -134,68 +115,72 @@ static int filehash58_cb (const char *p, const char *f, const char *h, probe_ctx
 	memcpy (pbuf + plen, f, sizeof (char) * flen);
 	pbuf[plen+flen] = '\0';
 
-	/*
-	 * Open the file
-	 */
-	fd = open (pbuf, O_RDONLY);
-
-	if (fd < 0) {
-		strerror_r (errno, pbuf, PATH_MAX);
-		pbuf[PATH_MAX] = '\0';
-
-		itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					NULL);
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-			"Can't open \"%s\": errno=%d, %s.", pbuf, errno, strerror (errno));
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
-	} else {
-		uint8_t hash_dst[1025];
-		size_t  hash_dstlen = sizeof hash_dst;
-		char    hash_str[2051];
-
-		crapi_alg_t hash_type;
-
-		hash_type = oscap_string_to_enum(CRAPI_ALG_MAP, h);
-		hash_dstlen = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, h);
-
-		/*
-		 * Compute hash value
-		 */
-		if (crapi_mdigest_fd (fd, 1, hash_type, hash_dst, &hash_dstlen) != 0) {
-			close (fd);
-			return (-1);
-		}
-
-		close (fd);
-
-		hash_str[0] = '\0';
-		mem2hex (hash_dst, hash_dstlen, hash_str, sizeof hash_str);
-
-		/*
-		 * Create and add the item
-		 */
-		itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					"hash",     OVAL_DATATYPE_STRING, hash_str,
-					NULL);
+	return (0);
+}
 
-		if (hash_dstlen == 0) {
+static void filehash58_cb (const char *p, const char *f, struct crapi_file_digest *digest,
+			   const char *hash_types[], probe_ctx *ctx)
+{
+	SEXP_t *itm;
+	int i;
+
+	for (i = 0; i < digest->num; ++i) {
+		const char *h = hash_types[i];
+
+		if (digest->error != 0) {
+			itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, digest->path,
+						"path",     OVAL_DATATYPE_STRING, p,
+						"filename", OVAL_DATATYPE_STRING, f,
+						"hash_type",OVAL_DATATYPE_STRING, h,
+						NULL);
 			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-					   "Unable to compute %s hash value of \"%s\".", h, pbuf);
+				"Can't read \"%s\": errno=%d, %s.", digest->path, digest->error, strerror (digest->error));
 			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		} else {
+			char hash_str[(CRAPI_DIGEST_MAXLEN * 2) + 1];
+
+			hash_str[0] = '\0';
+			mem2hex (digest->dst[i], digest->size[i], hash_str, sizeof hash_str);
+
+			/*
+			 * Create and add the item
+			 */
+			itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+						"filepath", OVAL_DATATYPE_STRING, digest->path,
+						"path",     OVAL_DATATYPE_STRING, p,
+						"filename", OVAL_DATATYPE_STRING, f,
+						"hash_type",OVAL_DATATYPE_STRING, h,
+						"hash",     OVAL_DATATYPE_STRING, hash_str,
+						NULL);
+
+			if (digest->size[i] == 0) {
+				probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+						   "Unable to compute %s hash value of \"%s\".", h, digest->path);
+				probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+			}
 		}
+
+		probe_item_collect(ctx, itm);
 	}
+}
 
-	probe_item_collect(ctx, itm);
+/*
+ * Hash the files of the batch, all the hash types of a file in one pass,
+ * and collect their items in the order of the files.
+ */
+static void filehash58_batch (OVAL_FTSENT **ents, struct crapi_file_digest *digests, size_t count,
+			      const char *hash_types[], probe_ctx *ctx)
+{
+	size_t i;
 
-	return (0);
+	crapi_mdigest_files (digests, count, 0);
+
+	for (i = 0; i < count; ++i) {
+		filehash58_cb (ents[i]->path, ents[i]->file, &digests[i], hash_types, ctx);
+		free ((char *)digests[i].path);
+		oval_ftsent_free (ents[i]);
+	}
 }
 
 void *probe_init (void)
@@ -238,7 +223,10 @@ int probe_main(probe_ctx *ctx, void *mutex)
 	SEXP_t *probe_in;
 	SEXP_t *path, *filename, *behaviors, *filepath, *hash_type;
 	char hash_type_str[128];
-	int err = 0;
+	int err = 0, num = 0;
+	const struct oscap_string_map *p;
+	const char *hash_types[CRAPI_DIGEST_CNT];
+	crapi_alg_t algs[CRAPI_DIGEST_CNT];
 
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
@@ -281,22 +269,42 @@ int probe_main(probe_ctx *ctx, void *mutex)
 		goto cleanup;
 	}
 
-	if ((ofts = oval_fts_open(path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
+	/* find hash types to compare with entity, think "not satisfy" */
+	for (p = CRAPI_ALG_MAP; p->value != CRAPI_INVALID; ++p) {
+		SEXP_t *crapi_hash_type_sexp = SEXP_string_new(p->string, strlen(p->string));
+		if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE) {
+			hash_types[num] = p->string;
+			algs[num++] = p->value;
+		}
+		SEXP_free(crapi_hash_type_sexp);
+	}
+
+	if (num > 0 && (ofts = oval_fts_open(path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
+		OVAL_FTSENT *ents[FILEHASH58_BATCH];
+		struct crapi_file_digest *digests = malloc(FILEHASH58_BATCH * sizeof(struct crapi_file_digest));
+		char pbuf[PATH_MAX+1];
+		size_t count = 0;
+
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			/* find hash types to compare with entity, think "not satisfy" */
-			const struct oscap_string_map *p = CRAPI_ALG_MAP;
-			while (p->value != CRAPI_INVALID) {
-				SEXP_t *crapi_hash_type_sexp = SEXP_string_new(p->string, strlen(p->string));
-				if (probe_entobj_cmp(hash_type, crapi_hash_type_sexp) == OVAL_RESULT_TRUE) {
-					filehash58_cb(ofts_ent->path, ofts_ent->file, p->string, ctx);
-				}
-
-				SEXP_free(crapi_hash_type_sexp);
-				p++;
+			if (ofts_ent->file == NULL ||
+			    filehash58_path(ofts_ent->path, ofts_ent->file, pbuf) != 0) {
+				oval_ftsent_free(ofts_ent);
+				continue;
+			}
+
+			ents[count] = ofts_ent;
+			digests[count].path = strdup(pbuf);
+			digests[count].num = num;
+			memcpy(digests[count].alg, algs, num * sizeof(crapi_alg_t));
+
+			if (++count == FILEHASH58_BATCH) {
+				filehash58_batch(ents, digests, count, hash_types, ctx);
+				count = 0;
 			}
-			oval_ftsent_free(ofts_ent);
 		}
 
+		filehash58_batch(ents, digests, count, hash_types, ctx);
+		free(digests);
 		oval_fts_close(ofts);
 	}
 
@@ -43,6 +43,12 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <limits.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <sys/mman.h>
 #if defined USE_REGEX_PCRE
 #include <pcre.h>
 #elif defined USE_REGEX_POSIX
@@ -60,13 +66,14 @@
 #include "common/debug_priv.h"
 
 #define FILE_SEPARATOR '/'
+#define TFC54_MAX_SUBSTRS 20
 
 oval_schema_version_t over;
 
 #if defined USE_REGEX_PCRE
-static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char ***substrings) {
+static int get_substrings(const char *str, int len, int *ofs, pcre *re, int exec_opts, int want_substrs, char ***substrings) {
 	int i, ret, rc;
-	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
+	int ovector[3 * TFC54_MAX_SUBSTRS], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
 	char **substrs;
 
 	// todo: max match count check
@@ -75,20 +82,26 @@ static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char
 		ovector[i] = -1;
 
 #if defined(__SVR4) && defined(__sun)
-	rc = pcre_exec(re, NULL, str, strlen(str), *ofs, PCRE_NO_UTF8_CHECK, ovector, ovector_len);
+	rc = pcre_exec(re, NULL, str, len, *ofs, PCRE_NO_UTF8_CHECK, ovector, ovector_len);
 #else
-	rc = pcre_exec(re, NULL, str, strlen(str), *ofs, 0, ovector, ovector_len);
+	rc = pcre_exec(re, NULL, str, len, *ofs, exec_opts, ovector, ovector_len);
 #endif
 
 	if (rc < -1) {
-		dE("Function pcre_exec() failed to match a regular expression with return code %d on string '%s'.", rc, str);
+		dE("Function pcre_exec() failed to match a regular expression with return code %d.", rc);
 		return rc;
 	} else if (rc == -1) {
 		/* no match */
 		return 0;
 	}
 
-	*ofs = (*ofs == ovector[1]) ? ovector[1] + 1 : ovector[1];
+	if (*ofs == ovector[1]) {
+		/* empty match, step over one (UTF-8) character */
+		*ofs = ovector[1] + 1;
+		while (*ofs < len && (str[*ofs] & 0xc0) == 0x80)
+			++*ofs;
+	} else
+		*ofs = ovector[1];
 
 	if (!want_substrs) {
 		/* just report successful match */
@@ -102,32 +115,39 @@ static int get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char
 		rc = ovector_len / 3;
 	}
 
-	substrs = malloc(rc * sizeof (char *));
+	/*
+	 * The array is handed over before anything is copied from
+	 * the subject, which may be a mapping of the file, so that
+	 * the caller can release it if the copying faults.
+	 */
+	substrs = calloc(TFC54_MAX_SUBSTRS, sizeof (char *));
+	*substrings = substrs;
+
 	for (i = 0; i < rc; ++i) {
-		int len;
+		int sub_len;
 		char *buf;
 
 		if (ovector[2 * i] == -1)
 			continue;
-		len = ovector[2 * i + 1] - ovector[2 * i];
-		buf = malloc(len + 1);
-		memcpy(buf, str + ovector[2 * i], len);
-		buf[len] = '\0';
+		sub_len = ovector[2 * i + 1] - ovector[2 * i];
+		buf = malloc(sub_len + 1);
+		memcpy(buf, str + ovector[2 * i], sub_len);
+		buf[sub_len] = '\0';
 		substrs[ret] = buf;
 		++ret;
 	}
 
-	*substrings = substrs;
-
 	return ret;
 }
 #elif defined USE_REGEX_POSIX
-static int get_substrings(char *str, int *ofs, regex_t *re, int want_substrs, char ***substrings) {
+static int get_substrings(const char *str, int len, int *ofs, regex_t *re, int exec_opts, int want_substrs, char ***substrings) {
 	int i, ret, rc;
 	regmatch_t pmatch[40];
 	int pmatch_len = sizeof (pmatch) / sizeof (pmatch[0]);
 	char **substrs;
 
+	(void)len;
+	(void)exec_opts;
 	rc = regexec(re, str + *ofs, pmatch_len, pmatch, 0);
 	if (rc == REG_NOMATCH) {
 		/* no match */
@@ -208,10 +228,32 @@ static SEXP_t *create_item(const char *path, const char *filename, char *pattern
 	return item;
 }
 
+/*
+ * Files at least this large are matched through a read-only mapping,
+ * smaller ones are read in one go into a buffer sized by fstat().
+ */
+#define TFC54_MMAP_MIN (64 * 1024)
+
+/*
+ * Number of matches of a file collected at once.
+ */
+#define TFC54_BATCH 64
+
 struct pfdata {
 	char *pattern;
 	int re_opts;
 	SEXP_t *instance_ent;
+	/*
+	 * A plain integer comparison on the instance entity is reduced
+	 * to the range [inst_min, inst_max] so that instances can be
+	 * checked without building SEXPs and the matching can stop once
+	 * no later instance can be wanted.
+	 */
+	bool inst_range;
+	int64_t inst_min, inst_max;
+	char **substrs;
+	SEXP_t *items[TFC54_BATCH];
+	size_t item_cnt;
         probe_ctx *ctx;
 #if defined USE_REGEX_PCRE
 	pcre *compiled_regex;
@@ -220,14 +262,285 @@ struct pfdata {
 #endif
 };
 
+static int instance_range(SEXP_t *inst_ent, int64_t *min, int64_t *max)
+{
+	SEXP_t *val;
+	int64_t v;
+
+	if (probe_ent_attrexists(inst_ent, "var_ref"))
+		return -1;
+	if (probe_ent_getdatatype(inst_ent) != OVAL_DATATYPE_INTEGER)
+		return -1;
+
+	val = probe_ent_getval(inst_ent);
+	if (val == NULL)
+		return -1;
+	if (!SEXP_numberp(val)) {
+		SEXP_free(val);
+		return -1;
+	}
+	v = SEXP_number_geti_64(val);
+	SEXP_free(val);
+
+	*min = INT64_MIN;
+	*max = INT64_MAX;
+
+	switch (probe_ent_getoperation(inst_ent, OVAL_OPERATION_EQUALS)) {
+	case OVAL_OPERATION_EQUALS:
+		*min = *max = v;
+		break;
+	case OVAL_OPERATION_GREATER_THAN:
+		if (v == INT64_MAX)
+			*max = INT64_MIN;
+		else
+			*min = v + 1;
+		break;
+	case OVAL_OPERATION_GREATER_THAN_OR_EQUAL:
+		*min = v;
+		break;
+	case OVAL_OPERATION_LESS_THAN:
+		if (v == INT64_MIN)
+			*min = INT64_MAX;
+		else
+			*max = v - 1;
+		break;
+	case OVAL_OPERATION_LESS_THAN_OR_EQUAL:
+		*max = v;
+		break;
+	default:
+		return -1;
+	}
+
+	return 0;
+}
+
+static bool want_instance(struct pfdata *pfd, int64_t instance)
+{
+	SEXP_t *se_inst;
+	bool want;
+
+	if (pfd->inst_range)
+		return instance >= pfd->inst_min && instance <= pfd->inst_max;
+
+	se_inst = SEXP_number_newi_32((int32_t) instance);
+	want = probe_entobj_cmp(pfd->instance_ent, se_inst) == OVAL_RESULT_TRUE;
+	SEXP_free(se_inst);
+
+	return want;
+}
+
+#if defined USE_REGEX_PCRE
+/*
+ * A mapped file that is truncated while it is being matched raises
+ * SIGBUS on access past its new end. The matcher arms the jump buffer
+ * while it touches the mapping and the fault is turned into a read
+ * error of that file.
+ */
+static __thread sigjmp_buf *tfc54_sigbus_jmp = NULL;
+static pthread_once_t tfc54_sigbus_once = PTHREAD_ONCE_INIT;
+static struct sigaction tfc54_sigbus_prev;
+static bool tfc54_sigbus_ok = false;
+
+static void tfc54_sigbus_handler(int sig)
+{
+	(void)sig;
+
+	if (tfc54_sigbus_jmp != NULL)
+		siglongjmp(*tfc54_sigbus_jmp, 1);
+	/* not ours, fault again with the previous disposition */
+	sigaction(SIGBUS, &tfc54_sigbus_prev, NULL);
+}
+
+static void tfc54_sigbus_init(void)
+{
+	struct sigaction sa;
+
+	memset(&sa, 0, sizeof sa);
+	sa.sa_handler = tfc54_sigbus_handler;
+	sigemptyset(&sa.sa_mask);
+
+	if (sigaction(SIGBUS, &sa, &tfc54_sigbus_prev) == 0)
+		tfc54_sigbus_ok = true;
+	else
+		dW("Can't install the SIGBUS handler, files won't be mapped: %s", strerror(errno));
+}
+#endif
+
+struct tfc54_buf {
+	const char *data;
+	int len;
+	void *map;
+	size_t map_len;
+	sigjmp_buf *jb; /* set while data points into the mapping */
+	char *mem;
+};
+
+static int tfc54_read(int fd, size_t hint, struct tfc54_buf *b)
+{
+	size_t size, used = 0;
+	ssize_t ret;
+	char *buf, *tmp;
+
+	/* one spare byte lets the final read see EOF without growing */
+	size = hint > 0 ? hint + 2 : 4096;
+	buf  = malloc(size);
+	if (buf == NULL)
+		return -1;
+
+	for (;;) {
+		if (used + 1 == size) {
+			size *= 2;
+			tmp = realloc(buf, size);
+			if (tmp == NULL) {
+				free(buf);
+				return -1;
+			}
+			buf = tmp;
+		}
+
+		ret = read(fd, buf + used, size - used - 1);
+		if (ret == -1) {
+			if (errno == EINTR)
+				continue;
+			free(buf);
+			return -1;
+		}
+		if (ret == 0)
+			break;
+		used += ret;
+	}
+
+	buf[used] = '\0';
+	used = strlen(buf);
+
+	if (used > INT_MAX) {
+		free(buf);
+		errno = EFBIG;
+		return -1;
+	}
+
+	b->mem  = buf;
+	b->data = buf;
+	b->len  = used;
+
+	return 0;
+}
+
+static void tfc54_buf_free(struct tfc54_buf *b)
+{
+	if (b->map != NULL)
+		munmap(b->map, b->map_len);
+	free(b->mem);
+}
+
+static void tfc54_error(struct pfdata *pfd, const char *fmt, const char *path, const char *err)
+{
+	SEXP_t *msg;
+
+	msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, fmt, path, err);
+	probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+	SEXP_free(msg);
+	probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+}
+
+static void free_substrs(char **substrs, int substr_cnt)
+{
+	int k;
+
+	for (k = 0; k < substr_cnt && substrs[k] != NULL; ++k)
+		free(substrs[k]);
+	free(substrs);
+}
+
+static int flush_items(struct pfdata *pfd)
+{
+	int ret;
+
+	if (pfd->item_cnt == 0)
+		return 0;
+
+	ret = probe_item_collect_batch(pfd->ctx, pfd->items, pfd->item_cnt);
+	pfd->item_cnt = 0;
+
+	return ret;
+}
+
+static int match_file(struct pfdata *pfd, struct tfc54_buf *buf,
+		      const char *path, const char *file, const char *whole_path)
+{
+	int substr_cnt, ofs = 0, exec_opts = 0;
+	int64_t cur_inst = 0;
+
+	do {
+		bool want;
+
+		if (pfd->inst_range && cur_inst >= pfd->inst_max)
+			break;
+
+		want = want_instance(pfd, cur_inst + 1);
+
+		pfd->substrs = NULL;
+#if defined USE_REGEX_PCRE
+		tfc54_sigbus_jmp = buf->jb;
+#endif
+		substr_cnt = get_substrings(buf->data, buf->len, &ofs, pfd->compiled_regex,
+					    exec_opts, want, &pfd->substrs);
+#if defined USE_REGEX_PCRE
+		tfc54_sigbus_jmp = NULL;
+		/* the subject has been validated by the first call */
+		exec_opts |= PCRE_NO_UTF8_CHECK;
+#endif
+
+		if (substr_cnt < 0) {
+			SEXP_t *msg;
+			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+				"Regular expression pattern match failed in file %s with error %d.",
+				whole_path, substr_cnt);
+			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+			SEXP_free(msg);
+			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+			flush_items(pfd);
+			return -3;
+		}
+
+		if (substr_cnt > 0) {
+			++cur_inst;
+
+			if (want) {
+				SEXP_t *item;
+
+				item = create_item(path, file, pfd->pattern,
+						   cur_inst, pfd->substrs, substr_cnt);
+				if (item != NULL)
+					pfd->items[pfd->item_cnt++] = item;
+				free_substrs(pfd->substrs, substr_cnt);
+				pfd->substrs = NULL;
+
+				/* no more items fit into the collected object */
+				if (pfd->item_cnt == TFC54_BATCH && flush_items(pfd) == 2)
+					break;
+			}
+		}
+	} while (substr_cnt > 0 && ofs <= buf->len);
+
+	flush_items(pfd);
+
+	return 0;
+}
+
 static int process_file(const char *path, const char *file, void *arg)
 {
 	struct pfdata *pfd = (struct pfdata *) arg;
-	int ret = 0, path_len, file_len, cur_inst = 0, fd = -1, substr_cnt,
-		buf_size = 0, buf_used = 0, ofs = 0, buf_inc = 4096;
-	char *whole_path = NULL, *buf = NULL;
-	SEXP_t *next_inst = NULL;
+	int ret = 0, path_len, file_len, fd = -1;
+	char *whole_path = NULL;
+	struct tfc54_buf buf;
 	struct stat st;
+#if defined USE_REGEX_PCRE
+	sigjmp_buf jb;
+	const char *nul;
+#endif
+
+	memset(&buf, 0, sizeof buf);
 
 	if (file == NULL)
 		goto cleanup;
@@ -261,86 +574,80 @@ static int process_file(const char *path, const char *file, void *arg)
 
 	fd = open(whole_path, O_RDONLY);
 	if (fd == -1) {
-		SEXP_t *msg;
+		tfc54_error(pfd, "open(): '%s' %s.", whole_path, strerror(errno));
+		ret = -1;
+		goto cleanup;
+	}
 
-		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "open(): '%s' %s.", whole_path, strerror(errno));
-		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-		SEXP_free(msg);
-		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+	if (fstat(fd, &st) == -1) {
+		tfc54_error(pfd, "fstat(): '%s' %s.", whole_path, strerror(errno));
 		ret = -1;
 		goto cleanup;
 	}
 
-	do {
-		buf_size += buf_inc;
-		buf = realloc(buf, buf_size);
-		ret = read(fd, buf + buf_used, buf_inc);
-		if (ret == -1) {
-			SEXP_t *msg;
+#if defined USE_REGEX_PCRE
+	/*
+	 * The subject is handed to pcre_exec() with its length, so a large
+	 * file is matched in place, multiline patterns included. Files which
+	 * don't report their size (e.g. in /proc) are read.
+	 */
+	(void)pthread_once(&tfc54_sigbus_once, tfc54_sigbus_init);
 
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno));
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+	if (tfc54_sigbus_ok && st.st_size >= TFC54_MMAP_MIN) {
+		if ((uintmax_t) st.st_size > INT_MAX) {
+			tfc54_error(pfd, "mmap(): '%s' %s.", whole_path, strerror(EFBIG));
 			ret = -2;
 			goto cleanup;
 		}
-		buf_used += ret;
-	} while (ret == buf_inc);
 
-	if (buf_used == buf_size)
-		buf = realloc(buf, ++buf_size);
-	buf[buf_used++] = '\0';
-
-	do {
-		char **substrs;
-		int want_instance;
-
-		next_inst = SEXP_number_newi_32(cur_inst + 1);
-
-		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
-			want_instance = 1;
-		else
-			want_instance = 0;
-
-		SEXP_free(next_inst);
-		substr_cnt = get_substrings(buf, &ofs, pfd->compiled_regex, want_instance, &substrs);
+		buf.map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (buf.map == MAP_FAILED) {
+			dD("mmap(%s): %s, falling back to read()", whole_path, strerror(errno));
+			buf.map = NULL;
+		} else {
+			buf.map_len = st.st_size;
+#if defined(POSIX_MADV_SEQUENTIAL)
+			(void)posix_madvise(buf.map, buf.map_len, POSIX_MADV_SEQUENTIAL);
+#endif
+		}
+	}
 
-		if (substr_cnt < 0) {
-			SEXP_t *msg;
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
-				"Regular expression pattern match failed in file %s with error %d.",
-				whole_path, substr_cnt);
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -3;
+	if (buf.map != NULL) {
+		if (sigsetjmp(jb, 1) != 0) {
+			tfc54_sigbus_jmp = NULL;
+			if (pfd->substrs != NULL) {
+				free_substrs(pfd->substrs, TFC54_MAX_SUBSTRS);
+				pfd->substrs = NULL;
+			}
+			/* the matches found before the truncation are reported */
+			flush_items(pfd);
+			tfc54_error(pfd, "read(): '%s' %s.", whole_path, "File truncated while being read");
+			ret = -2;
 			goto cleanup;
 		}
 
-		if (substr_cnt > 0) {
-			++cur_inst;
-
-			if (want_instance) {
-				int k;
-				SEXP_t *item;
-
-				item = create_item(path, file, pfd->pattern,
-						   cur_inst, substrs, substr_cnt);
+		/* the subject ends at the first NUL byte, as with read() */
+		tfc54_sigbus_jmp = &jb;
+		nul = memchr(buf.map, '\0', buf.map_len);
+		tfc54_sigbus_jmp = NULL;
 
-                                probe_item_collect(pfd->ctx, item);
+		buf.jb   = &jb;
+		buf.data = buf.map;
+		buf.len  = nul != NULL ? (int) (nul - buf.data) : (int) buf.map_len;
+	} else
+#endif
+	if (tfc54_read(fd, st.st_size > 0 ? (size_t) st.st_size : 0, &buf) != 0) {
+		tfc54_error(pfd, "read(): '%s' %s.", whole_path, strerror(errno));
+		ret = -2;
+		goto cleanup;
+	}
 
-				for (k = 0; k < substr_cnt; ++k)
-					free(substrs[k]);
-				free(substrs);
-			}
-		}
-	} while (substr_cnt > 0 && ofs < buf_used);
+	ret = match_file(pfd, &buf, path, file, whole_path);
 
  cleanup:
 	if (fd != -1)
 		close(fd);
-	free(buf);
+	tfc54_buf_free(&buf);
 	if (whole_path != NULL)
 		free(whole_path);
 
@@ -448,6 +755,7 @@ int probe_main(probe_ctx *ctx, void *arg)
 	probe_tfc54behaviors_canonicalize(&bh_ent);
 
 	pfd.instance_ent = inst_ent;
+	pfd.inst_range   = instance_range(inst_ent, &pfd.inst_min, &pfd.inst_max) == 0;
         pfd.ctx          = ctx;
 #if defined USE_REGEX_PCRE
 	pfd.re_opts = PCRE_UTF8;
@@ -42,6 +42,7 @@
 #include "alloc.h"
 #include "debug_priv.h"
 #include "oval_fts.h"
+#include "oval_fts_walk.h"
 #if defined(__SVR4) && defined(__sun)
 #include "fts_sun.h"
 #include <sys/mntent.h>
@@ -75,6 +76,8 @@ static void OVAL_FTS_free(OVAL_FTS *ofts)
 		fts_close(ofts->ofts_match_path_fts);
 	if (ofts->ofts_recurse_path_fts != NULL)
 		fts_close(ofts->ofts_recurse_path_fts);
+	if (ofts->ofts_recurse_path_walk != NULL)
+		oval_fts_walk_close(ofts->ofts_recurse_path_walk);
 
 	free(ofts);
 	return;
@@ -95,24 +98,25 @@ static int pathlen_from_ftse(int fts_pathlen, int fts_namelen)
 	return pathlen;
 }
 
-static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
+static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, const char *path, int pathlen,
+                                    const char *name, int namelen, unsigned int info)
 {
 	OVAL_FTSENT *ofts_ent;
 
 	ofts_ent = oscap_talloc(OVAL_FTSENT);
 
-	ofts_ent->fts_info = fts_ent->fts_info;
+	ofts_ent->fts_info = info;
 	if (ofts->ofts_sfilename || ofts->ofts_sfilepath) {
-		ofts_ent->path_len = pathlen_from_ftse(fts_ent->fts_pathlen, fts_ent->fts_namelen);
+		ofts_ent->path_len = pathlen_from_ftse(pathlen, namelen);
 		ofts_ent->path = malloc(ofts_ent->path_len + 1);
-		strncpy(ofts_ent->path, fts_ent->fts_path, ofts_ent->path_len);
+		strncpy(ofts_ent->path, path, ofts_ent->path_len);
 		ofts_ent->path[ofts_ent->path_len] = '\0';
 
-		ofts_ent->file_len = fts_ent->fts_namelen;
-		ofts_ent->file = strdup(fts_ent->fts_name);
+		ofts_ent->file_len = namelen;
+		ofts_ent->file = strdup(name);
 	} else {
-		ofts_ent->path_len = fts_ent->fts_pathlen;
-		ofts_ent->path = strdup(fts_ent->fts_path);
+		ofts_ent->path_len = pathlen;
+		ofts_ent->path = strdup(path);
 
 		ofts_ent->file_len = -1;
 		ofts_ent->file = NULL;
@@ -371,19 +375,19 @@ static char *extract_fixed_path_prefix(char *path)
 
 static int badpartial_check_slash(const char *pattern)
 {
-	pcre *regex;
+	struct oscap_pcre *regex;
 	const char *errptr = NULL;
 	int errofs = 0, fb, ret;
 
-	regex = pcre_compile(pattern + 1 /* skip '^' */, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_cache_get(pattern + 1 /* skip '^' */, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dE("Failed to validate the pattern: pcre_compile(): "
 		   "error: '%s', error offset: %d, pattern: '%s'.\n",
 		   errofs, errptr, pattern);
 		return -1;
 	}
-	ret = pcre_fullinfo(regex, NULL, PCRE_INFO_FIRSTBYTE, &fb);
-	pcre_free(regex);
+	ret = oscap_pcre_fullinfo(regex, PCRE_INFO_FIRSTBYTE, &fb);
+	oscap_pcre_cache_put(regex);
 	regex = NULL;
 	if (ret != 0) {
 		dE("Failed to validate the pattern: pcre_fullinfo(): "
@@ -403,7 +407,7 @@ static int badpartial_check_slash(const char *pattern)
 #define TEST_PATH1 "/"
 #define TEST_PATH2 "x"
 
-static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
+static int badpartial_transform_pattern(char *pattern, struct oscap_pcre **regex_out)
 {
 	/*
 	  PCREPARTIAL(3)
@@ -428,7 +432,7 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 	const char *errptr = NULL;
 	char *s, *brkt_mark;
 	bool bracketed = false, found_regex = false;
-	pcre *regex;
+	struct oscap_pcre *regex;
 
 	/* The processing bellow builds upon the assumption that
 	   the pattern has been validated by pcre_compile() */
@@ -478,7 +482,7 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 	else
 		*s = '\0';
 
-	regex = pcre_compile(pattern, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_cache_get(pattern, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dW("Nonfatal failure: can't transform the pattern for partial "
 		   "match optimization, error: '%s', error offset: %d, "
@@ -486,10 +490,10 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 		return -1;
 	}
 
-	ret = pcre_exec(regex, NULL, test_path1, strlen(test_path1), 0,
+	ret = oscap_pcre_exec(regex, test_path1, strlen(test_path1), 0,
 		PCRE_PARTIAL, NULL, 0);
 	if (ret != PCRE_ERROR_PARTIAL && ret < 0) {
-		pcre_free(regex);
+		oscap_pcre_cache_put(regex);
 		dW("Nonfatal failure: can't transform the pattern for partial "
 		   "match optimization, pcre_exec() return code: %d, pattern: "
 		   "'%s'.", ret, pattern);
@@ -498,6 +502,8 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 
 	if (regex_out != NULL)
 		*regex_out = regex;
+	else
+		oscap_pcre_cache_put(regex);
 
 	return 0;
 }
@@ -505,14 +511,14 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 /* Verify that the path is usable and try to craft a regex to speed up
    the filesystem traversal. If the path to match is ill-designed, an
    ugly heuristic is employed to obtain something meaningfull. */
-static int process_pattern_match(const char *path, pcre **regex_out)
+static int process_pattern_match(const char *path, struct oscap_pcre **regex_out)
 {
 	int ret, errofs = 0;
 	char *pattern;
 	const char *test_path1 = TEST_PATH1;
 	//const char *test_path2 = TEST_PATH2;
 	const char *errptr = NULL;
-	pcre *regex;
+	struct oscap_pcre *regex;
 
 	if (path[0] != '^') {
 		/* Matching has to have a fixed starting point and thus
@@ -530,7 +536,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		pattern = strdup(path);
 	}
 
-	regex = pcre_compile(pattern, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_cache_get(pattern, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dE("Failed to validate the pattern: pcre_compile(): "
 		   "error offset: %d, error: '%s', pattern: '%s'.\n",
@@ -538,7 +544,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		free(pattern);
 		return -1;
 	}
-	ret = pcre_exec(regex, NULL, test_path1, strlen(test_path1), 0,
+	ret = oscap_pcre_exec(regex, test_path1, strlen(test_path1), 0,
 		PCRE_PARTIAL, NULL, 0);
 
 	switch (ret) {
@@ -554,14 +560,14 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 
 		dI("pcre_exec() returned PCRE_ERROR_PARTIAL for pattern '%s' "
 		   "and test path '%s'.\n", pattern, test_path1);
-		ret = pcre_exec(regex, NULL, test_path2, strlen(test_path2),
+		ret = oscap_pcre_exec(regex, test_path2, strlen(test_path2),
 			0, PCRE_PARTIAL, NULL, 0);
 		if (ret == PCRE_ERROR_PARTIAL || ret >= 0) {
 			dE("Failed to validate the pattern: test path '%s' "
 			   "matched by pattern '%s' - the pattern is too "
 			   "general, i.e. inefficient. This could take a "
 			   "lifetime to complete.\n", test_path2, pattern);
-			pcre_free(regex);
+			oscap_pcre_cache_put(regex);
 			free(pattern);
 			return -2;
 		}
@@ -571,7 +577,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		dI("pcre_exec() returned PCRE_ERROR_BADPARTIAL for pattern "
 		   "'%s' and a test path '%s'. Falling back to "
 		   "pcre_fullinfo().\n", pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_cache_put(regex);
 		regex = NULL;
 
 		/* Fallback to first byte check to determin if
@@ -595,7 +601,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		   "PCRE_ERROR_NOMATCH for pattern '%s' and a test path '%s'. "
 		   "This indicates the pattern doesn't match a leading '/'.\n",
 		   pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_cache_put(regex);
 		free(pattern);
 		return -2;
 	default:
@@ -609,14 +615,14 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 			   their OVAL definitions that use ".*" as
 			   'path' and then uncomment this.
 
-			ret = pcre_exec(regex, NULL, test_path2, strlen(test_path2),
+			ret = oscap_pcre_exec(regex, test_path2, strlen(test_path2),
 					0, PCRE_PARTIAL, NULL, 0);
 			if (ret == PCRE_ERROR_PARTIAL || ret >= 0) {
 				dE("Failed to validate the pattern: test path '%s' "
 				   "matched by pattern '%s' - the pattern is too "
 				   "general, i.e. inefficient. This could take a "
 				   "lifetime to complete.\n", test_path2, pattern);
-				pcre_free(regex);
+				oscap_pcre_cache_put(regex);
 				free(pattern);
 				return -2;
 			}
@@ -627,7 +633,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		dE("Failed to validate the pattern: pcre_exec() return "
 		   "code: %d, pattern '%s', test path '%s'.\n", ret,
 		   pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_cache_put(regex);
 		free(pattern);
 		return -1;
 	}
@@ -639,6 +645,8 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		   "pattern: '%s'.", pattern);
 		if (regex_out != NULL)
 			*regex_out = regex;
+		else
+			oscap_pcre_cache_put(regex);
 	}
 
 	free(pattern);
@@ -670,7 +678,7 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 
 	uint32_t path_op;
 	bool nilfilename = false;
-	pcre *regex = NULL;
+	struct oscap_pcre *regex = NULL;
 	struct stat st;
 
 	assume_d((path == NULL && filename == NULL && filepath != NULL)
@@ -819,6 +827,7 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 			   errno, strerror(errno));
 		}
 		free((void *) paths[0]);
+		oscap_pcre_cache_put(regex);
 		return NULL;
 	}
 
@@ -834,17 +843,13 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 	if (ofts->ofts_match_path_fts == NULL || errno != 0) {
 		dE("fts_open() failed, errno: %d \"%s\".", errno, strerror(errno));
 		OVAL_FTS_free(ofts);
+		oscap_pcre_cache_put(regex);
 		return (NULL);
 	}
 
 	ofts->ofts_recurse_path_fts_opts = rec_fts_options;
 	ofts->ofts_path_op = path_op;
-	if (regex != NULL) {
-		const char *errptr = NULL;
-
-		ofts->ofts_path_regex = regex;
-		ofts->ofts_path_regex_extra = pcre_study(regex, 0, &errptr);
-	}
+	ofts->ofts_path_regex = regex;
 
 	if (filesystem == OVAL_RECURSE_FS_LOCAL) {
 #if   defined(__SVR4) && defined(__sun)
@@ -874,6 +879,7 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 
 	ofts->recurse = recurse;
 	ofts->filesystem = filesystem;
+	ofts->walk_threads = oval_fts_walk_threads();
 
 	if (path) { /* filepath == NULL */
 		ofts->ofts_spath = SEXP_ref(path); /* path entity */
@@ -898,24 +904,93 @@ OVAL_FTS *oval_fts_open(SEXP_t *path, SEXP_t *filename, SEXP_t *filepath, SEXP_t
 	return (ofts);
 }
 
-static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
+static inline int _oval_fts_is_local(OVAL_FTS *ofts, const char *path, int info, const struct stat *statp) {
 # if defined (__SVR4) && defined(__sun)
 	/* pseudo filesystems will be skipped */
 	/* don't recurse into remote fs if local is specified */
-	return ((fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
-	    && (!OVAL_FTS_localp(ofts, fts_ent->fts_path,
-	    (fts_ent->fts_statp != NULL) ?
-	    &fts_ent->fts_statp->st_fstype : NULL)));
+	return ((info == FTS_D || info == FTS_SL)
+	    && (!OVAL_FTS_localp(ofts, path,
+	    (statp != NULL) ?
+	    (void *)&statp->st_fstype : NULL)));
 #else
 	/* don't recurse into non-local filesystems */
 	return (ofts->filesystem == OVAL_RECURSE_FS_LOCAL
-	    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
-	    && (!OVAL_FTS_localp(ofts, fts_ent->fts_path,
-				 (fts_ent->fts_statp != NULL) ?
-				 &fts_ent->fts_statp->st_dev : NULL)));
+	    && (info == FTS_D || info == FTS_SL)
+	    && (!OVAL_FTS_localp(ofts, path,
+				 (statp != NULL) ?
+				 (void *)&statp->st_dev : NULL)));
 #endif
 }
 
+/* whether an entry found while recursing down is a matching target */
+static bool oval_fts_collect(OVAL_FTS *ofts, const char *name, int level, int info)
+{
+	SEXP_t *stmp;
+	oval_result_t result;
+
+	/* the condition below is correct because ofts_sfilepath is NULL here */
+	if (ofts->ofts_sfilename == NULL)
+		return (info == FTS_D && (ofts->max_depth == -1 || level <= ofts->max_depth));
+
+	if (info == FTS_D)
+		return (false);
+
+	stmp = SEXP_string_newf("%s", name);
+	result = probe_entobj_cmp(ofts->ofts_sfilename, stmp);
+	SEXP_free(stmp);
+
+	if (result == OVAL_RESULT_ERROR)
+		probe_cobj_set_flag(ofts->result, SYSCHAR_FLAG_ERROR);
+
+	return (result == OVAL_RESULT_TRUE);
+}
+
+/*
+ * The fts_set() instruction (or 0) for an entry found while recursing
+ * down, i.e. whether to descend into a directory or follow a symlink.
+ */
+static int oval_fts_recurse_instr(OVAL_FTS *ofts, const char *path, int level, int info,
+                                  const struct stat *statp)
+{
+	int instr = 0;
+
+	if (level > 0) { /* don't skip fts root */
+		/* limit recursion depth */
+		if (ofts->direction == OVAL_RECURSE_DIRECTION_NONE
+		    || (ofts->max_depth != -1 && level > ofts->max_depth))
+			return FTS_SKIP;
+
+		/* limit recursion only to selected file types */
+		switch (info) {
+		case FTS_D:
+			if (!(ofts->recurse & OVAL_RECURSE_DIRS))
+				return FTS_SKIP;
+			break;
+		case FTS_SL:
+			if (!(ofts->recurse & OVAL_RECURSE_SYMLINKS))
+				return FTS_SKIP;
+			instr = FTS_FOLLOW;
+			break;
+		default:
+			return 0;
+		}
+	}
+	if (_oval_fts_is_local(ofts, path, info, statp))
+		return FTS_SKIP;
+	/* don't recurse beyond the initial filesystem */
+	if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
+	    && (info == FTS_D || info == FTS_SL)
+	    && ofts->ofts_recurse_path_devid != statp->st_dev)
+		return FTS_SKIP;
+
+	return instr;
+}
+
+static int oval_fts_walk_instr(void *arg, const OVAL_FTS_WALKENT *ent)
+{
+	return oval_fts_recurse_instr(arg, ent->path, ent->level, ent->info, ent->statp);
+}
+
 /* find the first matching path or filepath */
 static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 {
@@ -951,7 +1026,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
 			continue;
 		}
-		if (_oval_fts_is_local(ofts, fts_ent)) {
+		if (_oval_fts_is_local(ofts, fts_ent->fts_path, fts_ent->fts_info, fts_ent->fts_statp)) {
 			dI("Don't recurse into non-local filesystems, skipping '%s'.", fts_ent->fts_path);
 			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			continue;
@@ -968,7 +1043,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 		if (ofts->ofts_path_regex != NULL && fts_ent->fts_info == FTS_D) {
 			int ret, svec[3];
 
-			ret = pcre_exec(ofts->ofts_path_regex, ofts->ofts_path_regex_extra,
+			ret = oscap_pcre_exec(ofts->ofts_path_regex,
 					fts_ent->fts_path, fts_ent->fts_pathlen, 0, PCRE_PARTIAL,
 					svec, sizeof(svec) / sizeof(svec[0]));
 			if (ret < 0) {
@@ -1072,6 +1147,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 		/* iterate until a match is found or all elements have been traversed */
 		while (out_fts_ent == NULL) {
 			FTSENT *fts_ent;
+			int instr;
 
 			fts_ent = fts_read(ofts->ofts_recurse_path_fts);
 			if (fts_ent == NULL) {
@@ -1098,71 +1174,13 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 #endif
 
 			/* collect matching target */
-			if (collect_dirs) {
-				if (fts_ent->fts_info == FTS_D
-				    && (ofts->max_depth == -1 || fts_ent->fts_level <= ofts->max_depth))
-					out_fts_ent = fts_ent;
-			} else {
-				if (fts_ent->fts_info != FTS_D) {
-					SEXP_t *stmp;
-
-					stmp = SEXP_string_newf("%s", fts_ent->fts_name);
-					oval_result_t result = probe_entobj_cmp(ofts->ofts_sfilename, stmp);
-					switch (result){
-						case OVAL_RESULT_TRUE:
-							out_fts_ent = fts_ent;
-							break;
-
-						case OVAL_RESULT_ERROR:
-							probe_cobj_set_flag(ofts->result, SYSCHAR_FLAG_ERROR);
-							break;
+			if (oval_fts_collect(ofts, fts_ent->fts_name, fts_ent->fts_level, fts_ent->fts_info))
+				out_fts_ent = fts_ent;
 
-						default:
-							break;
-					}
-
-					SEXP_free(stmp);
-				}
-			}
-
-			if (fts_ent->fts_level > 0) { /* don't skip fts root */
-				/* limit recursion depth */
-				if (ofts->direction == OVAL_RECURSE_DIRECTION_NONE
-				    || (ofts->max_depth != -1 && fts_ent->fts_level > ofts->max_depth)) {
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
-					continue;
-				}
-
-				/* limit recursion only to selected file types */
-				switch (fts_ent->fts_info) {
-				case FTS_D:
-					if (!(ofts->recurse & OVAL_RECURSE_DIRS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
-						continue;
-					}
-					break;
-				case FTS_SL:
-					if (!(ofts->recurse & OVAL_RECURSE_SYMLINKS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
-						continue;
-					}
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
-					break;
-				default:
-					continue;
-				}
-			}
-			if (_oval_fts_is_local(ofts, fts_ent)) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
-				continue;
-			}
-			/* don't recurse beyond the initial filesystem */
-			if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
-			    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
-			    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
-				continue;
-			}
+			instr = oval_fts_recurse_instr(ofts, fts_ent->fts_path, fts_ent->fts_level,
+			                               fts_ent->fts_info, fts_ent->fts_statp);
+			if (instr != 0)
+				fts_set(ofts->ofts_recurse_path_fts, fts_ent, instr);
 		}
 
 		break;
@@ -1287,6 +1305,33 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 	return out_fts_ent;
 }
 
+/*
+ * oval_fts_read_recurse_path() for the recursion down done by the parallel
+ * walker; it finds the same entries in the same order
+ */
+static const OVAL_FTS_WALKENT *oval_fts_read_recurse_walk(OVAL_FTS *ofts)
+{
+	const OVAL_FTS_WALKENT *ent;
+
+	if (ofts->ofts_recurse_path_walk == NULL)
+		ofts->ofts_recurse_path_walk = oval_fts_walk_open(ofts->ofts_match_path_fts_ent->fts_path,
+		                                                  ofts->walk_threads, oval_fts_walk_instr, ofts);
+
+	while ((ent = oval_fts_walk_read(ofts->ofts_recurse_path_walk)) != NULL) {
+		if (ent->info == FTS_DC) {
+			dW("Filesystem tree cycle detected at '%s'.", ent->path);
+			continue;
+		}
+		if (oval_fts_collect(ofts, ent->name, ent->level, ent->info))
+			return ent;
+	}
+
+	oval_fts_walk_close(ofts->ofts_recurse_path_walk);
+	ofts->ofts_recurse_path_walk = NULL;
+
+	return NULL;
+}
+
 OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 {
 	FTSENT *fts_ent;
@@ -1309,6 +1354,18 @@ OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 			fts_ent = ofts->ofts_match_path_fts_ent;
 			ofts->ofts_match_path_fts_ent = NULL;
 			break;
+		} else if (ofts->direction == OVAL_RECURSE_DIRECTION_DOWN && ofts->walk_threads > 1) {
+			const OVAL_FTS_WALKENT *ent = oval_fts_read_recurse_walk(ofts);
+
+			if (ent != NULL)
+				return OVAL_FTSENT_new(ofts, ent->path, ent->pathlen,
+						       ent->name, ent->namelen, ent->info);
+
+			ofts->ofts_match_path_fts_ent = NULL;
+
+			/* with 'equals', there's only one potential target */
+			if (ofts->ofts_path_op == OVAL_OPERATION_EQUALS)
+				return (NULL);
 		} else {
 			fts_ent = oval_fts_read_recurse_path(ofts);
 			if (fts_ent != NULL)
@@ -1323,7 +1380,8 @@ OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 		}
 	}
 
-	return OVAL_FTSENT_new(ofts, fts_ent);
+	return OVAL_FTSENT_new(ofts, fts_ent->fts_path, fts_ent->fts_pathlen,
+			       fts_ent->fts_name, fts_ent->fts_namelen, fts_ent->fts_info);
 }
 
 void oval_ftsent_free(OVAL_FTSENT *ofts_ent)
@@ -1336,10 +1394,7 @@ int oval_fts_close(OVAL_FTS *ofts)
 	if (ofts->ofts_recurse_path_pthcpy != NULL)
 		free(ofts->ofts_recurse_path_pthcpy);
 
-	if (ofts->ofts_path_regex)
-		pcre_free(ofts->ofts_path_regex);
-	if (ofts->ofts_path_regex_extra)
-		pcre_free(ofts->ofts_path_regex_extra);
+	oscap_pcre_cache_put(ofts->ofts_path_regex);
 
 	if (ofts->ofts_spath != NULL)
 		SEXP_free(ofts->ofts_spath);
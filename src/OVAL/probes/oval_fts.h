@@ -30,6 +30,8 @@
 #endif
 #include <pcre.h>
 #include "fsdev.h"
+#include "oval_fts_walk.h"
+#include "common/oscap_pcre_cache.h"
 
 #define ENT_GET_AREF(ent, dst, attr_name, mandatory)			\
 	do {								\
@@ -75,9 +77,11 @@ typedef struct {
 	char *ofts_recurse_path_pthcpy;
 	char *ofts_recurse_path_curpth;
 	dev_t ofts_recurse_path_devid;
+	/* parallel replacement of ofts_recurse_path_fts */
+	OVAL_FTS_WALK *ofts_recurse_path_walk;
+	int walk_threads;
 
-	pcre       *ofts_path_regex;
-	pcre_extra *ofts_path_regex_extra;
+	struct oscap_pcre *ofts_path_regex;
 	uint32_t ofts_path_op;
 
 	SEXP_t *ofts_spath;
@@ -0,0 +1,713 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if (defined(__SVR4) && defined(__sun)) || defined(_AIX)
+#include "fts_sun.h"
+#else
+#include <fts.h>
+#endif
+
+#include "debug_priv.h"
+#include "oval_fts_walk.h"
+
+/*
+ * Number of read but not yet consumed entries above which the threads stop
+ * reading ahead. The reader still reads the directories it needs itself.
+ */
+#define OVAL_FTS_WALK_MAX_BUFFERED 65536
+
+enum {
+	WALK_PENDING,
+	WALK_READING,
+	WALK_READY
+};
+
+struct walk_dir;
+
+struct walk_ent {
+	struct walk_dir *dir; /* directory to descend into */
+	uint32_t name;        /* offset of the name in walk_dir.names */
+	uint16_t namelen;
+	uint16_t info;
+};
+
+struct walk_dir {
+	struct walk_dir *parent;
+	char   *path;
+	size_t  pathlen;
+	size_t  namelen;      /* the name is at the end of the path */
+	int     level;
+	dev_t   dev;
+	ino_t   ino;
+
+	int     state;
+	bool    failed;       /* couldn't be opened, reported as FTS_DNR */
+	bool    queued;
+	bool    orphan;       /* consumed while still queued */
+
+	struct walk_ent *ent;
+	size_t  count;
+	size_t  alloc;
+	char   *names;
+	size_t  names_len;
+	size_t  names_alloc;
+};
+
+/* the owner pushes and pops at the tail, the others steal from the head */
+struct walk_queue {
+	struct walk_dir **dir;
+	size_t head;
+	size_t tail;
+	size_t alloc;
+};
+
+struct walk_thread {
+	OVAL_FTS_WALK *walk;
+	int index;
+	pthread_t thread;
+};
+
+struct walk_frame {
+	struct walk_dir *dir;
+	size_t index;
+	bool   ready;
+};
+
+struct oval_fts_walk {
+	oval_fts_walk_instr_t instr;
+	void *arg;
+
+	pthread_mutex_t lock;
+	pthread_cond_t  work;  /* directories were queued or consumed */
+	pthread_cond_t  ready; /* a directory was read */
+	bool   closing;
+	size_t buffered;
+
+	int threads;
+	int started;           /* threads are started with the first subdirectory */
+	struct walk_thread *thread;
+	struct walk_queue  *queue; /* one per thread, the last one is the reader's */
+
+	char  *root_path;
+	size_t root_pathlen;
+	int    root_info;
+	bool   root_done;
+	struct walk_dir *root;
+
+	struct walk_frame *stack;
+	size_t depth;
+	size_t stack_alloc;
+
+	char  *path;
+	size_t path_alloc;
+	OVAL_FTS_WALKENT cur;
+};
+
+int oval_fts_walk_threads(void)
+{
+	const char *str = getenv(OVAL_FTS_WALK_ENV_THREADS);
+	long n;
+
+	/*
+	 * The threads didn't pay off on the measured machines, the walk is
+	 * sequential unless they are requested.
+	 */
+	if (str == NULL)
+		return 0;
+
+	n = strtol(str, NULL, 10);
+
+	if (n < 0)
+		n = 0;
+	if (n > OVAL_FTS_WALK_MAX_THREADS)
+		n = OVAL_FTS_WALK_MAX_THREADS;
+
+	return (int)n;
+}
+
+/* same as fts: the slash isn't doubled after "/" */
+static size_t walk_join(char **buf, size_t *alloc, const char *dpath, size_t dlen,
+                        const char *name, size_t namelen)
+{
+	size_t len = dlen + namelen + 1;
+	bool slash = dlen == 0 || dpath[dlen - 1] != '/';
+
+	if (len + 1 > *alloc) {
+		*alloc = len + 1 > 2 * *alloc ? len + 1 : 2 * *alloc;
+		*buf = realloc(*buf, *alloc);
+	}
+
+	memcpy(*buf, dpath, dlen);
+	if (slash)
+		(*buf)[dlen++] = '/';
+	memcpy(*buf + dlen, name, namelen);
+	(*buf)[dlen + namelen] = '\0';
+
+	return dlen + namelen;
+}
+
+static struct walk_dir *walk_dir_new(struct walk_dir *parent, const char *path, size_t pathlen,
+                                     size_t namelen, int level, const struct stat *st)
+{
+	struct walk_dir *dir = calloc(1, sizeof(struct walk_dir));
+
+	dir->parent  = parent;
+	dir->path    = malloc(pathlen + 1);
+	memcpy(dir->path, path, pathlen);
+	dir->path[pathlen] = '\0';
+	dir->pathlen = pathlen;
+	dir->namelen = namelen;
+	dir->level   = level;
+	dir->dev     = st->st_dev;
+	dir->ino     = st->st_ino;
+	dir->state   = WALK_PENDING;
+
+	return dir;
+}
+
+static void walk_dir_free(struct walk_dir *dir)
+{
+	free(dir->path);
+	free(dir->ent);
+	free(dir->names);
+	free(dir);
+}
+
+/* free the directory and all the directories below it which weren't consumed */
+static void walk_dir_free_tree(struct walk_dir *dir)
+{
+	size_t i;
+
+	for (i = 0; i < dir->count; ++i)
+		if (dir->ent[i].dir != NULL)
+			walk_dir_free_tree(dir->ent[i].dir);
+
+	walk_dir_free(dir);
+}
+
+static struct walk_ent *walk_dir_add(struct walk_dir *dir, const char *name, size_t namelen, int info)
+{
+	struct walk_ent *ent;
+
+	if (dir->count == dir->alloc) {
+		dir->alloc = dir->alloc > 0 ? 2 * dir->alloc : 16;
+		dir->ent = realloc(dir->ent, dir->alloc * sizeof(struct walk_ent));
+	}
+	if (dir->names_len + namelen + 1 > dir->names_alloc) {
+		dir->names_alloc = dir->names_alloc > 0 ? 2 * dir->names_alloc : 256;
+		if (dir->names_alloc < dir->names_len + namelen + 1)
+			dir->names_alloc = dir->names_len + namelen + 1;
+		dir->names = realloc(dir->names, dir->names_alloc);
+	}
+
+	memcpy(dir->names + dir->names_len, name, namelen);
+	dir->names[dir->names_len + namelen] = '\0';
+
+	ent = &dir->ent[dir->count++];
+	ent->dir     = NULL;
+	ent->name    = dir->names_len;
+	ent->namelen = namelen;
+	ent->info    = info;
+
+	dir->names_len += namelen + 1;
+
+	return ent;
+}
+
+/* fts_stat() of an entry of the directory */
+static int walk_info(const struct walk_dir *dir, const struct stat *st)
+{
+	if (S_ISDIR(st->st_mode)) {
+		for (; dir != NULL; dir = dir->parent)
+			if (dir->ino == st->st_ino && dir->dev == st->st_dev)
+				return FTS_DC;
+		return FTS_D;
+	}
+	if (S_ISLNK(st->st_mode))
+		return FTS_SL;
+	if (S_ISREG(st->st_mode))
+		return FTS_F;
+
+	return FTS_DEFAULT;
+}
+
+static void walk_queue_push(struct walk_queue *queue, struct walk_dir *dir)
+{
+	if (queue->tail == queue->alloc) {
+		if (queue->head > 0) {
+			memmove(queue->dir, queue->dir + queue->head,
+			        (queue->tail - queue->head) * sizeof(struct walk_dir *));
+			queue->tail -= queue->head;
+			queue->head  = 0;
+		} else {
+			queue->alloc = queue->alloc > 0 ? 2 * queue->alloc : 64;
+			queue->dir = realloc(queue->dir, queue->alloc * sizeof(struct walk_dir *));
+		}
+	}
+
+	dir->queued = true;
+	queue->dir[queue->tail++] = dir;
+}
+
+static struct walk_dir *walk_dequeued(struct walk_dir *dir)
+{
+	dir->queued = false;
+
+	if (dir->orphan) {
+		walk_dir_free(dir);
+		return NULL;
+	}
+
+	return dir->state == WALK_PENDING ? dir : NULL;
+}
+
+/* called with the lock held */
+static struct walk_dir *walk_take(OVAL_FTS_WALK *walk, int self)
+{
+	struct walk_queue *queue;
+	struct walk_dir *dir;
+	int i;
+
+	/* the newest directory of our own */
+	queue = &walk->queue[self];
+	while (queue->tail > queue->head) {
+		dir = walk_dequeued(queue->dir[--queue->tail]);
+		if (queue->tail == queue->head)
+			queue->tail = queue->head = 0;
+		if (dir != NULL)
+			return dir;
+	}
+
+	/* the oldest directory of somebody else */
+	for (i = 1; i <= walk->threads; ++i) {
+		queue = &walk->queue[(self + i) % (walk->threads + 1)];
+		while (queue->tail > queue->head) {
+			dir = walk_dequeued(queue->dir[queue->head++]);
+			if (queue->tail == queue->head)
+				queue->tail = queue->head = 0;
+			if (dir != NULL)
+				return dir;
+		}
+	}
+
+	return NULL;
+}
+
+static void *walk_thread_run(void *arg);
+
+/* called with the lock held */
+static void walk_start(OVAL_FTS_WALK *walk)
+{
+	int i;
+
+	walk->thread = calloc(walk->threads, sizeof(struct walk_thread));
+
+	for (i = 0; i < walk->threads; ++i) {
+		walk->thread[i].walk  = walk;
+		walk->thread[i].index = i;
+
+		if (pthread_create(&walk->thread[i].thread, NULL, walk_thread_run, &walk->thread[i]) != 0) {
+			dW("Can't start a directory walking thread: %s.", strerror(errno));
+			break;
+		}
+	}
+
+	walk->started = i;
+}
+
+/*
+ * Read the entries of the directory, ask the callback what to do with the
+ * subdirectories and symlinks, and queue the subdirectories to descend into.
+ */
+static void walk_dir_read(OVAL_FTS_WALK *walk, struct walk_dir *dir, int self)
+{
+	DIR *dp;
+	struct dirent *de;
+	struct stat st, lst;
+	struct walk_ent *ent;
+	struct walk_dir **sub = NULL;
+	size_t nsub = 0, sub_alloc = 0, namelen, pathlen;
+	char *path = NULL;
+	size_t path_alloc = 0;
+	OVAL_FTS_WALKENT went;
+	int fd, info, instr;
+
+	dp = opendir(dir->path);
+	if (dp == NULL) {
+		dir->failed = true;
+		return;
+	}
+	fd = dirfd(dp);
+
+	while ((de = readdir(dp)) != NULL) {
+		namelen = strlen(de->d_name);
+
+		if (de->d_name[0] == '.' &&
+		    (namelen == 1 || (namelen == 2 && de->d_name[1] == '.')))
+			continue;
+
+		if (fstatat(fd, de->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+			info = FTS_NS;
+		else
+			info = walk_info(dir, &st);
+
+		ent = walk_dir_add(dir, de->d_name, namelen, info);
+
+		if (info != FTS_D && info != FTS_SL)
+			continue;
+
+		pathlen = walk_join(&path, &path_alloc, dir->path, dir->pathlen, de->d_name, namelen);
+
+		went.path    = path;
+		went.pathlen = pathlen;
+		went.name    = path + pathlen - namelen;
+		went.namelen = namelen;
+		went.level   = dir->level + 1;
+		went.info    = info;
+		went.statp   = &st;
+
+		instr = walk->instr(walk->arg, &went);
+
+		if (info == FTS_SL) {
+			if (instr != FTS_FOLLOW)
+				continue;
+
+			/* fts returns a followed symlink once more with the info of its target */
+			if (fstatat(fd, de->d_name, &st, 0) != 0) {
+				if (errno == ENOENT && fstatat(fd, de->d_name, &lst, AT_SYMLINK_NOFOLLOW) == 0)
+					info = FTS_SLNONE;
+				else
+					info = FTS_NS;
+			} else {
+				info = walk_info(dir, &st);
+			}
+
+			ent = walk_dir_add(dir, de->d_name, namelen, info);
+
+			if (info != FTS_D)
+				continue;
+
+			went.info = info;
+			instr = walk->instr(walk->arg, &went);
+		}
+
+		if (instr == FTS_SKIP)
+			continue;
+
+		ent->dir = walk_dir_new(dir, path, pathlen, namelen, dir->level + 1, &st);
+
+		if (nsub == sub_alloc) {
+			sub_alloc = sub_alloc > 0 ? 2 * sub_alloc : 16;
+			sub = realloc(sub, sub_alloc * sizeof(struct walk_dir *));
+		}
+		sub[nsub++] = ent->dir;
+	}
+
+	closedir(dp);
+	free(path);
+
+	if (nsub == 0 || walk->threads == 0) {
+		free(sub);
+		return;
+	}
+
+	pthread_mutex_lock(&walk->lock);
+
+	/* the first subdirectory is consumed first, so it's popped first */
+	while (nsub > 0)
+		walk_queue_push(&walk->queue[self], sub[--nsub]);
+
+	if (walk->started == 0)
+		walk_start(walk);
+
+	pthread_cond_broadcast(&walk->work);
+	pthread_mutex_unlock(&walk->lock);
+
+	free(sub);
+}
+
+static void *walk_thread_run(void *arg)
+{
+	struct walk_thread *thread = arg;
+	OVAL_FTS_WALK *walk = thread->walk;
+	struct walk_dir *dir;
+
+#if defined(HAVE_PTHREAD_SETNAME_NP)
+	pthread_setname_np(pthread_self(), "fts_walk");
+#endif
+	pthread_mutex_lock(&walk->lock);
+
+	while (!walk->closing) {
+		dir = walk->buffered < OVAL_FTS_WALK_MAX_BUFFERED ? walk_take(walk, thread->index) : NULL;
+
+		if (dir == NULL) {
+			pthread_cond_wait(&walk->work, &walk->lock);
+			continue;
+		}
+
+		dir->state = WALK_READING;
+		pthread_mutex_unlock(&walk->lock);
+
+		walk_dir_read(walk, dir, thread->index);
+
+		pthread_mutex_lock(&walk->lock);
+		dir->state = WALK_READY;
+		walk->buffered += dir->count;
+		pthread_cond_broadcast(&walk->ready);
+	}
+
+	pthread_mutex_unlock(&walk->lock);
+
+	return NULL;
+}
+
+/* wait for the directory to be read or read it if nobody started yet */
+static void walk_wait(OVAL_FTS_WALK *walk, struct walk_dir *dir)
+{
+	pthread_mutex_lock(&walk->lock);
+
+	while (dir->state != WALK_READY) {
+		if (dir->state == WALK_PENDING) {
+			dir->state = WALK_READING;
+			pthread_mutex_unlock(&walk->lock);
+
+			walk_dir_read(walk, dir, walk->threads);
+
+			pthread_mutex_lock(&walk->lock);
+			dir->state = WALK_READY;
+			walk->buffered += dir->count;
+		} else {
+			pthread_cond_wait(&walk->ready, &walk->lock);
+		}
+	}
+
+	pthread_mutex_unlock(&walk->lock);
+}
+
+static void walk_release(OVAL_FTS_WALK *walk, struct walk_dir *dir)
+{
+	bool release;
+
+	pthread_mutex_lock(&walk->lock);
+
+	if (walk->buffered >= OVAL_FTS_WALK_MAX_BUFFERED &&
+	    walk->buffered - dir->count < OVAL_FTS_WALK_MAX_BUFFERED)
+		pthread_cond_broadcast(&walk->work);
+	walk->buffered -= dir->count;
+
+	if (dir->queued)
+		dir->orphan = true;
+	release = !dir->queued;
+
+	pthread_mutex_unlock(&walk->lock);
+
+	if (release)
+		walk_dir_free(dir);
+}
+
+static void walk_push(OVAL_FTS_WALK *walk, struct walk_dir *dir)
+{
+	if (walk->depth == walk->stack_alloc) {
+		walk->stack_alloc = walk->stack_alloc > 0 ? 2 * walk->stack_alloc : 32;
+		walk->stack = realloc(walk->stack, walk->stack_alloc * sizeof(struct walk_frame));
+	}
+
+	walk->stack[walk->depth].dir   = dir;
+	walk->stack[walk->depth].index = 0;
+	walk->stack[walk->depth].ready = false;
+	++walk->depth;
+}
+
+OVAL_FTS_WALK *oval_fts_walk_open(const char *root, int threads, oval_fts_walk_instr_t instr, void *arg)
+{
+	OVAL_FTS_WALK *walk;
+	OVAL_FTS_WALKENT went;
+	struct stat st;
+
+	walk = calloc(1, sizeof(OVAL_FTS_WALK));
+	walk->instr   = instr;
+	walk->arg     = arg;
+	walk->threads = threads > 0 ? threads : 0;
+	walk->queue   = calloc(walk->threads + 1, sizeof(struct walk_queue));
+
+	pthread_mutex_init(&walk->lock, NULL);
+	pthread_cond_init(&walk->work, NULL);
+	pthread_cond_init(&walk->ready, NULL);
+
+	walk->root_path    = strdup(root);
+	walk->root_pathlen = strlen(root);
+
+	/* FTS_COMFOLLOW */
+	if (stat(root, &st) != 0) {
+		if (errno == ENOENT && lstat(root, &st) == 0)
+			walk->root_info = FTS_SLNONE;
+		else
+			walk->root_info = FTS_NS;
+	} else {
+		walk->root_info = walk_info(NULL, &st);
+	}
+
+	if (walk->root_info == FTS_D) {
+		went.path    = walk->root_path;
+		went.pathlen = walk->root_pathlen;
+		went.name    = walk->root_path;
+		went.namelen = walk->root_pathlen;
+		went.level   = 0;
+		went.info    = FTS_D;
+		went.statp   = &st;
+
+		if (instr(arg, &went) != FTS_SKIP)
+			walk->root = walk_dir_new(NULL, walk->root_path, walk->root_pathlen,
+			                          walk->root_pathlen, 0, &st);
+	}
+
+	return walk;
+}
+
+const OVAL_FTS_WALKENT *oval_fts_walk_read(OVAL_FTS_WALK *walk)
+{
+	struct walk_frame *frame;
+	struct walk_dir *dir;
+	struct walk_ent *ent;
+
+	walk->cur.statp = NULL;
+
+	if (!walk->root_done) {
+		walk->root_done = true;
+
+		walk->cur.path    = walk->root_path;
+		walk->cur.pathlen = walk->root_pathlen;
+		walk->cur.name    = walk->root_path;
+		walk->cur.namelen = walk->root_pathlen;
+		walk->cur.level   = 0;
+		walk->cur.info    = walk->root_info;
+
+		if (walk->root != NULL) {
+			walk_push(walk, walk->root);
+			walk->root = NULL;
+		}
+
+		return &walk->cur;
+	}
+
+	while (walk->depth > 0) {
+		frame = &walk->stack[walk->depth - 1];
+		dir = frame->dir;
+
+		if (!frame->ready) {
+			walk_wait(walk, dir);
+			frame->ready = true;
+
+			/* fts returns a directory which can't be read once more as FTS_DNR */
+			if (dir->failed) {
+				walk->cur.path    = dir->path;
+				walk->cur.pathlen = dir->pathlen;
+				walk->cur.name    = dir->path + dir->pathlen - dir->namelen;
+				walk->cur.namelen = dir->namelen;
+				walk->cur.level   = dir->level;
+				walk->cur.info    = FTS_DNR;
+
+				return &walk->cur;
+			}
+		}
+
+		if (frame->index == dir->count) {
+			walk_release(walk, dir);
+			--walk->depth;
+			continue;
+		}
+
+		ent = &dir->ent[frame->index++];
+
+		walk->cur.pathlen = walk_join(&walk->path, &walk->path_alloc, dir->path, dir->pathlen,
+		                              dir->names + ent->name, ent->namelen);
+		walk->cur.path    = walk->path;
+		walk->cur.name    = walk->path + walk->cur.pathlen - ent->namelen;
+		walk->cur.namelen = ent->namelen;
+		walk->cur.level   = dir->level + 1;
+		walk->cur.info    = ent->info;
+
+		if (ent->dir != NULL) {
+			walk_push(walk, ent->dir);
+			ent->dir = NULL;
+		}
+
+		return &walk->cur;
+	}
+
+	return NULL;
+}
+
+void oval_fts_walk_close(OVAL_FTS_WALK *walk)
+{
+	struct walk_queue *queue;
+	size_t i;
+	int t;
+
+	if (walk == NULL)
+		return;
+
+	pthread_mutex_lock(&walk->lock);
+	walk->closing = true;
+	pthread_cond_broadcast(&walk->work);
+	pthread_mutex_unlock(&walk->lock);
+
+	for (t = 0; t < walk->started; ++t)
+		pthread_join(walk->thread[t].thread, NULL);
+
+	/* the consumed directories are only in the queues, the rest is in the tree */
+	for (t = 0; t <= walk->threads; ++t) {
+		queue = &walk->queue[t];
+		for (i = queue->head; i < queue->tail; ++i)
+			if (queue->dir[i]->orphan)
+				walk_dir_free(queue->dir[i]);
+		free(queue->dir);
+	}
+
+	for (i = 0; i < walk->depth; ++i)
+		walk_dir_free_tree(walk->stack[i].dir);
+	if (walk->root != NULL)
+		walk_dir_free_tree(walk->root);
+
+	pthread_cond_destroy(&walk->ready);
+	pthread_cond_destroy(&walk->work);
+	pthread_mutex_destroy(&walk->lock);
+
+	free(walk->thread);
+	free(walk->queue);
+	free(walk->stack);
+	free(walk->path);
+	free(walk->root_path);
+	free(walk);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef OVAL_FTS_WALK_H
+#define OVAL_FTS_WALK_H
+
+#include <stddef.h>
+#include <sys/stat.h>
+
+/*
+ * Parallel replacement of fts_read() for walking a directory tree down.
+ *
+ * Directories are read (including the lstat() of every entry) by a pool of
+ * threads. Each thread keeps the directories it has found in its own queue
+ * and steals from the other queues when its own one is empty. The reader
+ * gets the entries in the same order as from fts_open(FTS_PHYSICAL |
+ * FTS_COMFOLLOW | FTS_NOCHDIR) + fts_read(), with the same fts_info values,
+ * and reads a directory itself if no thread got to it yet.
+ *
+ * Whether to descend into a directory or to follow a symlink is decided by
+ * a callback which replaces the fts_set() calls of an fts_read() loop. It
+ * is called from the walking threads.
+ */
+
+#define OVAL_FTS_WALK_ENV_THREADS "OSCAP_PROBE_FTS_THREADS"
+#define OVAL_FTS_WALK_MAX_THREADS 8
+
+typedef struct oval_fts_walk OVAL_FTS_WALK;
+
+typedef struct {
+	const char *path;
+	size_t pathlen;
+	const char *name;
+	size_t namelen;
+	int level;
+	int info;                  /* FTS_* value of fts_info */
+	const struct stat *statp;  /* set only for the callback */
+} OVAL_FTS_WALKENT;
+
+/**
+ * Called for every FTS_D and FTS_SL entry.
+ * @return 0, FTS_SKIP or FTS_FOLLOW like the instruction of fts_set()
+ */
+typedef int (*oval_fts_walk_instr_t)(void *arg, const OVAL_FTS_WALKENT *ent);
+
+/**
+ * Number of walking threads to use, given by OVAL_FTS_WALK_ENV_THREADS,
+ * 0 if it isn't set. Less than 2 means fts should be used instead.
+ */
+int oval_fts_walk_threads(void);
+
+OVAL_FTS_WALK *oval_fts_walk_open(const char *root, int threads, oval_fts_walk_instr_t instr, void *arg);
+
+/**
+ * Get the next entry. The entry is valid until the next call.
+ * @return the entry or NULL at the end of the walk
+ */
+const OVAL_FTS_WALKENT *oval_fts_walk_read(OVAL_FTS_WALK *walk);
+
+void oval_fts_walk_close(OVAL_FTS_WALK *walk);
+
+#endif /* OVAL_FTS_WALK_H */
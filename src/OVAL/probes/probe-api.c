@@ -107,7 +107,7 @@ SEXP_t *probe_item_new(const char *name, SEXP_t * attrs)
 
         /*
          * Allocate space for the ID which will be generated
-         * in the icache worker
+         * by the item cache
          */
 	sid  = SEXP_string_new("", 0);
 	attr = probe_attr_creat("id", sid, NULL);
@@ -51,6 +51,26 @@
 #include "../../results/oval_cmp_evr_string_impl.h"
 #include "../../results/oval_cmp_ip_address_impl.h"
 
+/* length of the buffers for the compared versions, longer ones are allocated */
+#define PROBE_ENT_CMP_BUFLEN 256
+
+/*
+ * Get a C string from a sexp object, in the provided buffer if it fits.
+ * Release the string by probe_ent_cstr_free().
+ */
+static char *probe_ent_cstr(const SEXP_t *val, char *buf, size_t len)
+{
+	if (SEXP_string_cstr_r(val, buf, len) != (size_t)-1)
+		return buf;
+	return SEXP_string_cstr(val);
+}
+
+static void probe_ent_cstr_free(char *str, char *buf)
+{
+	if (str != buf)
+		free(str);
+}
+
 oval_result_t probe_ent_cmp_binary(SEXP_t * val1, SEXP_t * val2, oval_operation_t op)
 {
 	oval_result_t result = OVAL_RESULT_ERROR;
@@ -80,13 +100,14 @@ oval_result_t probe_ent_cmp_bool(SEXP_t * val1, SEXP_t * val2, oval_operation_t
 oval_result_t probe_ent_cmp_evr(SEXP_t * val1, SEXP_t * val2, oval_operation_t op)
 {
 	oval_result_t result = OVAL_RESULT_ERROR;
-	char *s1 = SEXP_string_cstr(val1);
-	char *s2 = SEXP_string_cstr(val2);
+	char b1[PROBE_ENT_CMP_BUFLEN], b2[PROBE_ENT_CMP_BUFLEN];
+	char *s1 = probe_ent_cstr(val1, b1, sizeof b1);
+	char *s2 = probe_ent_cstr(val2, b2, sizeof b2);
 
 	result = oval_evr_string_cmp(s1, s2, op);
 
-	free(s1);
-	free(s2);
+	probe_ent_cstr_free(s1, b1);
+	probe_ent_cstr_free(s2, b2);
 	return result;
 }
 
@@ -141,13 +162,14 @@ oval_result_t probe_ent_cmp_ios(SEXP_t * val1, SEXP_t * val2, oval_operation_t o
 
 oval_result_t probe_ent_cmp_version(SEXP_t * val1, SEXP_t * val2, oval_operation_t op)
 {
-	char *state_version = SEXP_string_cstr(val1);
-	char *sys_version = SEXP_string_cstr(val2);
+	char state_buf[PROBE_ENT_CMP_BUFLEN], sys_buf[PROBE_ENT_CMP_BUFLEN];
+	char *state_version = probe_ent_cstr(val1, state_buf, sizeof state_buf);
+	char *sys_version = probe_ent_cstr(val2, sys_buf, sizeof sys_buf);
 
 	oval_result_t result = oval_versiontype_cmp(state_version, sys_version, op);
 
-	free(state_version);
-	free(sys_version);
+	probe_ent_cstr_free(state_version, state_buf);
+	probe_ent_cstr_free(sys_version, sys_buf);
 	return result;
 }
 
@@ -34,12 +34,12 @@
 #include "../SEAP/generic/rbt/rbt.h"
 #include "probe-api.h"
 #include "common/debug_priv.h"
-#include "common/memusage.h"
 #include "common/alloc.h"
 #include "common/assume.h"
 
 #include "probe.h"
 #include "icache.h"
+#include "memcheck.h"
 
 static volatile uint32_t next_ID = 0;
 
@@ -85,7 +85,7 @@ static void probe_icache_item_setID(SEXP_t *item, SEXP_ID_t item_ID)
         return;
 }
 
-static int icache_lookup(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
+static int icache_lookup(rbt_t *tree, int64_t item_id, SEXP_t **item) {
 
 	probe_citem_t *cached = NULL;
 
@@ -99,23 +99,23 @@ static int icache_lookup(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
 	dI("cache HIT #1");
 
 	register uint16_t i;
-	for (i = 0; i < cached->count; ++i) {
-		SEXP_t rest1;
-		SEXP_t* rest_r1 = SEXP_list_rest_r(&rest1, pair->p.item);
+	SEXP_t rest1;
+	SEXP_t* rest_r1 = SEXP_list_rest_r(&rest1, *item);
 
+	for (i = 0; i < cached->count; ++i) {
 		SEXP_t rest2;
 		SEXP_t* rest_r2 = SEXP_list_rest_r(&rest2, cached->item[i]);
 
 		if (SEXP_deepcmp(rest_r1, rest_r2)) {
-			SEXP_free_r(&rest1);
 			SEXP_free_r(&rest2);
 			break;
 		}
 
-		SEXP_free_r(&rest1);
 		SEXP_free_r(&rest2);
 	}
 
+	SEXP_free_r(&rest1);
+
 	if (i == cached->count) {
 		/*
 		* Cache MISS
@@ -123,30 +123,30 @@ static int icache_lookup(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
 		dI("cache MISS");
 
 		cached->item = realloc(cached->item, sizeof(SEXP_t *) * ++cached->count);
-		cached->item[cached->count - 1] = pair->p.item;
+		cached->item[cached->count - 1] = *item;
 
 		/* Assign an unique item ID */
-		probe_icache_item_setID(pair->p.item, item_id);
+		probe_icache_item_setID(*item, item_id);
 	} else {
 		/*
 		* Cache HIT
 		*/
 		dI("cache HIT #2 -> real HIT");
-		SEXP_free(pair->p.item);
-		pair->p.item = cached->item[i];
+		SEXP_free(*item);
+		*item = cached->item[i];
 	}
 	return 0;
 }
 
-static void icache_add_to_tree(rbt_t *tree, int64_t item_id, probe_iqpair_t *pair) {
+static void icache_add_to_tree(rbt_t *tree, int64_t item_id, SEXP_t *item) {
 
 	probe_citem_t *cached = oscap_talloc(probe_citem_t);
 	cached->item = oscap_talloc(SEXP_t *);
-	cached->item[0] = pair->p.item;
+	cached->item[0] = item;
 	cached->count = 1;
 
 	/* Assign an unique item ID */
-	probe_icache_item_setID(pair->p.item, item_id);
+	probe_icache_item_setID(item, item_id);
 
 	if (rbt_i64_add(tree, (int64_t)item_id, (void **)cached, NULL) != 0) {
 		dE("Can't add item (k=%"PRIi64" to the cache (%p)", item_id, tree);
@@ -159,343 +159,175 @@ static void icache_add_to_tree(rbt_t *tree, int64_t item_id, probe_iqpair_t *pai
 	}
 }
 
-static void *probe_icache_worker(void *arg)
+probe_icache_t *probe_icache_new(void)
 {
-        probe_icache_t *cache = (probe_icache_t *)(arg);
-        probe_iqpair_t *pair, pair_mem;
-        SEXP_ID_t       item_ID;
+        probe_icache_t *cache;
+        int i;
 
-        assume_d(cache != NULL, NULL);
+        cache = oscap_talloc(probe_icache_t);
 
-#if defined(HAVE_PTHREAD_SETNAME_NP)
-	pthread_setname_np(pthread_self(), "icache_worker");
-#endif
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                if (pthread_mutex_init(&cache->shard[i].mutex, NULL) != 0) {
+                        dE("Can't initialize icache mutex: %u, %s", errno, strerror(errno));
+                        goto fail;
+                }
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                return (NULL);
+                cache->shard[i].tree = rbt_i64_new();
         }
 
-	pair = &pair_mem;
-        dD("icache worker ready");
-
-        switch (errno = pthread_barrier_wait(&OSCAP_GSYM(th_barrier)))
-        {
-        case 0:
-        case PTHREAD_BARRIER_SERIAL_THREAD:
-	        break;
-        default:
-	        dE("pthread_barrier_wait: %d, %s.",
-	           errno, strerror(errno));
-	        pthread_mutex_unlock(&cache->queue_mutex);
-	        return (NULL);
+        return (cache);
+fail:
+        while (--i >= 0) {
+                rbt_i64_free(cache->shard[i].tree);
+                pthread_mutex_destroy(&cache->shard[i].mutex);
         }
 
-        while(pthread_cond_wait(&cache->queue_notempty, &cache->queue_mutex) == 0) {
-                assume_d(cache->queue_cnt > 0, NULL);
-        do {
-                dI("Extracting item from the cache queue: cnt=%"PRIu16", beg=%"PRIu16"", cache->queue_cnt, cache->queue_beg);
-                /*
-                 * Extract an item from the queue and update queue beg, end & cnt
-                 */
-                pair_mem = cache->queue[cache->queue_beg];
-#ifndef NDEBUG
-		memset(cache->queue + cache->queue_beg, 0, sizeof(probe_iqpair_t));
+        free(cache);
+
+        return (NULL);
+}
+
+/*
+ * Number of items whose IDs are computed and looked up at once
+ * by probe_icache_add_batch()
+ */
+#define PROBE_ICACHE_CHUNK 64
+
+#if PROBE_ICACHE_SHARDS > 32
+# error "PROBE_ICACHE_SHARDS must not be greater than 32"
 #endif
-                --cache->queue_cnt;
-		++cache->queue_beg;
 
-		if (cache->queue_beg == cache->queue_max)
-			cache->queue_beg = 0;
+int probe_icache_add_batch(probe_icache_t *cache, SEXP_t *cobj, SEXP_t **items, size_t count)
+{
+        SEXP_ID_t item_ID[PROBE_ICACHE_CHUNK];
+        uint8_t   shard_of[PROBE_ICACHE_CHUNK];
+        size_t    off, n, i;
+        int       cstate;
+
+        if (cache == NULL || cobj == NULL || items == NULL)
+                return (-1); /* XXX: EFAULT */
 
-		assume_d(cache->queue_cnt == 0 ?
-			 cache->queue_end == cache->queue_beg :
-			 cache->queue_end != cache->queue_beg, NULL);
+        /*
+         * The collecting thread may be running with asynchronous
+         * cancelation enabled. Don't let it be canceled while it
+         * holds a shard lock or while the collected object is being
+         * modified.
+         */
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &cstate);
 
+        for (off = 0; off < count; off += n) {
+                uint32_t shards = 0;
+                int s;
 
-                dD("Signaling `notfull'");
+                n = count - off < PROBE_ICACHE_CHUNK ? count - off : PROBE_ICACHE_CHUNK;
 
-                if (pthread_cond_signal(&cache->queue_notfull) != 0) {
-                        dE("An error ocured while signaling the `notfull' condition: %u, %s",
-                           errno, strerror(errno));
-                        abort();
-                }
                 /*
-                 * Release the mutex
+                 * Compute item IDs without holding any lock
                  */
-                if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while unlocking the queue mutex: %u, %s",
-                           errno, strerror(errno));
-                        abort();
+                for (i = 0; i < n; ++i) {
+                        item_ID[i]   = SEXP_ID_v(items[off + i]);
+                        shard_of[i]  = item_ID[i] % PROBE_ICACHE_SHARDS;
+                        shards      |= 1 << shard_of[i];
+                        dD("item ID=%"PRIu64"", item_ID[i]);
                 }
 
-                if (pair->cobj == NULL) {
-                        /*
-                         * Handle NOP case (synchronization)
-                         */
-                        assume_d(pair->p.cond != NULL, NULL);
+                /*
+                 * Deduplicate the items; each involved shard is locked once
+                 */
+                for (s = 0; shards != 0; ++s, shards >>= 1) {
+                        probe_ishard_t *shard = &cache->shard[s];
 
-                        dD("Handling NOP");
+                        if (!(shards & 1))
+                                continue;
 
-                        if (pthread_cond_signal(pair->p.cond) != 0) {
-                                dE("An error ocured while signaling NOP condition: %u, %s",
+                        if (pthread_mutex_lock(&shard->mutex) != 0) {
+                                dE("An error ocured while locking the shard mutex: %u, %s",
                                    errno, strerror(errno));
                                 abort();
                         }
-                } else {
-
-                        dD("Handling cache request");
-
-                        /*
-                         * Compute item ID
-                         */
-			dD("pair address: %"PRIu64, (uint64_t) pair);
-			dD("item address: %"PRIu64, (uint64_t) pair->p.item);
-                        item_ID = SEXP_ID_v(pair->p.item);
-                        dD("item ID=%"PRIu64"", item_ID);
-
-                        if (icache_lookup(cache->tree, item_ID, pair) != 0) {
-                                /*
-                                 * Cache MISS
-                                 */
-                                dI("cache MISS");
-                                icache_add_to_tree(cache->tree, item_ID, pair);
-                        }
 
-                        if (probe_cobj_add_item(pair->cobj, pair->p.item) != 0) {
-                            dW("An error ocured while adding the item to the collected object");
+                        for (i = 0; i < n; ++i) {
+                                if (shard_of[i] != s)
+                                        continue;
+
+                                if (icache_lookup(shard->tree, item_ID[i], items + off + i) != 0) {
+                                        /*
+                                         * Cache MISS
+                                         */
+                                        dI("cache MISS");
+                                        icache_add_to_tree(shard->tree, item_ID[i], items[off + i]);
+                                }
                         }
-                }
 
-                if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while re-locking the queue mutex: %u, %s",
-                           errno, strerror(errno));
-                        abort();
+                        if (pthread_mutex_unlock(&shard->mutex) != 0) {
+                                dE("An error ocured while unlocking the shard mutex: %u, %s",
+                                   errno, strerror(errno));
+                                abort();
+                        }
                 }
 
-                } while (cache->queue_cnt > 0);
-        }
-
-        return (NULL);
-}
-
-probe_icache_t *probe_icache_new(void)
-{
-        probe_icache_t *cache;
-
-        cache = oscap_talloc(probe_icache_t);
-        cache->tree = rbt_i64_new();
-
-        if (pthread_mutex_init(&cache->queue_mutex, NULL) != 0) {
-                dE("Can't initialize icache mutex: %u, %s", errno, strerror(errno));
-                goto fail;
-        }
-
-        cache->queue_beg = 0;
-        cache->queue_end = 0;
-        cache->queue_cnt = 0;
-        cache->queue_max = PROBE_IQUEUE_CAPACITY;
-
-        if (pthread_cond_init(&cache->queue_notempty, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (notempty): %u, %s",
-                   errno, strerror(errno));
-                goto fail;
-        }
-
-        if (pthread_cond_init(&cache->queue_notfull, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (notfull): %u, %s",
-                   errno, strerror(errno));
-                goto fail;
-        }
-
-        if (pthread_create(&cache->thid, NULL,
-                           probe_icache_worker, (void *)cache) != 0)
-        {
-                dE("Can't start the icache worker: %u, %s", errno, strerror(errno));
-                goto fail;
-        }
-
-        return (cache);
-fail:
-        if (cache->tree != NULL)
-                rbt_i64_free(cache->tree);
-
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
-        free(cache);
-
-        return (NULL);
-}
-
-static int __probe_icache_add_nolock(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item, pthread_cond_t *cond)
-{
-        assume_d((cond == NULL) ^ (item == NULL), -1);
-retry:
-        if (cache->queue_cnt < cache->queue_max) {
-                cache->queue[cache->queue_end].cobj = cobj;
-
-                if (item != NULL) {
-			assume_d(cobj != NULL, -1);
-                        cache->queue[cache->queue_end].p.item = item;
-                } else {
-			assume_d(item == NULL && cobj == NULL, -1);
-                        cache->queue[cache->queue_end].p.cond = cond;
-		}
-
-                ++cache->queue_cnt;
-		++cache->queue_end;
-
-                if (cache->queue_end == cache->queue_max)
-                        cache->queue_end = 0;
-        } else {
                 /*
-                 * The queue is full, we have to wait
+                 * Add the items to the collected object in the order
+                 * in which they were submitted
                  */
-                if (pthread_cond_wait(&cache->queue_notfull, &cache->queue_mutex) == 0)
-                        goto retry;
-                else {
-                        dE("An error ocured while waiting for the `notfull' queue condition: %u, %s",
-                           errno, strerror(errno));
-                        return (-1);
+                for (i = 0; i < n; ++i) {
+                        if (probe_cobj_add_item(cobj, items[off + i]) != 0) {
+                                dW("An error ocured while adding the item to the collected object");
+                        }
                 }
         }
 
+        pthread_setcancelstate(cstate, NULL);
+
         return (0);
 }
 
 int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item)
 {
-        int ret;
-
-        if (cache == NULL || cobj == NULL || item == NULL)
+        if (item == NULL)
                 return (-1); /* XXX: EFAULT */
 
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
-
-        ret = __probe_icache_add_nolock(cache, cobj, item, NULL);
-
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
-
-        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while unlocking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                abort();
-        }
-
-        if (ret != 0)
-                return (-1);
-
-        return (0);
+        return probe_icache_add_batch(cache, cobj, &item, 1);
 }
 
-int probe_icache_nop(probe_icache_t *cache)
-{
-        pthread_cond_t cond;
-
-        dD("NOP");
-
-        if (pthread_mutex_lock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while locking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
-
-        if (pthread_cond_init(&cond, NULL) != 0) {
-                dE("Can't initialize icache queue condition variable (NOP): %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
-
-        if (__probe_icache_add_nolock(cache, NULL, NULL, &cond) != 0) {
-                if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                        dE("An error ocured while unlocking the queue mutex: %u, %s",
-                           errno, strerror(errno));
-                        abort();
-                }
-
-                pthread_cond_destroy(&cond);
-                return (-1);
-        }
-
-        dD("Signaling `notempty'");
-
-        if (pthread_cond_signal(&cache->queue_notempty) != 0) {
-                dE("An error ocured while signaling the `notempty' condition: %u, %s",
-                   errno, strerror(errno));
-
-                pthread_cond_destroy(&cond);
-                return (-1);
-        }
-
-        dD("Waiting for icache worker to handle the NOP");
-
-        if (pthread_cond_wait(&cond, &cache->queue_mutex) != 0) {
-                dE("An error ocured while waiting for the `NOP' queue condition: %u, %s",
-                   errno, strerror(errno));
-                return (-1);
-        }
-
-        dD("Sync");
-
-        if (pthread_mutex_unlock(&cache->queue_mutex) != 0) {
-                dE("An error ocured while unlocking the queue mutex: %u, %s",
-                   errno, strerror(errno));
-                abort();
-        }
-
-        pthread_cond_destroy(&cond);
-
-        return (0);
-}
-
-#define PROBE_RESULT_MEMCHECK_CTRESHOLD  32768  /* item count */
-#define PROBE_RESULT_MEMCHECK_MINFREEMEM 512    /* MiB */
-#define PROBE_RESULT_MEMCHECK_MAXRATIO   0.8   /* max. memory usage ratio - used/total */
-
 /**
- * Returns 0 if the memory constraints are not reached. Otherwise, 1 is returned.
- * In case of an error, -1 is returned.
+ * Check the memory constraints before items are added to the collected
+ * object of the given probe context. If they are reached, the collected
+ * object is flagged as incomplete.
+ *
+ * Returns 0 if the items can be added, 2 if they can't.
  */
-static int probe_cobj_memcheck(size_t item_cnt)
+static int probe_ctx_memcheck(struct probe_ctx *ctx)
 {
-	if (item_cnt > PROBE_RESULT_MEMCHECK_CTRESHOLD) {
-		struct proc_memusage mu_proc;
-		struct sys_memusage  mu_sys;
-		double c_ratio;
+	SEXP_t *cobj_content;
+	size_t  cobj_itemcnt;
 
-		if (oscap_proc_memusage (&mu_proc) != 0)
-			return (-1);
+	cobj_content = SEXP_listref_nth(ctx->probe_out, 3);
+	cobj_itemcnt = SEXP_list_length(cobj_content);
+	SEXP_free(cobj_content);
 
-		if (oscap_sys_memusage (&mu_sys) != 0)
-			return (-1);
+	if (probe_memcheck(&ctx->memcheck, cobj_itemcnt) != 0) {
 
-		c_ratio = (double)mu_proc.mu_rss/(double)(mu_sys.mu_total);
+		/*
+		 * Don't set the message again if the collected object is
+		 * already flagged as incomplete.
+		 */
+		if (probe_cobj_get_flag(ctx->probe_out) != SYSCHAR_FLAG_INCOMPLETE) {
+			SEXP_t *msg;
 
-		if (c_ratio > PROBE_RESULT_MEMCHECK_MAXRATIO) {
-			dW("Memory usage ratio limit reached! limit=%f, current=%f",
-			   PROBE_RESULT_MEMCHECK_MAXRATIO, c_ratio);
-			errno = ENOMEM;
-			return (1);
-		}
+			msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_WARNING,
+			                      "Object is incomplete due to memory constraints.");
 
-		if ((mu_sys.mu_realfree / 1024) < PROBE_RESULT_MEMCHECK_MINFREEMEM) {
-			dW("Minimum free memory limit reached! limit=%zu, current=%zu",
-			   PROBE_RESULT_MEMCHECK_MINFREEMEM, mu_sys.mu_realfree / 1024);
-			errno = ENOMEM;
-			return (1);
+			probe_cobj_add_msg(ctx->probe_out, msg);
+			probe_cobj_set_flag(ctx->probe_out, SYSCHAR_FLAG_INCOMPLETE);
+
+			SEXP_free(msg);
 		}
+
+		return 2;
 	}
 
-	return (0);
+	return 0;
 }
 
 /**
@@ -511,45 +343,16 @@ static int probe_cobj_memcheck(size_t item_cnt)
  *-1 ... unexpected/internal error
  *
  * The caller must not free the item, it's freed automatically
- * by this function or by the icache worker thread.
+ * by this function or by the item cache.
  */
 int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 {
-	SEXP_t *cobj_content;
-	size_t  cobj_itemcnt;
-
 	assume_d(ctx != NULL, -1);
 	assume_d(ctx->probe_out != NULL, -1);
 	assume_d(item != NULL, -1);
 
-	cobj_content = SEXP_listref_nth(ctx->probe_out, 3);
-	cobj_itemcnt = SEXP_list_length(cobj_content);
-	SEXP_free(cobj_content);
-
-	if (probe_cobj_memcheck(cobj_itemcnt) != 0) {
-
-		/*
-		 * Don't set the message again if the collected object is
-		 * already flagged as incomplete.
-		 */
-		if (probe_cobj_get_flag(ctx->probe_out) != SYSCHAR_FLAG_INCOMPLETE) {
-			SEXP_t *msg;
-			/*
-			 * Sync with the icache thread before modifying the
-			 * collected object.
-			 */
-			if (probe_icache_nop(ctx->icache) != 0)
-				return -1;
-
-			msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_WARNING,
-			                      "Object is incomplete due to memory constraints.");
-
-			probe_cobj_add_msg(ctx->probe_out, msg);
-			probe_cobj_set_flag(ctx->probe_out, SYSCHAR_FLAG_INCOMPLETE);
-
-			SEXP_free(msg);
-		}
-
+	if (probe_ctx_memcheck(ctx) != 0) {
+		SEXP_free(item);
 		return 2;
 	}
 
@@ -567,6 +370,40 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
         return (0);
 }
 
+int probe_item_collect_batch(struct probe_ctx *ctx, SEXP_t **items, size_t count)
+{
+	size_t i, n;
+
+	assume_d(ctx != NULL, -1);
+	assume_d(ctx->probe_out != NULL, -1);
+	assume_d(items != NULL || count == 0, -1);
+
+	if (probe_ctx_memcheck(ctx) != 0) {
+		for (i = 0; i < count; ++i)
+			SEXP_free(items[i]);
+		return 2;
+	}
+
+	if (ctx->filters != NULL) {
+		for (i = n = 0; i < count; ++i) {
+			if (probe_item_filtered(items[i], ctx->filters))
+				SEXP_free(items[i]);
+			else
+				items[n++] = items[i];
+		}
+	} else
+		n = count;
+
+	if (probe_icache_add_batch(ctx->icache, ctx->probe_out, items, n) != 0) {
+		dE("Can't add %zu items to the item cache (%p)", n, ctx->icache);
+		for (i = 0; i < n; ++i)
+			SEXP_free(items[i]);
+		return (-1);
+	}
+
+	return (0);
+}
+
 static void probe_icache_free_node(struct rbt_i64_node *n)
 {
         probe_citem_t *ci = (probe_citem_t *)n->data;
@@ -582,15 +419,13 @@ static void probe_icache_free_node(struct rbt_i64_node *n)
 
 void probe_icache_free(probe_icache_t *cache)
 {
-        void *ret = NULL;
+        int i;
 
-        pthread_cancel(cache->thid);
-        pthread_join(cache->thid, &ret);
-        pthread_mutex_destroy(&cache->queue_mutex);
-        pthread_cond_destroy(&cache->queue_notempty);
-        pthread_cond_destroy(&cache->queue_notfull);
+        for (i = 0; i < PROBE_ICACHE_SHARDS; ++i) {
+                pthread_mutex_destroy(&cache->shard[i].mutex);
+                rbt_i64_free_cb(cache->shard[i].tree, &probe_icache_free_node);
+        }
 
-        rbt_i64_free_cb(cache->tree, &probe_icache_free_node);
         free(cache);
         return;
 }
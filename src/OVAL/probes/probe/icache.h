@@ -22,35 +22,26 @@
 #ifndef ICACHE_H
 #define ICACHE_H
 
+#include <pthread.h>
 #include <stddef.h>
 #include <sexp.h>
 #include "../SEAP/generic/rbt/rbt.h"
 
-#ifndef PROBE_IQUEUE_CAPACITY
-#define PROBE_IQUEUE_CAPACITY 1024
+#ifndef PROBE_ICACHE_SHARDS
+#define PROBE_ICACHE_SHARDS 16
 #endif
 
+/*
+ * The cache is split into shards selected by the item ID so that threads
+ * collecting items concurrently rarely contend for the same lock.
+ */
 typedef struct {
-        SEXP_t *cobj;
-        union {
-                SEXP_t         *item;
-                pthread_cond_t *cond;
-        } p;
-} probe_iqpair_t;
+        pthread_mutex_t mutex;
+        rbt_t          *tree; /* XXX: rewrite to extensible or linear hashing */
+} probe_ishard_t;
 
 typedef struct {
-        rbt_t    *tree; /* XXX: rewrite to extensible or linear hashing */
-        pthread_t thid;
-
-        pthread_mutex_t queue_mutex;
-        pthread_cond_t  queue_notempty;
-        pthread_cond_t  queue_notfull;
-
-        probe_iqpair_t  queue[PROBE_IQUEUE_CAPACITY];
-        uint16_t        queue_beg;
-        uint16_t        queue_end;
-        uint16_t        queue_cnt;
-        uint16_t        queue_max;
+        probe_ishard_t shard[PROBE_ICACHE_SHARDS];
 } probe_icache_t;
 
 typedef struct {
@@ -60,7 +51,7 @@ typedef struct {
 
 probe_icache_t *probe_icache_new(void);
 int probe_icache_add(probe_icache_t *cache, SEXP_t *cobj, SEXP_t *item);
-int probe_icache_nop(probe_icache_t *cache);
+int probe_icache_add_batch(probe_icache_t *cache, SEXP_t *cobj, SEXP_t **items, size_t count);
 void probe_icache_free(probe_icache_t *cache);
 
 #endif /* ICACHE_H */
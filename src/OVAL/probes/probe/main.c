@@ -34,10 +34,12 @@
 #include <libgen.h>
 #include <seap.h>
 #include "common/bfind.h"
+#include "common/oscap_pcre_cache.h"
 #include "probe.h"
 #include "ncache.h"
 #include "rcache.h"
 #include "icache.h"
+#include "memcheck.h"
 #include "worker.h"
 #include "signal_handler.h"
 #include "input_handler.h"
@@ -63,11 +65,19 @@ pthread_barrier_t OSCAP_GSYM(th_barrier);
 
 extern probe_ncache_t *OSCAP_GSYM(ncache);
 
+static uint32_t probe_scan = 0;
+
 static int probe_optecmp(char **a, char **b)
 {
 	return strcmp(*a, *b);
 }
 
+/*
+ * Clear the state left by the previous scan. The library resets the probe
+ * only between scans, i.e. when no worker is running. The element name
+ * cache is kept, it doesn't depend on the scanned content and the names
+ * are shared by the S-exps referenced from OSCAP_GSYM(ncache).
+ */
 static SEXP_t *probe_reset(SEXP_t *arg0, void *arg1)
 {
         probe_t *probe = (probe_t *)arg1;
@@ -75,12 +85,20 @@ static SEXP_t *probe_reset(SEXP_t *arg0, void *arg1)
          * FIXME: implement main loop locking & worker waiting
          */
 	probe_rcache_free(probe->rcache);
-        probe_ncache_free(probe->ncache);
+        probe_icache_free(probe->icache);
 
         probe->rcache = probe_rcache_new();
-        probe->ncache = probe_ncache_new();
+        probe->icache = probe_icache_new();
+
+        __sync_fetch_and_add(&probe_scan, 1);
 
-        return(NULL);
+        /* acknowledge the reset */
+        return(SEXP_number_newb(true));
+}
+
+uint32_t probe_scan_id(void)
+{
+        return __sync_fetch_and_add(&probe_scan, 0);
 }
 
 static int probe_opthandler_varref(int option, int op, va_list args)
@@ -183,6 +201,7 @@ int main(int argc, char *argv[])
 	sigset_t       sigmask;
 	probe_t        probe;
 	char *rootdir = NULL;
+	struct oscap_pcre_cache_stats pcre_stats;
 
 	/* Turn on verbose mode */
 	char *verbosity_level = getenv("OSCAP_PROBE_VERBOSITY_LEVEL");
@@ -192,10 +211,9 @@ int main(int argc, char *argv[])
 	if ((errno = pthread_barrier_init(&OSCAP_GSYM(th_barrier), NULL,
 	                                  1 + // signal thread
 	                                  1 + // input thread
-	                                  1 + // icache thread
 	                                  0)) != 0)
 	{
-		fail(errno, "pthread_barrier_init", __LINE__ - 6);
+		fail(errno, "pthread_barrier_init", __LINE__ - 5);
 	}
 
 	/*
@@ -228,7 +246,7 @@ int main(int argc, char *argv[])
 	if (probe.sd < 0)
 		fail(errno, "SEAP_openfd2", __LINE__ - 3);
 
-	if (SEAP_cmd_register(probe.SEAP_ctx, PROBECMD_RESET, 0, &probe_reset) != 0)
+	if (SEAP_cmd_register(probe.SEAP_ctx, PROBECMD_RESET, SEAP_CMDREG_USEARG, &probe_reset, &probe) != 0)
 		fail(errno, "SEAP_cmd_register", __LINE__ - 1);
 
 	/*
@@ -237,6 +255,7 @@ int main(int argc, char *argv[])
 	probe.rcache = probe_rcache_new();
 	probe.ncache = probe_ncache_new();
         probe.icache = probe_icache_new();
+        probe_memcheck_init();
 
         OSCAP_GSYM(ncache) = probe.ncache;
 
@@ -358,6 +377,11 @@ int main(int argc, char *argv[])
 	probe_rcache_free(probe.rcache);
         probe_icache_free(probe.icache);
 
+	oscap_pcre_cache_get_stats(&pcre_stats);
+	dI("PCRE cache: %lu hits, %lu misses, %lu evictions.",
+	   pcre_stats.hits, pcre_stats.misses, pcre_stats.evictions);
+	oscap_pcre_cache_clear();
+
         rbt_i32_free(probe.workers);
 
         if (probe.sd != -1)
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <pthread.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "common/debug_priv.h"
+#include "common/memusage.h"
+#include "memcheck.h"
+
+static struct {
+	double ratio;    /* max. ratio of the probe RSS to the total memory */
+	size_t min_free; /* min. free system memory, kB */
+	size_t limit;    /* max. probe RSS, kB; 0 means no limit */
+} memcheck_budget = {
+	PROBE_MEMCHECK_MAXRATIO,
+	PROBE_MEMCHECK_MINFREEMEM * 1024,
+	0
+};
+
+#if !defined(HAVE_ATOMIC_BUILTINS)
+static pthread_mutex_t memcheck_count_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static int memcheck_getenv_size(const char *name, size_t *dst)
+{
+	const char *str = getenv(name);
+	char *end;
+	unsigned long long val;
+
+	if (str == NULL)
+		return 0;
+
+	errno = 0;
+	val = strtoull(str, &end, 10);
+
+	if (errno != 0 || end == str || *end != '\0' || str[0] == '-') {
+		dW("Ignoring invalid value of %s: '%s'", name, str);
+		return -1;
+	}
+
+	*dst = (size_t)val * 1024;
+	return 0;
+}
+
+void probe_memcheck_init(void)
+{
+	const char *str;
+
+	if ((str = getenv(PROBE_MEMCHECK_ENV_RATIO)) != NULL) {
+		char *end;
+		double ratio = strtod(str, &end);
+
+		if (end == str || *end != '\0' || !(ratio > 0.0 && ratio <= 1.0))
+			dW("Ignoring invalid value of %s: '%s'", PROBE_MEMCHECK_ENV_RATIO, str);
+		else
+			memcheck_budget.ratio = ratio;
+	}
+
+	memcheck_getenv_size(PROBE_MEMCHECK_ENV_MINFREE, &memcheck_budget.min_free);
+	memcheck_getenv_size(PROBE_MEMCHECK_ENV_LIMIT, &memcheck_budget.limit);
+
+	dI("Memory budget: ratio=%f, min. free=%zu kB, limit=%zu kB",
+	   memcheck_budget.ratio, memcheck_budget.min_free, memcheck_budget.limit);
+}
+
+static int memcheck_sample(void)
+{
+	struct proc_memusage mu_proc;
+	struct sys_memusage  mu_sys;
+	double c_ratio;
+
+	if (oscap_proc_memusage (&mu_proc) != 0)
+		return (-1);
+
+	if (oscap_sys_memusage (&mu_sys) != 0)
+		return (-1);
+
+	if (memcheck_budget.limit > 0 && mu_proc.mu_rss > memcheck_budget.limit) {
+		dW("Memory limit reached! limit=%zu kB, current=%zu kB",
+		   memcheck_budget.limit, mu_proc.mu_rss);
+		return (1);
+	}
+
+	c_ratio = (double)mu_proc.mu_rss/(double)(mu_sys.mu_total);
+
+	if (c_ratio > memcheck_budget.ratio) {
+		dW("Memory usage ratio limit reached! limit=%f, current=%f",
+		   memcheck_budget.ratio, c_ratio);
+		return (1);
+	}
+
+	if (mu_sys.mu_realfree < memcheck_budget.min_free) {
+		dW("Minimum free memory limit reached! limit=%zu kB, current=%zu kB",
+		   memcheck_budget.min_free, mu_sys.mu_realfree);
+		return (1);
+	}
+
+	return (0);
+}
+
+int probe_memcheck(struct probe_memcheck *state, size_t item_cnt)
+{
+	uint32_t count;
+	int result;
+
+	if (item_cnt <= PROBE_MEMCHECK_THRESHOLD)
+		return (0);
+
+#if defined(HAVE_ATOMIC_BUILTINS)
+	count = __sync_fetch_and_add(&state->count, 1);
+#else
+	pthread_mutex_lock(&memcheck_count_mutex);
+	count = state->count++;
+	pthread_mutex_unlock(&memcheck_count_mutex);
+#endif
+	/*
+	 * Reading the /proc files is expensive, sample the memory
+	 * usage only once per PROBE_MEMCHECK_INTERVAL checks. The
+	 * samples taken for other objects are never reused, the
+	 * first check of every object takes a new one.
+	 */
+	if (count % PROBE_MEMCHECK_INTERVAL == 0)
+		state->result = memcheck_sample();
+
+	result = state->result;
+
+	if (result > 0)
+		errno = ENOMEM;
+
+	return (result);
+}
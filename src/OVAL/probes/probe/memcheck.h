@@ -0,0 +1,74 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef PROBE_MEMCHECK_H
+#define PROBE_MEMCHECK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Memory constraints are not checked until a collected object
+ * contains more than this number of items
+ */
+#ifndef PROBE_MEMCHECK_THRESHOLD
+#define PROBE_MEMCHECK_THRESHOLD 32768 /* item count */
+#endif
+
+/*
+ * The memory usage is sampled on the first check of a collected object
+ * and then once per this number of checks. The result of the last sample
+ * of the object is used for the checks in between.
+ */
+#ifndef PROBE_MEMCHECK_INTERVAL
+#define PROBE_MEMCHECK_INTERVAL 1024 /* check count */
+#endif
+
+#define PROBE_MEMCHECK_MINFREEMEM 512  /* MiB */
+#define PROBE_MEMCHECK_MAXRATIO   0.8  /* max. memory usage ratio - used/total */
+
+/*
+ * Environment variables which override the default memory budget
+ */
+#define PROBE_MEMCHECK_ENV_RATIO   "OSCAP_PROBE_MEMORY_USAGE_RATIO"   /* used/total, (0, 1] */
+#define PROBE_MEMCHECK_ENV_MINFREE "OSCAP_PROBE_MINIMUM_FREE_MEMORY"  /* MiB */
+#define PROBE_MEMCHECK_ENV_LIMIT   "OSCAP_PROBE_MEMORY_LIMIT"         /* MiB, 0 means no limit */
+
+/*
+ * Memory usage samples of one collected object, zeroed before the
+ * probe starts to collect its items.
+ */
+struct probe_memcheck {
+	uint32_t count;  /* number of checks */
+	int      result; /* result of the last sample */
+};
+
+/**
+ * Load the memory budget of the probe from the environment.
+ */
+void probe_memcheck_init(void);
+
+/**
+ * Returns 0 if the memory constraints are not reached. Otherwise, 1 is returned.
+ * In case of an error, -1 is returned.
+ * @param state samples of the collected object
+ * @param item_cnt number of items in the collected object
+ */
+int probe_memcheck(struct probe_memcheck *state, size_t item_cnt);
+
+#endif /* PROBE_MEMCHECK_H */
@@ -32,6 +32,7 @@
 #include "ncache.h"
 #include "rcache.h"
 #include "icache.h"
+#include "memcheck.h"
 #include "probe-common.h"
 #include "option.h"
 #include "common/util.h"
@@ -69,6 +70,7 @@ struct probe_ctx {
         SEXP_t         *probe_out; /**< collected object */
         SEXP_t         *filters;   /**< object filters (OVAL 5.8 and higher) */
         probe_icache_t *icache;    /**< item cache */
+        struct probe_memcheck memcheck; /**< memory usage samples of the collected object */
 };
 
 typedef enum {
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sexp.h>
+
+#include "probe-api.h"
+#include "common/debug_priv.h"
+
+#include "setop.h"
+
+/*
+ * Items are deduplicated by the item cache, so two items are the same
+ * item (have the same item ID) exactly when they share the value. The
+ * set operations hash the value pointers and don't need sorted input.
+ */
+struct probe_itemset_slot {
+	uintptr_t valp;
+	bool      used; /* already put into the result */
+};
+
+struct probe_itemset {
+	struct probe_itemset_slot *slot;
+	size_t mask;
+};
+
+static void probe_itemset_init(struct probe_itemset *set, size_t count)
+{
+	size_t size = 16;
+
+	while (size < 2 * count)
+		size <<= 1;
+
+	set->slot = calloc(size, sizeof(struct probe_itemset_slot));
+	set->mask = size - 1;
+}
+
+/**
+ * Find the slot of an item in the set.
+ * @param insert add the item if it isn't in the set yet
+ * @param found set to true if the item was already in the set
+ * @return the slot or NULL if the item isn't in the set and insert is false
+ */
+static struct probe_itemset_slot *probe_itemset_get(struct probe_itemset *set, const SEXP_t *item,
+                                                    bool insert, bool *found)
+{
+	uintptr_t valp = item->s_valp;
+	size_t i = (size_t)((valp >> 4) * UINT64_C(0x9e3779b97f4a7c15) >> 32) & set->mask;
+
+	while (set->slot[i].valp != 0) {
+		if (set->slot[i].valp == valp) {
+			*found = true;
+			return &set->slot[i];
+		}
+		i = (i + 1) & set->mask;
+	}
+
+	*found = false;
+
+	if (!insert)
+		return NULL;
+
+	set->slot[i].valp = valp;
+	return &set->slot[i];
+}
+
+SEXP_t *probe_set_combine(SEXP_t *cobj0, SEXP_t *cobj1, oval_setobject_operation_t op)
+{
+	SEXP_t *set0, *set1, *res_cobj, *cobj0_mask, *cobj1_mask, *res_mask;
+	SEXP_t *item, *res, **memb;
+	SEXP_list_it *sit;
+	struct probe_itemset iset;
+	struct probe_itemset_slot *slot;
+	size_t len0, len1, count;
+	bool found;
+	oval_syschar_collection_flag_t res_flag;
+
+	if (cobj0 == NULL)
+		return SEXP_ref(cobj1);
+	if (cobj1 == NULL)
+		return SEXP_ref(cobj0);
+
+	set0 = probe_cobj_get_items(cobj0);
+	set1 = probe_cobj_get_items(cobj1);
+	cobj0_mask = probe_cobj_get_mask(cobj0);
+	cobj1_mask = probe_cobj_get_mask(cobj1);
+
+	res_flag = probe_cobj_combine_flags(probe_cobj_get_flag(cobj0),
+	                                    probe_cobj_get_flag(cobj1), op);
+	res_mask = SEXP_list_join(cobj0_mask, cobj1_mask);
+
+	len0 = SEXP_list_length(set0);
+	len1 = SEXP_list_length(set1);
+
+	switch (op) {
+	case OVAL_SET_OPERATION_UNION:
+	case OVAL_SET_OPERATION_INTERSECTION:
+	case OVAL_SET_OPERATION_COMPLEMENT:
+		break;
+	default:
+		dE("Unknown set operation: %d", op);
+		abort();
+	}
+
+	/* empty or identical operands don't need to be looked at */
+	if (len0 == 0 || len1 == 0 || SEXP_refcmp(set0, set1) == 0) {
+		if (op == OVAL_SET_OPERATION_UNION)
+			res = SEXP_ref(len0 == 0 ? set1 : set0);
+		else if (op == OVAL_SET_OPERATION_INTERSECTION && len0 != 0 && len1 != 0)
+			res = SEXP_ref(set0);
+		else if (op == OVAL_SET_OPERATION_COMPLEMENT && len0 != 0 && len1 == 0)
+			res = SEXP_ref(set0);
+		else
+			res = SEXP_list_new(NULL);
+
+		goto result;
+	}
+
+	/*
+	 * The result members are borrowed from the operands and the result
+	 * list is built at once when their number is known.
+	 */
+	memb  = malloc((op == OVAL_SET_OPERATION_UNION ? len0 + len1 : len0) * sizeof(SEXP_t *));
+	count = 0;
+
+	switch (op) {
+	case OVAL_SET_OPERATION_UNION:
+		probe_itemset_init(&iset, len0 + len1);
+
+		sit = SEXP_list_it_new(set0);
+		while ((item = SEXP_list_it_next(sit)) != NULL) {
+			probe_itemset_get(&iset, item, true, &found);
+			if (!found)
+				memb[count++] = item;
+		}
+		SEXP_list_it_free(sit);
+
+		sit = SEXP_list_it_new(set1);
+		while ((item = SEXP_list_it_next(sit)) != NULL) {
+			probe_itemset_get(&iset, item, true, &found);
+			if (!found)
+				memb[count++] = item;
+		}
+		SEXP_list_it_free(sit);
+
+		break;
+	case OVAL_SET_OPERATION_INTERSECTION:
+		probe_itemset_init(&iset, len1);
+
+		sit = SEXP_list_it_new(set1);
+		while ((item = SEXP_list_it_next(sit)) != NULL)
+			probe_itemset_get(&iset, item, true, &found);
+		SEXP_list_it_free(sit);
+
+		sit = SEXP_list_it_new(set0);
+		while ((item = SEXP_list_it_next(sit)) != NULL) {
+			slot = probe_itemset_get(&iset, item, false, &found);
+			if (found && !slot->used) {
+				slot->used = true;
+				memb[count++] = item;
+			}
+		}
+		SEXP_list_it_free(sit);
+
+		break;
+	default: /* OVAL_SET_OPERATION_COMPLEMENT */
+		/* items of set0 are added as well to skip their duplicates */
+		probe_itemset_init(&iset, len0 + len1);
+
+		sit = SEXP_list_it_new(set1);
+		while ((item = SEXP_list_it_next(sit)) != NULL)
+			probe_itemset_get(&iset, item, true, &found);
+		SEXP_list_it_free(sit);
+
+		sit = SEXP_list_it_new(set0);
+		while ((item = SEXP_list_it_next(sit)) != NULL) {
+			probe_itemset_get(&iset, item, true, &found);
+			if (!found)
+				memb[count++] = item;
+		}
+		SEXP_list_it_free(sit);
+	}
+
+	res = SEXP_list_new_array(memb, count);
+
+	free(iset.slot);
+	free(memb);
+result:
+	/*
+	 * If the collected information is complete but all the items are
+	 * removed, the flag is set to SYSCHAR_FLAG_DOES_NOT_EXIST
+	 */
+	if (res_flag == SYSCHAR_FLAG_COMPLETE && SEXP_list_length(res) == 0)
+		res_flag = SYSCHAR_FLAG_DOES_NOT_EXIST;
+
+	res_cobj = probe_cobj_new(res_flag, NULL, res, res_mask);
+
+	SEXP_vfree(set0, set1, res, res_mask);
+	SEXP_vfree(cobj0_mask, cobj1_mask);
+
+	// todo: variables
+
+	return (res_cobj);
+}
@@ -25,6 +25,7 @@
 #endif
 
 #include <seap.h>
+#include <sm_alloc.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
@@ -36,6 +37,7 @@
 #include "entcmp.h"
 
 #include "worker.h"
+#include "setop.h"
 
 extern bool  OSCAP_GSYM(varref_handling);
 extern void *OSCAP_GSYM(probe_arg);
@@ -72,18 +74,10 @@ void *probe_worker_runfn(void *arg)
 
                 return (NULL);
 	} else {
-                SEXP_t *items;
-
 		dD("probe thread deleted");
 
 		obj = SEAP_msg_get(pair->pth->msg);
 		oid = probe_obj_getattrval(obj, "id");
-                items = probe_cobj_get_items(probe_res);
-
-                if (items != NULL) {
-                        SEXP_list_sort(items, SEXP_refcmp);
-                        SEXP_free(items);
-                }
 
 		if (probe_rcache_sexp_add(pair->probe->rcache, oid, probe_res) != 0) {
 			/* TODO */
@@ -132,6 +126,11 @@ void *probe_worker_runfn(void *arg)
         SEAP_msg_free(pair->pth->msg);
         free(pair->pth);
 	free(pair);
+	/*
+	 * The reply is out, hand the S-exp memory cached by this
+	 * thread back to the shared slabs.
+	 */
+	sm_slab_flush();
 	pthread_detach(pthread_self());
 
 	return (NULL);
@@ -417,136 +416,6 @@ static SEXP_t *probe_prepare_filters(probe_t *probe, SEXP_t *obj)
 	return filters;
 }
 
-/**
- * Combine two collections of items using an operation.
- * @param cobj1 item collection
- * @param cobj2 item collection
- * @param op operation
- * @return the result of the operation
- */
-static SEXP_t *probe_set_combine(SEXP_t *cobj0, SEXP_t *cobj1, oval_setobject_operation_t op)
-{
-        SEXP_t *set0, *set1, *res_cobj, *cobj0_mask, *cobj1_mask, *res_mask;
-        register int cmp;
-        register SEXP_t *item0, *item1, *res;
-        register SEXP_list_it *sit0, *sit1;
-	oval_syschar_collection_flag_t res_flag;
-
-	if (cobj0 == NULL)
-		return SEXP_ref(cobj1);
-	if (cobj1 == NULL)
-		return SEXP_ref(cobj0);
-
-        set0 = probe_cobj_get_items(cobj0);
-        set1 = probe_cobj_get_items(cobj1);
-        cobj0_mask = probe_cobj_get_mask(cobj0);
-        cobj1_mask = probe_cobj_get_mask(cobj1);
-
-        /* prepare storage for results */
-        res = SEXP_list_new(NULL);
-        res_flag = probe_cobj_combine_flags(probe_cobj_get_flag(cobj0),
-                                            probe_cobj_get_flag(cobj1), op);
-        res_mask = SEXP_list_join(cobj0_mask, cobj1_mask);
-
-        /* prepare iterators & first items */
-        sit0  = SEXP_list_it_new(set0);
-        sit1  = SEXP_list_it_new(set1);
-        item0 = SEXP_list_it_next(sit0);
-        item1 = SEXP_list_it_next(sit1);
-
-        /* perform the set operation */
-        switch(op) {
-        case OVAL_SET_OPERATION_UNION:
-                while (item0 != NULL && item1 != NULL) {
-                        cmp = SEXP_refcmp(item0, item1);
-
-                        if (cmp < 0) {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                        } else if (cmp > 0) {
-                                SEXP_list_add(res, item1);
-                                item1 = SEXP_list_it_next(sit1);
-                        } else {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                                item1 = SEXP_list_it_next(sit1);
-                        }
-                }
-
-                if (item0 != NULL) {
-                        do {
-                                SEXP_list_add(res, item0);
-                        } while((item0 = SEXP_list_it_next(sit0)) != NULL);
-                } else if (item1 != NULL) {
-                        do {
-                                SEXP_list_add(res, item1);
-                        } while((item1 = SEXP_list_it_next(sit1)) != NULL);
-                }
-
-                break;
-        case OVAL_SET_OPERATION_INTERSECTION:
-                while (item0 != NULL && item1 != NULL) {
-                        cmp = SEXP_refcmp(item0, item1);
-
-                        if (cmp < 0)
-                                item0 = SEXP_list_it_next(sit0);
-                        else if (cmp > 0)
-                                item1 = SEXP_list_it_next(sit1);
-                        else {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                                item1 = SEXP_list_it_next(sit1);
-                        }
-                }
-
-                break;
-        case OVAL_SET_OPERATION_COMPLEMENT:
-                while (item0 != NULL && item1 != NULL) {
-                        cmp = SEXP_refcmp(item0, item1);
-
-                        if (cmp < 0) {
-                                SEXP_list_add(res, item0);
-                                item0 = SEXP_list_it_next(sit0);
-                        } else if (cmp > 0) {
-                                item1 = SEXP_list_it_next(sit1);
-                        } else {
-                                item0 = SEXP_list_it_next(sit0);
-                                item1 = SEXP_list_it_next(sit1);
-                        }
-                }
-
-                if (item0 != NULL) {
-                        do {
-                                SEXP_list_add(res, item0);
-                        } while((item0 = SEXP_list_it_next(sit0)) != NULL);
-                }
-
-                break;
-        default:
-                dE("Unknown set operation: %d", op);
-                abort();
-        }
-
-        SEXP_list_it_free(sit0);
-        SEXP_list_it_free(sit1);
-
-	/*
-	 * If the collected information is complete but all the items are
-	 * removed, the flag is set to SYSCHAR_FLAG_DOES_NOT_EXIST
-	 */
-	if (res_flag == SYSCHAR_FLAG_COMPLETE && SEXP_list_length(res) == 0)
-		res_flag = SYSCHAR_FLAG_DOES_NOT_EXIST;
-
-	res_cobj = probe_cobj_new(res_flag, NULL, res, res_mask);
-
-        SEXP_vfree(set0, set1, res, res_mask);
-        SEXP_vfree(cobj0_mask, cobj1_mask);
-
-	// todo: variables
-
-	return (res_cobj);
-}
-
 /**
  * Apply a set of filters to a collected object.
  * @param cobj item collection
@@ -941,6 +810,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			
                         pctx.probe_in  = probe_in;
                         pctx.probe_out = probe_out;
+                        memset(&pctx.memcheck, 0, sizeof(pctx.memcheck));
 
                         /*
                          * Run the main function of the probe implementation. Set thread
@@ -952,11 +822,6 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			*ret = probe_main(&pctx, probe->probe_arg);
 			pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &__unused_oldstate);
 
-                        /*
-                         * Synchronize
-                         */
-                        probe_icache_nop(probe->icache);
-
 			probe_cobj_compute_flag(probe_out);
 		} else {
 			/*
@@ -984,16 +849,12 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 
                                 pctx.probe_in  = ctx->pi2;
                                 pctx.probe_out = cobj;
+                                memset(&pctx.memcheck, 0, sizeof(pctx.memcheck));
                                 /*
                                  * Run the main function of the probe implementation
                                  */
 				*ret = probe_main(&pctx, probe->probe_arg);
 
-                                /*
-                                 * Synchronize
-                                 */
-                                probe_icache_nop(probe->icache);
-
 				probe_cobj_compute_flag(cobj);
 				r0 = probe_out;
 				probe_out = probe_set_combine(r0, cobj, OVAL_SET_OPERATION_UNION);
@@ -474,6 +474,14 @@ void probe_preload(void);
 void *probe_init(void) __attribute__ ((unused));
 void probe_fini(void *) __attribute__ ((unused));
 
+/**
+ * Get the number of the scan the probe is working on. The number changes
+ * when the library resets the probe between two scans, so that data a probe
+ * keeps in its probe_init() argument can be dropped when they belong to
+ * a previous scan.
+ */
+uint32_t probe_scan_id(void);
+
 typedef struct probe_ctx probe_ctx;
 
 int probe_main(probe_ctx *, void *) __attribute__ ((nonnull(1)));
@@ -491,6 +499,17 @@ int probe_result_additem(SEXP_t *result, SEXP_t *item);
  */
 int probe_item_collect(probe_ctx *ctx, SEXP_t *item);
 
+/**
+ * Collect several generated items at once. This is equivalent to calling
+ * probe_item_collect() on each of the items in the given order, but the
+ * memory constraints are checked and the item cache is locked only once
+ * per batch. The function takes ownership of all the item references;
+ * the content of the items array is undefined after the call.
+ * Returns 0 if the items were collected or filtered out, 2 if they were
+ * dropped because of memory constraints and -1 on an internal error.
+ */
+int probe_item_collect_batch(probe_ctx *ctx, SEXP_t **items, size_t count);
+
 /**
  * Return reference to the input object. The reference counter
  * is NOT incremented by this operation (i.e. don't call SEXP_free
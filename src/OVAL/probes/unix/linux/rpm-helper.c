@@ -24,6 +24,14 @@
 #include <config.h>
 #endif
 
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <regex.h>
+#include <pcre.h>
+#include "common/oscap_pcre_cache.h"
+#include "probe/entcmp.h"
+
 #ifdef HAVE_RPM46
 int rpmErrorCb (rpmlogRec rec, rpmlogCallbackData data)
 {
@@ -39,3 +47,341 @@ void rpmLibsPreload()
 	const char* rcfiles = "";
 	rpmReadConfigFiles(rcfiles, NULL);
 }
+
+static const char keyid_regex_string[] = "Key ID [a-fA-F0-9]{16}";
+
+static char *rpm_package_keyid(Header h, regex_t *keyid_regex)
+{
+	errmsg_t rpmerr;
+	char *str, *sid = NULL;
+	regmatch_t keyid_match[1];
+
+	str = headerFormat(h, "%|SIGGPG?{%{SIGGPG:pgpsig}}:{%{SIGPGP:pgpsig}}|", &rpmerr);
+
+	if (str == NULL || regexec(keyid_regex, str, 1, keyid_match, 0) != 0) {
+		dD("Failed to extract the Key ID value: regex=\"%s\", string=\"%s\"",
+		   keyid_regex_string, str);
+	} else if (keyid_match[0].rm_so >= 0 && keyid_match[0].rm_eo >= 0) {
+		size_t keyid_start, keyid_length;
+
+		keyid_start = keyid_match[0].rm_so + strlen("Key ID ");
+		keyid_length = keyid_match[0].rm_eo - keyid_start;
+		sid = str + keyid_start;
+		sid[keyid_length] = '\0';
+	}
+
+	sid = strdup(sid != NULL ? sid : "0");
+	free(str);
+	return sid;
+}
+
+static void rpm_package_read(Header h, regex_t *keyid_regex, struct rpm_package *pkg)
+{
+	errmsg_t rpmerr;
+	const char *epoch;
+
+	pkg->name = headerFormat(h, "%{NAME}", &rpmerr);
+	pkg->epoch = headerFormat(h, "%{EPOCH}", &rpmerr);
+	pkg->version = headerFormat(h, "%{VERSION}", &rpmerr);
+	pkg->release = headerFormat(h, "%{RELEASE}", &rpmerr);
+	pkg->arch = headerFormat(h, "%{ARCH}", &rpmerr);
+
+	epoch = oscap_streq(pkg->epoch, "(none)") ? "0" : pkg->epoch;
+	pkg->evr = oscap_sprintf("%s:%s-%s", epoch, pkg->version, pkg->release);
+	pkg->extended_name = oscap_sprintf("%s-%s:%s-%s.%s", pkg->name, epoch,
+					   pkg->version, pkg->release, pkg->arch);
+	pkg->signature_keyid = rpm_package_keyid(h, keyid_regex);
+	pkg->files_loaded = false;
+	pkg->files = NULL;
+	pkg->files_count = 0;
+}
+
+static void rpm_package_free(struct rpm_package *pkg)
+{
+	size_t i;
+
+	free(pkg->name);
+	free(pkg->epoch);
+	free(pkg->version);
+	free(pkg->release);
+	free(pkg->arch);
+	free(pkg->evr);
+	free(pkg->signature_keyid);
+	free(pkg->extended_name);
+	for (i = 0; i < pkg->files_count; ++i)
+		free(pkg->files[i]);
+	free(pkg->files);
+}
+
+static int rpm_package_cmp(const void *a, const void *b)
+{
+	const struct rpm_package *pa = a, *pb = b;
+	int ret;
+
+	ret = strcmp(pa->name, pb->name);
+	if (ret == 0)
+		ret = (pa->instance > pb->instance) - (pa->instance < pb->instance);
+	return ret;
+}
+
+static struct rpm_snapshot *rpm_snapshot_build(rpmts ts)
+{
+	struct rpm_snapshot *snapshot;
+	rpmdbMatchIterator match;
+	regex_t keyid_regex;
+	Header pkgh;
+	size_t i, alloc = 0;
+	struct timespec start, end;
+
+	if (regcomp(&keyid_regex, keyid_regex_string, REG_EXTENDED) != 0) {
+		dE("regcomp(%s) failed.", keyid_regex_string);
+		return NULL;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	snapshot = calloc(1, sizeof(struct rpm_snapshot));
+	snapshot->scan = probe_scan_id();
+	snapshot->refs = 1;
+
+	match = rpmtsInitIterator(ts, RPMDBI_PACKAGES, NULL, 0);
+	if (match != NULL) {
+		while ((pkgh = rpmdbNextIterator(match)) != NULL) {
+			struct rpm_package *pkg;
+
+			if (snapshot->count == alloc) {
+				alloc = alloc == 0 ? 512 : alloc * 2;
+				snapshot->packages = realloc(snapshot->packages, alloc * sizeof(struct rpm_package));
+			}
+
+			pkg = &snapshot->packages[snapshot->count++];
+			rpm_package_read(pkgh, &keyid_regex, pkg);
+			pkg->instance = rpmdbGetIteratorOffset(match);
+		}
+		match = rpmdbFreeIterator(match);
+	}
+	regfree(&keyid_regex);
+
+	/* packages of the same name are next to each other */
+	qsort(snapshot->packages, snapshot->count, sizeof(struct rpm_package), rpm_package_cmp);
+
+	snapshot->names = oscap_htable_new1(strcmp, snapshot->count > 256 ? snapshot->count : 256);
+	for (i = 0; i < snapshot->count; ++i) {
+		if (i == 0 || strcmp(snapshot->packages[i - 1].name, snapshot->packages[i].name) != 0)
+			oscap_htable_add(snapshot->names, snapshot->packages[i].name, &snapshot->packages[i]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	dI("Read %zu packages from the rpm database in %.3f ms.", snapshot->count,
+	   (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+
+	return snapshot;
+}
+
+static void rpm_snapshot_free(struct rpm_snapshot *snapshot)
+{
+	size_t i;
+
+	oscap_htable_free0(snapshot->names);
+	for (i = 0; i < snapshot->count; ++i)
+		rpm_package_free(&snapshot->packages[i]);
+	free(snapshot->packages);
+	free(snapshot);
+}
+
+struct rpm_snapshot *rpm_snapshot_get(struct rpm_probe_global *g)
+{
+	if (g->snapshot != NULL && g->snapshot->scan != probe_scan_id())
+		rpm_snapshot_drop(g);
+
+	if (g->snapshot == NULL) {
+		/*
+		 * A database opened by an earlier scan doesn't have to show
+		 * the packages installed or removed since, the iterator of
+		 * the new snapshot opens it again.
+		 */
+		rpmtsCloseDB(g->rpmts);
+		g->snapshot = rpm_snapshot_build(g->rpmts);
+	}
+
+	if (g->snapshot != NULL)
+		g->snapshot->refs++;
+
+	return g->snapshot;
+}
+
+void rpm_snapshot_put(struct rpm_snapshot *snapshot)
+{
+	if (snapshot != NULL && --snapshot->refs == 0)
+		rpm_snapshot_free(snapshot);
+}
+
+void rpm_snapshot_drop(struct rpm_probe_global *g)
+{
+	rpm_snapshot_put(g->snapshot);
+	g->snapshot = NULL;
+}
+
+int rpm_snapshot_select(struct rpm_snapshot *snapshot, const char *name, oval_operation_t op,
+			struct rpm_package ***packages)
+{
+	struct rpm_package *pkg, **selected;
+	struct oscap_pcre *re;
+	const char *errmsg;
+	size_t i;
+	int erroff, count = 0;
+	bool matched = false;
+
+	switch (op) {
+	case OVAL_OPERATION_EQUALS:
+		pkg = oscap_htable_get(snapshot->names, name);
+		if (pkg == NULL) {
+			*packages = NULL;
+			return 0;
+		}
+
+		for (i = pkg - snapshot->packages; i < snapshot->count; ++i) {
+			if (strcmp(snapshot->packages[i].name, name) != 0)
+				break;
+		}
+		count = i - (pkg - snapshot->packages);
+
+		selected = malloc(count * sizeof(struct rpm_package *));
+		for (i = 0; i < (size_t)count; ++i)
+			selected[i] = pkg + i;
+		break;
+	case OVAL_OPERATION_NOT_EQUAL:
+		selected = malloc((snapshot->count + 1) * sizeof(struct rpm_package *));
+		for (i = 0; i < snapshot->count; ++i) {
+			if (strcmp(snapshot->packages[i].name, name) != 0)
+				selected[count++] = &snapshot->packages[i];
+		}
+		break;
+	case OVAL_OPERATION_PATTERN_MATCH:
+		re = oscap_pcre_cache_get(name, PCRE_UTF8, &errmsg, &erroff);
+		if (re == NULL) {
+			dE("Failed to compile the pattern \"%s\": %s at offset %d.", name, errmsg, erroff);
+			return -1;
+		}
+
+		selected = malloc((snapshot->count + 1) * sizeof(struct rpm_package *));
+		for (i = 0; i < snapshot->count; ++i) {
+			pkg = &snapshot->packages[i];
+
+			/* the packages are sorted by name, test each name once */
+			if (i == 0 || strcmp(pkg[-1].name, pkg->name) != 0)
+				matched = oscap_pcre_exec(re, pkg->name, strlen(pkg->name), 0, 0, NULL, 0) >= 0;
+			if (matched)
+				selected[count++] = pkg;
+		}
+		oscap_pcre_cache_put(re);
+		break;
+	default:
+		dE("package name: operation not supported");
+		return -1;
+	}
+
+	*packages = selected;
+	return count;
+}
+
+int rpm_snapshot_select_ent(struct rpm_snapshot *snapshot, SEXP_t *name_ent,
+			    struct rpm_package ***packages)
+{
+	struct rpm_package **selected;
+	oval_operation_t op;
+	char name[1024];
+	size_t i;
+
+	if (name_ent != NULL && !probe_ent_attrexists(name_ent, "var_ref")) {
+		op = probe_ent_getoperation(name_ent, OVAL_OPERATION_EQUALS);
+		if (op == OVAL_OPERATION_EQUALS || op == OVAL_OPERATION_PATTERN_MATCH) {
+			bool has_value = true;
+
+			/* an empty pattern selects every package, rpm_package_match() decides without a value */
+			PROBE_ENT_STRVAL(name_ent, name, sizeof name, has_value = false;, name[0] = '\0';);
+			if (has_value)
+				return rpm_snapshot_select(snapshot, name, op, packages);
+		}
+	}
+
+	selected = malloc((snapshot->count + 1) * sizeof(struct rpm_package *));
+	for (i = 0; i < snapshot->count; ++i)
+		selected[i] = &snapshot->packages[i];
+
+	*packages = selected;
+	return snapshot->count;
+}
+
+static bool rpm_ent_match(SEXP_t *ent, const char *value)
+{
+	SEXP_t *val;
+	bool ret;
+
+	if (ent == NULL)
+		return true;
+
+	val = probe_entval_from_cstr(probe_ent_getdatatype(ent), value, strlen(value));
+	if (val == NULL)
+		return true;
+
+	ret = probe_entobj_cmp(ent, val) == OVAL_RESULT_TRUE;
+	SEXP_free(val);
+	return ret;
+}
+
+bool rpm_package_match(const struct rpm_package *pkg, SEXP_t *name_ent, SEXP_t *epoch_ent,
+		       SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent)
+{
+	return rpm_ent_match(name_ent, pkg->name) &&
+	       rpm_ent_match(epoch_ent, pkg->epoch) &&
+	       rpm_ent_match(version_ent, pkg->version) &&
+	       rpm_ent_match(release_ent, pkg->release) &&
+	       rpm_ent_match(arch_ent, pkg->arch);
+}
+
+int rpm_snapshot_get_files(rpmts ts, struct rpm_package *pkg)
+{
+	rpmdbMatchIterator match;
+	Header pkgh;
+	rpmfi fi;
+	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
+	size_t alloc = 0;
+	int i;
+
+	if (pkg->files_loaded)
+		return 0;
+
+	match = rpm_package_iterator(ts, pkg);
+	if (match == NULL)
+		return -1;
+
+	pkgh = rpmdbNextIterator(match);
+	if (pkgh == NULL) {
+		rpmdbFreeIterator(match);
+		return -1;
+	}
+
+	for (i = 0; i < 2; ++i) {
+		fi = rpmfiNew(ts, pkgh, tag[i], 1);
+
+		while (rpmfiNext(fi) != -1) {
+			if (pkg->files_count == alloc) {
+				alloc = alloc == 0 ? 16 : alloc * 2;
+				pkg->files = realloc(pkg->files, alloc * sizeof(char *));
+			}
+			pkg->files[pkg->files_count++] = strdup(rpmfiFN(fi));
+		}
+		rpmfiFree(fi);
+	}
+
+	rpmdbFreeIterator(match);
+	pkg->files_loaded = true;
+	return 0;
+}
+
+rpmdbMatchIterator rpm_package_iterator(rpmts ts, const struct rpm_package *pkg)
+{
+	unsigned int instance = pkg->instance;
+
+	return rpmtsInitIterator(ts, RPMDBI_PACKAGES, &instance, sizeof(instance));
+}
@@ -33,13 +33,52 @@
 #include <rpm/header.h>
 
 #include <pthread.h>
+#include <stdbool.h>
+#include <probe-api.h>
 #include "common/util.h"
+#include "common/list.h"
 #include "common/debug_priv.h"
 #include "pthread.h"
 
+/**
+ * Installed package as read from the rpm database. The strings are
+ * formatted the way the probes report them, unset epoch is "(none)".
+ */
+struct rpm_package {
+	char *name;
+	char *epoch;
+	char *version;
+	char *release;
+	char *arch;
+	char *evr;             /**< epoch:version-release, epoch 0 if unset */
+	char *signature_keyid;
+	char *extended_name;   /**< name-epoch:version-release.arch */
+	unsigned int instance; /**< header instance in the rpm database */
+	bool files_loaded;
+	char **files;          /**< file paths, see rpm_snapshot_get_files() */
+	size_t files_count;
+};
+
+/**
+ * Read-only copy of the rpm database. It is built by the first object
+ * evaluated by the probe in a scan and all the following objects of the
+ * scan are answered from it, the database is opened again only to load
+ * the file lists and the headers of the packages to verify. A probe kept
+ * for the next scan builds a new snapshot, packages may have been
+ * installed or removed in between.
+ */
+struct rpm_snapshot {
+	uint32_t scan;                /**< probe_scan_id() of the scan */
+	int refs;
+	struct rpm_package *packages; /**< sorted by name */
+	size_t count;
+	struct oscap_htable *names;   /**< name -> first package of that name */
+};
+
 struct rpm_probe_global {
 	rpmts rpmts;
 	pthread_mutex_t mutex;
+	struct rpm_snapshot *snapshot; /**< snapshot of the current scan */
 };
 
 #ifndef HAVE_HEADERFORMAT
@@ -93,4 +132,65 @@ int rpmErrorCb (rpmlogRec rec, rpmlogCallbackData data);
  */
 void rpmLibsPreload(void);
 
+/*
+ * The rpm_snapshot functions have to be called with the mutex of
+ * the probe locked.
+ */
+
+/**
+ * Get the snapshot of the current scan, read all packages from the rpm
+ * database if there is none yet. The snapshot is released by
+ * rpm_snapshot_put().
+ * @return the snapshot or NULL on error
+ */
+struct rpm_snapshot *rpm_snapshot_get(struct rpm_probe_global *g);
+
+/**
+ * Release the snapshot, it is freed once it isn't used and belongs
+ * to a previous scan.
+ */
+void rpm_snapshot_put(struct rpm_snapshot *snapshot);
+
+/**
+ * Release the snapshot of the current scan, used by probe_fini().
+ */
+void rpm_snapshot_drop(struct rpm_probe_global *g);
+
+/**
+ * Select the packages by name.
+ * @param op equals, not equal or pattern match
+ * @param packages array of the selected packages, free it by free()
+ * @return the number of packages in the array, -1 on error
+ */
+int rpm_snapshot_select(struct rpm_snapshot *snapshot, const char *name, oval_operation_t op,
+			struct rpm_package ***packages);
+
+/**
+ * Select the packages whose names can match the name entity of an object,
+ * all packages if the entity is NULL or if it refers to a variable. The
+ * packages still have to be checked by rpm_package_match().
+ * @return the number of packages in the array, -1 on error
+ */
+int rpm_snapshot_select_ent(struct rpm_snapshot *snapshot, SEXP_t *name_ent,
+			    struct rpm_package ***packages);
+
+/**
+ * Compare the package with the entities of an object, NULL entities
+ * match everything.
+ */
+bool rpm_package_match(const struct rpm_package *pkg, SEXP_t *name_ent, SEXP_t *epoch_ent,
+		       SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent);
+
+/**
+ * Load the paths of files and directories of the package, once.
+ * @return 0 on success, -1 on error
+ */
+int rpm_snapshot_get_files(rpmts ts, struct rpm_package *pkg);
+
+/**
+ * Get an iterator over the header of the package in the database.
+ * Free it by rpmdbFreeIterator().
+ */
+rpmdbMatchIterator rpm_package_iterator(rpmts ts, const struct rpm_package *pkg);
+
 #endif
@@ -81,11 +81,12 @@ static int rpmverify_collect(probe_ctx *ctx,
                              uint64_t flags,
                              void (*callback)(probe_ctx *, struct rpmverify_res *))
 {
-	rpmdbMatchIterator match;
+        struct rpm_snapshot *snapshot = NULL;
+        struct rpm_package **packages = NULL;
         rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
 	Header pkgh;
         pcre *re = NULL;
-	int  ret = -1;
+	int  ret = -1, count, p;
 
         /* pre-compile regex if needed */
         if (file_op == OVAL_OPERATION_PATTERN_MATCH) {
@@ -102,52 +103,14 @@ static int rpmverify_collect(probe_ctx *ctx,
 
         RPMVERIFY_LOCK;
 
-        switch (name_op) {
-        case OVAL_OPERATION_EQUALS:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMTAG_NAME, (const void *)name, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                ret = rpmdbGetIteratorCount (match);
-
-                break;
-	case OVAL_OPERATION_NOT_EQUAL:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
-        case OVAL_OPERATION_PATTERN_MATCH:
-                match = rpmtsInitIterator (g_rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
+        snapshot = rpm_snapshot_get(&g_rpm);
+        if (snapshot == NULL) {
+                ret = -1;
+                goto ret;
+        }
 
-                break;
-        default:
-                /* not supported */
-                dE("package name: operation not supported");
+        count = rpm_snapshot_select(snapshot, name, name_op, &packages);
+        if (count < 0) {
                 ret = -1;
                 goto ret;
         }
@@ -155,15 +118,15 @@ static int rpmverify_collect(probe_ctx *ctx,
 	assume_d(RPMTAG_BASENAMES != 0, -1);
 	assume_d(RPMTAG_DIRNAMES  != 0, -1);
 
-        while ((pkgh = rpmdbNextIterator (match)) != NULL) {
+        for (p = 0; p < count; ++p) {
+                rpmdbMatchIterator match;
                 rpmfi  fi;
 		rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
                 struct rpmverify_res res;
-                errmsg_t rpmerr;
 		int i;
 		SEXP_t *name_sexp;
 
-                res.name = headerFormat(pkgh, "%{NAME}", &rpmerr);
+                res.name = packages[p]->name;
 
 		name_sexp = SEXP_string_newf("%s", res.name);
 		if (probe_entobj_cmp(name_ent, name_sexp) != OVAL_RESULT_TRUE) {
@@ -172,6 +135,16 @@ static int rpmverify_collect(probe_ctx *ctx,
 		}
 		SEXP_free(name_sexp);
 
+		match = rpm_package_iterator(g_rpm.rpmts, packages[p]);
+		if (match == NULL)
+			continue;
+
+		pkgh = rpmdbNextIterator(match);
+		if (pkgh == NULL) {
+			rpmdbFreeIterator(match);
+			continue;
+		}
+
                 /*
                  * Inspect package files & directories
                  */
@@ -207,11 +180,14 @@ static int rpmverify_collect(probe_ctx *ctx,
 
 		  rpmfiFree(fi);
 		}
+
+		rpmdbFreeIterator(match);
 	}
 
-	match = rpmdbFreeIterator (match);
         ret   = 0;
 ret:
+        free(packages);
+        rpm_snapshot_put(snapshot);
         if (re != NULL)
                 pcre_free(re);
 
@@ -264,6 +240,7 @@ void probe_fini (void *ptr)
 	if (r == NULL)
 		return;
 
+	rpm_snapshot_drop(r);
 	rpmtsFree(r->rpmts);
 	pthread_mutex_destroy (&(r->mutex));
 
@@ -0,0 +1,652 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#if defined(__linux__)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "seap.h"
+#include "probe-api.h"
+#include "probe/probe.h"
+#include "common/debug_priv.h"
+#include "proc-snapshot.h"
+
+/*
+ * Buffer the /proc files are read into, reused for all the files
+ */
+struct proc_buf {
+        char   *data;
+        size_t  size;
+};
+
+/*
+ * Read the whole file to the buffer and terminate it by a null byte.
+ * @return length of the file, -1 if it can't be read
+ */
+static ssize_t proc_read(int dir_fd, const char *path, struct proc_buf *buf)
+{
+        ssize_t len = 0, ret;
+        int fd;
+
+        fd = openat(dir_fd, path, O_RDONLY);
+        if (fd < 0)
+                return (-1);
+
+        for (;;) {
+                if ((size_t)len + 1 >= buf->size) {
+                        buf->size *= 2;
+                        buf->data = realloc(buf->data, buf->size);
+                }
+
+                ret = read(fd, buf->data + len, buf->size - len - 1);
+                if (ret < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        close(fd);
+                        return (-1);
+                }
+                if (ret == 0)
+                        break;
+                len += ret;
+        }
+
+        close(fd);
+        buf->data[len] = '\0';
+
+        return (len);
+}
+
+static unsigned long proc_boot_time(int dir_fd, struct proc_buf *buf)
+{
+        unsigned long boot = 0;
+        char *line;
+
+        if (proc_read(dir_fd, "stat", buf) < 0)
+                return (0);
+
+        line = strstr(buf->data, "\nbtime ");
+        if (line != NULL)
+                sscanf(line + 1, "btime %lu", &boot);
+
+        return (boot);
+}
+
+/*
+ * Parse /proc/PID/stat
+ * @return false if the file doesn't look like a stat file
+ */
+static bool proc_parse_stat(char *buf, ssize_t len, struct proc_entry *proc)
+{
+        char *tmp;
+        int pid, pgrp, tpgid;
+        unsigned flags;
+        unsigned long minflt, cminflt, majflt, cmajflt;
+        long cutime, cstime, cnice, nthreads, itrealvalue;
+
+        if (len < 40)
+                return (false);
+
+        tmp = strrchr(buf, ')');
+        if (tmp == NULL)
+                return (false);
+        *tmp = '\0';
+
+        sscanf(buf, "%d (%15c", &pid, proc->comm);
+        sscanf(tmp + 2, "%c %d %d %d %d %d "
+                        "%u %lu %lu %lu %lu "
+                        "%lu %lu %lu %ld %ld "
+                        "%ld %ld %ld %llu",
+               &proc->state, &proc->ppid, &pgrp, &proc->session, &proc->tty_nr, &tpgid,
+               &flags, &minflt, &cminflt, &majflt, &cmajflt,
+               &proc->utime, &proc->stime, &cutime, &cstime, &proc->priority,
+               &cnice, &nthreads, &itrealvalue, &proc->start);
+
+        return (true);
+}
+
+static void proc_parse_uids(const char *buf, struct proc_entry *proc)
+{
+        const char *line;
+
+        line = strstr(buf, "\nUid:");
+        if (line != NULL)
+                sscanf(line + 1, "Uid: %d %d", &proc->ruid, &proc->euid);
+}
+
+/*
+ * Make a ps-like command line from /proc/PID/cmdline: the arguments are
+ * separated by spaces and non-printable characters are replaced by dots.
+ * @return the command line or NULL if the file is empty
+ */
+static char *proc_parse_cmdline(char *buf, ssize_t len)
+{
+        ssize_t i;
+
+        if (len <= 0)
+                return (NULL);
+
+        /* Skip multiple trailing zeros */
+        i = len - 1;
+        while (i > 0 && buf[i] == '\0')
+                --i;
+        buf[i + 1] = '\0';
+
+        for (; i >= 0; --i) {
+                if (buf[i] == '\0' || buf[i] == '\n')
+                        buf[i] = ' ';
+                else if (!isprint((unsigned char)buf[i]))
+                        buf[i] = '.';
+        }
+
+        return (strdup(buf));
+}
+
+static char *proc_defunct_cmdline(const char *comm)
+{
+        size_t len = strlen(comm);
+        char *cmd = malloc(len + sizeof("[] <defunct>"));
+
+        cmd[0] = '[';
+        memcpy(cmd + 1, comm, len);
+        memcpy(cmd + 1 + len, "] <defunct>", sizeof("] <defunct>"));
+
+        return (cmd);
+}
+
+/*
+ * Collect the inodes of the sockets the process has open.
+ */
+static void proc_read_sockets(int dir_fd, int pid, struct proc_snapshot *snapshot, size_t *alloc)
+{
+        char path[32], link[256], *s, *e;
+        struct dirent *ent;
+        unsigned long inode;
+        ssize_t len;
+        DIR *d;
+        int fd;
+
+        snprintf(path, sizeof path, "%d/fd", pid);
+        fd = openat(dir_fd, path, O_RDONLY | O_DIRECTORY);
+        if (fd < 0)
+                return;
+
+        d = fdopendir(fd);
+        if (d == NULL) {
+                close(fd);
+                return;
+        }
+
+        while ((ent = readdir(d)) != NULL) {
+                if (ent->d_name[0] == '.')
+                        continue;
+
+                len = readlinkat(dirfd(d), ent->d_name, link, sizeof link - 1);
+                if (len < 0)
+                        continue;
+                link[len] = '\0';
+
+                if (memcmp(link, "socket:", 7) == 0) {
+                        /* Type 1 sockets */
+                        s = strchr(link + 7, '[');
+                        if (s == NULL)
+                                continue;
+                        s++;
+                        e = strchr(s, ']');
+                        if (e == NULL)
+                                continue;
+                        *e = '\0';
+                } else if (memcmp(link, "[0000]:", 7) == 0) {
+                        /* Type 2 sockets */
+                        s = link + 8;
+                } else {
+                        continue;
+                }
+
+                errno = 0;
+                inode = strtoul(s, NULL, 10);
+                if (errno)
+                        continue;
+
+                if (snapshot->socket_count == *alloc) {
+                        *alloc = *alloc == 0 ? 256 : *alloc * 2;
+                        snapshot->sockets = realloc(snapshot->sockets, *alloc * sizeof(struct proc_socket));
+                }
+
+                /* the process is resolved when all the processes are read */
+                snapshot->sockets[snapshot->socket_count].inode = inode;
+                snapshot->sockets[snapshot->socket_count].pid = pid;
+                snapshot->socket_count++;
+        }
+
+        closedir(d);
+}
+
+static int proc_pid_cmp(const void *a, const void *b)
+{
+        const struct proc_entry *p1 = a, *p2 = b;
+
+        return (p1->pid > p2->pid) - (p1->pid < p2->pid);
+}
+
+static int proc_pidp_cmp(const void *a, const void *b)
+{
+        return proc_pid_cmp(*(struct proc_entry * const *)a, *(struct proc_entry * const *)b);
+}
+
+static int proc_comm_cmp(const void *a, const void *b)
+{
+        const struct proc_entry *p1 = *(struct proc_entry * const *)a, *p2 = *(struct proc_entry * const *)b;
+        int ret = strcmp(p1->comm, p2->comm);
+
+        return ret != 0 ? ret : proc_pid_cmp(p1, p2);
+}
+
+static int proc_cmdline_cmp(const void *a, const void *b)
+{
+        const struct proc_entry *p1 = *(struct proc_entry * const *)a, *p2 = *(struct proc_entry * const *)b;
+        int ret = strcmp(p1->command_line, p2->command_line);
+
+        return ret != 0 ? ret : proc_pid_cmp(p1, p2);
+}
+
+static int proc_socket_cmp(const void *a, const void *b)
+{
+        const struct proc_socket *s1 = a, *s2 = b;
+
+        if (s1->inode != s2->inode)
+                return (s1->inode > s2->inode) - (s1->inode < s2->inode);
+
+        return (s1->pid > s2->pid) - (s1->pid < s2->pid);
+}
+
+static struct proc_entry *proc_find_pid(struct proc_snapshot *snapshot, int pid)
+{
+        struct proc_entry key;
+
+        key.pid = pid;
+
+        return bsearch(&key, snapshot->procs, snapshot->count, sizeof(struct proc_entry), proc_pid_cmp);
+}
+
+static void proc_snapshot_free(struct proc_snapshot *snapshot)
+{
+        size_t i;
+
+        for (i = 0; i < snapshot->count; ++i)
+                free(snapshot->procs[i].command_line);
+
+        free(snapshot->procs);
+        free(snapshot->by_comm);
+        free(snapshot->by_cmdline);
+        free(snapshot->sockets);
+        free(snapshot);
+}
+
+/*
+ * Index the processes and resolve the owners of the sockets.
+ */
+static void proc_snapshot_index(struct proc_snapshot *snapshot, unsigned flags)
+{
+        size_t i, j;
+
+        qsort(snapshot->procs, snapshot->count, sizeof(struct proc_entry), proc_pid_cmp);
+
+        snapshot->by_comm = malloc((snapshot->count + 1) * sizeof(struct proc_entry *));
+        for (i = 0; i < snapshot->count; ++i)
+                snapshot->by_comm[i] = &snapshot->procs[i];
+        qsort(snapshot->by_comm, snapshot->count, sizeof(struct proc_entry *), proc_comm_cmp);
+
+        if (flags & PROC_SNAPSHOT_CMDLINE) {
+                snapshot->by_cmdline = malloc((snapshot->count + 1) * sizeof(struct proc_entry *));
+                for (i = 0; i < snapshot->count; ++i)
+                        snapshot->by_cmdline[i] = &snapshot->procs[i];
+                qsort(snapshot->by_cmdline, snapshot->count, sizeof(struct proc_entry *), proc_cmdline_cmp);
+        }
+
+        for (i = 0, j = 0; i < snapshot->socket_count; ++i) {
+                struct proc_entry *proc = proc_find_pid(snapshot, snapshot->sockets[i].pid);
+
+                if (proc != NULL) {
+                        snapshot->sockets[j] = snapshot->sockets[i];
+                        snapshot->sockets[j].proc = proc;
+                        ++j;
+                }
+        }
+        snapshot->socket_count = j;
+        qsort(snapshot->sockets, snapshot->socket_count, sizeof(struct proc_socket), proc_socket_cmp);
+}
+
+static struct proc_snapshot *proc_snapshot_take(struct proc_snapshot_cache *cache)
+{
+        struct proc_snapshot *snapshot;
+        struct proc_buf buf;
+        struct dirent *ent;
+        size_t alloc = 0, socket_alloc = 0;
+        char path[32];
+        ssize_t len;
+        DIR *d;
+        int fd;
+
+        fd = open(cache->path, O_RDONLY | O_DIRECTORY);
+        if (fd < 0) {
+                /* Images and chroots often have no proc directory */
+                if (cache->offline)
+                        dI("Can't open %s: %s", cache->path, strerror(errno));
+                else
+                        dW("Can't open %s: %s", cache->path, strerror(errno));
+                return (NULL);
+        }
+
+        d = fdopendir(fd);
+        if (d == NULL) {
+                close(fd);
+                return (NULL);
+        }
+        fd = dirfd(d);
+
+        buf.size = 4096;
+        buf.data = malloc(buf.size);
+
+        snapshot = calloc(1, sizeof(struct proc_snapshot));
+        snapshot->scan = probe_scan_id();
+        snapshot->refs = 1;
+        snapshot->offline = cache->offline;
+        snapshot->path = cache->path;
+        snapshot->ticks = (unsigned long)sysconf(_SC_CLK_TCK);
+        snapshot->boot = proc_boot_time(fd, &buf);
+
+        while ((ent = readdir(d)) != NULL) {
+                struct proc_entry *proc;
+                int pid;
+
+                /* Skip non-process dir entries */
+                if (*ent->d_name < '0' || *ent->d_name > '9')
+                        continue;
+                errno = 0;
+                pid = strtol(ent->d_name, NULL, 10);
+                if (errno || pid == 2) /* skip err & kthreads */
+                        continue;
+
+                if (snapshot->count == alloc) {
+                        alloc = alloc == 0 ? 1024 : alloc * 2;
+                        snapshot->procs = realloc(snapshot->procs, alloc * sizeof(struct proc_entry));
+                }
+                proc = &snapshot->procs[snapshot->count];
+                memset(proc, 0, sizeof(struct proc_entry));
+
+                snprintf(path, sizeof path, "%d/stat", pid);
+                len = proc_read(fd, path, &buf);
+                if (!proc_parse_stat(buf.data, len, proc))
+                        continue;
+
+                /* Skip kthreads */
+                if (proc->ppid == 2)
+                        continue;
+
+                proc->pid = pid;
+                proc->ruid = -1;
+                proc->euid = -1;
+                proc->loginuid = -1;
+
+                snprintf(path, sizeof path, "%d/status", pid);
+                if (proc_read(fd, path, &buf) > 0)
+                        proc_parse_uids(buf.data, proc);
+
+                if (cache->flags & PROC_SNAPSHOT_CMDLINE) {
+                        if (proc->state == 'Z') {
+                                proc->command_line = proc_defunct_cmdline(proc->comm);
+                        } else {
+                                snprintf(path, sizeof path, "%d/cmdline", pid);
+                                len = proc_read(fd, path, &buf);
+                                proc->command_line = proc_parse_cmdline(buf.data, len);
+                                if (proc->command_line == NULL)
+                                        proc->command_line = strdup(proc->comm);
+                        }
+                }
+
+                if (cache->flags & PROC_SNAPSHOT_LOGINUID) {
+                        snprintf(path, sizeof path, "%d/loginuid", pid);
+                        if (proc_read(fd, path, &buf) >= 0 && sscanf(buf.data, "%u", &proc->loginuid) < 1)
+                                dW("Can't read the loginuid of process %d", pid);
+                }
+
+                if (cache->flags & PROC_SNAPSHOT_SOCKETS)
+                        proc_read_sockets(fd, pid, snapshot, &socket_alloc);
+
+                snapshot->count++;
+        }
+
+        closedir(d);
+        free(buf.data);
+
+        /* The proc directory of an offline target is usually empty */
+        if (snapshot->offline && snapshot->count == 0) {
+                dI("No processes in %s.", snapshot->path);
+                proc_snapshot_free(snapshot);
+                return (NULL);
+        }
+
+        proc_snapshot_index(snapshot, cache->flags);
+        dI("Took a snapshot of %zu processes from %s.", snapshot->count, snapshot->path);
+
+        return (snapshot);
+}
+
+void proc_snapshot_cache_init(struct proc_snapshot_cache *cache, unsigned flags)
+{
+        const char *root = NULL;
+        size_t len = 0;
+
+        pthread_mutex_init(&cache->lock, NULL);
+        cache->flags = flags;
+        cache->snapshot = NULL;
+        cache->offline = (OSCAP_GSYM(offline_mode) & PROBE_OFFLINE_OWN) != 0;
+
+        if (cache->offline) {
+                root = getenv("OSCAP_PROBE_ROOT");
+                len = strlen(root);
+                while (len > 0 && root[len - 1] == '/')
+                        --len;
+        }
+
+        cache->path = malloc(len + sizeof("/proc"));
+        if (len > 0)
+                memcpy(cache->path, root, len);
+        memcpy(cache->path + len, "/proc", sizeof("/proc"));
+}
+
+void proc_snapshot_cache_destroy(struct proc_snapshot_cache *cache)
+{
+        if (cache->snapshot != NULL)
+                proc_snapshot_free(cache->snapshot);
+
+        free(cache->path);
+        pthread_mutex_destroy(&cache->lock);
+}
+
+struct proc_snapshot *proc_snapshot_get(struct proc_snapshot_cache *cache)
+{
+        struct proc_snapshot *snapshot;
+
+        pthread_mutex_lock(&cache->lock);
+
+        if (cache->snapshot != NULL && cache->snapshot->scan != probe_scan_id()) {
+                if (--cache->snapshot->refs == 0)
+                        proc_snapshot_free(cache->snapshot);
+                cache->snapshot = NULL;
+        }
+
+        if (cache->snapshot == NULL)
+                cache->snapshot = proc_snapshot_take(cache);
+
+        snapshot = cache->snapshot;
+
+        if (snapshot != NULL)
+                snapshot->refs++;
+
+        pthread_mutex_unlock(&cache->lock);
+
+        return (snapshot);
+}
+
+void proc_snapshot_put(struct proc_snapshot_cache *cache, struct proc_snapshot *snapshot)
+{
+        pthread_mutex_lock(&cache->lock);
+
+        if (--snapshot->refs == 0)
+                proc_snapshot_free(snapshot);
+
+        pthread_mutex_unlock(&cache->lock);
+}
+
+/*
+ * Append the processes which have the given value of the key.
+ */
+static void proc_lookup_value(struct proc_snapshot *snapshot, proc_key_t key, SEXP_t *val,
+                              struct proc_entry ***found, size_t *count)
+{
+        struct proc_entry **index;
+        size_t lo = 0, hi = snapshot->count, mid;
+        char *str;
+
+        if (key == PROC_KEY_PID) {
+                int64_t pid = SEXP_number_geti_64(val);
+                struct proc_entry *proc = NULL;
+
+                if (pid > 0 && pid <= INT_MAX)
+                        proc = proc_find_pid(snapshot, pid);
+                if (proc != NULL) {
+                        *found = realloc(*found, (*count + 1) * sizeof(struct proc_entry *));
+                        (*found)[(*count)++] = proc;
+                }
+                return;
+        }
+
+        index = key == PROC_KEY_COMM ? snapshot->by_comm : snapshot->by_cmdline;
+        str = SEXP_string_cstr(val);
+        if (str == NULL)
+                return;
+
+#define PROC_KEY_STR(p) (key == PROC_KEY_COMM ? (p)->comm : (p)->command_line)
+        while (lo < hi) {
+                mid = lo + (hi - lo) / 2;
+                if (strcmp(PROC_KEY_STR(index[mid]), str) < 0)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+        }
+
+        for (; lo < snapshot->count && strcmp(PROC_KEY_STR(index[lo]), str) == 0; ++lo) {
+                *found = realloc(*found, (*count + 1) * sizeof(struct proc_entry *));
+                (*found)[(*count)++] = index[lo];
+        }
+#undef PROC_KEY_STR
+
+        free(str);
+}
+
+int proc_snapshot_lookup(struct proc_snapshot *snapshot, proc_key_t key, SEXP_t *ent,
+                         struct proc_entry ***found)
+{
+        SEXP_t *vals, *val, *chk;
+        size_t count = 0, i, j;
+        bool usable = true;
+
+        *found = NULL;
+
+        if (ent == NULL || probe_ent_getoperation(ent, OVAL_OPERATION_EQUALS) != OVAL_OPERATION_EQUALS)
+                return (-1);
+        if (key == PROC_KEY_CMDLINE && snapshot->by_cmdline == NULL)
+                return (-1);
+        if (probe_ent_getdatatype(ent) != (key == PROC_KEY_PID ? OVAL_DATATYPE_INTEGER : OVAL_DATATYPE_STRING))
+                return (-1);
+
+        /* the items of "none satisfy" variables aren't among the values */
+        chk = probe_ent_getattrval(ent, "var_check");
+        if (chk != NULL) {
+                oval_check_t check = SEXP_number_geti_32(chk);
+
+                SEXP_free(chk);
+                if (check == OVAL_CHECK_NONE_EXIST || check == OVAL_CHECK_NONE_SATISFY)
+                        return (-1);
+        }
+
+        if (probe_ent_getvals(ent, &vals) <= 0) {
+                SEXP_free(vals);
+                return (-1);
+        }
+
+        SEXP_list_foreach(val, vals) {
+                if (key == PROC_KEY_PID ? !SEXP_numberp(val) : !SEXP_stringp(val)) {
+                        usable = false;
+                        SEXP_free(val);
+                        break;
+                }
+                proc_lookup_value(snapshot, key, val, found, &count);
+        }
+
+        SEXP_free(vals);
+
+        if (!usable) {
+                free(*found);
+                *found = NULL;
+                return (-1);
+        }
+
+        /* the values may repeat */
+        qsort(*found, count, sizeof(struct proc_entry *), proc_pidp_cmp);
+        for (i = 0, j = 0; i < count; ++i) {
+                if (j == 0 || (*found)[j - 1] != (*found)[i])
+                        (*found)[j++] = (*found)[i];
+        }
+
+        return (j);
+}
+
+struct proc_entry *proc_snapshot_find_socket(struct proc_snapshot *snapshot, unsigned long inode)
+{
+        size_t lo = 0, hi = snapshot->socket_count, mid;
+
+        while (lo < hi) {
+                mid = lo + (hi - lo) / 2;
+                if (snapshot->sockets[mid].inode < inode)
+                        lo = mid + 1;
+                else
+                        hi = mid;
+        }
+
+        if (lo < snapshot->socket_count && snapshot->sockets[lo].inode == inode)
+                return (snapshot->sockets[lo].proc);
+
+        return (NULL);
+}
+
+#endif /* __linux__ */
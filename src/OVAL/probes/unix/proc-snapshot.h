@@ -0,0 +1,130 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PROC_SNAPSHOT_H
+#define PROC_SNAPSHOT_H
+
+#if defined(__linux__)
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <seap.h>
+
+/*
+ * Snapshot of the processes listed in /proc, shared by the probes which
+ * look at running processes. The /proc files of every process are read
+ * once per scan and all the objects of the scan are matched against the
+ * snapshot. In the offline mode the snapshot is taken from the proc
+ * directory below OSCAP_PROBE_ROOT.
+ */
+
+/* Data which are read only when the probe asks for them */
+#define PROC_SNAPSHOT_CMDLINE  0x01  /* command_line, /proc/PID/cmdline */
+#define PROC_SNAPSHOT_LOGINUID 0x02  /* loginuid, /proc/PID/loginuid */
+#define PROC_SNAPSHOT_SOCKETS  0x04  /* socket inodes, /proc/PID/fd */
+
+struct proc_entry {
+        int                pid;
+        int                ppid;
+        int                session;
+        int                tty_nr;
+        char               state;
+        char               comm[16];
+        char              *command_line;  /* ps-like, "[comm] <defunct>" for zombies */
+        unsigned long      utime;
+        unsigned long      stime;
+        long               priority;
+        unsigned long long start;
+        int                ruid;          /* -1 if unknown */
+        int                euid;          /* -1 if unknown */
+        unsigned           loginuid;      /* (unsigned)-1 if unknown */
+};
+
+struct proc_socket {
+        unsigned long      inode;
+        int                pid;
+        struct proc_entry *proc;
+};
+
+struct proc_snapshot {
+        uint32_t            scan;
+        int                 refs;
+        bool                offline;  /* taken from OSCAP_PROBE_ROOT */
+        const char         *path;     /* path of the proc directory */
+        unsigned long       ticks;
+        unsigned long       boot;
+
+        size_t              count;
+        struct proc_entry  *procs;    /* sorted by pid */
+        struct proc_entry **by_comm;
+        struct proc_entry **by_cmdline;
+
+        size_t              socket_count;
+        struct proc_socket *sockets;  /* sorted by inode, then by pid */
+};
+
+/*
+ * The snapshot of the current scan, kept in the probe_init() argument
+ * of the probe.
+ */
+struct proc_snapshot_cache {
+        pthread_mutex_t       lock;
+        unsigned              flags;
+        bool                  offline;
+        char                 *path;
+        struct proc_snapshot *snapshot;
+};
+
+void proc_snapshot_cache_init(struct proc_snapshot_cache *cache, unsigned flags);
+void proc_snapshot_cache_destroy(struct proc_snapshot_cache *cache);
+
+/*
+ * Get the snapshot of the current scan, take it if there is none yet.
+ * The snapshot is released with proc_snapshot_put().
+ * @return the snapshot or NULL if the proc directory can't be read, in the
+ * offline mode also if it has no processes
+ */
+struct proc_snapshot *proc_snapshot_get(struct proc_snapshot_cache *cache);
+void proc_snapshot_put(struct proc_snapshot_cache *cache, struct proc_snapshot *snapshot);
+
+typedef enum {
+        PROC_KEY_PID,
+        PROC_KEY_COMM,
+        PROC_KEY_CMDLINE
+} proc_key_t;
+
+/*
+ * Find the processes which may match an "equals" entity using the index
+ * of the key; the candidates still have to be compared with the entity.
+ * @param found array of the candidates sorted by pid, to be freed
+ * @return number of candidates, -1 if the index can't be used for the entity
+ */
+int proc_snapshot_lookup(struct proc_snapshot *snapshot, proc_key_t key, SEXP_t *ent,
+                         struct proc_entry ***found);
+
+/*
+ * Find the first process (by pid) which has the socket open.
+ */
+struct proc_entry *proc_snapshot_find_socket(struct proc_snapshot *snapshot, unsigned long inode);
+
+#endif /* __linux__ */
+
+#endif /* PROC_SNAPSHOT_H */
@@ -56,8 +56,11 @@
 #include "seap.h"
 #include "probe-api.h"
 #include "probe/entcmp.h"
+#include "probe/probe.h"
+#include "probe/option.h"
 #include "alloc.h"
 #include "common/debug_priv.h"
+#include "proc-snapshot.h"
 
 oval_schema_version_t over;
 
@@ -104,62 +107,7 @@ static void report_finding(struct result_info *res, probe_ctx *ctx)
 
 #if defined(__linux__)
 
-unsigned long ticks, boot;
-
-static void get_boot_time(void)
-{
-	char buf[100];
-	FILE *sf;
-	int line;
-
-	boot = 0;
-	sf = fopen("/proc/stat", "rt");
-	if (sf == NULL)
-		return;
-
-	line = 0;
-	__fsetlocking(sf, FSETLOCKING_BYCALLER);
-	while (fgets(buf, sizeof(buf), sf)) {
-		if (line == 0) {
-			line++;
-			continue;
-		}
-		if (memcmp(buf, "btime", 5) == 0) {
-			sscanf(buf, "btime %lu", &boot);
-			break;
-		}
-	}
-	fclose(sf);
-}
-
-static int get_uids(int pid, struct result_info *r)
-{
-	char buf[100];
-	FILE *sf;
-
-	r->ruid = -1;
-	r->user_id = -1;
-
-	snprintf(buf, sizeof(buf), "/proc/%d/status", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		int line = 0;
-		__fsetlocking(sf, FSETLOCKING_BYCALLER);
-		while (fgets(buf, sizeof(buf), sf)) {
-			if (line == 0) {
-				line++;
-				continue;
-			}
-			if (memcmp(buf, "Uid:", 4) == 0) {
-				sscanf(buf, "Uid: %d %d", &r->ruid, &r->user_id);
-				break;
-			}
-		}
-		fclose(sf);
-	}
-
-	return 0;
-}
+static struct proc_snapshot_cache __process_cache;
 
 static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 {
@@ -179,85 +127,40 @@ static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 	return tbuf;
 }
 
-static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
+static int read_process(struct proc_snapshot *snapshot, SEXP_t *cmd_ent, probe_ctx *ctx)
 {
-	int err = 1;
-	DIR *d;
-	struct dirent *ent;
+	struct proc_entry **found, *proc;
+	int count, i;
 
-	d = opendir("/proc");
-	if (d == NULL)
-		return err;
+	// No process has been read, there must be permission problems
+	if (snapshot->count == 0)
+		return 1;
 
-	// Get the time tick hertz
-	ticks = (unsigned long)sysconf(_SC_CLK_TCK);
-	get_boot_time();
+	// Use the index of the snapshot for the "equals" operation
+	count = proc_snapshot_lookup(snapshot, PROC_KEY_COMM, cmd_ent, &found);
+	if (count < 0)
+		count = snapshot->count;
 
-	// Scan the directories
-	while (( ent = readdir(d) )) {
-		int fd, len;
-		char buf[256];
-		char *tmp, cmd[16], state, tty_dev[128];
-		int pid, ppid, pgrp, session, tty_nr, tpgid;
-		unsigned flags, sched_policy;
-		unsigned long minflt, cminflt, majflt, cmajflt, uutime, ustime;
-		long cutime, cstime, priority, cnice, nthreads, itrealvalue;
-		unsigned long long start;
+	for (i = 0; i < count; ++i) {
+		char tty_dev[128];
+		unsigned sched_policy;
 		SEXP_t *cmd_sexp;
 
-		// Skip non-process dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno || pid == 2) // skip err & kthreads
-			continue;
+		proc = found != NULL ? found[i] : &snapshot->procs[i];
 
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd, 0, sizeof(cmd));
-		sscanf(buf, "%d (%15c", &ppid, cmd);
-		sscanf(tmp+2,	"%c %d %d %d %d %d "
-				"%u %lu %lu %lu %lu "
-				"%lu %lu %lu %ld %ld "
-				"%ld %ld %ld %llu",
-			&state, &ppid, &pgrp, &session, &tty_nr, &tpgid,
-			&flags, &minflt, &cminflt, &majflt, &cmajflt,
-			&uutime, &ustime, &cutime, &cstime, &priority,
-			&cnice, &nthreads, &itrealvalue, &start
-		);
-
-		// Skip kthreads
-		if (ppid == 2)
-			continue;
-
-		err = 0; // If we get this far, no permission problems
-		dI("Have command: %s", cmd);
-		cmd_sexp = SEXP_string_newf("%s", cmd);
+		dI("Have command: %s", proc->comm);
+		cmd_sexp = SEXP_string_newf("%s", proc->comm);
 		if (probe_entobj_cmp(cmd_ent, cmd_sexp) == OVAL_RESULT_TRUE) {
 			struct result_info r;
-			unsigned long t = uutime/ticks + ustime/ticks;
+			unsigned long t = proc->utime/snapshot->ticks + proc->stime/snapshot->ticks;
 			char tbuf[32], sbuf[32];
 			int tday,tyear;
 			time_t s_time;
-			struct tm *proc, *now;
+			struct tm *tm_proc, *now;
 			const char *fmt;
 
-			// Now get scheduler policy
-			sched_policy = sched_getscheduler(pid);
+			// Now get scheduler policy, it's known only for live processes
+			sched_policy = snapshot->offline ? -1 : sched_getscheduler(proc->pid);
 			switch (sched_policy) {
 				case SCHED_OTHER:
 					r.scheduling_class = "TS";
@@ -286,8 +189,8 @@ static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 			now = localtime(&s_time);
 			tyear = now->tm_year;
 			tday = now->tm_yday;
-			s_time = boot + (start / ticks);
-			proc = localtime(&s_time);
+			s_time = snapshot->boot + (proc->start / snapshot->ticks);
+			tm_proc = localtime(&s_time);
 
 			// Select format based on how long we've been running
 			//
@@ -296,49 +199,78 @@ static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 			// the same day the process started or formatted as MMM_DD (Ex.: Feb_5)
 			// if process started the previous day or further in the past."
 			//
-			if (tday != proc->tm_yday || tyear != proc->tm_year)
+			if (tday != tm_proc->tm_yday || tyear != tm_proc->tm_year)
 				fmt = "%b_%d";
 			else
 				fmt = "%H:%M:%S";
-			strftime(sbuf, sizeof(sbuf), fmt, proc);
+			strftime(sbuf, sizeof(sbuf), fmt, tm_proc);
 
-			r.command = cmd;
+			r.command = proc->comm;
 			r.exec_time = convert_time(t, tbuf, sizeof(tbuf));
-			r.pid = pid;
-			r.ppid = ppid;
-			r.priority = priority;
+			r.pid = proc->pid;
+			r.ppid = proc->ppid;
+			r.priority = proc->priority;
 			r.start_time = sbuf;
 
-                        dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) tty_nr, pid, ABBREV_DEV);
-                        r.tty = tty_dev;
+			if (snapshot->offline)
+				strcpy(tty_dev, "?");
+			else
+				dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) proc->tty_nr, proc->pid, ABBREV_DEV);
+			r.tty = tty_dev;
 
-			get_uids(pid, &r);
+			r.ruid = proc->ruid;
+			r.user_id = proc->euid;
 			report_finding(&r, ctx);
 		}
 		SEXP_free(cmd_sexp);
 	}
-        closedir(d);
+	free(found);
 
-	return err;
+	return 0;
+}
+
+void probe_offline_mode(void)
+{
+	probe_setoption(PROBEOPT_OFFLINE_MODE_SUPPORTED, PROBE_OFFLINE_OWN);
+}
+
+void *probe_init(void)
+{
+	proc_snapshot_cache_init(&__process_cache, 0);
+	return (&__process_cache);
+}
+
+void probe_fini(void *arg)
+{
+	proc_snapshot_cache_destroy(arg);
 }
 
 int probe_main(probe_ctx *ctx, void *arg)
 {
 	SEXP_t *ent;
+	struct proc_snapshot *snapshot;
+	int err = 0;
 
 	ent = probe_obj_getent(probe_ctx_getobject(ctx), "command", 1);
 	if (ent == NULL) {
 		return PROBE_ENOVAL;
 	}
 
-	if (read_process(ent, ctx)) {
-		SEXP_free(ent);
-		return PROBE_EACCESS;
+	snapshot = proc_snapshot_get(arg);
+	if (snapshot == NULL) {
+		if (((struct proc_snapshot_cache *)arg)->offline)
+			probe_cobj_set_flag(probe_ctx_getresult(ctx), OSCAP_GSYM(offline_mode_cobjflag));
+		else
+			err = PROBE_EACCESS;
+	} else {
+		if (read_process(snapshot, ent, ctx))
+			err = PROBE_EACCESS;
+		proc_snapshot_put(arg, snapshot);
 	}
 
 	SEXP_free(ent);
 
-	return 0;
+	return err;
 }
 #elif defined (__SVR4) && defined (__sun)
 
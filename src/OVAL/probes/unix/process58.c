@@ -100,10 +100,11 @@ extern char const *_cap_names[];
 #include "seap.h"
 #include "probe-api.h"
 #include "probe/entcmp.h"
+#include "probe/probe.h"
+#include "probe/option.h"
 #include "alloc.h"
 #include "common/debug_priv.h"
-#include <ctype.h>
-#include "common/oscap_buffer.h"
+#include "proc-snapshot.h"
 
 /* Convenience structure for the results being reported */
 struct result_info {
@@ -151,72 +152,7 @@ static void report_finding(struct result_info *res, probe_ctx *ctx)
 
 #if defined(__linux__)
 
-unsigned long ticks, boot;
-
-static void get_boot_time(void)
-{
-	char buf[100];
-	FILE *sf;
-	int line;
-
-	boot = 0;
-	sf = fopen("/proc/stat", "rt");
-	if (sf == NULL)
-		return;
-
-	line = 0;
-	__fsetlocking(sf, FSETLOCKING_BYCALLER);
-	while (fgets(buf, sizeof(buf), sf)) {
-		if (line == 0) {
-			line++;
-			continue;
-		}
-		if (memcmp(buf, "btime", 5) == 0) {
-			sscanf(buf, "btime %lu", &boot);
-			break;
-		}
-	}
-	fclose(sf);
-}
-
-static int get_uids(int pid, struct result_info *r)
-{
-	char buf[100];
-	FILE *sf;
-
-	r->ruid = -1;
-	r->user_id = -1;
-	r->loginuid = -1;
-
-	snprintf(buf, sizeof(buf), "/proc/%d/status", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		int line = 0;
-		__fsetlocking(sf, FSETLOCKING_BYCALLER);
-		while (fgets(buf, sizeof(buf), sf)) {
-			if (line == 0) {
-				line++;
-				continue;
-			}
-			if (memcmp(buf, "Uid:", 4) == 0) {
-				sscanf(buf, "Uid: %d %d", &r->ruid, &r->user_id);
-				break;
-			}
-		}
-		fclose(sf);
-	}
-
-	snprintf(buf, sizeof(buf), "/proc/%d/loginuid", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		if (fscanf(sf, "%u", &r->loginuid) < 1) {
-			dW("fscanf failed from %s", buf);
-		}
-		fclose(sf);
-	}
-
-	return 0;
-}
+static struct proc_snapshot_cache __process58_cache;
 
 static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 {
@@ -335,7 +271,7 @@ static char **get_posix_capability(int pid, int max_cap_id) {
 
 /* get exec shield status according to http://people.redhat.com/sgrubb/files/lsexec
  * return value: -1 - not detected, 0 - disabled, 1 - enabled */
-static int get_exec_shield_status(int pid) {
+static int get_exec_shield_status(const char *proc_path, int pid) {
 	char buf[501];
 	FILE *sf;
 	long unsigned low, high, inode;
@@ -344,7 +280,7 @@ static int get_exec_shield_status(int pid) {
 	char perm[3], trim;
 	int ret = -1, read_items;
 
-	snprintf(buf, sizeof(buf), "/proc/%d/maps", pid);
+	snprintf(buf, sizeof(buf), "%s/%d/maps", proc_path, pid);
 	sf = fopen(buf, "rt");
 	if (sf) {
 		while (fgets(buf, 500, sf)) {
@@ -368,98 +304,15 @@ static int get_exec_shield_status(int pid) {
 	return ret;
 }
 
-/**
- * Parse /proc/%d/cmdline file
- * @param filepath Path to file ~ use preallocated buffer for the path
- * @param buffer output buffer with non-zero size
- * @return ps-like command info or NULL
- */
-static inline bool get_process_cmdline(const char* filepath, struct oscap_buffer* const buffer){
-
-	int fd = open(filepath, O_RDONLY, 0);
-
-	if (fd < 0) {
-		return false;
-	}
-
-	oscap_buffer_clear(buffer);
-
-
-
-	for(;;) {
-		static const int chunk_size = 1024;
-		char chunk[chunk_size];
-		// Read data, store to buffer
-		ssize_t read_size = read(fd, chunk, chunk_size );
-		if (read_size < 0) {
-			close(fd);
-			return false;
-		}
-		oscap_buffer_append_binary_data(buffer, chunk, read_size);
-
-		// If reach end of file, then end the loop
-		if (chunk_size != read_size) {
-			break;
-		}
-	}
-
-	close(fd);
-
-	int length = oscap_buffer_get_length(buffer);
-	char* buffer_mem = oscap_buffer_get_raw(buffer);
-
-	if ( length == 0 ) { // empty file
-		return false;
-	} else {
-
-		// Skip multiple trailing zeros
-		int i = length - 1;
-		while ( (i > 0) && (buffer_mem[i] == '\0') ) {
-			--i;
-		}
-
-		// Program and args are separated by '\0'
-		// Replace them with spaces ' '
-		while( i >= 0 ){
-			char chr = buffer_mem[i];
-			if ( ( chr == '\0') || ( chr == '\n' ) ) {
-				buffer_mem[i] = ' ';
-			} else if ( !isprint(chr) ) { // "ps" replace non-printable characters with '.' (LC_ALL=C)
-				buffer_mem[i] = '.';
-			}
-			--i;
-		}
-	}
-	return true;
-}
-
-/**
- * Make "[%s] <defunct>" from cmd string - inplace
- * @param cmd_buffer @see read_process() > cmd_buffer
- * @return pointer to start of string
- */
-static inline char *make_defunc_str(char* const cmd_buffer){
-	static const char DEFUNC_STR[] = "] <defunct>";
-
-	size_t len = strlen(cmd_buffer);
-	memcpy(cmd_buffer + len, DEFUNC_STR, sizeof(DEFUNC_STR));
-	return cmd_buffer;
-}
-
-static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
+static int read_process(struct proc_snapshot *snapshot, SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 {
-	int err = 1, max_cap_id;
-	DIR *d;
-	struct dirent *ent;
+	int max_cap_id, count, i;
 	oval_schema_version_t oval_version;
+	struct proc_entry **found, *proc;
 
-	d = opendir("/proc");
-	if (d == NULL)
-		return err;
-
-	// Get the time tick hertz
-	ticks = (unsigned long)sysconf(_SC_CLK_TCK);
-	get_boot_time();
+	// No process has been read, there must be permission problems
+	if (snapshot->count == 0)
+		return 1;
 
 	oval_version = probe_obj_get_platform_schema_version(probe_ctx_getobject(ctx));
 	if (oval_schema_version_cmp(oval_version, OVAL_SCHEMA_VERSION(5.11)) < 0) {
@@ -468,92 +321,36 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		max_cap_id = OVAL_5_11_MAX_CAP_ID;
 	}
 
-	struct oscap_buffer *cmdline_buffer = oscap_buffer_new();
-	
-	char cmd_buffer[1 + 15 + 11 + 1]; // Format:" [ cmd:15 ] <defunc>"
-	cmd_buffer[0] = '[';
+	// Use the indexes of the snapshot for the "equals" operation
+	count = proc_snapshot_lookup(snapshot, PROC_KEY_CMDLINE, cmd_ent, &found);
+	if (count < 0)
+		count = proc_snapshot_lookup(snapshot, PROC_KEY_PID, pid_ent, &found);
+	if (count < 0)
+		count = snapshot->count;
 
-	// Scan the directories
-	while (( ent = readdir(d) )) {
-		int fd, len;
-		char buf[256];
-		char *tmp, state, tty_dev[128];
-		int pid, ppid, pgrp, session, tty_nr, tpgid;
-		unsigned flags, sched_policy;
-		unsigned long minflt, cminflt, majflt, cmajflt, uutime, ustime;
-		long cutime, cstime, priority, cnice, nthreads, itrealvalue;
-		unsigned long long start;
+	for (i = 0; i < count; ++i) {
+		char tty_dev[128];
+		unsigned sched_policy;
 		SEXP_t *cmd_sexp = NULL, *pid_sexp = NULL;
 
-		// Skip non-process58 dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno || pid == 2) // skip err & kthreads
-			continue;
+		proc = found != NULL ? found[i] : &snapshot->procs[i];
 
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd_buffer + 1, 0, sizeof(cmd_buffer)-1); // clear cmd after starting '['
-		sscanf(buf, "%d (%15c", &ppid, cmd_buffer + 1);
-		sscanf(tmp+2,	"%c %d %d %d %d %d "
-				"%u %lu %lu %lu %lu "
-				"%lu %lu %lu %ld %ld "
-				"%ld %ld %ld %llu",
-			&state, &ppid, &pgrp, &session, &tty_nr, &tpgid,
-			&flags, &minflt, &cminflt, &majflt, &cmajflt,
-			&uutime, &ustime, &cutime, &cstime, &priority,
-			&cnice, &nthreads, &itrealvalue, &start
-		);
-
-		// Skip kthreads
-		if (ppid == 2)
-			continue;
-
-		const char* cmd;
-		if (state == 'Z') { // zombie
-			cmd = make_defunc_str(cmd_buffer);
-		} else {
-			snprintf(buf, 32, "/proc/%d/cmdline", pid);
-			if (get_process_cmdline(buf, cmdline_buffer)) {
-				cmd = oscap_buffer_get_raw(cmdline_buffer); // use full cmdline
-			} else {
-				cmd = cmd_buffer + 1;
-			}
-		}
-
-
-		err = 0; // If we get this far, no permission problems
-		dI("Have command: %s", cmd);
-		cmd_sexp = SEXP_string_newf("%s", cmd);
-		pid_sexp = SEXP_number_newu_32(pid);
+		dI("Have command: %s", proc->command_line);
+		cmd_sexp = SEXP_string_newf("%s", proc->command_line);
+		pid_sexp = SEXP_number_newu_32(proc->pid);
 		if ((cmd_sexp == NULL || probe_entobj_cmp(cmd_ent, cmd_sexp) == OVAL_RESULT_TRUE) &&
 		    (pid_sexp == NULL || probe_entobj_cmp(pid_ent, pid_sexp) == OVAL_RESULT_TRUE)
 		) {
 			struct result_info r;
-			unsigned long t = uutime/ticks + ustime/ticks;
+			unsigned long t = proc->utime/snapshot->ticks + proc->stime/snapshot->ticks;
 			char tbuf[32], sbuf[32], *selinux_domain_label, **posix_capabilities;
 			int tday,tyear;
 			time_t s_time;
-			struct tm *proc, *now;
+			struct tm *tm_proc, *now;
 			const char *fmt;
 
-			// Now get scheduler policy
-			sched_policy = sched_getscheduler(pid);
+			// Now get scheduler policy, it's known only for live processes
+			sched_policy = snapshot->offline ? -1 : sched_getscheduler(proc->pid);
 			switch (sched_policy) {
 				case SCHED_OTHER:
 					r.scheduling_class = "TS";
@@ -582,8 +379,8 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 			now = localtime(&s_time);
 			tyear = now->tm_year;
 			tday = now->tm_yday;
-			s_time = boot + (start / ticks);
-			proc = localtime(&s_time);
+			s_time = snapshot->boot + (proc->start / snapshot->ticks);
+			tm_proc = localtime(&s_time);
 
 			// Select format based on how long we've been running
 			//
@@ -592,33 +389,38 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 			// the same day the process started or formatted as MMM_DD (Ex.: Feb_5)
 			// if process started the previous day or further in the past."
 			//
-			if (tday != proc->tm_yday || tyear != proc->tm_year)
+			if (tday != tm_proc->tm_yday || tyear != tm_proc->tm_year)
 				fmt = "%b_%d";
 			else
 				fmt = "%H:%M:%S";
-			strftime(sbuf, sizeof(sbuf), fmt, proc);
+			strftime(sbuf, sizeof(sbuf), fmt, tm_proc);
 
-			r.command_line = cmd;
+			r.command_line = proc->command_line;
 			r.exec_time = convert_time(t, tbuf, sizeof(tbuf));
-			r.pid = pid;
-			r.ppid = ppid;
-			r.priority = priority;
+			r.pid = proc->pid;
+			r.ppid = proc->ppid;
+			r.priority = proc->priority;
 			r.start_time = sbuf;
 
-			dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) tty_nr, pid, ABBREV_DEV);
+			if (snapshot->offline)
+				strcpy(tty_dev, "?");
+			else
+				dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) proc->tty_nr, proc->pid, ABBREV_DEV);
 			r.tty = tty_dev;
 
-			r.exec_shield = (get_exec_shield_status(pid) > 0);
+			r.exec_shield = (get_exec_shield_status(snapshot->path, proc->pid) > 0);
 
-			selinux_domain_label = get_selinux_label(pid);
+			selinux_domain_label = snapshot->offline ? NULL : get_selinux_label(proc->pid);
 			r.selinux_domain_label = selinux_domain_label;
 
-			posix_capabilities = get_posix_capability(pid, max_cap_id);
+			posix_capabilities = snapshot->offline ? NULL : get_posix_capability(proc->pid, max_cap_id);
 			r.posix_capability = posix_capabilities;
 
-			r.session_id = session;
+			r.session_id = proc->session;
 
-			get_uids(pid, &r);
+			r.ruid = proc->ruid;
+			r.user_id = proc->euid;
+			r.loginuid = proc->loginuid;
 			report_finding(&r, ctx);
 
 			if (selinux_domain_label != NULL)
@@ -634,14 +436,31 @@ static int read_process(SEXP_t *cmd_ent, SEXP_t *pid_ent, probe_ctx *ctx)
 		SEXP_free(cmd_sexp);
 		SEXP_free(pid_sexp);
 	}
-        closedir(d);
-	oscap_buffer_free(cmdline_buffer);
-	return err;
+	free(found);
+	return 0;
+}
+
+void probe_offline_mode(void)
+{
+	probe_setoption(PROBEOPT_OFFLINE_MODE_SUPPORTED, PROBE_OFFLINE_OWN);
+}
+
+void *probe_init(void)
+{
+	proc_snapshot_cache_init(&__process58_cache, PROC_SNAPSHOT_CMDLINE | PROC_SNAPSHOT_LOGINUID);
+	return (&__process58_cache);
+}
+
+void probe_fini(void *arg)
+{
+	proc_snapshot_cache_destroy(arg);
 }
 
 int probe_main(probe_ctx *ctx, void *arg)
 {
 	SEXP_t *command_line_ent, *pid_ent;
+	struct proc_snapshot *snapshot;
+	int err = 0;
 
 	command_line_ent = probe_obj_getent(probe_ctx_getobject(ctx), "command_line", 1);
 	pid_ent = probe_obj_getent(probe_ctx_getobject(ctx), "pid", 1);
@@ -649,16 +468,22 @@ int probe_main(probe_ctx *ctx, void *arg)
 		return PROBE_ENOVAL;
 	}
 
-	if (read_process(command_line_ent, pid_ent, ctx)) {
-		SEXP_free(command_line_ent);
-		SEXP_free(pid_ent);
-		return PROBE_EACCESS;
+	snapshot = proc_snapshot_get(arg);
+	if (snapshot == NULL) {
+		if (((struct proc_snapshot_cache *)arg)->offline)
+			probe_cobj_set_flag(probe_ctx_getresult(ctx), OSCAP_GSYM(offline_mode_cobjflag));
+		else
+			err = PROBE_EACCESS;
+	} else {
+		if (read_process(snapshot, command_line_ent, pid_ent, ctx))
+			err = PROBE_EACCESS;
+		proc_snapshot_put(arg, snapshot);
 	}
 
 	SEXP_free(command_line_ent);
 	SEXP_free(pid_ent);
 
-	return 0;
+	return err;
 }
 #elif defined (__SVR4) && defined (__sun)
 
@@ -36,10 +36,13 @@
 #if defined(__linux__)
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
 #include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include "oval_fts.h"
 #include "common/debug_priv.h"
 #include "common/assume.h"
@@ -47,30 +50,83 @@
 #define PROC_SYS_DIR "/proc/sys"
 #define PROC_SYS_MAXDEPTH 7
 
-int probe_main(probe_ctx *ctx, void *probe_arg)
+/*
+ * Index of the readable sysctls, built by walking PROC_SYS_DIR once per
+ * scan. Objects which don't use the "equals" operation are matched
+ * against the index instead of walking the whole tree again; the values
+ * are still read when an item is collected.
+ */
+struct sysctl_mib {
+        char   *path;
+        SEXP_t *name;
+};
+
+struct sysctl_index {
+        uint32_t           scan;
+        int                refs;
+        size_t             count;
+        struct sysctl_mib *mibs;
+};
+
+struct sysctl_probe {
+        pthread_mutex_t      lock;
+        struct sysctl_index *index;
+};
+
+static struct sysctl_probe __sysctl_probe;
+
+static char *sysctl_path_to_mib(const char *mibpath)
 {
-        OVAL_FTS    *ofts;
-        OVAL_FTSENT *ofts_ent;
+        char *mib;
+        size_t miblen;
 
-        SEXP_t *name_entity, *probe_in;
-        SEXP_t *r0, *r1, *r2, *r3;
-        SEXP_t *ent_attrs, *bh_entity, *path_entity, *filename_entity;
-        oval_schema_version_t over;
-        int over_cmp;
+        mib    = strdup(mibpath + strlen(PROC_SYS_DIR) + 1);
+        miblen = strlen(mib);
 
-	const char *ipv6_conf_path = "/proc/sys/net/ipv6/conf/";
-	size_t ipv6_conf_path_len = strlen(ipv6_conf_path);
+        while (miblen > 0) {
+                if(mib[miblen - 1] == '/')
+                        mib[miblen - 1] = '.';
+                --miblen;
+        }
 
-        probe_in    = probe_ctx_getobject(ctx);
-        name_entity = probe_obj_getent(probe_in, "name", 1);
-        over        = probe_obj_get_platform_schema_version(probe_in);
-        over_cmp    = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10));
+        return (mib);
+}
 
-        if (name_entity == NULL) {
-                dE("Missing \"name\" entity in the input object");
-                return (PROBE_ENOENT);
+/* the sysctl utility uses the same condition in sysctl.c in ReadSetting() */
+static bool sysctl_readable(const char *mibpath, const struct stat *st)
+{
+        /* Skip write-only files, eg. /proc/sys/net/ipv4/route/flush */
+        if ((st->st_mode & S_IRUSR) == 0) {
+                dI("Skipping write-only file %s", mibpath);
+                return (false);
         }
 
+        return (true);
+}
+
+static void sysctl_index_free(struct sysctl_index *index)
+{
+        size_t i;
+
+        for (i = 0; i < index->count; ++i) {
+                free(index->mibs[i].path);
+                SEXP_free(index->mibs[i].name);
+        }
+
+        free(index->mibs);
+        free(index);
+}
+
+static struct sysctl_index *sysctl_index_build(SEXP_t *result)
+{
+        OVAL_FTS    *ofts;
+        OVAL_FTSENT *ofts_ent;
+
+        SEXP_t *r0, *r1, *r2, *r3;
+        SEXP_t *ent_attrs, *bh_entity, *path_entity, *filename_entity;
+        struct sysctl_index *index;
+        size_t alloc = 0;
+
         /*
          * prepare behaviors
          */
@@ -95,163 +151,384 @@ int probe_main(probe_ctx *ctx, void *probe_arg)
         filename_entity = probe_ent_creat1("filename", ent_attrs, r1 = SEXP_string_new(".*", 2));
         SEXP_vfree(r0, r1, ent_attrs, NULL);
 
-        /*
-         * collect sysctls
-         *  XXX: use direct access for the "equals" op
-         */
-        ofts = oval_fts_open(path_entity, filename_entity, NULL, bh_entity, probe_ctx_getresult(ctx));
+        ofts = oval_fts_open(path_entity, filename_entity, NULL, bh_entity, result);
+        SEXP_vfree(path_entity, filename_entity, bh_entity, NULL);
 
         if (ofts == NULL) {
                 dE("oval_fts_open(%s, %s) failed", PROC_SYS_DIR, ".\\+");
-                SEXP_vfree(path_entity, filename_entity, bh_entity, name_entity, NULL);
-
-                return (PROBE_EFATAL);
+                return (NULL);
         }
 
+        index = calloc(1, sizeof(struct sysctl_index));
+        index->scan = probe_scan_id();
+        index->refs = 1;
+
         while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-                SEXP_t *se_mib;
-                char    mibpath[PATH_MAX], *mib;
-                size_t  miblen;
+                char   mibpath[PATH_MAX], *mib;
 		struct stat file_stat;
 
                 snprintf(mibpath, sizeof mibpath, "%s/%s", ofts_ent->path, ofts_ent->file);
+                oval_ftsent_free(ofts_ent);
 
-		/* Skip write-only files, eg. /proc/sys/net/ipv4/route/flush */
 		if (stat(mibpath, &file_stat) == -1) {
 			dE("Stat failed on %s: %u, %s", mibpath, errno, strerror(errno));
-			oval_ftsent_free(ofts_ent);
-			continue;
-		}
-		/* the sysctl utility uses same condition in sysctl.c in ReadSetting() */
-		if ((file_stat.st_mode & S_IRUSR) == 0) {
-			dI("Skipping write-only file %s", mibpath);
-			oval_ftsent_free(ofts_ent);
 			continue;
 		}
 
-                mib    = strdup(mibpath + strlen(PROC_SYS_DIR) + 1);
-                miblen = strlen(mib);
+		if (!sysctl_readable(mibpath, &file_stat))
+			continue;
 
-                while (miblen > 0) {
-                        if(mib[miblen - 1] == '/')
-                                mib[miblen - 1] = '.';
-                        --miblen;
+                if (index->count == alloc) {
+                        alloc = alloc == 0 ? 1024 : alloc * 2;
+                        index->mibs = realloc(index->mibs, alloc * sizeof(struct sysctl_mib));
                 }
 
-                dI("MIB: %s", mib);
-                se_mib = SEXP_string_new(mib, strlen(mib));
+                mib = sysctl_path_to_mib(mibpath);
+                index->mibs[index->count].path = strdup(mibpath);
+                index->mibs[index->count].name = SEXP_string_new(mib, strlen(mib));
+                index->count++;
                 free(mib);
+        }
 
-                if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE) {
-                        FILE   *fp;
-                        SEXP_t *item;
-                        char    sysval[8192];
-                        char   *sysvals[512];
-                        long i, l;
-                        size_t s;
-
-                        dI("MIB match");
-
-                        /*
-                         * read sysctl value
-                         */
-                        fp = fopen(mibpath, "r");
-
-                        if (fp == NULL) {
-                                dE("Can't read sysctl value from \"%s\": %u, %s",
-                                   mibpath, errno, strerror(errno));
-                                goto fail_item;
-                        }
+        oval_fts_close(ofts);
+        dI("Indexed %zu sysctls.", index->count);
 
-                        l = fread(sysval, 1, sizeof sysval - 1, fp);
-
-                        if (ferror(fp)) {
-				/* Linux 4.1.0 introduced a per-NIC IPv6 stable_secret file.
-				 * The stable_secret file cannot be read until it is set,
-				 * so we skip it when it is not readable. Otherwise we collect it.
-				 */
-				if (strncmp(ofts_ent->path, ipv6_conf_path, ipv6_conf_path_len) == 0 &&
-						strcmp(ofts_ent->file, "stable_secret") == 0) {
-					dI("Skipping file %s", mibpath);
-					oval_ftsent_free(ofts_ent);
-					SEXP_free(se_mib);
-					fclose(fp);
-					continue;
-				} else {
-					dE("An error ocured when reading from \"%s\" (fp=%p): l=%ld, %u, %s",
-						mibpath, fp, l, errno, strerror(errno));
-					goto fail_item;
-				}
-                        }
+        return (index);
+}
 
-                        fclose(fp);
-
-			/* Skip empty values as sysctl tool does.
-			 * See https://bugzilla.redhat.com/show_bug.cgi?id=1473207
-			 */
-			if (l == 0) {
-				dI("Skipping file '%s' because it has no value.", mibpath);
-				oval_ftsent_free(ofts_ent);
-				SEXP_free(se_mib);
-				continue;
-			}
-
-                        /*
-                         * sanitize the value
-                         *  - only printable and whitespace chars allowed
-                         *  - remove the last '\n'
-                         */
-                        sysvals[0] = sysval;
-
-                        for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
-	                        if ((!isprint(sysval[i]) && !isspace(sysval[i]))
-	                            || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
-                                {
-                                        sysval[i] = '\0';
-                                        sysvals[++s] = sysval + i + 1;
+/*
+ * Get the index of the current scan, build it if there is none yet.
+ * The index is released with sysctl_index_put().
+ */
+static struct sysctl_index *sysctl_index_get(struct sysctl_probe *probe, SEXP_t *result)
+{
+        struct sysctl_index *index;
+
+        pthread_mutex_lock(&probe->lock);
+
+        if (probe->index != NULL && probe->index->scan != probe_scan_id()) {
+                if (--probe->index->refs == 0)
+                        sysctl_index_free(probe->index);
+                probe->index = NULL;
+        }
+
+        if (probe->index == NULL)
+                probe->index = sysctl_index_build(result);
+
+        index = probe->index;
+
+        if (index != NULL)
+                index->refs++;
+
+        pthread_mutex_unlock(&probe->lock);
+
+        return (index);
+}
+
+static void sysctl_index_put(struct sysctl_probe *probe, struct sysctl_index *index)
+{
+        pthread_mutex_lock(&probe->lock);
+
+        if (--index->refs == 0)
+                sysctl_index_free(index);
+
+        pthread_mutex_unlock(&probe->lock);
+}
+
+static bool sysctl_path_listed(char **paths, size_t count, const char *path)
+{
+        size_t i;
+
+        for (i = 0; i < count; ++i)
+                if (strcmp(paths[i], path) == 0)
+                        return (true);
+
+        return (false);
+}
+
+/*
+ * Is the resolved path of the file below PROC_SYS_DIR?
+ */
+static bool sysctl_path_inside(const char *path)
+{
+        char real[PATH_MAX];
+
+        if (realpath(path, real) == NULL)
+                return (false);
+
+        return (strncmp(real, PROC_SYS_DIR "/", strlen(PROC_SYS_DIR) + 1) == 0);
+}
+
+/*
+ * Find the files which have the MIB name mib below the directory dir.
+ * Names of sysctl directories may contain dots (e.g. net.ipv4.conf.eth0.100
+ * for the eth0.100 interface), so every dot is tried as a separator.
+ * Components made only of dots ("." and "..") would leave the directory
+ * and are never tried.
+ */
+static void sysctl_resolve(const char *dir, const char *mib, int level, char ***paths, size_t *count)
+{
+        const char *dot;
+        char path[PATH_MAX];
+        struct stat st;
+        int len;
+
+        for (dot = mib; ; ++dot) {
+                if (*dot != '.' && *dot != '\0')
+                        continue;
+
+                if (dot > mib && memchr(mib, '/', dot - mib) == NULL
+                    && strspn(mib, ".") < (size_t)(dot - mib)) {
+                        len = snprintf(path, sizeof path, "%s/%.*s", dir, (int)(dot - mib), mib);
+
+                        if (len > 0 && (size_t)len < sizeof path && stat(path, &st) == 0) {
+                                if (*dot == '\0') {
+                                        if (!S_ISDIR(st.st_mode) && sysctl_readable(path, &st)
+                                            && sysctl_path_inside(path)
+                                            && !sysctl_path_listed(*paths, *count, path)) {
+                                                *paths = realloc(*paths, (*count + 1) * sizeof(char *));
+                                                (*paths)[(*count)++] = strdup(path);
+                                        }
+                                } else if (S_ISDIR(st.st_mode) && level <= PROC_SYS_MAXDEPTH) {
+                                        sysctl_resolve(path, dot + 1, level + 1, paths, count);
                                 }
                         }
+                }
 
-                        if (sysval[l - 1] == '\n')
-                                sysval[l - 1] = '\0';
-                        else
-                                sysval[l] = '\0';
-
-                        if (strlen(sysvals[s]) == 0)
-                                sysvals[s] = NULL;
-                        else
-                                sysvals[++s] = NULL;
-
-                        if (over_cmp >= 0) {
-	                        /* Only in OVAL 5.10 and above */
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING_M, sysvals,
-	                                                 NULL);
-                        } else {
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING, sysval,
-	                                                 NULL);
-                        }
+                if (*dot == '\0')
+                        break;
+        }
+}
 
-                        goto add_item;
-                fail_item:
-                        if (fp != NULL)
-                                fclose(fp);
+/*
+ * Look up the files named by the values of an "equals" name entity
+ * directly instead of walking the whole tree.
+ * @return number of files found, -1 if the values aren't strings
+ */
+static int sysctl_lookup(SEXP_t *name_entity, char ***paths)
+{
+        SEXP_t *vals, *val;
+        size_t count = 0;
+        char *mib;
+
+        *paths = NULL;
+
+        if (probe_ent_getvals(name_entity, &vals) < 0)
+                return (-1);
+
+        SEXP_list_foreach(val, vals) {
+                mib = SEXP_string_cstr(val);
+
+                if (mib == NULL) {
+                        SEXP_free(val);
+                        SEXP_free(vals);
+                        while (count > 0)
+                                free((*paths)[--count]);
+                        free(*paths);
+                        *paths = NULL;
+                        return (-1);
+                }
+
+                sysctl_resolve(PROC_SYS_DIR, mib, 1, paths, &count);
+                free(mib);
+        }
+
+        SEXP_free(vals);
+
+        return (count);
+}
+
+/*
+ * Read the value of the sysctl and collect its item.
+ * @return 0 if the item was collected or skipped
+ */
+static int sysctl_collect(probe_ctx *ctx, const char *mibpath, SEXP_t *se_mib, int over_cmp)
+{
+	const char *ipv6_conf_path = "/proc/sys/net/ipv6/conf/";
+	size_t ipv6_conf_path_len = strlen(ipv6_conf_path);
 
-                        item = probe_item_creat("sysctl_item", NULL, NULL);
-                        probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
-                add_item:
-                        probe_item_collect(ctx, item);
+        FILE   *fp;
+        SEXP_t *item;
+        char    sysval[8192];
+        char   *sysvals[512];
+        const char *file;
+        long i, l;
+        size_t s;
+
+        dI("MIB match");
+
+        /*
+         * read sysctl value
+         */
+        fp = fopen(mibpath, "r");
+
+        if (fp == NULL) {
+                dE("Can't read sysctl value from \"%s\": %u, %s",
+                   mibpath, errno, strerror(errno));
+                goto fail_item;
+        }
+
+        l = fread(sysval, 1, sizeof sysval - 1, fp);
+
+        if (ferror(fp)) {
+		/* Linux 4.1.0 introduced a per-NIC IPv6 stable_secret file.
+		 * The stable_secret file cannot be read until it is set,
+		 * so we skip it when it is not readable. Otherwise we collect it.
+		 */
+		file = strrchr(mibpath, '/') + 1;
+
+		if (strncmp(mibpath, ipv6_conf_path, ipv6_conf_path_len) == 0 &&
+				strcmp(file, "stable_secret") == 0) {
+			dI("Skipping file %s", mibpath);
+			fclose(fp);
+			return (0);
+		} else {
+			dE("An error ocured when reading from \"%s\" (fp=%p): l=%ld, %u, %s",
+				mibpath, fp, l, errno, strerror(errno));
+			goto fail_item;
+		}
+        }
+
+        fclose(fp);
+
+	/* Skip empty values as sysctl tool does.
+	 * See https://bugzilla.redhat.com/show_bug.cgi?id=1473207
+	 */
+	if (l == 0) {
+		dI("Skipping file '%s' because it has no value.", mibpath);
+		return (0);
+	}
+
+        /*
+         * sanitize the value
+         *  - only printable and whitespace chars allowed
+         *  - remove the last '\n'
+         */
+        sysvals[0] = sysval;
+
+        for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
+                if ((!isprint(sysval[i]) && !isspace(sysval[i]))
+                    || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
+                {
+                        sysval[i] = '\0';
+                        sysvals[++s] = sysval + i + 1;
                 }
+        }
 
-                oval_ftsent_free(ofts_ent);
-                SEXP_free(se_mib);
+        if (sysval[l - 1] == '\n')
+                sysval[l - 1] = '\0';
+        else
+                sysval[l] = '\0';
+
+        if (strlen(sysvals[s]) == 0)
+                sysvals[s] = NULL;
+        else
+                sysvals[++s] = NULL;
+
+        if (over_cmp >= 0) {
+                /* Only in OVAL 5.10 and above */
+                item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+                                         "name",  OVAL_DATATYPE_SEXP,   se_mib,
+                                         "value", OVAL_DATATYPE_STRING_M, sysvals,
+                                         NULL);
+        } else {
+                item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+                                         "name",  OVAL_DATATYPE_SEXP,   se_mib,
+                                         "value", OVAL_DATATYPE_STRING, sysval,
+                                         NULL);
         }
 
-        oval_fts_close(ofts);
-	SEXP_vfree(path_entity, filename_entity, bh_entity, name_entity);
+        goto add_item;
+fail_item:
+        if (fp != NULL)
+                fclose(fp);
+
+        item = probe_item_creat("sysctl_item", NULL, NULL);
+        probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
+add_item:
+        probe_item_collect(ctx, item);
+
+        return (0);
+}
+
+void *probe_init(void)
+{
+        pthread_mutex_init(&__sysctl_probe.lock, NULL);
+        __sysctl_probe.index = NULL;
+
+        return (&__sysctl_probe);
+}
+
+void probe_fini(void *arg)
+{
+        struct sysctl_probe *probe = arg;
+
+        if (probe->index != NULL)
+                sysctl_index_free(probe->index);
+
+        pthread_mutex_destroy(&probe->lock);
+}
+
+int probe_main(probe_ctx *ctx, void *probe_arg)
+{
+        struct sysctl_probe *probe = probe_arg;
+        struct sysctl_index *index;
+
+        SEXP_t *name_entity, *probe_in, *se_mib;
+        oval_schema_version_t over;
+        int over_cmp;
+        char **paths, *mib;
+        int count, i;
+        size_t j;
+
+        probe_in    = probe_ctx_getobject(ctx);
+        name_entity = probe_obj_getent(probe_in, "name", 1);
+        over        = probe_obj_get_platform_schema_version(probe_in);
+        over_cmp    = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10));
+
+        if (name_entity == NULL) {
+                dE("Missing \"name\" entity in the input object");
+                return (PROBE_ENOENT);
+        }
+
+        /*
+         * collect sysctls, use direct access for the "equals" op
+         */
+        if (probe_ent_getoperation(name_entity, OVAL_OPERATION_EQUALS) == OVAL_OPERATION_EQUALS
+            && (count = sysctl_lookup(name_entity, &paths)) >= 0) {
+                for (i = 0; i < count; ++i) {
+                        mib = sysctl_path_to_mib(paths[i]);
+                        dI("MIB: %s", mib);
+                        se_mib = SEXP_string_new(mib, strlen(mib));
+                        free(mib);
+
+                        if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE)
+                                sysctl_collect(ctx, paths[i], se_mib, over_cmp);
+
+                        SEXP_free(se_mib);
+                        free(paths[i]);
+                }
+
+                free(paths);
+                SEXP_free(name_entity);
+
+                return (0);
+        }
+
+        index = sysctl_index_get(probe, probe_ctx_getresult(ctx));
+
+        if (index == NULL) {
+                SEXP_free(name_entity);
+                return (PROBE_EFATAL);
+        }
+
+        for (j = 0; j < index->count; ++j) {
+                if (probe_entobj_cmp(name_entity, index->mibs[j].name) == OVAL_RESULT_TRUE)
+                        sysctl_collect(ctx, index->mibs[j].path, index->mibs[j].name, over_cmp);
+        }
+
+        sysctl_index_put(probe, index);
+        SEXP_free(name_entity);
 
         return (0);
 }
@@ -72,6 +72,34 @@ struct oval_definition_model* oval_agent_get_definition_model(oval_agent_session
  */
 void oval_agent_set_product_name(oval_agent_session_t *, char *);
 
+/**
+ * Set the number of threads used to collect objects when the whole
+ * definition model is evaluated. Objects which don't depend on any
+ * variable are then collected by several probes at once before the
+ * definitions are evaluated. The default (1) keeps the collection
+ * strictly sequential.
+ */
+void oval_agent_set_eval_threads(oval_agent_session_t *ag_sess, unsigned int threads);
+
+/**
+ * Reuse the objects collected by earlier sessions as long as the files
+ * they were collected from don't change, see \ref oval_probe_session_set_cache.
+ * @param ag_sess agent session
+ * @param dir cache directory, NULL disables the cache
+ * @return 0 on success, -1 if the directory can't be used
+ */
+int oval_agent_set_object_cache(oval_agent_session_t *ag_sess, const char *dir);
+
+/**
+ * Collect the objects of the given definitions which don't depend on any
+ * variable before the definitions are evaluated. It has no effect unless
+ * more threads were set by \ref oval_agent_set_eval_threads.
+ * @param ag_sess agent session
+ * @param ids IDs of definitions, NULL for all definitions of the session
+ * @return 0 on success, 1 if the collection was aborted
+ */
+int oval_agent_prefetch_definitions(oval_agent_session_t *ag_sess, struct oscap_stringlist *ids);
+
 /**
  * Probe the system and evaluate specified definition
  * @return 0 on success; -1 error; 1 warning
@@ -90,5 +90,37 @@ int oval_probe_session_sethandler(oval_probe_session_t *sess, oval_subtype_t typ
  */
 struct oval_syschar_model *oval_probe_session_getmodel(oval_probe_session_t *sess);
 
+/**
+ * Keep the probe processes running when a probe session is destroyed or
+ * reinitialized. The probes are handed over to the next probe session,
+ * which is typically created by a new OVAL agent session, instead of being
+ * started again. Before a session reuses the probes, the probes which are
+ * no longer running or don't respond are restarted and the results cached
+ * by the others are dropped. Disabling the keepalive terminates the idle
+ * probes.
+ * @param keepalive true to keep the probes running, false otherwise (default)
+ */
+void oval_probe_session_set_keepalive(bool keepalive);
+
+/**
+ * Terminate the probes kept running by the destroyed probe sessions.
+ */
+void oval_probe_session_close_idle(void);
+
+/**
+ * Keep the collected objects in a directory and reuse them in later probe
+ * sessions. A stored object is used instead of querying its probe as long
+ * as the files it was collected from (the files named by file based
+ * objects, the package database for rpminfo and dpkginfo objects) keep
+ * the same metadata. Objects of other types, objects with filters and
+ * file objects which match paths by patterns or recurse into directories
+ * are always collected.
+ * @param sess pointer to the probe session structure
+ * @param dir cache directory, created if it doesn't exist; it must be owned
+ * by the current user and not writable by others. NULL disables the cache.
+ * @return 0 on success, -1 if the directory can't be used
+ */
+int oval_probe_session_set_cache(oval_probe_session_t *sess, const char *dir);
+
 #endif /* OVAL_PROBE_SESSION */
 /// @}
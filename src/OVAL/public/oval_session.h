@@ -152,6 +152,26 @@ void oval_session_set_report_export(struct oval_session *session, const char *fi
  */
 void oval_session_set_xml_reporter(struct oval_session *session, xml_reporter fn);
 
+/**
+ * Set the number of threads used to collect the objects which don't
+ * depend on any variable before the definitions are evaluated.
+ *
+ * @memberof oval_session
+ * @param session an \ref oval_session
+ * @param threads number of threads, 1 (default) disables the parallel collection
+ */
+void oval_session_set_eval_threads(struct oval_session *session, unsigned int threads);
+
+/**
+ * Keep the collected objects in a directory and reuse them in later
+ * evaluations as long as the files they were collected from don't change.
+ *
+ * @memberof oval_session
+ * @param session an \ref oval_session
+ * @param dir cache directory, NULL (default) disables the cache
+ */
+void oval_session_set_object_cache(struct oval_session *session, const char *dir);
+
 /**
  * Load OVAL Definitions and bind OVAL Variables to it if provided. Validation
  * if performed automatically if you've set it with \ref
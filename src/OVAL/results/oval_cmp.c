@@ -34,6 +34,8 @@
 #include <sys/socket.h>
 
 #include "oval_types.h"
+#include "../oval_definitions_impl.h"
+#include "../oval_system_characteristics_impl.h"
 #include "oval_system_characteristics.h"
 #include "common/_error.h"
 #include "common/debug_priv.h"
@@ -162,3 +164,18 @@ oval_result_t oval_ent_cmp_str(char *state_data, oval_datatype_t state_data_type
 	const char *sys_data = oval_sysent_get_value(sysent);
 	return oval_str_cmp_str(state_data, state_data_type, sys_data, operation);
 }
+
+oval_result_t oval_ent_cmp_value(struct oval_value *state_value, struct oval_sysent *sysent, oval_operation_t operation)
+{
+	oval_datatype_t state_data_type = oval_value_get_datatype(state_value);
+
+	if ((state_data_type == OVAL_DATATYPE_EVR_STRING ||
+	     state_data_type == OVAL_DATATYPE_DEBIAN_EVR_STRING ||
+	     state_data_type == OVAL_DATATYPE_VERSION) &&
+	    oval_sysent_get_value(sysent) != NULL) {
+		return oval_evr_cmp(oval_value_get_evr(state_value),
+		                    oval_sysent_get_evr(sysent, state_data_type), operation);
+	}
+
+	return oval_ent_cmp_str(oval_value_get_text(state_value), state_data_type, sysent, operation);
+}
@@ -30,6 +30,9 @@
 #include <math.h>
 #include <string.h>
 #include <ctype.h>
+#if !defined(__FreeBSD__)
+#include <alloca.h>
+#endif
 #include "oval_cmp_evr_string_impl.h"
 #include "oval_definitions.h"
 #include "oval_types.h"
@@ -39,9 +42,6 @@
 #ifdef HAVE_RPMVERCMP
 #include <rpm/rpmlib.h>
 #else
-#if !defined(__FreeBSD__)
-#include <alloca.h>
-#endif
 static int rpmvercmp(const char *a, const char *b);
 static int risdigit(int c) {
 	// locale independent
@@ -49,14 +49,33 @@ static int risdigit(int c) {
 }
 #endif
 
+/*
+ * Parsed evr_string, debian_evr_string or version value. The epoch,
+ * version and release point into the copy of the evr string stored after
+ * the structure, the version fields are stored there for the version type.
+ */
+struct oval_evr {
+	oval_datatype_t datatype;
+	unsigned long serial;
+	/* the last comparison in which this value was the state */
+	unsigned long memo_serial;
+	int memo_cmp;
+	const char *epoch;
+	const char *version;
+	const char *release;
+	size_t field_count;
+	const int *fields;
+};
+
+static unsigned long oval_evr_serial = 0;
+
 static inline int rpmevrcmp(const char *a, const char *b);
 static int compare_values(const char *str1, const char *str2);
 static void parseEVR(char *evr, const char **ep, const char **vp, const char **rp);
+static int versiontype_cmp(const char *a, const char *b);
 
-oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_operation_t operation)
+static oval_result_t cmp_to_result(int result, oval_operation_t operation, const char *type)
 {
-	int result = rpmevrcmp(sys, state);
-
 	if (operation == OVAL_OPERATION_EQUALS) {
 		return ((result == 0) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
 	} else if (operation == OVAL_OPERATION_NOT_EQUAL) {
@@ -71,10 +90,17 @@ oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_opera
 		return ((result != 1) ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE);
 	}
 
-	oscap_seterr(OSCAP_EFAMILY_OVAL, "Invalid type of operation in rpm version comparison: %d.", operation);
+	oscap_seterr(OSCAP_EFAMILY_OVAL, "Invalid type of operation in %s comparison: %d.", type, operation);
 	return OVAL_RESULT_ERROR;
 }
 
+oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_operation_t operation)
+{
+	int result = rpmevrcmp(sys, state);
+
+	return cmp_to_result(result, operation, "rpm version");
+}
+
 static inline int rpmevrcmp(const char *a, const char *b)
 {
 	/* This mimics rpmevrcmp which is not exported by rpmlib version 4.
@@ -85,8 +111,9 @@ static inline int rpmevrcmp(const char *a, const char *b)
 	char *a_copy, *b_copy;
 	int result;
 
-	a_copy = oscap_strdup(a);
-	b_copy = oscap_strdup(b);
+	/* the copies are on the stack, comparisons don't allocate memory */
+	a_copy = strcpy(alloca(strlen(a) + 1), a);
+	b_copy = strcpy(alloca(strlen(b) + 1), b);
 	parseEVR(a_copy, &a_epoch, &a_version, &a_release);
 	parseEVR(b_copy, &b_epoch, &b_version, &b_release);
 
@@ -97,8 +124,6 @@ static inline int rpmevrcmp(const char *a, const char *b)
 			result = compare_values(a_release, b_release);
 	}
 
-	free(a_copy);
-	free(b_copy);
 	return result;
 }
 
@@ -155,6 +180,8 @@ static void parseEVR(char *evr, const char **ep, const char **vp, const char **r
 #ifndef HAVE_RPMVERCMP
 /*
  * code from http://rpm.org/api/4.4.2.2/rpmvercmp_8c-source.html
+ * changed to compare the segments in place instead of in copies of the
+ * versions
  */
 
 /* compare alpha and numeric segments of two versions */
@@ -163,9 +190,8 @@ static void parseEVR(char *evr, const char **ep, const char **vp, const char **r
 /*       -1: b is newer than a */
 static int rpmvercmp(const char *a, const char *b)
 {
-	char oldch1, oldch2;
-	char *str1, *str2;
-	char *one, *two;
+	const char *one, *two, *end1, *end2;
+	size_t len1, len2;
 	int rc;
 	int isnum;
 
@@ -173,17 +199,10 @@ static int rpmvercmp(const char *a, const char *b)
 	if (!strcmp(a, b))
 		return 0;
 
-	/* TODO: make new malloca */
-	str1 = alloca(strlen(a) + 1);
-	str2 = alloca(strlen(b) + 1);
-
-	strcpy(str1, a);
-	strcpy(str2, b);
-
-	one = str1;
-	two = str2;
+	one = a;
+	two = b;
 
-	/* loop through each version segment of str1 and str2 and compare them */
+	/* loop through each version segment of a and b and compare them */
 	while (*one && *two) {
 		while (*one && !isalnum(*one))
 			one++;
@@ -194,76 +213,66 @@ static int rpmvercmp(const char *a, const char *b)
 		if (!(*one && *two))
 			break;
 
-		str1 = one;
-		str2 = two;
+		end1 = one;
+		end2 = two;
 
 		/* grab first completely alpha or completely numeric segment */
 		/* leave one and two pointing to the start of the alpha or numeric */
-		/* segment and walk str1 and str2 to end of segment */
-		if (isdigit(*str1)) {
-			while (*str1 && isdigit(*str1))
-				str1++;
-			while (*str2 && isdigit(*str2))
-				str2++;
+		/* segment and walk end1 and end2 to end of segment */
+		if (isdigit(*end1)) {
+			while (*end1 && isdigit(*end1))
+				end1++;
+			while (*end2 && isdigit(*end2))
+				end2++;
 			isnum = 1;
 		} else {
-			while (*str1 && isalpha(*str1))
-				str1++;
-			while (*str2 && isalpha(*str2))
-				str2++;
+			while (*end1 && isalpha(*end1))
+				end1++;
+			while (*end2 && isalpha(*end2))
+				end2++;
 			isnum = 0;
 		}
 
-		/* save character at the end of the alpha or numeric segment */
-		/* so that they can be restored after the comparison */
-		oldch1 = *str1;
-		*str1 = '\0';
-		oldch2 = *str2;
-		*str2 = '\0';
-
 		/* this cannot happen, as we previously tested to make sure that */
 		/* the first string has a non-null segment */
-		if (one == str1)
+		if (one == end1)
 			return -1;	/* arbitrary */
 
 		/* take care of the case where the two version segments are */
 		/* different types: one numeric, the other alpha (i.e. empty) */
 		/* numeric segments are always newer than alpha segments */
 		/* result_test See patch #60884 (and details) from bugzilla #50977. */
-		if (two == str2)
+		if (two == end2)
 			return (isnum ? 1 : -1);
 
 		if (isnum) {
-			/* this used to be done by converting the digit segments */
-			/* to ints using atoi() - it's changed because long  */
-			/* digit segments can overflow an int - this should fix that. */
-
 			/* throw away any leading zeros - it's a number, right? */
-			while (*one == '0')
+			while (one < end1 && *one == '0')
 				one++;
-			while (*two == '0')
+			while (two < end2 && *two == '0')
 				two++;
 
 			/* whichever number has more digits wins */
-			if (strlen(one) > strlen(two))
+			if (end1 - one > end2 - two)
 				return 1;
-			if (strlen(two) > strlen(one))
+			if (end2 - two > end1 - one)
 				return -1;
 		}
 
-		/* strcmp will return which one is greater - even if the two */
-		/* segments are alpha or if they are numeric.  don't return  */
+		/* compare the segments like strcmp() would do - even if the */
+		/* two segments are alpha or if they are numeric. don't return */
 		/* if they are equal because there might be more segments to */
 		/* compare */
-		rc = strcmp(one, two);
+		len1 = end1 - one;
+		len2 = end2 - two;
+		rc = memcmp(one, two, len1 < len2 ? len1 : len2);
+		if (rc == 0 && len1 != len2)
+			rc = (len1 < len2) ? -1 : 1;
 		if (rc)
 			return (rc < 1 ? -1 : 1);
 
-		/* restore character that was replaced by null above */
-		*str1 = oldch1;
-		one = str1;
-		*str2 = oldch2;
-		two = str2;
+		one = end1;
+		two = end2;
 	}
 	/* this catches the case where all numeric and alpha segments have */
 	/* compared identically but the segment sepparating characters were */
@@ -279,76 +288,122 @@ static int rpmvercmp(const char *a, const char *b)
 }
 #endif
 
+/* move to the next field within the version string (if there is one) */
+static inline const char *versiontype_next_field(const char *s)
+{
+	if (*s)
+		++s;
+	while (*s && isdigit(*s))
+		++s;
+	if (*s && !isdigit(*s))
+		++s;
+	return s;
+}
+
+/*
+ * Compare the fields of two version strings, a missing field is 0.
+ * @return 1, 0 or -1 if a is greater than, equal to or less than b
+ */
+static int versiontype_cmp(const char *a, const char *b)
+{
+	// keep going as long as there is data in either of the versions
+	while (*a || *b) {
+		int a_int = atoi(a);	// look at the current data field (if we're at the end, atoi should return 0)
+		int b_int = atoi(b);
+
+		if (a_int != b_int)
+			return (a_int > b_int) ? 1 : -1;
+
+		a = versiontype_next_field(a);
+		b = versiontype_next_field(b);
+	}
+
+	return 0;
+}
 
 oval_result_t oval_versiontype_cmp(const char *state, const char *syschar, oval_operation_t operation)
 {
-	int state_idx = 0;
-	int sys_idx = 0;
-	int result = -1;
-	/* int is_equal = 1; */
-	for (state_idx = 0, sys_idx = 0; (((state[state_idx]) || (syschar[sys_idx])) && (result == -1));) {	// keep going as long as there is data in either the state or sysitem
-		int tmp_state_int, tmp_sys_int;
-		tmp_state_int = atoi(&state[state_idx]);	// look at the current data field (if we're at the end, atoi should return 0)
-		tmp_sys_int = atoi(&syschar[sys_idx]);
-                /* o rly?
-		if (tmp_state_int != tmp_sys_int)
-			is_equal = 0;	// we might need this later (if we don't terminate early)
-                */
-		if (operation == OVAL_OPERATION_EQUALS) {
-			if (tmp_state_int != tmp_sys_int)
-				return (OVAL_RESULT_FALSE);
-		} else if (operation == OVAL_OPERATION_NOT_EQUAL) {
-			if (tmp_state_int != tmp_sys_int)
-				return (OVAL_RESULT_TRUE);
-		} else if ((operation == OVAL_OPERATION_GREATER_THAN)
-			   || (operation == OVAL_OPERATION_GREATER_THAN_OR_EQUAL)) {
-			if (tmp_sys_int > tmp_state_int)
-				return (OVAL_RESULT_TRUE);
-			if (tmp_sys_int < tmp_state_int)
-				return (OVAL_RESULT_FALSE);
-		} else if ((operation == OVAL_OPERATION_LESS_THAN)
-			   || (operation == OVAL_OPERATION_LESS_THAN_OR_EQUAL)) {
-			if (tmp_sys_int < tmp_state_int)
-				return (OVAL_RESULT_TRUE);
-			if (tmp_sys_int > tmp_state_int)
-				return (OVAL_RESULT_FALSE);
-		} else {
-			oscap_seterr(OSCAP_EFAMILY_OVAL, "Invalid type of operation in version comparison: %d.", operation);
-			return OVAL_RESULT_ERROR;
-		}
+	int result = versiontype_cmp(syschar, state);
 
-		if (state[state_idx])
-			++state_idx;
-		/* move to the next field within the version string (if there is one) */
-		while ((state[state_idx]) && (isdigit(state[state_idx])))
-			++state_idx;
-		if ((state[state_idx]) && (!isdigit(state[state_idx])))
-			++state_idx;
-
-		if (syschar[sys_idx])
-			++sys_idx;
-		/* move to the next field within the version string (if there is one) */
-		while ((syschar[sys_idx]) && (isdigit(syschar[sys_idx])))
-			++sys_idx;
-		if ((syschar[sys_idx]) && (!isdigit(syschar[sys_idx])))
-			++sys_idx;
+	return cmp_to_result(result, operation, "version");
+}
+
+struct oval_evr *oval_evr_new(oval_datatype_t datatype, const char *str)
+{
+	struct oval_evr *evr;
+	size_t count = 0;
+	const char *s;
+	int *fields;
+
+	if (datatype == OVAL_DATATYPE_VERSION) {
+		for (s = str; *s; s = versiontype_next_field(s))
+			++count;
+		evr = malloc(sizeof(struct oval_evr) + count * sizeof(int));
+		fields = (int *)(evr + 1);
+		for (s = str, count = 0; *s; s = versiontype_next_field(s))
+			fields[count++] = atoi(s);
+		evr->fields = fields;
+		evr->epoch = evr->version = evr->release = NULL;
+	} else {
+		evr = malloc(sizeof(struct oval_evr) + strlen(str) + 1);
+		parseEVR(strcpy((char *)(evr + 1), str), &evr->epoch, &evr->version, &evr->release);
+		evr->fields = NULL;
 	}
 
-	// OK, we did not terminate early, and we're out of data, so we now know what to return
-	if (operation == OVAL_OPERATION_EQUALS) {
-		return (OVAL_RESULT_TRUE);
-	} else if (operation == OVAL_OPERATION_NOT_EQUAL) {
-		return (OVAL_RESULT_FALSE);
-	} else if (operation == OVAL_OPERATION_GREATER_THAN) {
-		return (OVAL_RESULT_FALSE);
-	} else if (operation == OVAL_OPERATION_GREATER_THAN_OR_EQUAL) {
-		return (OVAL_RESULT_TRUE);
-	} else if (operation == OVAL_OPERATION_LESS_THAN) {
-		return (OVAL_RESULT_FALSE);
-	} else if (operation == OVAL_OPERATION_LESS_THAN_OR_EQUAL) {
-		return (OVAL_RESULT_TRUE);
-	}		// we have already filtered out the invalid ones
-	assert(0);
-	return OVAL_RESULT_ERROR;
+	evr->datatype = datatype;
+	evr->field_count = count;
+	evr->serial = __sync_add_and_fetch(&oval_evr_serial, 1);
+	evr->memo_serial = 0;
+	evr->memo_cmp = 0;
+	return evr;
+}
+
+void oval_evr_free(struct oval_evr *evr)
+{
+	free(evr);
+}
+
+oval_datatype_t oval_evr_get_datatype(const struct oval_evr *evr)
+{
+	return evr->datatype;
+}
+
+static int oval_evr_fields_cmp(const struct oval_evr *a, const struct oval_evr *b)
+{
+	size_t i;
+
+	for (i = 0; i < a->field_count || i < b->field_count; ++i) {
+		int a_int = i < a->field_count ? a->fields[i] : 0;
+		int b_int = i < b->field_count ? b->fields[i] : 0;
+
+		if (a_int != b_int)
+			return (a_int > b_int) ? 1 : -1;
+	}
+
+	return 0;
+}
+
+oval_result_t oval_evr_cmp(struct oval_evr *state, const struct oval_evr *sys, oval_operation_t operation)
+{
+	int result;
+
+	if (state->memo_serial == sys->serial) {
+		result = state->memo_cmp;
+	} else {
+		if (state->datatype == OVAL_DATATYPE_VERSION) {
+			result = oval_evr_fields_cmp(sys, state);
+		} else {
+			result = compare_values(sys->epoch, state->epoch);
+			if (!result) {
+				result = compare_values(sys->version, state->version);
+				if (!result)
+					result = compare_values(sys->release, state->release);
+			}
+		}
+		state->memo_serial = sys->serial;
+		state->memo_cmp = result;
+	}
 
+	return cmp_to_result(result, operation,
+	                     state->datatype == OVAL_DATATYPE_VERSION ? "version" : "rpm version");
 }
@@ -50,6 +50,33 @@ oval_result_t oval_evr_string_cmp(const char *state, const char *sys, oval_opera
 
 oval_result_t oval_versiontype_cmp(const char *state, const char *syschar, oval_operation_t operation);
 
+/**
+ * Pre-parsed evr_string, debian_evr_string or version value. Parsing the
+ * value once saves the work when the same state value is compared with
+ * many items and the same item with many states.
+ */
+struct oval_evr;
+
+/**
+ * Parse a value of the given datatype.
+ * @param datatype OVAL_DATATYPE_EVR_STRING, OVAL_DATATYPE_DEBIAN_EVR_STRING or OVAL_DATATYPE_VERSION
+ * @param str the value
+ */
+struct oval_evr *oval_evr_new(oval_datatype_t datatype, const char *str);
+void oval_evr_free(struct oval_evr *evr);
+oval_datatype_t oval_evr_get_datatype(const struct oval_evr *evr);
+
+/**
+ * Compare two pre-parsed values of the same datatype, without allocating
+ * memory. The result of the last comparison is remembered by the state,
+ * comparing it with the same item again doesn't compare the values.
+ * @param state value as defined by state element
+ * @param sys value as captured from system (from syschar object)
+ * @param operation type of comparison operation
+ * @returns result of comparison
+ */
+oval_result_t oval_evr_cmp(struct oval_evr *state, const struct oval_evr *sys, oval_operation_t operation);
+
 OSCAP_HIDDEN_END;
 
 #endif
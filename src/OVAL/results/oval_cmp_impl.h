@@ -40,6 +40,18 @@ OSCAP_HIDDEN_START;
  */
 oval_result_t oval_ent_cmp_str(char *state_data, oval_datatype_t state_data_type, struct oval_sysent *sysent, oval_operation_t operation);
 
+/**
+ * Compare state entity (or variable/value) to sysent object collected from system.
+ * Values of evr_string, debian_evr_string and version datatypes are parsed only
+ * once and compared pre-parsed, other datatypes are compared as oval_ent_cmp_str() does.
+ * This function does not support @datatype="record".
+ * @param state_value Value defined within state/entity/value or variable/value
+ * @param sysent Value collected from system
+ * @operation Comparison type operation
+ * @returns OVAL Result of comparison
+ */
+oval_result_t oval_ent_cmp_value(struct oval_value *state_value, struct oval_sysent *sysent, oval_operation_t operation);
+
 /**
  * Compare state entity (or variable/value) to data collected from system.
  * This function does not support @datatype="record".
@@ -252,9 +252,36 @@ int oval_results_model_eval(struct oval_results_model *res_model)
 	return 0;
 }
 
+/*
+ * Record fields of states declare the definitions namespace on the root
+ * element when they are converted. A streamed root is written before the
+ * states are, so the declaration has to be made in advance.
+ */
+static void _oval_results_declare_record_field_ns(struct oval_definition_model *definition_model, xmlDocPtr doc)
+{
+	bool found = false;
+	struct oval_state_iterator *states = oval_definition_model_get_states(definition_model);
+	while (!found && oval_state_iterator_has_more(states)) {
+		struct oval_state *state = oval_state_iterator_next(states);
+		struct oval_state_content_iterator *contents = oval_state_get_contents(state);
+		while (!found && oval_state_content_iterator_has_more(contents)) {
+			struct oval_state_content *content = oval_state_content_iterator_next(contents);
+			struct oval_record_field_iterator *rf_itr = oval_state_content_get_record_fields(content);
+			found = oval_record_field_iterator_has_more(rf_itr);
+			oval_record_field_iterator_free(rf_itr);
+		}
+		oval_state_content_iterator_free(contents);
+	}
+	oval_state_iterator_free(states);
+
+	if (found && xmlSearchNsByHref(doc, xmlDocGetRootElement(doc), OVAL_DEFINITIONS_NAMESPACE) == NULL)
+		xmlNewNs(xmlDocGetRootElement(doc), OVAL_DEFINITIONS_NAMESPACE, BAD_CAST "oval-def");
+}
+
 static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 				    struct oval_directives_model *directives_model, 
-				    xmlDocPtr doc, xmlNode * parent)
+				    xmlDocPtr doc, xmlNode * parent,
+				    struct oscap_xml_stream *stream)
 {
 	xmlNode *root_node;
 	struct oval_result_directives * dirs;
@@ -266,6 +293,7 @@ static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 		root_node = xmlNewNode(NULL, BAD_CAST OVAL_ROOT_ELM_RESULTS);
 		xmlDocSetRootElement(doc, root_node);
 	}
+	oscap_xml_stream_open(stream, root_node);
 	xmlNewNsProp(root_node, lookup_xsi_ns(doc), BAD_CAST "schemaLocation", BAD_CAST OVAL_RES_SCHEMA_LOCATION);
 
 	xmlNs *ns_common = xmlNewNs(root_node, OVAL_COMMON_NAMESPACE, BAD_CAST "oval");
@@ -287,20 +315,42 @@ static xmlNode *oval_results_to_dom(struct oval_results_model *results_model,
 	/* Report definitions */
 	if(oval_result_directives_get_included(dirs)) {
 		struct oval_definition_model *definition_model = oval_results_model_get_definition_model(results_model);
-		oval_definition_model_to_dom(definition_model, doc, root_node);
+		if (stream != NULL)
+			_oval_results_declare_record_field_ns(definition_model, doc);
+		oval_definition_model_to_dom(definition_model, doc, root_node, stream);
 	}
 
 	xmlNode *results_node = xmlNewTextChild(root_node, ns_results, BAD_CAST "results", NULL);
+	oscap_xml_stream_open(stream, results_node);
 	struct oval_result_system_iterator *systems = oval_results_model_get_systems(results_model);
 	while (oval_result_system_iterator_has_more(systems)) {
 		struct oval_result_system *sys = oval_result_system_iterator_next(systems);
-		oval_result_system_to_dom(sys, results_model, dirs_model, doc, results_node);
+		oval_result_system_to_dom(sys, results_model, dirs_model, doc, results_node, stream);
 	}
 	oval_result_system_iterator_free(systems);
+	oscap_xml_stream_close(stream);
 
+	oscap_xml_stream_close(stream);
 	return root_node;
 }
 
+int oval_results_model_stream(struct oval_results_model *results_model,
+			      struct oval_directives_model *directives_model,
+			      struct oscap_xml_stream *stream)
+{
+	__attribute__nonnull__(results_model);
+
+	xmlDocPtr doc = xmlNewDoc(BAD_CAST "1.0");
+	if (doc == NULL) {
+		oscap_setxmlerr(xmlGetLastError());
+		return -1;
+	}
+
+	oval_results_to_dom(results_model, directives_model, doc, NULL, stream);
+	xmlFreeDoc(doc);
+	return 0;
+}
+
 struct oscap_source *oval_results_model_export_source(struct oval_results_model *results_model, struct oval_directives_model *directives_model, const char *name)
 {
 	__attribute__nonnull__(results_model);
@@ -311,7 +361,7 @@ struct oscap_source *oval_results_model_export_source(struct oval_results_model
 		return NULL;
 	}
 
-	oval_results_to_dom(results_model, directives_model, doc, NULL);
+	oval_results_to_dom(results_model, directives_model, doc, NULL, NULL);
 	return oscap_source_new_from_xmlDoc(doc, name);
 }
 
@@ -319,13 +369,16 @@ int oval_results_model_export(struct oval_results_model *results_model,
 			      struct oval_directives_model *directives_model,
 			      const char *file)
 {
-	struct oscap_source *source = oval_results_model_export_source(results_model, directives_model, file);
-	if (source == NULL) {
+	/* Results are written out as they are converted, the whole DOM is never built */
+	struct oscap_xml_stream *stream = oscap_xml_stream_new(file);
+	if (stream == NULL) {
 		return -1;
 	}
-	int ret = oscap_source_save_as(source, NULL);
-	oscap_source_free(source);
-	return ret;
+	if (oval_results_model_stream(results_model, directives_model, stream) != 0) {
+		oscap_xml_stream_free(stream);
+		return -1;
+	}
+	return oscap_xml_stream_free(stream);
 }
 
 int oval_results_model_parse(xmlTextReaderPtr reader, struct oval_parser_context *context) {
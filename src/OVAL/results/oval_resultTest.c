@@ -416,9 +416,8 @@ static inline oval_result_t _evaluate_sysent_with_variable(struct oval_syschar_m
 				ores_add_res(&var_ores, OVAL_RESULT_ERROR);
 				break;
 			}
-			oval_datatype_t state_entity_val_datatype = oval_value_get_datatype(var_val);
 
-			var_val_res = oval_ent_cmp_str(state_entity_val_text, state_entity_val_datatype, item_entity, state_entity_operation);
+			var_val_res = oval_ent_cmp_value(var_val, item_entity, state_entity_operation);
 			if (var_val_res == OVAL_RESULT_ERROR) {
 				dE("Error occured when comparing a variable '%s' value '%s' with collected item entity = '%s'",
 					oval_variable_get_id(state_entity_var), state_entity_val_text, oval_sysent_get_value(item_entity));
@@ -455,7 +454,6 @@ static inline oval_result_t _evaluate_sysent(struct oval_syschar_model *syschar_
 	} else {
 		struct oval_value *state_entity_val;
 		char *state_entity_val_text;
-		oval_datatype_t state_entity_val_datatype;
 
 		if ((state_entity_val = oval_entity_get_value(state_entity)) == NULL) {
 			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity value");
@@ -465,9 +463,8 @@ static inline oval_result_t _evaluate_sysent(struct oval_syschar_model *syschar_
 			oscap_seterr(OSCAP_EFAMILY_OVAL, "OVAL internal error: found NULL entity value text");
 			return -1;
 		}
-		state_entity_val_datatype = oval_value_get_datatype(state_entity_val);
 
-		return oval_ent_cmp_str(state_entity_val_text, state_entity_val_datatype, item_entity, state_entity_operation);
+		return oval_ent_cmp_value(state_entity_val, item_entity, state_entity_operation);
 	}
 }
 
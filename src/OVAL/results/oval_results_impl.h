@@ -43,7 +43,13 @@
 OSCAP_HIDDEN_START;
 
 int oval_result_system_parse_tag(xmlTextReaderPtr, struct oval_parser_context *, void *);
-xmlNode *oval_result_system_to_dom(struct oval_result_system *, struct oval_results_model *, struct oval_directives_model *, xmlDocPtr, xmlNode *);
+xmlNode *oval_result_system_to_dom(struct oval_result_system *, struct oval_results_model *, struct oval_directives_model *, xmlDocPtr, xmlNode *, struct oscap_xml_stream *);
+
+/**
+ * Write the results document to the stream without building its DOM. The
+ * document root is written as a child of the innermost open element, if any.
+ */
+int oval_results_model_stream(struct oval_results_model *, struct oval_directives_model *, struct oscap_xml_stream *);
 
 struct oval_result_test *oval_result_system_get_new_test(struct oval_result_system *, struct oval_test *, int variable_instance);
 
@@ -253,6 +253,26 @@ void xccdf_session_set_custom_oval_eval_fn(struct xccdf_session *session, xccdf_
  */
 bool xccdf_session_set_product_cpe(struct xccdf_session *session, const char *product_cpe);
 
+/**
+ * Set the number of threads used to collect OVAL objects which don't depend
+ * on any variable before the rules are evaluated. This function must be called
+ * before OVAL files are loaded.
+ * @memberof xccdf_session
+ * @param session XCCDF Session.
+ * @param threads Number of threads, 1 (default) disables the parallel collection.
+ */
+void xccdf_session_set_oval_eval_threads(struct xccdf_session *session, unsigned int threads);
+
+/**
+ * Keep the collected OVAL objects in a directory and reuse them in later
+ * scans as long as the files they were collected from don't change. This
+ * function must be called before OVAL files are loaded.
+ * @memberof xccdf_session
+ * @param session XCCDF Session.
+ * @param dir Cache directory, NULL (default) disables the cache.
+ */
+void xccdf_session_set_oval_object_cache(struct xccdf_session *session, const char *dir);
+
 /**
  * Set whether the System Characteristics shall be exported in result files.
  * @memberof xccdf_session
@@ -500,6 +520,19 @@ OSCAP_DEPRECATED(int xccdf_session_export_sce(struct xccdf_session *session));
  */
 int xccdf_session_export_arf(struct xccdf_session *session);
 
+/**
+ * Render the HTML report of the evaluation in memory. The report is generated
+ * from the results held by the session, nothing is written or read back from
+ * files. It is the same as the report exported to the file set by
+ * @ref xccdf_session_set_report_export. OVAL details are included when OVAL
+ * results have been exported by @ref xccdf_session_export_oval before.
+ * @memberof xccdf_session
+ * @param session XCCDF Session
+ * @returns a buffer of HTML content that should be freed by the caller,
+ * NULL on failure
+ */
+char *xccdf_session_get_html_report(struct xccdf_session *session);
+
 /**
  * Get policy_model of the session. The @ref xccdf_session_load_xccdf shall be run
  * before this to parse XCCDF file to the policy_model.
@@ -26,6 +26,7 @@
 
 #include <libgen.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <oscap.h>
@@ -47,6 +48,7 @@
 #include "DS/rds_priv.h"
 #include "DS/sds_priv.h"
 #include "OVAL/results/oval_results_impl.h"
+#include "source/validate_priv.h"
 #include "source/xslt_priv.h"
 #include "XCCDF/xccdf_impl.h"
 #include "XCCDF_POLICY/public/xccdf_policy.h"
@@ -91,8 +93,11 @@ struct xccdf_session {
 		char *product_cpe;			///< CPE of scanner product.
 		struct oscap_source* arf_report;	///< ARF report
 		struct oscap_htable *result_sources;    ///< mapping 'filepath' to oscap_source for OVAL results
+		struct oscap_htable *result_models;     ///< mapping 'filepath' to the OVAL results model exported there
 		struct oscap_htable *results_mapping;    ///< mapping OVAL filename to filepath for OVAL results
 		struct oscap_htable *arf_report_mapping;    ///< mapping OVAL filename to ARF report ID for OVAL results
+		unsigned int eval_threads;		///< Number of threads collecting OVAL objects ahead of evaluation
+		char *object_cache;			///< Directory of the persistent OVAL object cache
 	} oval;
 	struct {
 		char *arf_file;				///< Path to ARF file to export
@@ -255,6 +260,7 @@ void xccdf_session_free(struct xccdf_session *session)
 	oscap_list_free0(session->check_engine_plugins);
 	free(session->user_cpe);
 	free(session->oval.product_cpe);
+	free(session->oval.object_cache);
 	_xccdf_session_free_oval_agents(session);
 	_oval_content_resources_free(session->oval.custom_resources);
 	_oval_content_resources_free(session->oval.resources);
@@ -377,6 +383,17 @@ bool xccdf_session_set_product_cpe(struct xccdf_session *session, const char *pr
 	return true;
 }
 
+void xccdf_session_set_oval_eval_threads(struct xccdf_session *session, unsigned int threads)
+{
+	session->oval.eval_threads = threads;
+}
+
+void xccdf_session_set_oval_object_cache(struct xccdf_session *session, const char *dir)
+{
+	free(session->oval.object_cache);
+	session->oval.object_cache = oscap_strdup(dir);
+}
+
 void xccdf_session_set_without_sys_chars_export(struct xccdf_session *session, bool without_sys_chars)
 {
 	session->export.without_sys_chars = without_sys_chars;
@@ -578,7 +595,7 @@ struct ds_sds_index *xccdf_session_get_sds_idx(struct xccdf_session *session)
 	return ds_sds_session_get_sds_idx(xccdf_session_get_ds_sds_session(session));
 }
 
-int xccdf_session_load(struct xccdf_session *session)
+static int _xccdf_session_load(struct xccdf_session *session)
 {
 	int ret = 0;
 
@@ -609,6 +626,26 @@ int xccdf_session_load(struct xccdf_session *session)
 	return xccdf_session_load_tailoring(session);
 }
 
+int xccdf_session_load(struct xccdf_session *session)
+{
+	struct oscap_validation_stats before, after;
+	struct timespec start, end;
+	int ret;
+
+	oscap_validation_get_stats(&before);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	ret = _xccdf_session_load(session);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	oscap_validation_get_stats(&after);
+
+	dI("Session loaded in %.3f ms, XSD validation of %lu documents took %.3f ms of it, "
+	   "parsing of %lu schemas %.3f ms.",
+	   (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6,
+	   after.validations - before.validations, after.validation_ms - before.validation_ms,
+	   after.schema_misses - before.schema_misses, after.schema_parse_ms - before.schema_parse_ms);
+	return ret;
+}
+
 static int _reporter(const char *file, int line, const char *msg, void *arg)
 {
 	oscap_seterr(OSCAP_EFAMILY_OSCAP, "File '%s' line %d: %s", file, line, msg);
@@ -1055,6 +1092,14 @@ int xccdf_session_load_oval(struct xccdf_session *session)
 		/* store our name in the generated documents */
 		oval_agent_set_product_name(tmp_sess, session->oval.product_cpe != NULL ?
 				session->oval.product_cpe : (char *) oscap_productname);
+		oval_agent_set_eval_threads(tmp_sess, session->oval.eval_threads);
+
+		if (session->oval.object_cache != NULL &&
+		    oval_agent_set_object_cache(tmp_sess, session->oval.object_cache) != 0) {
+			oval_agent_destroy_session(tmp_sess);
+			oval_definition_model_free(tmp_def_model);
+			return 1;
+		}
 
 		/* remember sessions */
 		session->oval.agents = realloc(session->oval.agents, (idx + 2) * sizeof(struct oval_agent_session *));
@@ -1185,6 +1230,70 @@ int xccdf_session_load_tailoring(struct xccdf_session *session)
 	return xccdf_policy_model_set_tailoring(session->xccdf.policy_model, tailoring) ? 0 : 1;
 }
 
+struct _oval_prefetch {
+	struct xccdf_session *session;
+	struct oscap_stringlist **ids;		///< Definitions referenced by the policy, per OVAL agent
+	bool *all;				///< Whether all definitions of the OVAL agent are referenced
+};
+
+static bool _xccdf_session_prefetch_content_ref(const char *system_name, const char *href, const char *name, void *usr)
+{
+	struct _oval_prefetch *pf = (struct _oval_prefetch *) usr;
+
+	if (system_name == NULL || strcmp(system_name, oval_sysname) != 0)
+		return false;
+
+	for (int i = 0; pf->session->oval.agents[i]; i++) {
+		struct oval_agent_session *agent = pf->session->oval.agents[i];
+		if (href == NULL || strcmp(oval_agent_get_filename(agent), href) != 0)
+			continue;
+
+		if (name == NULL) {
+			pf->all[i] = true;
+			return true;
+		}
+		if (oval_definition_model_get_definition(oval_agent_get_definition_model(agent), name) == NULL)
+			return false;
+		oscap_stringlist_add_string(pf->ids[i], name);
+		return true;
+	}
+	return false;
+}
+
+/*
+ * Collect the OVAL objects used by the selected rules which don't depend on any
+ * variable ahead of the evaluation, several probes at once.
+ */
+static int _xccdf_session_prefetch_oval(struct xccdf_session *session, struct xccdf_policy *policy)
+{
+	int count = 0, ret = 0;
+
+	if (session->oval.eval_threads <= 1 || session->oval.agents == NULL || session->oval.user_eval_fn != NULL)
+		return 0;
+
+	while (session->oval.agents[count])
+		count++;
+
+	struct _oval_prefetch pf = {
+		.session = session,
+		.ids = malloc(count * sizeof(struct oscap_stringlist *)),
+		.all = calloc(count, sizeof(bool)),
+	};
+	for (int i = 0; i < count; i++)
+		pf.ids[i] = oscap_stringlist_new();
+
+	xccdf_policy_foreach_content_ref(policy, _xccdf_session_prefetch_content_ref, &pf);
+
+	for (int i = 0; i < count; i++) {
+		if (ret == 0)
+			ret = oval_agent_prefetch_definitions(session->oval.agents[i], pf.all[i] ? NULL : pf.ids[i]);
+		oscap_stringlist_free(pf.ids[i]);
+	}
+	free(pf.ids);
+	free(pf.all);
+	return ret;
+}
+
 int xccdf_session_evaluate(struct xccdf_session *session)
 {
 	struct xccdf_policy *policy = xccdf_session_get_xccdf_policy(session);
@@ -1194,6 +1303,9 @@ int xccdf_session_evaluate(struct xccdf_session *session)
 	}
 	policy->rule = session->rule;
 
+	if (_xccdf_session_prefetch_oval(session, policy) != 0)
+		return 1;
+
 	session->xccdf.result = xccdf_policy_evaluate(policy);
 	if (session->xccdf.result == NULL)
 		return 1;
@@ -1234,7 +1346,7 @@ static size_t _paramlist_cpy(const char **to, const char **p) {
 	return s;
 }
 
-static int _app_xslt(struct oscap_source *infile, const char *xsltfile, const char *outfile, const char **params)
+static int _app_xslt(struct oscap_source *infile, const char *xsltfile, const char *outfile, char **output, const char **params)
 {
 	char pwd[PATH_MAX];
 
@@ -1249,10 +1361,14 @@ static int _app_xslt(struct oscap_source *infile, const char *xsltfile, const ch
 	size_t s = _paramlist_cpy(par, params);
 	s += _paramlist_cpy(par + s, stdparams);
 
+	if (output != NULL) {
+		*output = oscap_source_apply_xslt_path_mem(infile, xsltfile, par, oscap_path_to_xslt());
+		return *output == NULL;
+	}
 	return oscap_source_apply_xslt_path(infile, xsltfile, outfile, par, oscap_path_to_xslt()) == -1;
 }
 
-static inline int _xccdf_gen_report(struct oscap_source *infile, const char *id, const char *outfile, const char *show, const char* sce_template, const char* profile)
+static inline int _xccdf_gen_report(struct oscap_source *infile, const char *id, const char *outfile, char **output, const char *show, const char* sce_template, const char* profile)
 {
 	const char *params[] = {
 		"result-id",		id,
@@ -1264,17 +1380,17 @@ static inline int _xccdf_gen_report(struct oscap_source *infile, const char *id,
 		"hide-profile-info",	NULL,
 		NULL};
 
-	return _app_xslt(infile, "xccdf-report.xsl", outfile, params);
+	return _app_xslt(infile, "xccdf-report.xsl", outfile, output, params);
 }
 
-static int _build_xccdf_result_source(struct xccdf_session *session)
+static int _build_xccdf_result_source(struct xccdf_session *session, bool in_memory)
 {
 	if (session->xccdf.result_source != NULL) {
 		return 0;
 	}
 
 	/* Build oscap_source of XCCDF TestResult only when needed */
-	if (session->export.xccdf_file != NULL || session->export.report_file != NULL || session->export.arf_file != NULL || session->export.xccdf_stig_viewer_file != NULL) {
+	if (in_memory || session->export.xccdf_file != NULL || session->export.report_file != NULL || session->export.arf_file != NULL || session->export.xccdf_stig_viewer_file != NULL) {
 		const struct xccdf_benchmark *benchmark = xccdf_policy_model_get_benchmark(session->xccdf.policy_model);
 
 		if (session->xccdf.result == NULL) {
@@ -1316,18 +1432,11 @@ static int _build_xccdf_result_source(struct xccdf_session *session)
 	return 0;
 }
 
-int xccdf_session_export_xccdf(struct xccdf_session *session)
+static int _xccdf_session_gen_report(struct xccdf_session *session, bool with_oval, const char *outfile, char **output)
 {
-	if (_build_xccdf_result_source(session)) {
-		return 1;
-	}
-
-	if (session->export.report_file == NULL)
-		return 0;
-
 	struct oscap_source* results = session->xccdf.result_source;
 	struct oscap_source* arf = NULL;
-	if (session->export.oval_results) {
+	if (with_oval) {
 		arf = xccdf_session_create_arf_source(session);
 		if (arf == NULL) {
 			return 1;
@@ -1335,24 +1444,63 @@ int xccdf_session_export_xccdf(struct xccdf_session *session)
 		results = arf;
 	}
 
-	/* generate report */
-	_xccdf_gen_report(results,
+	return _xccdf_gen_report(results,
 			xccdf_result_get_id(session->xccdf.result),
-			session->export.report_file,
+			outfile,
+			output,
 			"",
 			(session->export.check_engine_plugins_results ? "%.result.xml" : ""),
 			session->xccdf.profile_id == NULL ? "" : session->xccdf.profile_id
 	);
+}
+
+int xccdf_session_export_xccdf(struct xccdf_session *session)
+{
+	if (_build_xccdf_result_source(session, false)) {
+		return 1;
+	}
+
+	if (session->export.report_file == NULL)
+		return 0;
+
+	/* generate report */
+	_xccdf_session_gen_report(session, session->export.oval_results, session->export.report_file, NULL);
 
 	return 0;
 }
 
+char *xccdf_session_get_html_report(struct xccdf_session *session)
+{
+	char *report = NULL;
+
+	if (_build_xccdf_result_source(session, true)) {
+		return NULL;
+	}
+
+	/* OVAL details are available once the OVAL results have been exported */
+	bool with_oval = session->export.oval_results && session->oval.result_sources != NULL;
+	_xccdf_session_gen_report(session, with_oval, NULL, &report);
+	return report;
+}
+
+/*
+ * The HTML report of a session exporting OVAL results is generated from an
+ * ARF built in memory, which needs the DOM of the results. Otherwise results
+ * are streamed to their files and into the ARF.
+ */
+static bool _xccdf_session_needs_oval_result_dom(const struct xccdf_session *session)
+{
+	return session->export.report_file != NULL && session->export.oval_results;
+}
+
 static void _xccdf_session_free_oval_result_sources(struct xccdf_session *session)
 {
 	if (session->oval.result_sources != NULL) {
 		oscap_htable_free(session->oval.result_sources, (oscap_destruct_func) oscap_source_free);
 		session->oval.result_sources = NULL;
 	}
+	oscap_htable_free0(session->oval.result_models);
+	session->oval.result_models = NULL;
 }
 
 static char *_xccdf_session_get_unique_oval_result_filename(struct xccdf_session *session, struct oval_agent_session *oval_session, const char *oval_results_directory)
@@ -1456,11 +1604,18 @@ static char *_xccdf_session_export_oval_result_file(struct xccdf_session *sessio
 		return NULL;
 	}
 
-	struct oscap_source *source = oval_results_model_export_source(res_model, NULL, name);
+	struct oscap_source *source = NULL;
+	if (_xccdf_session_needs_oval_result_dom(session)) {
+		source = oval_results_model_export_source(res_model, NULL, name);
+	} else if (oval_results_model_export(res_model, NULL, name) == 0) {
+		/* Written right away, the DOM is built only if the file is validated */
+		source = oscap_source_new_from_file(name);
+	}
 	if (source == NULL) {
 		free(name);
 		return NULL;
 	}
+	oscap_htable_add(session->oval.result_models, name, res_model);
 	if (oscap_htable_add(session->oval.result_sources, name, source) == false) {
 		// The source is already there, but it shouldn't be
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Internal error: attempted to export file %s twice", name);
@@ -1497,6 +1652,7 @@ static int _build_oval_result_sources(struct xccdf_session *session)
 
 	/* Export OVAL results */
 	session->oval.result_sources = oscap_htable_new();
+	session->oval.result_models = oscap_htable_new();
 	session->oval.results_mapping = oscap_htable_new();
 	session->oval.arf_report_mapping = oscap_htable_new();
 	if (session->oval.agents) {
@@ -1535,7 +1691,7 @@ int xccdf_session_export_oval(struct xccdf_session *session)
 			return 1;
 		}
 		struct oscap_htable_iterator *hit = oscap_htable_iterator_new(session->oval.result_sources);
-		while (oscap_htable_iterator_has_more(hit)) {
+		while (_xccdf_session_needs_oval_result_dom(session) && oscap_htable_iterator_has_more(hit)) {
 			struct oscap_source *source = oscap_htable_iterator_next_value(hit);
 			if (oscap_source_save_as(source, NULL) != 0) {
 				oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not save file: %s", oscap_source_readable_origin(source));
@@ -1610,15 +1766,48 @@ int xccdf_session_export_sce(struct xccdf_session *session)
 	return xccdf_session_export_check_engine_plugins(session);
 }
 
+static int _xccdf_session_stream_oval_report(struct oscap_xml_stream *stream, const char *report_file, void *arg)
+{
+	struct xccdf_session *session = arg;
+	struct oval_results_model *res_model = oscap_htable_get(session->oval.result_models, report_file);
+	if (res_model == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Internal error: no OVAL results exported to %s", report_file);
+		return -1;
+	}
+	return oval_results_model_stream(res_model, NULL, stream);
+}
+
+static int _xccdf_session_stream_arf(struct xccdf_session *session)
+{
+	struct oscap_source *sds_source = NULL;
+
+	if (xccdf_session_is_sds(session)) {
+		sds_source = session->source;
+	} else {
+		xmlDocPtr sds_doc = ds_sds_compose_xmlDoc_from_xccdf_source(session->source);
+		sds_source = oscap_source_new_from_xmlDoc(sds_doc, NULL);
+	}
+
+	int ret = ds_rds_export_stream(sds_source, session->xccdf.result_source, session->oval.results_mapping, session->oval.arf_report_mapping, _xccdf_session_stream_oval_report, session, session->export.arf_file);
+	if (!xccdf_session_is_sds(session)) {
+		oscap_source_free(sds_source);
+	}
+	return ret;
+}
+
 int xccdf_session_export_arf(struct xccdf_session *session)
 {
 	if (session->export.arf_file != NULL) {
-		struct oscap_source* arf_source = xccdf_session_create_arf_source(session);
+		struct oscap_source* arf_source = session->oval.arf_report;
 		if (arf_source == NULL) {
-			return 1;
-		}
-
-		if (oscap_source_save_as(arf_source, NULL) != 0) {
+			/* Unless the ARF has already been built for the HTML report,
+			 * write it out directly; its DOM is built only for validation */
+			if (_xccdf_session_stream_arf(session) != 0) {
+				return 1;
+			}
+			arf_source = oscap_source_new_from_file(session->export.arf_file);
+			session->oval.arf_report = arf_source;
+		} else if (oscap_source_save_as(arf_source, NULL) != 0) {
 			oscap_source_free(arf_source);
 			session->oval.arf_report = NULL;
 			return 1;
@@ -1626,6 +1815,7 @@ int xccdf_session_export_arf(struct xccdf_session *session)
 		if (session->full_validation) {
 			if (oscap_source_validate(arf_source, _reporter, NULL) != 0) {
 				oscap_source_free(arf_source);
+				session->oval.arf_report = NULL;
 				return 1;
 			}
 		}
@@ -1135,6 +1135,80 @@ static int xccdf_policy_item_evaluate(struct xccdf_policy * policy, struct xccdf
     return ret;
 }
 
+static bool _xccdf_policy_check_foreach_content_ref(struct xccdf_policy *policy, const struct xccdf_check *check,
+		xccdf_policy_content_ref_fn fn, void *usr)
+{
+	if (xccdf_check_get_complex(check)) {
+		/* all children of complex-check are evaluated */
+		struct xccdf_check_iterator *child_it = xccdf_check_get_children(check);
+		while (xccdf_check_iterator_has_more(child_it))
+			_xccdf_policy_check_foreach_content_ref(policy, xccdf_check_iterator_next(child_it), fn, usr);
+		xccdf_check_iterator_free(child_it);
+		return true;
+	}
+
+	/* checks with unresolvable value bindings are not evaluated */
+	struct oscap_list *bindings = xccdf_policy_check_get_value_bindings(policy, xccdf_check_get_exports(check));
+	if (bindings == NULL) {
+		oscap_clearerr();
+		return false;
+	}
+	oscap_list_free(bindings, (oscap_destruct_func) xccdf_value_binding_free);
+
+	/* alternatives, the first one resolved by a checking engine wins */
+	bool resolved = false;
+	const char *system_name = xccdf_check_get_system(check);
+	struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(check);
+	while (!resolved && xccdf_check_content_ref_iterator_has_more(content_it)) {
+		struct xccdf_check_content_ref *content = xccdf_check_content_ref_iterator_next(content_it);
+		resolved = fn(system_name, xccdf_check_content_ref_get_href(content),
+				xccdf_check_content_ref_get_name(content), usr);
+	}
+	xccdf_check_content_ref_iterator_free(content_it);
+	return resolved;
+}
+
+static void _xccdf_policy_item_foreach_content_ref(struct xccdf_policy *policy, struct xccdf_item *item,
+		xccdf_policy_content_ref_fn fn, void *usr)
+{
+	if (xccdf_item_get_type(item) == XCCDF_GROUP) {
+		struct xccdf_item_iterator *child_it = xccdf_group_get_content((const struct xccdf_group *) item);
+		while (xccdf_item_iterator_has_more(child_it))
+			_xccdf_policy_item_foreach_content_ref(policy, xccdf_item_iterator_next(child_it), fn, usr);
+		xccdf_item_iterator_free(child_it);
+		return;
+	}
+	if (xccdf_item_get_type(item) != XCCDF_RULE)
+		return;
+
+	/* the same conditions as in _xccdf_policy_rule_evaluate */
+	const struct xccdf_rule *rule = (const struct xccdf_rule *) item;
+	const char *rule_id = xccdf_rule_get_id(rule);
+	if (policy->rule != NULL && strcmp(policy->rule, rule_id) != 0)
+		return;
+	if (!xccdf_policy_is_item_selected(policy, rule_id))
+		return;
+	struct xccdf_refine_rule_internal *r_rule = oscap_htable_get(policy->refine_rules_internal, rule_id);
+	if (xccdf_get_final_role(rule, r_rule) == XCCDF_ROLE_UNCHECKED)
+		return;
+	if (!xccdf_policy_model_item_is_applicable(policy->model, item))
+		return;
+	const struct xccdf_check *check = _xccdf_policy_rule_get_applicable_check(policy, item);
+	if (check != NULL)
+		_xccdf_policy_check_foreach_content_ref(policy, check, fn, usr);
+}
+
+void xccdf_policy_foreach_content_ref(struct xccdf_policy *policy, xccdf_policy_content_ref_fn fn, void *usr)
+{
+	__attribute__nonnull__(policy);
+
+	struct xccdf_benchmark *benchmark = xccdf_policy_model_get_benchmark(xccdf_policy_get_model(policy));
+	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+	while (xccdf_item_iterator_has_more(item_it))
+		_xccdf_policy_item_foreach_content_ref(policy, xccdf_item_iterator_next(item_it), fn, usr);
+	xccdf_item_iterator_free(item_it);
+}
+
 struct oscap_file_entry {
 	char* system_name;
 	char* file;
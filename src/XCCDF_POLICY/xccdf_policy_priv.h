@@ -110,6 +110,20 @@ int xccdf_policy_rule_result_remediate(struct xccdf_policy *policy, struct xccdf
  */
 int xccdf_policy_check_evaluate(struct xccdf_policy * policy, struct xccdf_check * check);
 
+/**
+ * Callback for \ref xccdf_policy_foreach_content_ref.
+ * @return true if the checking engine resolves the content reference,
+ * false to continue with the next alternative content reference
+ */
+typedef bool (*xccdf_policy_content_ref_fn)(const char *system_name, const char *href, const char *name, void *usr);
+
+/**
+ * Call the function for check-content-refs which evaluation of the policy
+ * will use, in the order of evaluation. Only rules which are going to be
+ * checked (selected, applicable, ...) are considered.
+ */
+void xccdf_policy_foreach_content_ref(struct xccdf_policy *policy, xccdf_policy_content_ref_fn fn, void *usr);
+
 /**
  * Remediate all rule-results in the given result, with settings of given policy.
  * @memberof xccdf_policy
@@ -0,0 +1,251 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "oscap_pcre_cache.h"
+#include "OVAL/probes/SEAP/MurmurHash3.h"
+
+#if defined(OSCAP_THREAD_SAFE)
+# include <pthread.h>
+static pthread_mutex_t pcre_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+# define PCRE_CACHE_LOCK   do { if (pthread_mutex_lock   (&pcre_cache_mutex) != 0) abort(); } while(0)
+# define PCRE_CACHE_UNLOCK do { if (pthread_mutex_unlock (&pcre_cache_mutex) != 0) abort(); } while(0)
+#else
+# define PCRE_CACHE_LOCK   while(0)
+# define PCRE_CACHE_UNLOCK while(0)
+#endif
+
+#if defined(PCRE_STUDY_JIT_COMPILE)
+# define PCRE_CACHE_STUDY_OPTIONS PCRE_STUDY_JIT_COMPILE
+# define pcre_cache_free_study(extra) pcre_free_study(extra)
+#else
+# define PCRE_CACHE_STUDY_OPTIONS 0
+# define pcre_cache_free_study(extra) pcre_free(extra)
+#endif
+
+/* number of hash chains, a power of 2 */
+#define PCRE_CACHE_BUCKETS (2 * OSCAP_PCRE_CACHE_MAX)
+
+struct oscap_pcre {
+	pcre       *re;
+	pcre_extra *extra;
+	char       *pattern;
+	int         options;
+	uint32_t    hash;
+	unsigned int refcnt; /* users + 1 while the pattern is in the cache */
+	struct oscap_pcre *next;     /* hash chain */
+	struct oscap_pcre *lru_prev; /* more recently used */
+	struct oscap_pcre *lru_next; /* less recently used */
+};
+
+static struct {
+	struct oscap_pcre *buckets[PCRE_CACHE_BUCKETS];
+	struct oscap_pcre *lru_head;
+	struct oscap_pcre *lru_tail;
+	struct oscap_pcre_cache_stats stats;
+} pcre_cache;
+
+static void oscap_pcre_free(struct oscap_pcre *regex)
+{
+	if (regex->extra != NULL)
+		pcre_cache_free_study(regex->extra);
+	pcre_free(regex->re);
+	free(regex->pattern);
+	free(regex);
+}
+
+static void pcre_cache_lru_unlink(struct oscap_pcre *regex)
+{
+	if (regex->lru_prev != NULL)
+		regex->lru_prev->lru_next = regex->lru_next;
+	else
+		pcre_cache.lru_head = regex->lru_next;
+	if (regex->lru_next != NULL)
+		regex->lru_next->lru_prev = regex->lru_prev;
+	else
+		pcre_cache.lru_tail = regex->lru_prev;
+	regex->lru_prev = regex->lru_next = NULL;
+}
+
+static void pcre_cache_lru_push(struct oscap_pcre *regex)
+{
+	regex->lru_prev = NULL;
+	regex->lru_next = pcre_cache.lru_head;
+	if (pcre_cache.lru_head != NULL)
+		pcre_cache.lru_head->lru_prev = regex;
+	else
+		pcre_cache.lru_tail = regex;
+	pcre_cache.lru_head = regex;
+}
+
+/* Remove the pattern from the cache and drop the reference of the cache. */
+static void pcre_cache_remove(struct oscap_pcre *regex)
+{
+	struct oscap_pcre **pp = &pcre_cache.buckets[regex->hash & (PCRE_CACHE_BUCKETS - 1)];
+
+	while (*pp != regex)
+		pp = &(*pp)->next;
+	*pp = regex->next;
+	regex->next = NULL;
+
+	pcre_cache_lru_unlink(regex);
+	--pcre_cache.stats.entries;
+
+	if (--regex->refcnt == 0)
+		oscap_pcre_free(regex);
+}
+
+static struct oscap_pcre *pcre_cache_lookup(const char *pattern, int options, uint32_t hash)
+{
+	struct oscap_pcre *regex;
+
+	for (regex = pcre_cache.buckets[hash & (PCRE_CACHE_BUCKETS - 1)]; regex != NULL; regex = regex->next) {
+		if (regex->hash == hash && regex->options == options &&
+		    strcmp(regex->pattern, pattern) == 0) {
+			++regex->refcnt;
+			if (regex != pcre_cache.lru_head) {
+				pcre_cache_lru_unlink(regex);
+				pcre_cache_lru_push(regex);
+			}
+			return regex;
+		}
+	}
+
+	return NULL;
+}
+
+struct oscap_pcre *oscap_pcre_cache_get(const char *pattern, int options, const char **errptr, int *erroffset)
+{
+	struct oscap_pcre *regex, *found;
+	const char *err = NULL;
+	int errofs = 0;
+	uint32_t hash;
+
+	MurmurHash3_x86_32(pattern, (int)strlen(pattern), (uint32_t)options, &hash);
+
+	PCRE_CACHE_LOCK;
+	regex = pcre_cache_lookup(pattern, options, hash);
+	if (regex != NULL)
+		++pcre_cache.stats.hits;
+	else
+		++pcre_cache.stats.misses;
+	PCRE_CACHE_UNLOCK;
+
+	if (regex != NULL)
+		return regex;
+
+	/* Compile without holding the lock, other threads may use the cache
+	   in the meantime. */
+	regex = calloc(1, sizeof(struct oscap_pcre));
+	regex->re = pcre_compile(pattern, options, &err, &errofs, NULL);
+	if (regex->re == NULL) {
+		if (errptr != NULL)
+			*errptr = err;
+		if (erroffset != NULL)
+			*erroffset = errofs;
+		free(regex);
+		return NULL;
+	}
+	regex->extra = pcre_study(regex->re, PCRE_CACHE_STUDY_OPTIONS, &err);
+	regex->pattern = strdup(pattern);
+	regex->options = options;
+	regex->hash = hash;
+	regex->refcnt = 2;
+
+	PCRE_CACHE_LOCK;
+	/* Another thread may have added the same pattern meanwhile. */
+	found = pcre_cache_lookup(pattern, options, hash);
+	if (found == NULL) {
+		struct oscap_pcre **bucket = &pcre_cache.buckets[hash & (PCRE_CACHE_BUCKETS - 1)];
+
+		regex->next = *bucket;
+		*bucket = regex;
+		pcre_cache_lru_push(regex);
+		if (++pcre_cache.stats.entries > OSCAP_PCRE_CACHE_MAX) {
+			pcre_cache_remove(pcre_cache.lru_tail);
+			++pcre_cache.stats.evictions;
+		}
+	}
+	PCRE_CACHE_UNLOCK;
+
+	if (found != NULL) {
+		oscap_pcre_free(regex);
+		regex = found;
+	}
+
+	return regex;
+}
+
+void oscap_pcre_cache_put(struct oscap_pcre *regex)
+{
+	bool release;
+
+	if (regex == NULL)
+		return;
+
+	PCRE_CACHE_LOCK;
+	release = (--regex->refcnt == 0);
+	PCRE_CACHE_UNLOCK;
+
+	if (release)
+		oscap_pcre_free(regex);
+}
+
+int oscap_pcre_exec(const struct oscap_pcre *regex, const char *subject, int length,
+                    int startoffset, int options, int *ovector, int ovecsize)
+{
+	int ret;
+
+	ret = pcre_exec(regex->re, regex->extra, subject, length, startoffset, options, ovector, ovecsize);
+#if defined(PCRE_ERROR_JIT_STACKLIMIT)
+	/* The JIT code runs out of its default stack on deeply recursive
+	   patterns, the interpreter doesn't have that limit. */
+	if (ret == PCRE_ERROR_JIT_STACKLIMIT)
+		ret = pcre_exec(regex->re, NULL, subject, length, startoffset, options, ovector, ovecsize);
+#endif
+	return ret;
+}
+
+int oscap_pcre_fullinfo(const struct oscap_pcre *regex, int what, void *where)
+{
+	return pcre_fullinfo(regex->re, regex->extra, what, where);
+}
+
+void oscap_pcre_cache_get_stats(struct oscap_pcre_cache_stats *stats)
+{
+	PCRE_CACHE_LOCK;
+	*stats = pcre_cache.stats;
+	PCRE_CACHE_UNLOCK;
+}
+
+void oscap_pcre_cache_clear(void)
+{
+	PCRE_CACHE_LOCK;
+	while (pcre_cache.lru_head != NULL)
+		pcre_cache_remove(pcre_cache.lru_head);
+	memset(&pcre_cache.stats, 0, sizeof pcre_cache.stats);
+	PCRE_CACHE_UNLOCK;
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef OSCAP_PCRE_CACHE_H_
+#define OSCAP_PCRE_CACHE_H_
+
+#include <stddef.h>
+#include <pcre.h>
+#include "util.h"
+
+OSCAP_HIDDEN_START;
+
+/*
+ * Process-wide cache of compiled PCRE patterns keyed by the pattern and
+ * the compile options. Patterns are studied (JIT compiled where PCRE
+ * supports it) once, when they are added. The least recently used
+ * patterns are evicted when the cache is full. A pattern stays valid
+ * until it is released by everyone who got it, even when it is evicted
+ * in the meantime. All functions are thread-safe.
+ */
+
+/** Maximal number of patterns kept in the cache */
+#define OSCAP_PCRE_CACHE_MAX 1024
+
+struct oscap_pcre;
+
+struct oscap_pcre_cache_stats {
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long evictions;
+	size_t entries;
+};
+
+/**
+ * Get a compiled pattern from the cache, compile it on a miss.
+ * @param pattern the regular expression
+ * @param options pcre_compile() options
+ * @param errptr set to the error message on failure, may be NULL
+ * @param erroffset set to the offset of the error on failure, may be NULL
+ * @return the compiled pattern, release it by oscap_pcre_cache_put(),
+ *         or NULL if the pattern can't be compiled
+ */
+struct oscap_pcre *oscap_pcre_cache_get(const char *pattern, int options, const char **errptr, int *erroffset);
+
+/**
+ * Release a pattern obtained by oscap_pcre_cache_get().
+ */
+void oscap_pcre_cache_put(struct oscap_pcre *regex);
+
+/**
+ * pcre_exec() with the compiled pattern and its study data.
+ */
+int oscap_pcre_exec(const struct oscap_pcre *regex, const char *subject, int length,
+                    int startoffset, int options, int *ovector, int ovecsize);
+
+/**
+ * pcre_fullinfo() of the compiled pattern.
+ */
+int oscap_pcre_fullinfo(const struct oscap_pcre *regex, int what, void *where);
+
+/**
+ * Get the number of hits, misses and evictions since the last
+ * oscap_pcre_cache_clear() and the number of cached patterns.
+ */
+void oscap_pcre_cache_get_stats(struct oscap_pcre_cache_stats *stats);
+
+/**
+ * Drop all patterns from the cache and reset the statistics.
+ */
+void oscap_pcre_cache_clear(void);
+
+OSCAP_HIDDEN_END;
+
+#endif /* OSCAP_PCRE_CACHE_H_ */
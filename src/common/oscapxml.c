@@ -45,6 +45,7 @@
 #include "debug_priv.h"
 #include "oscap_source.h"
 #include "oscapxml.h"
+#include "oscap_pcre_cache.h"
 #include "source/schematron_priv.h"
 #include "source/validate_priv.h"
 #include "source/xslt_priv.h"
@@ -109,7 +110,25 @@ void oscap_init(void)
 
 void oscap_cleanup(void)
 {
+	struct oscap_pcre_cache_stats pcre_stats;
+	struct oscap_validation_stats validation_stats;
+	struct oscap_xslt_stats xslt_stats;
+
 	oscap_clearerr();
+	oscap_pcre_cache_get_stats(&pcre_stats);
+	dI("PCRE cache: %lu hits, %lu misses, %lu evictions.",
+	   pcre_stats.hits, pcre_stats.misses, pcre_stats.evictions);
+	oscap_pcre_cache_clear();
+	oscap_validation_get_stats(&validation_stats);
+	dI("XSD validation: %lu documents in %.3f ms, %lu schemas parsed in %.3f ms, %lu reused.",
+	   validation_stats.validations, validation_stats.validation_ms,
+	   validation_stats.schema_misses, validation_stats.schema_parse_ms, validation_stats.schema_hits);
+	oscap_schema_cache_clear();
+	oscap_xslt_get_stats(&xslt_stats);
+	dI("XSLT: %lu transformations in %.3f ms, %lu stylesheets compiled in %.3f ms, %lu reused.",
+	   xslt_stats.transformations, xslt_stats.transform_ms,
+	   xslt_stats.stylesheet_misses, xslt_stats.parse_ms, xslt_stats.stylesheet_hits);
+	oscap_xslt_cache_clear();
 	xsltCleanupGlobals();
 	xmlCleanupParser();
 }
@@ -134,6 +134,20 @@ typedef int (*xml_reporter)(const char *file, int line, const char *msg, void *a
  */
 OSCAP_DEPRECATED(int oscap_validate_document(const char *xmlfile, oscap_document_type_t doctype, const char *version, xml_reporter reporter, void *arg));
 
+/**
+ * Parse XML schemas of SCAP documents in advance.
+ *
+ * Parsed schemas are kept until @ref oscap_cleanup and used by all the
+ * following validations, the schema of each document type and version is
+ * parsed only once. The schemas are parsed on the first validation if this
+ * function isn't called, long running applications can call it at the start.
+ *
+ * @param doctype Document type, OSCAP_DOCUMENT_UNKNOWN for all document types.
+ * @param version Version of the document, NULL for all versions.
+ * @return 0 on success; -1 if there is no such schema or it can't be parsed
+ */
+int oscap_schema_cache_warm(oscap_document_type_t doctype, const char *version);
+
 /**
  * Validate a SCAP document file against schematron rules.
  *
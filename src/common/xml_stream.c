@@ -0,0 +1,265 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <libxml/xmlsave.h>
+
+#include "_error.h"
+#include "debug_priv.h"
+#include "xml_stream.h"
+
+/* libxml2 doesn't indent deeper than 60 characters */
+#define XML_STREAM_INDENT "                                                            "
+#define XML_STREAM_INDENT_MAX 30
+
+struct oscap_xml_stream_elm {
+	xmlNode *node;
+	xmlNode *written;	///< last child already written, kept in the tree
+	bool started;		///< has the start tag been written?
+};
+
+struct oscap_xml_stream {
+	xmlOutputBuffer *out;
+	int fd;
+	struct oscap_xml_stream_elm *stack;
+	size_t depth;
+	size_t size;
+	bool error;
+};
+
+static void _write(struct oscap_xml_stream *stream, const char *data, size_t len)
+{
+	if (stream->error)
+		return;
+	if (len > 0 && xmlOutputBufferWrite(stream->out, len, data) < 0) {
+		oscap_setxmlerr(xmlGetLastError());
+		stream->error = true;
+	}
+}
+
+static void _write_indent(struct oscap_xml_stream *stream, size_t level)
+{
+	if (level > XML_STREAM_INDENT_MAX)
+		level = XML_STREAM_INDENT_MAX;
+	_write(stream, XML_STREAM_INDENT, 2 * level);
+}
+
+/*
+ * Serialize the node alone (without its children); the result ends with "/>".
+ */
+static xmlOutputBuffer *_dump_empty(xmlNode *node)
+{
+	xmlOutputBuffer *buf = xmlAllocOutputBuffer(NULL);
+	if (buf == NULL)
+		return NULL;
+
+	xmlNode *children = node->children;
+	xmlNode *last = node->last;
+	node->children = node->last = NULL;
+	xmlNodeDumpOutput(buf, node->doc, node, 0, 1, "UTF-8");
+	node->children = children;
+	node->last = last;
+	return buf;
+}
+
+static void _write_start_tag(struct oscap_xml_stream *stream, struct oscap_xml_stream_elm *elm, size_t level)
+{
+	xmlOutputBuffer *buf = _dump_empty(elm->node);
+	if (buf == NULL) {
+		stream->error = true;
+		return;
+	}
+	const char *tag = (const char *) xmlOutputBufferGetContent(buf);
+	size_t len = xmlOutputBufferGetSize(buf);
+	if (len < 2 || memcmp(tag + len - 2, "/>", 2) != 0) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Unexpected serialization of element '%s'.", elm->node->name);
+		stream->error = true;
+	} else {
+		_write_indent(stream, level);
+		_write(stream, tag, len - 2);
+		_write(stream, ">\n", 2);
+	}
+	xmlOutputBufferClose(buf);
+	elm->started = true;
+}
+
+static void _write_empty(struct oscap_xml_stream *stream, xmlNode *node, size_t level)
+{
+	xmlOutputBuffer *buf = _dump_empty(node);
+	if (buf == NULL) {
+		stream->error = true;
+		return;
+	}
+	_write_indent(stream, level);
+	_write(stream, (const char *) xmlOutputBufferGetContent(buf), xmlOutputBufferGetSize(buf));
+	_write(stream, "\n", 1);
+	xmlOutputBufferClose(buf);
+}
+
+static void _write_end_tag(struct oscap_xml_stream *stream, xmlNode *node, size_t level)
+{
+	_write_indent(stream, level);
+	_write(stream, "</", 2);
+	if (node->ns != NULL && node->ns->prefix != NULL) {
+		_write(stream, (const char *) node->ns->prefix, strlen((const char *) node->ns->prefix));
+		_write(stream, ":", 1);
+	}
+	_write(stream, (const char *) node->name, strlen((const char *) node->name));
+	_write(stream, ">\n", 2);
+}
+
+/*
+ * Write and free the children of the open element at the given position
+ * of the stack, up to the stop node (exclusive).
+ */
+static void _flush(struct oscap_xml_stream *stream, size_t pos, xmlNode *stop)
+{
+	struct oscap_xml_stream_elm *elm = &stream->stack[pos];
+	xmlNode *child = elm->written != NULL ? elm->written->next : elm->node->children;
+
+	while (child != NULL && child != stop) {
+		xmlNode *next = child->next;
+
+		if (!elm->started)
+			_write_start_tag(stream, elm, pos);
+		if (!stream->error) {
+			_write_indent(stream, pos + 1);
+			xmlNodeDumpOutput(stream->out, child->doc, child, pos + 1, 1, "UTF-8");
+			_write(stream, "\n", 1);
+		}
+		xmlUnlinkNode(child);
+		xmlFreeNode(child);
+		child = next;
+	}
+}
+
+struct oscap_xml_stream *oscap_xml_stream_new(const char *filename)
+{
+	xmlOutputBuffer *out;
+	int fd = -1;
+
+	if (strcmp(filename, "-") == 0) {
+		out = xmlOutputBufferCreateFile(stdout, NULL);
+	} else {
+		fd = open(filename, O_CREAT|O_TRUNC|O_WRONLY,
+				S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
+		if (fd < 0) {
+			oscap_seterr(OSCAP_EFAMILY_GLIBC, "%s '%s'", strerror(errno), filename);
+			return NULL;
+		}
+		out = xmlOutputBufferCreateFd(fd, NULL);
+	}
+	if (out == NULL) {
+		if (fd >= 0)
+			close(fd);
+		oscap_setxmlerr(xmlGetLastError());
+		dW("xmlOutputBufferCreateFile() failed.");
+		return NULL;
+	}
+
+	struct oscap_xml_stream *stream = calloc(1, sizeof(struct oscap_xml_stream));
+	stream->out = out;
+	stream->fd = fd;
+	_write(stream, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n", 39);
+	return stream;
+}
+
+int oscap_xml_stream_free(struct oscap_xml_stream *stream)
+{
+	if (stream == NULL)
+		return -1;
+
+	if (stream->depth > 0) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Element '%s' has not been closed.",
+				stream->stack[stream->depth - 1].node->name);
+		stream->error = true;
+	}
+	if (xmlOutputBufferClose(stream->out) < 0 && !stream->error) {
+		oscap_setxmlerr(xmlGetLastError());
+		stream->error = true;
+	}
+	if (stream->fd >= 0)
+		close(stream->fd);
+
+	int ret = stream->error ? -1 : 0;
+	free(stream->stack);
+	free(stream);
+	return ret;
+}
+
+void oscap_xml_stream_open(struct oscap_xml_stream *stream, xmlNode *node)
+{
+	if (stream == NULL)
+		return;
+
+	if (stream->depth > 0) {
+		size_t pos = stream->depth - 1;
+		_flush(stream, pos, node);
+		if (!stream->stack[pos].started)
+			_write_start_tag(stream, &stream->stack[pos], pos);
+	}
+
+	if (stream->depth == stream->size) {
+		stream->size = stream->size ? 2 * stream->size : 8;
+		stream->stack = realloc(stream->stack, stream->size * sizeof(struct oscap_xml_stream_elm));
+	}
+	struct oscap_xml_stream_elm *elm = &stream->stack[stream->depth++];
+	elm->node = node;
+	elm->written = NULL;
+	elm->started = false;
+}
+
+void oscap_xml_stream_flush(struct oscap_xml_stream *stream)
+{
+	if (stream == NULL || stream->depth == 0)
+		return;
+
+	_flush(stream, stream->depth - 1, NULL);
+}
+
+void oscap_xml_stream_close(struct oscap_xml_stream *stream)
+{
+	if (stream == NULL || stream->depth == 0)
+		return;
+
+	size_t pos = stream->depth - 1;
+	struct oscap_xml_stream_elm *elm = &stream->stack[pos];
+
+	_flush(stream, pos, NULL);
+	if (elm->started)
+		_write_end_tag(stream, elm->node, pos);
+	else
+		_write_empty(stream, elm->node, pos);
+
+	/* The element may come from another document than its parent */
+	if (pos > 0 && elm->node->parent == stream->stack[pos - 1].node)
+		stream->stack[pos - 1].written = elm->node;
+	stream->depth--;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#pragma once
+#ifndef _OSCAP_XML_STREAM_H
+#define _OSCAP_XML_STREAM_H
+
+#include "util.h"
+#include <libxml/tree.h>
+
+OSCAP_HIDDEN_START;
+
+/**
+ * Stream writing an XML document to a file while it is being built.
+ *
+ * The document is built in a scratch xmlDoc the usual way. Elements which
+ * may get many children are opened on the stream; children appended to the
+ * innermost open element are written out and freed whenever the stream is
+ * flushed, so only the open elements and the children not flushed yet are
+ * kept in memory. The output is the same as the one of xmlSaveFormatFileTo()
+ * with the UTF-8 encoding would be for the whole document.
+ *
+ * All the functions taking a stream do nothing if the stream is NULL, so the
+ * same code can build a complete DOM or stream it.
+ */
+struct oscap_xml_stream;
+
+/**
+ * Create a stream writing to a file and write the XML declaration.
+ * @param filename path of the file, "-" stands for standard output
+ * @returns the stream or NULL if the file can't be opened
+ */
+struct oscap_xml_stream *oscap_xml_stream_new(const char *filename);
+
+/**
+ * Finish writing and close the file. All the opened elements must be
+ * closed before.
+ * @returns 0 on success, -1 if anything could not be written
+ */
+int oscap_xml_stream_free(struct oscap_xml_stream *stream);
+
+/**
+ * Open an element. The element must be the root of the scratch document or
+ * the last child of the innermost open element. Its start tag is written
+ * lazily, attributes and namespace declarations may be added to the element
+ * until one of its children is flushed.
+ */
+void oscap_xml_stream_open(struct oscap_xml_stream *stream, xmlNode *node);
+
+/**
+ * Write out and free the children of the innermost open element.
+ */
+void oscap_xml_stream_flush(struct oscap_xml_stream *stream);
+
+/**
+ * Flush and close the innermost open element. The element itself is kept
+ * (without children) in the scratch document.
+ */
+void oscap_xml_stream_close(struct oscap_xml_stream *stream);
+
+OSCAP_HIDDEN_END;
+
+#endif
@@ -26,9 +26,16 @@
 #include <libxml/xmlerror.h>
 #include <libxml/xmlschemas.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
+#if defined(OSCAP_THREAD_SAFE)
+#include <pthread.h>
+#endif
 
 #include "common/_error.h"
+#include "common/debug_priv.h"
+#include "common/list.h"
+#include "common/oscap_timing.h"
 #include "common/util.h"
 #include "oscap.h"
 #include "oscap_source.h"
@@ -78,13 +85,94 @@ static void oscap_xml_validity_handler(void *user, xmlErrorPtr error)
 	context->reporter(file, error->line, error->message, context->arg);
 }
 
+/*
+ * Parsed schemas are kept for the life of the process (until oscap_cleanup())
+ * and shared by all validations, keyed by the path of the schema file which
+ * contains the version of the schema. Parsed schemas are read-only, only
+ * the validation contexts are per validation.
+ */
+static struct oscap_htable *schema_cache = NULL;
+static struct oscap_validation_stats validation_stats;
+
+#if defined(OSCAP_THREAD_SAFE)
+static pthread_mutex_t schema_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+# define SCHEMA_CACHE_LOCK   do { if (pthread_mutex_lock   (&schema_cache_mutex) != 0) abort(); } while(0)
+# define SCHEMA_CACHE_UNLOCK do { if (pthread_mutex_unlock (&schema_cache_mutex) != 0) abort(); } while(0)
+#else
+# define SCHEMA_CACHE_LOCK   while(0)
+# define SCHEMA_CACHE_UNLOCK while(0)
+#endif
+
+static xmlSchemaPtr oscap_schema_cache_get(const char *schemapath, struct ctxt *context)
+{
+	xmlSchemaParserCtxtPtr parser_ctxt;
+	xmlSchemaPtr schema, cached;
+	struct timespec start;
+
+	SCHEMA_CACHE_LOCK;
+	schema = schema_cache != NULL ? oscap_htable_get(schema_cache, schemapath) : NULL;
+	if (schema != NULL)
+		++validation_stats.schema_hits;
+	SCHEMA_CACHE_UNLOCK;
+	if (schema != NULL)
+		return schema;
+
+	/* the schemas are parsed outside of the lock, it takes long */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	parser_ctxt = xmlSchemaNewParserCtxt(schemapath);
+	if (parser_ctxt == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Could not create parser context for validation");
+		return NULL;
+	}
+
+	xmlSchemaSetParserStructuredErrors(parser_ctxt, oscap_xml_validity_handler, context);
+
+	schema = xmlSchemaParse(parser_ctxt);
+	xmlSchemaFreeParserCtxt(parser_ctxt);
+	if (schema == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Could not parse XML schema");
+		return NULL;
+	}
+
+	SCHEMA_CACHE_LOCK;
+	++validation_stats.schema_misses;
+	validation_stats.schema_parse_ms += oscap_elapsed_ms(&start);
+	if (schema_cache == NULL)
+		schema_cache = oscap_htable_new();
+	/* another thread may have parsed the same schema in the meantime */
+	cached = oscap_htable_get(schema_cache, schemapath);
+	if (cached == NULL)
+		oscap_htable_add(schema_cache, schemapath, schema);
+	SCHEMA_CACHE_UNLOCK;
+
+	if (cached != NULL) {
+		xmlSchemaFree(schema);
+		schema = cached;
+	}
+	return schema;
+}
+
+static char *oscap_schema_path(const char *schemafile, struct oscap_source *source)
+{
+	char *schemapath = oscap_sprintf("%s%s%s", oscap_path_to_schemas(), "/", schemafile);
+
+	if (access(schemapath, R_OK)) {
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Schema file '%s' not found in path '%s' when trying to validate '%s'",
+				schemafile, oscap_path_to_schemas(),
+				source != NULL ? oscap_source_readable_origin(source) : "nothing");
+		free(schemapath);
+		return NULL;
+	}
+	return schemapath;
+}
+
 static inline int oscap_validate_xml(struct oscap_source *source, const char *schemafile, xml_reporter reporter, void *arg)
 {
 	int result = -1;
-	xmlSchemaParserCtxtPtr parser_ctxt = NULL;
 	xmlSchemaPtr schema = NULL;
 	xmlSchemaValidCtxtPtr ctxt = NULL;
 	xmlDocPtr doc = NULL;
+	struct timespec start;
 
 	struct ctxt context = { reporter, arg, (void*) oscap_source_readable_origin(source)};
 
@@ -93,27 +181,15 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 		return -1;
 	}
 
-	char * schemapath = oscap_sprintf("%s%s%s", oscap_path_to_schemas(), "/", schemafile);
-	if (access(schemapath, R_OK)) {
-		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Schema file '%s' not found in path '%s' when trying to validate '%s'",
-				schemafile, oscap_path_to_schemas(), oscap_source_readable_origin(source));
-		goto cleanup;
-	}
-
-	parser_ctxt = xmlSchemaNewParserCtxt(schemapath);
-	if (parser_ctxt == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_XML, "Could not create parser context for validation");
+	char *schemapath = oscap_schema_path(schemafile, source);
+	if (schemapath == NULL)
 		goto cleanup;
-	}
-
-	xmlSchemaSetParserStructuredErrors(parser_ctxt, oscap_xml_validity_handler, &context);
 
-	schema = xmlSchemaParse(parser_ctxt);
-	if (schema == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_XML, "Could not parse XML schema");
+	schema = oscap_schema_cache_get(schemapath, &context);
+	if (schema == NULL)
 		goto cleanup;
-	}
 
+	clock_gettime(CLOCK_MONOTONIC, &start);
 	ctxt = xmlSchemaNewValidCtxt(schema);
 	if (ctxt == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_XML, "Could not create validation context");
@@ -140,13 +216,14 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 	 *	oscap_setxmlerr(xmlGetLastError());
 	*/
 
+	SCHEMA_CACHE_LOCK;
+	++validation_stats.validations;
+	validation_stats.validation_ms += oscap_elapsed_ms(&start);
+	SCHEMA_CACHE_UNLOCK;
+
 cleanup:
 	if (ctxt)
 		xmlSchemaFreeValidCtxt(ctxt);
-	if (schema)
-		xmlSchemaFree(schema);
-	if (parser_ctxt)
-		xmlSchemaFreeParserCtxt(parser_ctxt);
 	free(schemapath);
 
 	return result;
@@ -249,3 +326,46 @@ int oscap_source_validate_priv(struct oscap_source *source, oscap_document_type_
 	oscap_seterr(OSCAP_EFAMILY_OSCAP, "Schema file not found when trying to validate '%s'", oscap_source_readable_origin(source));
 	return -1;
 }
+
+int oscap_schema_cache_warm(oscap_document_type_t doctype, const char *version)
+{
+	int ret = -1;
+
+	for (struct oscap_schema_table_entry *entry = OSCAP_SCHEMAS_TABLE; entry->doc_type != 0; ++entry) {
+		if (doctype != OSCAP_DOCUMENT_UNKNOWN && entry->doc_type != doctype)
+			continue;
+		if (version != NULL && strcmp(entry->schema_version, version))
+			continue;
+
+		struct ctxt context = { NULL, NULL, NULL };
+		char *schemapath = oscap_schema_path(entry->schema_path, NULL);
+		if (schemapath == NULL || oscap_schema_cache_get(schemapath, &context) == NULL) {
+			free(schemapath);
+			return -1;
+		}
+		free(schemapath);
+		ret = 0;
+	}
+
+	if (ret != 0)
+		oscap_seterr(OSCAP_EFAMILY_OSCAP, "No schema of %s (%s) documents",
+				oscap_document_type_to_string(doctype), version != NULL ? version : "any version");
+	return ret;
+}
+
+void oscap_validation_get_stats(struct oscap_validation_stats *stats)
+{
+	SCHEMA_CACHE_LOCK;
+	*stats = validation_stats;
+	SCHEMA_CACHE_UNLOCK;
+}
+
+void oscap_schema_cache_clear(void)
+{
+	SCHEMA_CACHE_LOCK;
+	if (schema_cache != NULL)
+		oscap_htable_free(schema_cache, (oscap_destruct_func) xmlSchemaFree);
+	schema_cache = NULL;
+	memset(&validation_stats, 0, sizeof(validation_stats));
+	SCHEMA_CACHE_UNLOCK;
+}
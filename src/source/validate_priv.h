@@ -43,5 +43,23 @@ struct oscap_schema_table_entry {
  */
 int oscap_source_validate_priv(struct oscap_source *source, oscap_document_type_t doc_type, const char *version, xml_reporter reporter, void *user);
 
+/**
+ * Counters of the XSD validations since the last oscap_schema_cache_clear()
+ */
+struct oscap_validation_stats {
+	unsigned long validations;	///< number of validated documents
+	unsigned long schema_hits;	///< validations which used an already parsed schema
+	unsigned long schema_misses;	///< schemas which had to be parsed
+	double schema_parse_ms;		///< time spent by parsing of the schemas
+	double validation_ms;		///< time spent by validation of the documents
+};
+
+void oscap_validation_get_stats(struct oscap_validation_stats *stats);
+
+/**
+ * Free the parsed schemas and reset the counters
+ */
+void oscap_schema_cache_clear(void);
+
 OSCAP_HIDDEN_END;
 #endif
@@ -29,9 +29,17 @@
 #include <libxslt/xsltutils.h>
 #include <libexslt/exslt.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
+#if defined(OSCAP_THREAD_SAFE)
+#include <pthread.h>
+#endif
 
 #include "common/_error.h"
+#include "common/debug_priv.h"
+#include "common/list.h"
+#include "common/oscap_timing.h"
 #include "common/util.h"
 #include "oscap.h"
 #include "oscap_source.h"
@@ -75,6 +83,165 @@ static int xccdf_ns_xslt_workaround(xmlDocPtr doc, xmlNodePtr node)
 	return 0;
 }
 
+/*
+ * Compiled stylesheets are kept for the life of the process (until
+ * oscap_cleanup()) and shared by all transformations, keyed by the path of
+ * the stylesheet file. Compiled stylesheets are read-only, only the
+ * transformation contexts are per transformation. A stylesheet is compiled
+ * again when its file or one of the files it imports or includes (e.g.
+ * xccdf-report-impl.xsl) changes; the replaced one may still be in use by
+ * another thread, so it is kept until the cache is cleared.
+ */
+struct xslt_cache_file {
+	char *path;
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	struct timespec mtime;
+};
+
+struct xslt_cache_entry {
+	xsltStylesheet *stylesheet;
+	struct xslt_cache_file *files; /* the stylesheet file first */
+	size_t file_count;
+};
+
+static struct oscap_htable *xslt_cache = NULL;
+static struct oscap_list *xslt_retired = NULL;
+static struct oscap_xslt_stats xslt_stats;
+
+#if defined(OSCAP_THREAD_SAFE)
+static pthread_mutex_t xslt_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+# define XSLT_CACHE_LOCK   do { if (pthread_mutex_lock   (&xslt_cache_mutex) != 0) abort(); } while(0)
+# define XSLT_CACHE_UNLOCK do { if (pthread_mutex_unlock (&xslt_cache_mutex) != 0) abort(); } while(0)
+#else
+# define XSLT_CACHE_LOCK   while(0)
+# define XSLT_CACHE_UNLOCK while(0)
+#endif
+
+static bool xslt_cache_file_current(const struct xslt_cache_file *file, const struct stat *st)
+{
+	return file->dev == st->st_dev && file->ino == st->st_ino && file->size == st->st_size &&
+		file->mtime.tv_sec == st->st_mtim.tv_sec && file->mtime.tv_nsec == st->st_mtim.tv_nsec;
+}
+
+/* @a st is the stat of the stylesheet file, the imported and included files are checked here */
+static bool xslt_cache_entry_current(const struct xslt_cache_entry *entry, const struct stat *st)
+{
+	struct stat file_st;
+
+	if (!xslt_cache_file_current(entry->files, st))
+		return false;
+
+	for (size_t i = 1; i < entry->file_count; ++i) {
+		if (stat(entry->files[i].path, &file_st) != 0 ||
+		    !xslt_cache_file_current(entry->files + i, &file_st))
+			return false;
+	}
+
+	return true;
+}
+
+static void xslt_cache_entry_add_file(struct xslt_cache_entry *entry, const char *path, const struct stat *st)
+{
+	struct stat file_st;
+	struct xslt_cache_file *file;
+
+	if (path == NULL)
+		return;
+	for (size_t i = 0; i < entry->file_count; ++i) {
+		if (strcmp(entry->files[i].path, path) == 0)
+			return;
+	}
+	/* documents which aren't local files can't be checked */
+	if (st == NULL) {
+		if (stat(path, &file_st) != 0)
+			return;
+		st = &file_st;
+	}
+
+	entry->files = realloc(entry->files, (entry->file_count + 1) * sizeof(struct xslt_cache_file));
+	file = entry->files + entry->file_count++;
+	file->path = strdup(path);
+	file->dev = st->st_dev;
+	file->ino = st->st_ino;
+	file->size = st->st_size;
+	file->mtime = st->st_mtim;
+}
+
+/* adds the files the stylesheet imports or includes, recursively */
+static void xslt_cache_entry_add_imports(struct xslt_cache_entry *entry, xsltStylesheet *stylesheet)
+{
+	if (stylesheet->doc != NULL)
+		xslt_cache_entry_add_file(entry, (const char *)stylesheet->doc->URL, NULL);
+	for (xsltDocument *include = stylesheet->docList; include != NULL; include = include->next) {
+		if (include->doc != NULL)
+			xslt_cache_entry_add_file(entry, (const char *)include->doc->URL, NULL);
+	}
+	for (xsltStylesheet *import = stylesheet->imports; import != NULL; import = import->next)
+		xslt_cache_entry_add_imports(entry, import);
+}
+
+static void xslt_cache_entry_free(struct xslt_cache_entry *entry)
+{
+	if (entry != NULL) {
+		xsltFreeStylesheet(entry->stylesheet);
+		for (size_t i = 0; i < entry->file_count; ++i)
+			free(entry->files[i].path);
+		free(entry->files);
+		free(entry);
+	}
+}
+
+static xsltStylesheet *xslt_cache_get(const char *xsltpath, const struct stat *st)
+{
+	struct xslt_cache_entry *entry, *cached;
+	xsltStylesheet *stylesheet = NULL;
+	struct timespec start;
+
+	XSLT_CACHE_LOCK;
+	entry = xslt_cache != NULL ? oscap_htable_get(xslt_cache, xsltpath) : NULL;
+	if (entry != NULL && xslt_cache_entry_current(entry, st)) {
+		++xslt_stats.stylesheet_hits;
+		stylesheet = entry->stylesheet;
+	}
+	XSLT_CACHE_UNLOCK;
+	if (stylesheet != NULL)
+		return stylesheet;
+
+	/* the stylesheets are compiled outside of the lock, it takes long */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	stylesheet = xsltParseStylesheetFile(BAD_CAST xsltpath);
+	if (stylesheet == NULL)
+		return NULL;
+
+	entry = calloc(1, sizeof(struct xslt_cache_entry));
+	entry->stylesheet = stylesheet;
+	xslt_cache_entry_add_file(entry, xsltpath, st);
+	xslt_cache_entry_add_imports(entry, stylesheet);
+
+	XSLT_CACHE_LOCK;
+	++xslt_stats.stylesheet_misses;
+	xslt_stats.parse_ms += oscap_elapsed_ms(&start);
+	if (xslt_cache == NULL)
+		xslt_cache = oscap_htable_new();
+	/* another thread may have compiled the same stylesheet in the meantime */
+	cached = oscap_htable_get(xslt_cache, xsltpath);
+	if (cached != NULL && xslt_cache_entry_current(cached, st)) {
+		xslt_cache_entry_free(entry);
+		stylesheet = cached->stylesheet;
+	} else {
+		if (cached != NULL) {
+			if (xslt_retired == NULL)
+				xslt_retired = oscap_list_new();
+			oscap_list_add(xslt_retired, oscap_htable_detach(xslt_cache, xsltpath));
+		}
+		oscap_htable_add(xslt_cache, xsltpath, entry);
+	}
+	XSLT_CACHE_UNLOCK;
+	return stylesheet;
+}
+
 static inline int save_stylesheet_result_to_file(xmlDoc *resulting_doc, xsltStylesheet *stylesheet, const char *outfile)
 {
 	FILE *f = NULL;
@@ -117,9 +284,10 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 
 	/* is it an absolute path? */
 	char *xsltpath;
+	struct stat st;
 	if (strstr(xsltfile, "/") == xsltfile) {
 		xsltpath = strdup(xsltfile);
-		if (access(xsltpath, R_OK)) {
+		if (access(xsltpath, R_OK) || stat(xsltpath, &st)) {
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "XSLT file '%s' not found when trying to transform '%s'",
 				xsltfile, oscap_source_readable_origin(source));
 			free(xsltpath);
@@ -128,7 +296,7 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 	}
 	else {
 		xsltpath = oscap_sprintf("%s%s%s", path_to_xslt, "/", xsltfile);
-		if (access(xsltpath, R_OK)) {
+		if (access(xsltpath, R_OK) || stat(xsltpath, &st)) {
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "XSLT file '%s' not found in path '%s' when trying to transform '%s'",
 				xsltfile, path_to_xslt, oscap_source_readable_origin(source));
 			free(xsltpath);
@@ -141,7 +309,7 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 			ns_workaround = true;
 	}
 
-	*stylesheet = xsltParseStylesheetFile(BAD_CAST xsltpath);
+	*stylesheet = xslt_cache_get(xsltpath, &st);
 	if (*stylesheet == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not parse XSLT file '%s'", xsltpath);
 		free(xsltpath);
@@ -153,7 +321,6 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Had problems employing XCCDF XSLT namespace workaround for XML document '%s'",
 				oscap_source_readable_origin(source));
 			free(xsltpath);
-			xsltFreeStylesheet(*stylesheet);
 			*stylesheet = NULL;
 			return NULL;
 		}
@@ -164,6 +331,8 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 		if (params[i+1]) args[i+1] = oscap_sprintf("'%s'", params[i+1]);
 	}
 
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
 	xmlDoc *transformed = xsltApplyStylesheet(*stylesheet, doc, (const char **) args);
 	for (size_t i = 0; args[i]; i += 2) {
 		free(args[i+1]);
@@ -172,10 +341,16 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not apply XSLT %s to XML file: %s", xsltpath,
 			oscap_source_readable_origin(source));
 		free(xsltpath);
-		xsltFreeStylesheet(*stylesheet);
 		*stylesheet = NULL;
 		return NULL;
 	}
+	double transform_ms = oscap_elapsed_ms(&start);
+	dI("Applied XSLT %s to '%s' in %.3f ms.", xsltpath, oscap_source_readable_origin(source), transform_ms);
+
+	XSLT_CACHE_LOCK;
+	++xslt_stats.transformations;
+	xslt_stats.transform_ms += transform_ms;
+	XSLT_CACHE_UNLOCK;
 	free(xsltpath);
 	return transformed;
 
@@ -189,7 +364,6 @@ int oscap_source_apply_xslt_path(struct oscap_source *source, const char *xsltfi
 		return -1;
 	}
 	int ret = save_stylesheet_result_to_file(transformed, stylesheet, outfile);
-	xsltFreeStylesheet(stylesheet);
 	xmlFreeDoc(transformed);
 	return ret;
 }
@@ -209,5 +383,25 @@ char *oscap_source_apply_xslt_path_mem(struct oscap_source *source, const char *
 		free(result);
 		result = NULL;
 	}
+	xmlFreeDoc(transformed);
 	return (char *)result;
 }
+
+void oscap_xslt_get_stats(struct oscap_xslt_stats *stats)
+{
+	XSLT_CACHE_LOCK;
+	*stats = xslt_stats;
+	XSLT_CACHE_UNLOCK;
+}
+
+void oscap_xslt_cache_clear(void)
+{
+	XSLT_CACHE_LOCK;
+	if (xslt_cache != NULL)
+		oscap_htable_free(xslt_cache, (oscap_destruct_func) xslt_cache_entry_free);
+	xslt_cache = NULL;
+	oscap_list_free(xslt_retired, (oscap_destruct_func) xslt_cache_entry_free);
+	xslt_retired = NULL;
+	memset(&xslt_stats, 0, sizeof(xslt_stats));
+	XSLT_CACHE_UNLOCK;
+}
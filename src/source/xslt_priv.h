@@ -56,5 +56,23 @@ int oscap_source_apply_xslt_path(struct oscap_source *source, const char *xsltfi
  */
 char *oscap_source_apply_xslt_path_mem(struct oscap_source *source, const char *xsltfile, const char **params, const char *path_to_xslt);
 
+/**
+ * Counters of the XSL transformations since the last oscap_xslt_cache_clear()
+ */
+struct oscap_xslt_stats {
+	unsigned long transformations;		///< number of transformed documents
+	unsigned long stylesheet_hits;		///< transformations which used an already compiled stylesheet
+	unsigned long stylesheet_misses;	///< stylesheets which had to be compiled
+	double parse_ms;			///< time spent by compiling of the stylesheets
+	double transform_ms;			///< time spent by the transformations
+};
+
+void oscap_xslt_get_stats(struct oscap_xslt_stats *stats);
+
+/**
+ * Free the compiled stylesheets and reset the counters
+ */
+void oscap_xslt_cache_clear(void);
+
 OSCAP_HIDDEN_END;
 #endif
@@ -20,14 +20,35 @@ function test_api_oval_definition {
     ./test_api_oval ${srcdir}/scap-rhel5-oval.xml
 }
 
+function test_api_oval_iterators {
+    ./test_api_oval_iterators ${srcdir}/scap-rhel5-oval.xml 20
+}
+
+function test_api_oval_string_map {
+    ./test_api_oval_string_map 20000 ${srcdir}/scap-rhel5-oval.xml
+}
+
+function test_api_oval_pcre_cache {
+    ./test_api_oval_pcre_cache 50000
+}
+
+function test_api_oval_evr {
+    ./test_api_oval_evr 3000
+}
+
+function test_api_oval_components {
+    ./test_api_oval_components 20000
+}
+
 function test_api_oval_syschar {
     ./test_api_syschar $srcdir/composed-oval.xml \
 	$srcdir/system-characteristics.xml
 }
 
 function test_api_oval_results {
-    ./test_api_results $srcdir/results.xml exported-results.xml
+    ./test_api_results $srcdir/results.xml exported-results.xml exported-results-dom.xml
     cmp $srcdir/results-good.xml exported-results.xml
+    cmp exported-results-dom.xml exported-results.xml
 }
 
 function test_api_oval_directives {
@@ -41,6 +62,11 @@ test_init "test_api_oval.log"
 
 if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "test_api_oval_definition" test_api_oval_definition
+    test_run "test_api_oval_iterators" test_api_oval_iterators
+    test_run "test_api_oval_string_map" test_api_oval_string_map
+    test_run "test_api_oval_pcre_cache" test_api_oval_pcre_cache
+    test_run "test_api_oval_evr" test_api_oval_evr
+    test_run "test_api_oval_components" test_api_oval_components
     test_run "test_api_oval_syschar" test_api_oval_syschar
     test_run "test_api_oval_results" test_api_oval_results
     test_run "test_api_oval_directives" test_api_oval_directives
@@ -0,0 +1,214 @@
+/*
+ * Test and benchmark of the string functions of local variables.
+ *
+ * Evaluates regex_capture, unique, split, substring and concat functions
+ * over a constant variable with the given number of values, checks the
+ * results and reports the average time of every function.
+ *
+ * Usage: test_api_oval_components [values]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <oval_definitions.h>
+#include <oval_system_characteristics.h>
+#include "common/oscap_timing.h"
+
+#define ROUNDS 5
+
+static struct oval_definition_model *model;
+static struct oval_syschar_model *sysmod;
+static struct oval_variable *input;
+static struct oval_variable *letters;
+
+static struct oval_component *varref_new(struct oval_variable *variable)
+{
+	struct oval_component *component = oval_component_new(model, OVAL_COMPONENT_VARREF);
+
+	oval_component_set_variable(component, variable);
+	return component;
+}
+
+static struct oval_component *literal_new(char *text)
+{
+	struct oval_component *component = oval_component_new(model, OVAL_COMPONENT_LITERAL);
+
+	oval_component_set_literal_value(component, oval_value_new(OVAL_DATATYPE_STRING, text));
+	return component;
+}
+
+static struct oval_component *function_new(oval_component_type_t type, struct oval_component *arg)
+{
+	struct oval_component *component = oval_component_new(model, type);
+
+	oval_component_add_function_component(component, arg);
+	return component;
+}
+
+static struct oval_component *regex_capture_new(void)
+{
+	struct oval_component *component = function_new(OVAL_FUNCTION_REGEX_CAPTURE, varref_new(input));
+
+	oval_component_set_regex_pattern(component, "^key([0-9]+)=");
+	return component;
+}
+
+static struct oval_component *unique_new(void)
+{
+	struct oval_component *component = function_new(OVAL_FUNCTION_UNIQUE, varref_new(input));
+
+	/* every value twice */
+	oval_component_add_function_component(component, varref_new(input));
+	return component;
+}
+
+static struct oval_component *split_new(void)
+{
+	struct oval_component *component = function_new(OVAL_FUNCTION_SPLIT, varref_new(input));
+
+	oval_component_set_split_delimiter(component, "=");
+	return component;
+}
+
+static struct oval_component *substring_new(void)
+{
+	struct oval_component *component = function_new(OVAL_FUNCTION_SUBSTRING, varref_new(input));
+
+	oval_component_set_substring_start(component, 4);
+	oval_component_set_substring_length(component, 6);
+	return component;
+}
+
+static struct oval_component *concat_new(void)
+{
+	struct oval_component *component = function_new(OVAL_FUNCTION_CONCAT, varref_new(input));
+
+	oval_component_add_function_component(component, literal_new("/"));
+	oval_component_add_function_component(component, varref_new(letters));
+	return component;
+}
+
+/*
+ * Check the values of a local variable, the expected values are generated
+ * by a printf format from the index of the value.
+ */
+typedef void (*expect_func)(char *buf, size_t size, size_t index);
+
+static size_t values;
+
+static void expect_capture(char *buf, size_t size, size_t i)
+{
+	snprintf(buf, size, "%06zu", i);
+}
+
+static void expect_unique(char *buf, size_t size, size_t i)
+{
+	snprintf(buf, size, "key%06zu=val%zu", i, i % (values / 4));
+}
+
+static void expect_split(char *buf, size_t size, size_t i)
+{
+	if (i % 2)
+		snprintf(buf, size, "val%zu", i / 2 % (values / 4));
+	else
+		snprintf(buf, size, "key%06zu", i / 2);
+}
+
+static void expect_substring(char *buf, size_t size, size_t i)
+{
+	snprintf(buf, size, "%06zu", i);
+}
+
+static void expect_concat(char *buf, size_t size, size_t i)
+{
+	/* the values of the first component rotate the fastest */
+	snprintf(buf, size, "key%06zu=val%zu/%c", i % values, i % values % (values / 4),
+		 (char) ('a' + i / values));
+}
+
+static int check(const char *name, struct oval_component *(*component_new)(void),
+		 expect_func expect, size_t expected)
+{
+	double total = 0;
+	int ret = 0;
+
+	for (int r = 0; r < ROUNDS && ret == 0; ++r) {
+		static int id = 100;
+		struct oval_variable *variable;
+		struct timespec start;
+		size_t count = 0;
+		char buf[128];
+
+		/* the model owns the variable */
+		snprintf(buf, sizeof(buf), "oval:x:var:%d", id++);
+		variable = oval_variable_new(model, buf, OVAL_VARIABLE_LOCAL);
+
+		oval_variable_set_datatype(variable, OVAL_DATATYPE_STRING);
+		oval_variable_set_component(variable, component_new());
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		oval_syschar_model_compute_variable(sysmod, variable);
+		total += oscap_elapsed_ms(&start);
+
+		struct oval_value_iterator *vals = oval_variable_get_values(variable);
+		while (vals != NULL && oval_value_iterator_has_more(vals)) {
+			char *text = oval_value_get_text(oval_value_iterator_next(vals));
+			expect(buf, sizeof(buf), count);
+			if (strcmp(text, buf) != 0) {
+				fprintf(stderr, "%s: value %zu is '%s', expected '%s'\n", name, count, text, buf);
+				ret = 1;
+				break;
+			}
+			count++;
+		}
+		oval_value_iterator_free(vals);
+		if (ret == 0 && count != expected) {
+			fprintf(stderr, "%s: %zu values, expected %zu\n", name, count, expected);
+			ret = 1;
+		}
+	}
+	printf("%-16s %zu values: %.3f ms\n", name, expected, total / ROUNDS);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = 0;
+	char buf[64];
+
+	values = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+	if (values < 4)
+		values = 4;
+
+	model = oval_definition_model_new();
+	sysmod = oval_syschar_model_new(model);
+
+	/* the values are unique, the part after '=' repeats four times */
+	input = oval_variable_new(model, "oval:x:var:1", OVAL_VARIABLE_CONSTANT);
+	oval_variable_set_datatype(input, OVAL_DATATYPE_STRING);
+	for (size_t i = 0; i < values; ++i) {
+		snprintf(buf, sizeof(buf), "key%06zu=val%zu", i, i % (values / 4));
+		oval_variable_add_value(input, oval_value_new(OVAL_DATATYPE_STRING, buf));
+	}
+	letters = oval_variable_new(model, "oval:x:var:2", OVAL_VARIABLE_CONSTANT);
+	oval_variable_set_datatype(letters, OVAL_DATATYPE_STRING);
+	oval_variable_add_value(letters, oval_value_new(OVAL_DATATYPE_STRING, "a"));
+	oval_variable_add_value(letters, oval_value_new(OVAL_DATATYPE_STRING, "b"));
+	oval_variable_add_value(letters, oval_value_new(OVAL_DATATYPE_STRING, "c"));
+
+	ret |= check("regex_capture", regex_capture_new, expect_capture, values);
+	ret |= check("unique", unique_new, expect_unique, values);
+	ret |= check("split", split_new, expect_split, 2 * values);
+	ret |= check("substring", substring_new, expect_substring, values);
+	ret |= check("concat", concat_new, expect_concat, 3 * values);
+
+	oval_syschar_model_free(sysmod);
+	oval_definition_model_free(model);
+	return ret;
+}
@@ -0,0 +1,418 @@
+/*
+ * Benchmark of the evr_string and version comparisons in the evaluation
+ * of a vendor patch feed.
+ *
+ * Generates definitions in the form of the Red Hat security advisories
+ * (rpminfo tests with 'less than' evr_string states and 'greater than or
+ * equal' version states) and a system characteristics document with the
+ * installed packages, evaluates the definitions several times and checks
+ * the result of each definition. Then compares the evr_string values of
+ * the states with the installed versions directly, as strings and
+ * pre-parsed. Real content can be evaluated instead:
+ *
+ * Usage: test_api_oval_evr [definitions]
+ *        test_api_oval_evr --feed <oval-definitions.xml> <system-characteristics.xml>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "oval_agent_api.h"
+#include "oval_definitions.h"
+#include "oval_system_characteristics.h"
+#include "oval_results.h"
+#include "oscap.h"
+#include "oscap_error.h"
+#include "oscap_source.h"
+#include "results/oval_cmp_evr_string_impl.h"
+#include "common/oscap_timing.h"
+
+#define ROUNDS 3
+#define PACKAGES 500
+#define CRITERIA 5
+#define CASES 7
+
+#define NS_DEF "xmlns=\"http://oval.mitre.org/XMLSchema/oval-definitions-5\" " \
+	"xmlns:oval=\"http://oval.mitre.org/XMLSchema/oval-common-5\" " \
+	"xmlns:lin-def=\"http://oval.mitre.org/XMLSchema/oval-definitions-5#linux\""
+#define NS_SYS "xmlns=\"http://oval.mitre.org/XMLSchema/oval-system-characteristics-5\" " \
+	"xmlns:oval=\"http://oval.mitre.org/XMLSchema/oval-common-5\" " \
+	"xmlns:lin-sys=\"http://oval.mitre.org/XMLSchema/oval-system-characteristics-5#linux\""
+#define GENERATOR "<generator><oval:schema_version>5.10</oval:schema_version>" \
+	"<oval:timestamp>2017-01-01T00:00:00</oval:timestamp></generator>"
+
+/* installed version of the package */
+static void package_evr(int p, int *epoch, int *major, int *minor, int *release)
+{
+	*epoch = p % 3;
+	*major = 1 + p % 5;
+	*minor = p % 17;
+	*release = 10 + p % 23;
+}
+
+/*
+ * Write the evr_string state of the criterion, each case compares the
+ * installed version with another part of the evr changed.
+ * @return whether the installed package is 'less than' the state
+ */
+static int state_evr(FILE *f, int p, int c)
+{
+	int epoch, major, minor, release;
+
+	package_evr(p, &epoch, &major, &minor, &release);
+	switch (c) {
+	case 0:	/* the same version */
+		fprintf(f, "%d:%d.%d.%d-%d.el7", epoch, major, minor, p, release);
+		return 0;
+	case 1:	/* newer release */
+		fprintf(f, "%d:%d.%d.%d-%d.el7", epoch, major, minor, p, release + 1);
+		return 1;
+	case 2:	/* older version */
+		fprintf(f, "%d:%d.%d.%d-%d.el7", epoch, major - 1, minor, p, release + 1);
+		return 0;
+	case 3:	/* newer epoch */
+		fprintf(f, "%d:%d.%d.%d-%d.el7", epoch + 1, major - 1, minor, p, release);
+		return 1;
+	case 4:	/* one more release segment */
+		fprintf(f, "%d:%d.%d.%d-%d.el7.1", epoch, major, minor, p, release);
+		return 1;
+	case 5:	/* alphabetic suffix */
+		fprintf(f, "%d:%d.%d.%d-%d.el7_4a", epoch, major, minor, p, release);
+		return 1;
+	default:	/* leading zeros */
+		fprintf(f, "%d:%d.%03d.%d-%d.el7", epoch, major, minor, p, release);
+		return 0;
+	}
+}
+
+static void generate_definitions(FILE *f, int count, int *expected)
+{
+	int d, c;
+
+	fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<oval_definitions " NS_DEF ">" GENERATOR "<definitions>\n");
+	for (d = 0; d < count; ++d) {
+		/* odd definitions are vulnerable if any package is older */
+		int any = d % 2;
+
+		expected[d] = !any;
+		fprintf(f, "<definition id=\"oval:com.example:def:%d\" version=\"1\" class=\"patch\">"
+		        "<metadata><title>EXSA-%d</title><description/></metadata><criteria operator=\"AND\">"
+		        "<criterion test_ref=\"oval:com.example:tst:v%d\"/><criteria operator=\"%s\">",
+		        d, d, d % PACKAGES, any ? "OR" : "AND");
+		for (c = 0; c < CRITERIA; ++c)
+			fprintf(f, "<criterion test_ref=\"oval:com.example:tst:%d\"/>", d * CRITERIA + c);
+		fprintf(f, "</criteria></criteria></definition>\n");
+	}
+
+	fprintf(f, "</definitions><tests>\n");
+	for (d = 0; d < count * CRITERIA; ++d)
+		fprintf(f, "<lin-def:rpminfo_test id=\"oval:com.example:tst:%d\" version=\"1\" check=\"at least one\">"
+		        "<lin-def:object object_ref=\"oval:com.example:obj:%d\"/>"
+		        "<lin-def:state state_ref=\"oval:com.example:ste:%d\"/></lin-def:rpminfo_test>\n",
+		        d, (d * 7) % PACKAGES, d);
+	for (d = 0; d < PACKAGES && d < count; ++d)
+		fprintf(f, "<lin-def:rpminfo_test id=\"oval:com.example:tst:v%d\" version=\"1\" check=\"at least one\">"
+		        "<lin-def:object object_ref=\"oval:com.example:obj:%d\"/>"
+		        "<lin-def:state state_ref=\"oval:com.example:ste:v%d\"/></lin-def:rpminfo_test>\n",
+		        d, d, d);
+
+	fprintf(f, "</tests><objects>\n");
+	for (d = 0; d < PACKAGES; ++d)
+		fprintf(f, "<lin-def:rpminfo_object id=\"oval:com.example:obj:%d\" version=\"1\">"
+		        "<lin-def:name>package%d</lin-def:name></lin-def:rpminfo_object>\n", d, d);
+
+	fprintf(f, "</objects><states>\n");
+	for (d = 0; d < count * CRITERIA; ++d) {
+		int older;
+
+		fprintf(f, "<lin-def:rpminfo_state id=\"oval:com.example:ste:%d\" version=\"1\">"
+		        "<lin-def:evr datatype=\"evr_string\" operation=\"less than\">", d);
+		older = state_evr(f, (d * 7) % PACKAGES, (d / 3 + d) % CASES);
+		fprintf(f, "</lin-def:evr></lin-def:rpminfo_state>\n");
+
+		if (d / CRITERIA % 2)
+			expected[d / CRITERIA] |= older;
+		else
+			expected[d / CRITERIA] &= older;
+	}
+	for (d = 0; d < PACKAGES && d < count; ++d) {
+		int epoch, major, minor, release;
+
+		/* the version is at least major.minor, definitions of every third package don't apply */
+		package_evr(d, &epoch, &major, &minor, &release);
+		fprintf(f, "<lin-def:rpminfo_state id=\"oval:com.example:ste:v%d\" version=\"1\">"
+		        "<lin-def:version datatype=\"version\" operation=\"greater than or equal\">%d.%d</lin-def:version>"
+		        "</lin-def:rpminfo_state>\n", d, major, minor + (d % 3 == 0));
+	}
+	fprintf(f, "</states></oval_definitions>\n");
+
+	for (d = 0; d < count; ++d) {
+		if (d % PACKAGES % 3 == 0)
+			expected[d] = 0;
+	}
+}
+
+static void generate_syschar(FILE *f)
+{
+	int p;
+
+	fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<oval_system_characteristics " NS_SYS ">" GENERATOR
+	        "<system_info><os_name>Linux</os_name><os_version>1</os_version><architecture>x86_64</architecture>"
+	        "<primary_host_name>localhost</primary_host_name><interfaces/></system_info><collected_objects>\n");
+	for (p = 0; p < PACKAGES; ++p)
+		fprintf(f, "<object id=\"oval:com.example:obj:%d\" version=\"1\" flag=\"complete\">"
+		        "<reference item_ref=\"%d\"/></object>\n", p, p + 1);
+
+	fprintf(f, "</collected_objects><system_data>\n");
+	for (p = 0; p < PACKAGES; ++p) {
+		int epoch, major, minor, release;
+
+		package_evr(p, &epoch, &major, &minor, &release);
+		fprintf(f, "<lin-sys:rpminfo_item id=\"%d\" status=\"exists\"><lin-sys:name>package%d</lin-sys:name>"
+		        "<lin-sys:arch>x86_64</lin-sys:arch><lin-sys:epoch>%d</lin-sys:epoch>"
+		        "<lin-sys:release>%d.el7</lin-sys:release><lin-sys:version>%d.%d.%d</lin-sys:version>"
+		        "<lin-sys:evr datatype=\"evr_string\">%d:%d.%d.%d-%d.el7</lin-sys:evr></lin-sys:rpminfo_item>\n",
+		        p + 1, p, epoch, release, major, minor, p, epoch, major, minor, p, release);
+	}
+	fprintf(f, "</system_data></oval_system_characteristics>\n");
+}
+
+static char *evr_new(int p, int c, int *older)
+{
+	char *buf = NULL;
+	size_t size = 0;
+	FILE *f = open_memstream(&buf, &size);
+
+	if (c < 0) {
+		int epoch, major, minor, release;
+
+		package_evr(p, &epoch, &major, &minor, &release);
+		fprintf(f, "%d:%d.%d.%d-%d.el7", epoch, major, minor, p, release);
+	} else {
+		*older = state_evr(f, p, c);
+	}
+	fclose(f);
+	return buf;
+}
+
+static int test_comparisons(int count)
+{
+	static const char *versions[][2] = {
+		{ "1.2.3", "1.2.3" }, { "1.2", "1.2.0.0" }, { "1.10", "1.9" }, { "2", "10" },
+		{ "1-2_3", "1.2.3" }, { "1.2a.3", "1.2.4" }, { "", "0" }, { "7.0.1", "7.0" },
+	};
+	static const oval_operation_t ops[] = {
+		OVAL_OPERATION_EQUALS, OVAL_OPERATION_NOT_EQUAL, OVAL_OPERATION_LESS_THAN,
+		OVAL_OPERATION_LESS_THAN_OR_EQUAL, OVAL_OPERATION_GREATER_THAN, OVAL_OPERATION_GREATER_THAN_OR_EQUAL,
+	};
+	int n = count * CRITERIA, i, r, ret = 0;
+	char **states = malloc(n * sizeof(char *));
+	char *sys[PACKAGES];
+	int *older = malloc(n * sizeof(int));
+	struct oval_evr **parsed_states = malloc(n * sizeof(struct oval_evr *));
+	struct oval_evr *parsed_sys[PACKAGES];
+	struct timespec start;
+	size_t v, o;
+
+	for (i = 0; i < PACKAGES; ++i)
+		sys[i] = evr_new(i, -1, NULL);
+	for (i = 0; i < n; ++i)
+		states[i] = evr_new((i * 7) % PACKAGES, (i / 3 + i) % CASES, &older[i]);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (r = 0; r < ROUNDS; ++r) {
+		for (i = 0; i < n; ++i) {
+			oval_result_t res = oval_evr_string_cmp(states[i], sys[(i * 7) % PACKAGES], OVAL_OPERATION_LESS_THAN);
+
+			if (res != (older[i] ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE)) {
+				fprintf(stderr, "'%s' < '%s' is %s\n", sys[(i * 7) % PACKAGES], states[i], oval_result_get_text(res));
+				ret = 1;
+			}
+		}
+	}
+	printf("strings:    %d x %d comparisons in %.3f ms\n", ROUNDS, n, oscap_elapsed_ms(&start));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < PACKAGES; ++i)
+		parsed_sys[i] = oval_evr_new(OVAL_DATATYPE_EVR_STRING, sys[i]);
+	for (i = 0; i < n; ++i)
+		parsed_states[i] = oval_evr_new(OVAL_DATATYPE_EVR_STRING, states[i]);
+	printf("parsing:    %d values in %.3f ms\n", PACKAGES + n, oscap_elapsed_ms(&start));
+
+	/* only the first round compares the values, the others are remembered */
+	for (r = 0; r < ROUNDS; ++r) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < n; ++i) {
+			oval_result_t res = oval_evr_cmp(parsed_states[i], parsed_sys[(i * 7) % PACKAGES], OVAL_OPERATION_LESS_THAN);
+
+			if (res != (older[i] ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE)) {
+				fprintf(stderr, "parsed '%s' < '%s' is %s\n", sys[(i * 7) % PACKAGES], states[i], oval_result_get_text(res));
+				ret = 1;
+			}
+		}
+		printf("parsed:     %d comparisons in %.3f ms\n", n, oscap_elapsed_ms(&start));
+	}
+
+	/* both sides of the pre-parsed comparisons give the results of the string comparisons */
+	for (i = 0; i < PACKAGES; ++i) {
+		for (o = 0; o < sizeof(ops) / sizeof(ops[0]); ++o) {
+			int s = (i * 13) % n;
+
+			if (oval_evr_cmp(parsed_sys[i], parsed_states[s], ops[o]) != oval_evr_string_cmp(sys[i], states[s], ops[o])) {
+				fprintf(stderr, "'%s' %d '%s' differs\n", states[s], ops[o], sys[i]);
+				ret = 1;
+			}
+		}
+	}
+	for (v = 0; v < sizeof(versions) / sizeof(versions[0]); ++v) {
+		for (o = 0; o < sizeof(ops) / sizeof(ops[0]); ++o) {
+			struct oval_evr *state = oval_evr_new(OVAL_DATATYPE_VERSION, versions[v][0]);
+			struct oval_evr *item = oval_evr_new(OVAL_DATATYPE_VERSION, versions[v][1]);
+
+			if (oval_evr_cmp(state, item, ops[o]) != oval_versiontype_cmp(versions[v][0], versions[v][1], ops[o])) {
+				fprintf(stderr, "version '%s' %d '%s' differs\n", versions[v][1], ops[o], versions[v][0]);
+				ret = 1;
+			}
+			oval_evr_free(state);
+			oval_evr_free(item);
+		}
+	}
+
+	for (i = 0; i < PACKAGES; ++i) {
+		oval_evr_free(parsed_sys[i]);
+		free(sys[i]);
+	}
+	for (i = 0; i < n; ++i) {
+		oval_evr_free(parsed_states[i]);
+		free(states[i]);
+	}
+	free(parsed_states);
+	free(states);
+	free(older);
+	return ret;
+}
+
+static struct oscap_source *source_generate(const char *name, int count, int *expected)
+{
+	struct oscap_source *source;
+	char *buf = NULL;
+	size_t size = 0;
+	FILE *f = open_memstream(&buf, &size);
+
+	if (f == NULL)
+		return NULL;
+	if (expected != NULL)
+		generate_definitions(f, count, expected);
+	else
+		generate_syschar(f);
+	fclose(f);
+
+	source = oscap_source_new_from_memory(buf, size, name);
+	free(buf);
+	return source;
+}
+
+static int evaluate(struct oscap_source *def_source, struct oscap_source *sys_source, int count, const int *expected)
+{
+	struct oval_definition_model *def_model;
+	struct oval_syschar_model *sys_model;
+	struct timespec start;
+	char id[64];
+	int i, d, ret = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	def_model = oval_definition_model_import_source(def_source);
+	if (def_model == NULL) {
+		fprintf(stderr, "Can't import the definitions: %s\n", oscap_err_desc());
+		return 1;
+	}
+	sys_model = oval_syschar_model_new(def_model);
+	if (oval_syschar_model_import_source(sys_model, sys_source) != 0) {
+		fprintf(stderr, "Can't import the system characteristics: %s\n", oscap_err_desc());
+		oval_syschar_model_free(sys_model);
+		oval_definition_model_free(def_model);
+		return 1;
+	}
+	printf("import:     %.3f ms\n", oscap_elapsed_ms(&start));
+
+	for (i = 0; i < ROUNDS; ++i) {
+		struct oval_syschar_model *sys_models[] = { sys_model, NULL };
+		struct oval_results_model *res_model = oval_results_model_new(def_model, sys_models);
+		struct oval_result_system_iterator *systems;
+		struct oval_result_system *system;
+		int counts[2] = { 0, 0 };
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if (oval_results_model_eval(res_model) != 0) {
+			fprintf(stderr, "Evaluation failed: %s\n", oscap_err_desc());
+			oval_results_model_free(res_model);
+			ret = 1;
+			break;
+		}
+		printf("evaluation: %.3f ms", oscap_elapsed_ms(&start));
+
+		systems = oval_results_model_get_systems(res_model);
+		system = oval_result_system_iterator_next(systems);
+		oval_result_system_iterator_free(systems);
+
+		for (d = 0; expected != NULL && d < count; ++d) {
+			struct oval_result_definition *definition;
+			oval_result_t result;
+
+			snprintf(id, sizeof(id), "oval:com.example:def:%d", d);
+			definition = oval_result_system_get_definition(system, id);
+			result = definition != NULL ? oval_result_definition_get_result(definition) : OVAL_RESULT_ERROR;
+			if (result != (expected[d] ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE)) {
+				fprintf(stderr, "\n%s: %s instead of %s", id, oval_result_get_text(result),
+				        expected[d] ? "true" : "false");
+				ret = 1;
+			} else {
+				++counts[result == OVAL_RESULT_TRUE];
+			}
+		}
+		if (expected != NULL)
+			printf(", %d true, %d false", counts[1], counts[0]);
+		printf("\n");
+
+		oval_results_model_free(res_model);
+	}
+
+	oval_syschar_model_free(sys_model);
+	oval_definition_model_free(def_model);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	struct oscap_source *def_source, *sys_source;
+	int *expected = NULL;
+	int count = 0, ret;
+
+	if (argc == 4 && !strcmp(argv[1], "--feed")) {
+		def_source = oscap_source_new_from_file(argv[2]);
+		sys_source = oscap_source_new_from_file(argv[3]);
+	} else {
+		count = argc > 1 ? atoi(argv[1]) : 3000;
+		expected = malloc(count * sizeof(int));
+		def_source = source_generate("definitions.xml", count, expected);
+		sys_source = source_generate("system-characteristics.xml", 0, NULL);
+		printf("%d definitions, %d rpminfo tests, %d packages\n", count,
+		       count * CRITERIA + (count < PACKAGES ? count : PACKAGES), PACKAGES);
+	}
+
+	ret = evaluate(def_source, sys_source, count, expected);
+	if (expected != NULL)
+		ret |= test_comparisons(count);
+
+	oscap_source_free(def_source);
+	oscap_source_free(sys_source);
+	free(expected);
+	oscap_cleanup();
+	return ret;
+}
@@ -0,0 +1,286 @@
+/*
+ * Micro-benchmark of the OVAL collection iterators.
+ *
+ * Walks every definition of the given model together with its criteria,
+ * tests, objects and states the given number of times and reports how many
+ * iterators were created, how many elements were visited, how many heap
+ * allocations it took and how long it took. Iterating a collection must not
+ * allocate anything per visited element; the program fails if it does.
+ *
+ * Usage: test_api_oval_iterators <oval-definitions.xml> [rounds]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <oval_agent_api.h>
+#include <oscap.h>
+#include "oscap_source.h"
+
+/*
+ * Allocation counting. The program interposes malloc() and friends so the
+ * calls made by the library are counted too. While the real functions are
+ * being looked up, dlsym() itself may allocate; those requests are served
+ * from a small static arena.
+ */
+static void *(*real_malloc)(size_t);
+static void *(*real_calloc)(size_t, size_t);
+static void *(*real_realloc)(void *, size_t);
+static void (*real_free)(void *);
+
+static unsigned long allocations;
+static int counting;
+
+static char bootstrap_arena[4096];
+static size_t bootstrap_used;
+static int bootstrapping;
+
+static void *bootstrap_alloc(size_t size)
+{
+	size = (size + 15) & ~(size_t)15;
+	if (bootstrap_used + size > sizeof(bootstrap_arena))
+		return NULL;
+	void *ptr = bootstrap_arena + bootstrap_used;
+	bootstrap_used += size;
+	return ptr;
+}
+
+static void resolve_allocator(void)
+{
+	bootstrapping = 1;
+	real_malloc = dlsym(RTLD_NEXT, "malloc");
+	real_calloc = dlsym(RTLD_NEXT, "calloc");
+	real_realloc = dlsym(RTLD_NEXT, "realloc");
+	real_free = dlsym(RTLD_NEXT, "free");
+	bootstrapping = 0;
+}
+
+void *malloc(size_t size)
+{
+	if (bootstrapping)
+		return bootstrap_alloc(size);
+	if (real_malloc == NULL)
+		resolve_allocator();
+	if (counting)
+		++allocations;
+	return real_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	if (bootstrapping)
+		return bootstrap_alloc(nmemb * size);	/* the arena is zeroed */
+	if (real_calloc == NULL)
+		resolve_allocator();
+	if (counting)
+		++allocations;
+	return real_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	if (real_realloc == NULL)
+		resolve_allocator();
+	if (counting)
+		++allocations;
+	return real_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+	if ((char *)ptr >= bootstrap_arena && (char *)ptr < bootstrap_arena + sizeof(bootstrap_arena))
+		return;
+	if (real_free == NULL)
+		resolve_allocator();
+	real_free(ptr);
+}
+
+/*
+ * Model walk.
+ */
+struct walk_stats {
+	unsigned long iterators;
+	unsigned long elements;
+};
+
+static void walk_strings(struct oval_string_iterator *strings, struct walk_stats *stats)
+{
+	++stats->iterators;
+	while (oval_string_iterator_has_more(strings)) {
+		oval_string_iterator_next(strings);
+		++stats->elements;
+	}
+	oval_string_iterator_free(strings);
+}
+
+static void walk_state(struct oval_state *state, struct walk_stats *stats)
+{
+	walk_strings(oval_state_get_notes(state), stats);
+
+	struct oval_state_content_iterator *contents = oval_state_get_contents(state);
+	++stats->iterators;
+	while (oval_state_content_iterator_has_more(contents)) {
+		oval_state_content_iterator_next(contents);
+		++stats->elements;
+	}
+	oval_state_content_iterator_free(contents);
+}
+
+static void walk_object(struct oval_object *object, struct walk_stats *stats)
+{
+	walk_strings(oval_object_get_notes(object), stats);
+
+	struct oval_object_content_iterator *contents = oval_object_get_object_contents(object);
+	++stats->iterators;
+	while (oval_object_content_iterator_has_more(contents)) {
+		oval_object_content_iterator_next(contents);
+		++stats->elements;
+	}
+	oval_object_content_iterator_free(contents);
+
+	struct oval_behavior_iterator *behaviors = oval_object_get_behaviors(object);
+	++stats->iterators;
+	while (oval_behavior_iterator_has_more(behaviors)) {
+		oval_behavior_iterator_next(behaviors);
+		++stats->elements;
+	}
+	oval_behavior_iterator_free(behaviors);
+}
+
+static void walk_test(struct oval_test *test, struct walk_stats *stats)
+{
+	walk_strings(oval_test_get_notes(test), stats);
+
+	struct oval_object *object = oval_test_get_object(test);
+	if (object != NULL)
+		walk_object(object, stats);
+
+	struct oval_state_iterator *states = oval_test_get_states(test);
+	++stats->iterators;
+	while (oval_state_iterator_has_more(states)) {
+		walk_state(oval_state_iterator_next(states), stats);
+		++stats->elements;
+	}
+	oval_state_iterator_free(states);
+}
+
+static void walk_criteria(struct oval_criteria_node *node, struct walk_stats *stats)
+{
+	switch (oval_criteria_node_get_type(node)) {
+	case OVAL_NODETYPE_CRITERIA: {
+		struct oval_criteria_node_iterator *subnodes = oval_criteria_node_get_subnodes(node);
+		++stats->iterators;
+		while (oval_criteria_node_iterator_has_more(subnodes)) {
+			walk_criteria(oval_criteria_node_iterator_next(subnodes), stats);
+			++stats->elements;
+		}
+		oval_criteria_node_iterator_free(subnodes);
+		break;
+	}
+	case OVAL_NODETYPE_CRITERION: {
+		struct oval_test *test = oval_criteria_node_get_test(node);
+		if (test != NULL)
+			walk_test(test, stats);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void walk_definition(struct oval_definition *definition, struct walk_stats *stats)
+{
+	walk_strings(oval_definition_get_notes(definition), stats);
+
+	struct oval_affected_iterator *affected = oval_definition_get_affected(definition);
+	++stats->iterators;
+	while (oval_affected_iterator_has_more(affected)) {
+		struct oval_affected *aff = oval_affected_iterator_next(affected);
+		walk_strings(oval_affected_get_platforms(aff), stats);
+		walk_strings(oval_affected_get_products(aff), stats);
+		++stats->elements;
+	}
+	oval_affected_iterator_free(affected);
+
+	struct oval_reference_iterator *references = oval_definition_get_references(definition);
+	++stats->iterators;
+	while (oval_reference_iterator_has_more(references)) {
+		oval_reference_iterator_next(references);
+		++stats->elements;
+	}
+	oval_reference_iterator_free(references);
+
+	struct oval_criteria_node *criteria = oval_definition_get_criteria(definition);
+	if (criteria != NULL)
+		walk_criteria(criteria, stats);
+}
+
+static void walk_model(struct oval_definition_model *model, struct walk_stats *stats)
+{
+	struct oval_definition_iterator *definitions = oval_definition_model_get_definitions(model);
+	++stats->iterators;
+	while (oval_definition_iterator_has_more(definitions)) {
+		walk_definition(oval_definition_iterator_next(definitions), stats);
+		++stats->elements;
+	}
+	oval_definition_iterator_free(definitions);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s <oval-definitions.xml> [rounds]\n", argv[0]);
+		return 2;
+	}
+	unsigned long rounds = argc > 2 ? strtoul(argv[2], NULL, 10) : 100;
+	if (rounds == 0)
+		rounds = 1;
+
+	struct oscap_source *source = oscap_source_new_from_file(argv[1]);
+	struct oval_definition_model *model = oval_definition_model_import_source(source);
+	oscap_source_free(source);
+	if (model == NULL) {
+		fprintf(stderr, "Failed to import '%s'.\n", argv[1]);
+		return 1;
+	}
+
+	struct walk_stats stats = { 0, 0 };
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	counting = 1;
+	for (unsigned long i = 0; i < rounds; ++i)
+		walk_model(model, &stats);
+	counting = 0;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double elapsed = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+	printf("rounds:      %lu\n", rounds);
+	printf("iterators:   %lu (%lu per round)\n", stats.iterators, stats.iterators / rounds);
+	printf("elements:    %lu (%lu per round)\n", stats.elements, stats.elements / rounds);
+	printf("allocations: %lu (%lu per round)\n", allocations, allocations / rounds);
+	printf("time:        %.3f ms (%.3f ms per round)\n", elapsed, elapsed / rounds);
+
+	oval_definition_model_free(model);
+	oscap_cleanup();
+
+	/* The definitions of the model are iterated through a string map which
+	 * may grow its buffer a few times; everything else must cost at most
+	 * the iterator itself. */
+	if (allocations > stats.iterators + rounds * 32) {
+		fprintf(stderr, "Iterating allocates per element: %lu allocations for %lu iterators.\n",
+			allocations, stats.iterators);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * Test and benchmark of the compiled pattern cache (oscap_pcre_cache).
+ *
+ * Compares a 'pattern match' state with the given number of file paths the
+ * way oval_string_cmp() does, once compiling the pattern for every path as
+ * before the cache and once using the cache, checks that the results are
+ * the same and reports the times and the cache statistics. Then checks
+ * the eviction of the least recently used patterns and the use of the
+ * cache from several threads.
+ *
+ * Usage: test_api_oval_pcre_cache [paths]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <pcre.h>
+#include <oval_definitions.h>
+#include "common/oscap_pcre_cache.h"
+#include "common/oscap_timing.h"
+
+#define THREADS 4
+#define THREAD_ROUNDS 20000
+
+static const char *patterns[] = {
+	"^/usr/lib(64)?/[^/]+\\.so(\\.[0-9]+)*$",
+	"^/etc/.*\\.conf$",
+	"^/var/log/(messages|secure|audit/audit\\.log)(\\.[0-9]+)?$",
+	"^.*/\\.ssh/authorized_keys2?$",
+};
+
+#define PATTERN_COUNT (sizeof(patterns) / sizeof(patterns[0]))
+
+static char *path_new(size_t i)
+{
+	static const char *fmt[] = {
+		"/usr/lib64/lib%zu.so.1",
+		"/etc/sysconfig/%zu.conf",
+		"/var/log/messages.%zu",
+		"/home/user%zu/.ssh/authorized_keys",
+		"/usr/share/doc/%zu/README",
+	};
+	char path[64];
+
+	snprintf(path, sizeof(path), fmt[i % (sizeof(fmt) / sizeof(fmt[0]))], i);
+	return strdup(path);
+}
+
+/* oval_string_cmp() for 'pattern match' as it was without the cache */
+static oval_result_t uncached_cmp(const char *pattern, const char *str)
+{
+	const char *err;
+	int errofs, ret;
+	pcre *re;
+
+	re = pcre_compile(pattern, PCRE_UTF8, &err, &errofs, NULL);
+	if (re == NULL)
+		return OVAL_RESULT_ERROR;
+	ret = pcre_exec(re, NULL, str, strlen(str), 0, 0, NULL, 0);
+	pcre_free(re);
+
+	return ret >= 0 ? OVAL_RESULT_TRUE : ret == -1 ? OVAL_RESULT_FALSE : OVAL_RESULT_ERROR;
+}
+
+/* oval_string_cmp() for 'pattern match' */
+static oval_result_t cached_cmp(const char *pattern, const char *str)
+{
+	struct oscap_pcre *re;
+	int ret;
+
+	re = oscap_pcre_cache_get(pattern, PCRE_UTF8, NULL, NULL);
+	if (re == NULL)
+		return OVAL_RESULT_ERROR;
+	ret = oscap_pcre_exec(re, str, strlen(str), 0, 0, NULL, 0);
+	oscap_pcre_cache_put(re);
+
+	return ret >= 0 ? OVAL_RESULT_TRUE : ret == -1 ? OVAL_RESULT_FALSE : OVAL_RESULT_ERROR;
+}
+
+static int test_benchmark(size_t count)
+{
+	struct oscap_pcre_cache_stats stats;
+	oval_result_t *expected = malloc(count * PATTERN_COUNT * sizeof(oval_result_t));
+	char **paths = malloc(count * sizeof(char *));
+	struct timespec start;
+	size_t i, p, matched = 0;
+	int ret = 0;
+
+	for (i = 0; i < count; ++i)
+		paths[i] = path_new(i);
+
+	oscap_pcre_cache_clear();
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (p = 0; p < PATTERN_COUNT; ++p)
+		for (i = 0; i < count; ++i)
+			expected[p * count + i] = uncached_cmp(patterns[p], paths[i]);
+	printf("uncached: %zu comparisons in %.3f ms\n", count * PATTERN_COUNT, oscap_elapsed_ms(&start));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (p = 0; p < PATTERN_COUNT; ++p) {
+		for (i = 0; i < count; ++i) {
+			oval_result_t res = cached_cmp(patterns[p], paths[i]);
+
+			if (res != expected[p * count + i]) {
+				fprintf(stderr, "'%s' ~ '%s': %d instead of %d\n",
+				        paths[i], patterns[p], res, expected[p * count + i]);
+				ret = 1;
+			}
+			if (res == OVAL_RESULT_TRUE)
+				++matched;
+		}
+	}
+	printf("cached:   %zu comparisons in %.3f ms, %zu matched\n", count * PATTERN_COUNT,
+	       oscap_elapsed_ms(&start), matched);
+
+	oscap_pcre_cache_get_stats(&stats);
+	printf("cache:    %lu hits, %lu misses, %lu evictions, %zu patterns\n",
+	       stats.hits, stats.misses, stats.evictions, stats.entries);
+	if (stats.misses != PATTERN_COUNT || stats.hits != count * PATTERN_COUNT - PATTERN_COUNT ||
+	    stats.entries != PATTERN_COUNT) {
+		fprintf(stderr, "Unexpected cache statistics\n");
+		ret = 1;
+	}
+	if (matched != count * PATTERN_COUNT / 5 && count % 5 == 0) {
+		fprintf(stderr, "%zu paths matched, expected %zu\n", matched, count * PATTERN_COUNT / 5);
+		ret = 1;
+	}
+
+	for (i = 0; i < count; ++i)
+		free(paths[i]);
+	free(paths);
+	free(expected);
+	return ret;
+}
+
+static int test_eviction(void)
+{
+	struct oscap_pcre_cache_stats stats;
+	struct oscap_pcre *held, *regex;
+	char pattern[32];
+	size_t i;
+	int ret = 0;
+
+	oscap_pcre_cache_clear();
+
+	held = oscap_pcre_cache_get("^held$", 0, NULL, NULL);
+	for (i = 0; i < OSCAP_PCRE_CACHE_MAX + 10; ++i) {
+		snprintf(pattern, sizeof(pattern), "^p%zu$", i);
+		regex = oscap_pcre_cache_get(pattern, 0, NULL, NULL);
+		oscap_pcre_cache_put(regex);
+	}
+
+	oscap_pcre_cache_get_stats(&stats);
+	if (stats.entries != OSCAP_PCRE_CACHE_MAX || stats.evictions != 11) {
+		fprintf(stderr, "eviction: %zu patterns, %lu evictions\n", stats.entries, stats.evictions);
+		ret = 1;
+	}
+	/* the evicted pattern is still usable by its holder */
+	if (oscap_pcre_exec(held, "held", 4, 0, 0, NULL, 0) < 0) {
+		fprintf(stderr, "eviction: the held pattern doesn't match\n");
+		ret = 1;
+	}
+	oscap_pcre_cache_put(held);
+
+	/* the most recently used patterns stay in the cache */
+	regex = oscap_pcre_cache_get(pattern, 0, NULL, NULL);
+	oscap_pcre_cache_put(regex);
+	oscap_pcre_cache_get_stats(&stats);
+	if (stats.hits != 1) {
+		fprintf(stderr, "eviction: '%s' was evicted\n", pattern);
+		ret = 1;
+	}
+
+	if (oscap_pcre_cache_get("(", 0, NULL, NULL) != NULL) {
+		fprintf(stderr, "An invalid pattern was compiled\n");
+		ret = 1;
+	}
+
+	return ret;
+}
+
+static void *thread_fn(void *arg)
+{
+	size_t id = (size_t)arg, i;
+	char pattern[32], str[32];
+	intptr_t failed = 0;
+
+	for (i = 0; i < THREAD_ROUNDS; ++i) {
+		/* more distinct patterns than the cache holds */
+		size_t n = (i * 7 + id * 13) % (2 * OSCAP_PCRE_CACHE_MAX);
+
+		snprintf(pattern, sizeof(pattern), "^x%zu(y|z)$", n);
+		snprintf(str, sizeof(str), "x%zu%c", n, i % 2 ? 'y' : 'w');
+		if (cached_cmp(pattern, str) !=
+		    (i % 2 ? OVAL_RESULT_TRUE : OVAL_RESULT_FALSE))
+			++failed;
+	}
+
+	return (void *)failed;
+}
+
+static int test_threads(void)
+{
+	struct oscap_pcre_cache_stats stats;
+	pthread_t threads[THREADS];
+	struct timespec start;
+	void *failed;
+	size_t i;
+	int ret = 0;
+
+	oscap_pcre_cache_clear();
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < THREADS; ++i)
+		pthread_create(&threads[i], NULL, thread_fn, (void *)i);
+	for (i = 0; i < THREADS; ++i) {
+		pthread_join(threads[i], &failed);
+		if (failed != NULL) {
+			fprintf(stderr, "thread %zu: %zu wrong results\n", i, (size_t)failed);
+			ret = 1;
+		}
+	}
+
+	oscap_pcre_cache_get_stats(&stats);
+	printf("threads:  %d x %d comparisons in %.3f ms, %lu hits, %lu misses, %lu evictions\n",
+	       THREADS, THREAD_ROUNDS, oscap_elapsed_ms(&start), stats.hits, stats.misses, stats.evictions);
+	if (stats.hits + stats.misses != THREADS * THREAD_ROUNDS || stats.entries > OSCAP_PCRE_CACHE_MAX) {
+		fprintf(stderr, "Unexpected cache statistics\n");
+		ret = 1;
+	}
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 50000;
+	int ret = 0;
+
+	ret |= test_benchmark(count);
+	ret |= test_eviction();
+	ret |= test_threads();
+
+	oscap_pcre_cache_clear();
+	return ret;
+}
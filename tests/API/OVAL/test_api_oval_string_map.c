@@ -0,0 +1,159 @@
+/*
+ * Test and benchmark of the OVAL model lookups by ID (oval_string_map).
+ *
+ * Fills a definition model with definitions whose IDs share a long common
+ * prefix, as in the SCAP Security Guide content, checks the lookups and the
+ * iteration order and reports how long the insertions, lookups and iterations
+ * took. If an OVAL definitions file is given, the program also reports how
+ * long its import takes.
+ *
+ * Usage: test_api_oval_string_map [count] [oval-definitions.xml]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <oval_agent_api.h>
+#include <oscap.h>
+#include "oscap_source.h"
+#include "common/oscap_timing.h"
+
+#define LOOKUP_ROUNDS 10
+#define IMPORT_ROUNDS 5
+#define ITERATE_ROUNDS 100
+
+/* definitions are iterated in descending order of their IDs */
+static int check_order(struct oval_definition_model *model, size_t count)
+{
+	struct oval_definition_iterator *it = oval_definition_model_get_definitions(model);
+	const char *prev = NULL;
+	size_t n = 0;
+	int ret = 0;
+
+	while (oval_definition_iterator_has_more(it)) {
+		const char *id = oval_definition_get_id(oval_definition_iterator_next(it));
+		if (prev != NULL && strcmp(prev, id) <= 0) {
+			fprintf(stderr, "Definitions are not ordered: '%s', '%s'.\n", prev, id);
+			ret = 1;
+			break;
+		}
+		prev = id;
+		++n;
+	}
+	oval_definition_iterator_free(it);
+	if (n != count && ret == 0) {
+		fprintf(stderr, "Iterated %zu definitions out of %zu.\n", n, count);
+		ret = 1;
+	}
+
+	return ret;
+}
+
+static int test_map(size_t count)
+{
+	struct oval_definition_model *model = oval_definition_model_new();
+	struct oval_definition **defs = malloc(count * sizeof(struct oval_definition *));
+	char **ids = malloc(count * sizeof(char *));
+	struct timespec start;
+	size_t i, r;
+	int ret = 0;
+
+	for (i = 0; i < count; ++i) {
+		char id[64];
+
+		snprintf(id, sizeof(id), "oval:org.ssgproject.content:def:%zu", 20000 + i);
+		ids[i] = strdup(id);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; ++i)
+		defs[i] = oval_definition_new(model, ids[i]);
+	printf("insert: %zu definitions in %.3f ms\n", count, oscap_elapsed_ms(&start));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (r = 0; r < LOOKUP_ROUNDS; ++r) {
+		for (i = 0; i < count; ++i) {
+			if (oval_definition_model_get_definition(model, ids[i]) != defs[i]) {
+				fprintf(stderr, "Lookup of '%s' failed.\n", ids[i]);
+				ret = 1;
+			}
+		}
+	}
+	double ms = oscap_elapsed_ms(&start);
+	printf("lookup: %zu lookups in %.3f ms (%.1f ns per lookup)\n",
+	       count * LOOKUP_ROUNDS, ms, ms * 1e6 / (count * LOOKUP_ROUNDS));
+
+	/* missing keys */
+	if (oval_definition_model_get_definition(model, "oval:org.ssgproject.content:def:1") != NULL ||
+	    oval_definition_model_get_definition(model, "") != NULL) {
+		fprintf(stderr, "Lookup of a missing definition succeeded.\n");
+		ret = 1;
+	}
+
+	if (check_order(model, count) != 0)
+		ret = 1;
+
+	/* the iteration is repeated, e.g. by the exports of the results */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (r = 0; r < ITERATE_ROUNDS; ++r) {
+		struct oval_definition_iterator *it = oval_definition_model_get_definitions(model);
+		oval_definition_iterator_free(it);
+	}
+	printf("iterate: %d iterations in %.3f ms\n", ITERATE_ROUNDS, oscap_elapsed_ms(&start));
+
+	/* a definition added after an iteration is iterated too */
+	oval_definition_new(model, "oval:org.ssgproject.content:def:99999999");
+	if (ret == 0 && check_order(model, count + 1) != 0)
+		ret = 1;
+
+	oval_definition_model_free(model);
+	for (i = 0; i < count; ++i)
+		free(ids[i]);
+	free(ids);
+	free(defs);
+
+	return ret;
+}
+
+static int bench_import(const char *path)
+{
+	struct timespec start;
+	int r;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (r = 0; r < IMPORT_ROUNDS; ++r) {
+		struct oscap_source *source = oscap_source_new_from_file(path);
+		struct oval_definition_model *model = oval_definition_model_import_source(source);
+
+		oscap_source_free(source);
+		if (model == NULL) {
+			fprintf(stderr, "Failed to import '%s'.\n", path);
+			return 1;
+		}
+		oval_definition_model_free(model);
+	}
+	printf("import: %.3f ms per import of %s\n", oscap_elapsed_ms(&start) / IMPORT_ROUNDS, path);
+
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 50000;
+	int ret;
+
+	if (count < 2)
+		count = 2;
+
+	ret = test_map(count);
+	if (argc > 2)
+		ret |= bench_import(argv[2]);
+
+	oscap_cleanup();
+	return ret;
+}
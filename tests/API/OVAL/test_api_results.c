@@ -26,6 +26,13 @@ int main(int argc, char **argv)
 
 	oval_results_model_export(results_model, NULL, argv[2]);
 
+	/* Export the same model through the in-memory document */
+	if (argc > 3) {
+		source = oval_results_model_export_source(results_model, NULL, argv[3]);
+		oscap_source_save_as(source, NULL);
+		oscap_source_free(source);
+	}
+
 	oval_results_model_free(results_model);
 	oval_definition_model_free(definition_model);
 	oscap_cleanup();
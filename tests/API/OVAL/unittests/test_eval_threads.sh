@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# Parallel collection of independent objects must not change the results.
+
+sequential=`mktemp`
+parallel=`mktemp`
+stderr=`mktemp`
+
+set -e
+set -o pipefail
+
+$OSCAP oval eval --results $sequential $srcdir/test_eval_threads.xml > /dev/null
+$OSCAP oval eval --threads 4 --results $parallel $srcdir/test_eval_threads.xml 2> $stderr > /dev/null
+[ ! -s $stderr ]
+
+result=$sequential
+assert_exists 1 '//definition[@definition_id="oval:x:def:1"][@result="true"]'
+assert_exists 1 '//definition[@definition_id="oval:x:def:2"][@result="true"]'
+assert_exists 1 '//definition[@definition_id="oval:x:def:3"][@result="true"]'
+assert_exists 6 '//collected_objects/object'
+
+result=$parallel
+assert_exists 1 '//definition[@definition_id="oval:x:def:1"][@result="true"]'
+assert_exists 1 '//definition[@definition_id="oval:x:def:2"][@result="true"]'
+assert_exists 1 '//definition[@definition_id="oval:x:def:3"][@result="true"]'
+assert_exists 6 '//collected_objects/object'
+assert_exists 1 '//collected_objects/object[@id="oval:x:obj:6"][@flag="does not exist"]'
+
+# the result of every test must be the same as during sequential evaluation
+for tst in 1 2 3 4 5 6; do
+	expected=`$XPATH $sequential "string(//test[@test_id=\"oval:x:tst:$tst\"]/@result)"`
+	[ -n "$expected" ]
+	assert_exists 1 "//test[@test_id=\"oval:x:tst:$tst\"][@result=\"$expected\"]"
+done
+
+# invalid number of threads is rejected
+$OSCAP oval eval --threads 0 $srcdir/test_eval_threads.xml 2> $stderr && false
+grep -q "Invalid number of threads" $stderr
+
+rm $sequential $parallel $stderr
@@ -0,0 +1,62 @@
+#!/bin/bash
+
+# Objects taken from the object cache must give the same results as the
+# probes, and a changed file must not be taken from the cache.
+
+dir=`mktemp -d`
+stderr=`mktemp`
+
+set -e
+set -o pipefail
+
+sed "s|@DIR@|$dir|g" $srcdir/test_object_cache.xml > $dir/defs.xml
+echo "value=1" > $dir/config
+
+$OSCAP oval eval --object-cache $dir/cache --results $dir/first.xml $dir/defs.xml > /dev/null
+[ -d $dir/cache ]
+[ `ls $dir/cache | wc -l` -eq 2 ]
+
+$OSCAP oval eval --object-cache $dir/cache --results $dir/second.xml \
+	--verbose INFO --verbose-log-file $dir/second.log $dir/defs.xml > /dev/null
+# file items report the access time, which the first scan may have changed,
+# so only the textfilecontent54 object is sure to be taken from the cache
+grep -q "Using the object cache for object 'oval:x:obj:2'" $dir/second.log
+
+for result in $dir/first.xml $dir/second.xml; do
+	assert_exists 1 '//definition[@definition_id="oval:x:def:1"][@result="true"]'
+	assert_exists 2 '//collected_objects/object[@flag="complete"]'
+	assert_exists 1 '//*[local-name()="textfilecontent_item"]/*[local-name()="subexpression"][text()="1"]'
+done
+
+# same size, different content
+echo "value=2" > $dir/config
+$OSCAP oval eval --object-cache $dir/cache --results $dir/third.xml \
+	--verbose INFO --verbose-log-file $dir/third.log $dir/defs.xml > /dev/null
+grep -q "Using the object cache for object 'oval:x:obj:2'" $dir/third.log && false
+result=$dir/third.xml
+assert_exists 1 '//definition[@definition_id="oval:x:def:1"][@result="false"]'
+assert_exists 1 '//*[local-name()="textfilecontent_item"]/*[local-name()="subexpression"][text()="2"]'
+
+# the state used by a filter is part of the key
+sed "s|@DIR@|$dir|g;s|@VALUE@|2|" $srcdir/test_object_cache_filter.xml > $dir/filter.xml
+$OSCAP oval eval --object-cache $dir/cache --results $dir/filter1.xml $dir/filter.xml > /dev/null
+$OSCAP oval eval --object-cache $dir/cache --results $dir/filter2.xml \
+	--verbose INFO --verbose-log-file $dir/filter2.log $dir/filter.xml > /dev/null
+grep -q "Using the object cache for object 'oval:x:obj:1'" $dir/filter2.log
+sed "s|@DIR@|$dir|g;s|@VALUE@|1|" $srcdir/test_object_cache_filter.xml > $dir/filter.xml
+$OSCAP oval eval --object-cache $dir/cache --results $dir/filter3.xml \
+	--verbose INFO --verbose-log-file $dir/filter3.log $dir/filter.xml > /dev/null
+grep -q "Using the object cache for object 'oval:x:obj:1'" $dir/filter3.log && false
+for result in $dir/filter1.xml $dir/filter2.xml; do
+	assert_exists 1 '//definition[@definition_id="oval:x:def:1"][@result="true"]'
+done
+result=$dir/filter3.xml
+assert_exists 1 '//definition[@definition_id="oval:x:def:1"][@result="false"]'
+
+# a directory writable by others is refused
+mkdir -m 0777 $dir/shared
+chmod 0777 $dir/shared
+$OSCAP oval eval --object-cache $dir/shared $dir/defs.xml 2> $stderr > /dev/null && false
+grep -q "Object cache directory" $stderr
+
+rm -rf $dir $stderr
@@ -491,10 +491,14 @@ if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "test_api_seap_concurency"             test_api_seap_concurency
     test_run "test_api_seap_spb"                  ./test_api_seap_spb
     test_run "test_api_seap_list"                 ./test_api_seap_list
+    test_run "test_api_seap_list_perf"            ./test_api_seap_list_perf
+    test_run "test_api_seap_slab"                 ./test_api_seap_slab
     test_run "test_api_seap_number_expression"    ./test_api_seap_number
     test_run "test_api_seap_string_expression"    ./test_api_seap_string
     test_run "test_api_SEXP_deepcmp"              ./test_api_SEXP_deepcmp
     test_run "test_api_strto"                     ./test_api_strto
+    test_run "test_api_seap_binary"               ./test_api_seap_binary
+    test_run "test_api_seap_transport"            ./test_api_seap_transport
 fi
 
 test_exit
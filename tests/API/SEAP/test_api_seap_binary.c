@@ -0,0 +1,237 @@
+/*
+ * Test and benchmark of the binary SEAP framing.
+ *
+ * Builds an S-expression shaped like the result of a file_object
+ * collection (a list of file items with their entities), checks that it
+ * survives the binary encoding unchanged, that damaged frames are rejected
+ * and reports the encoding and decoding throughput of both the textual and
+ * the binary format.
+ *
+ * Usage: test_api_seap_binary [items] [rounds]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sexp.h>
+#include <strbuf.h>
+#include "common/oscap_timing.h"
+
+static void add_free(SEXP_t *list, SEXP_t *s_exp)
+{
+	SEXP_list_add(list, s_exp);
+	SEXP_free(s_exp);
+}
+
+static void add_entity(SEXP_t *item, const char *name, SEXP_t *value, const char *type)
+{
+	SEXP_t *attrs = SEXP_list_new(NULL), *ent;
+
+	add_free(attrs, SEXP_string_newf("%s", name));
+	ent = SEXP_list_new(attrs, value, NULL);
+	SEXP_datatype_set(ent, type);
+	add_free(item, ent);
+	SEXP_vfree(attrs, value, NULL);
+}
+
+static SEXP_t *file_object_result(size_t count)
+{
+	SEXP_t *result, *hdr;
+	size_t i;
+
+	hdr = SEXP_list_new(NULL);
+	add_free(hdr, SEXP_string_newf("file_object"));
+	add_free(hdr, SEXP_string_newf(":id"));
+	add_free(hdr, SEXP_string_newf("oval:org.open-scap.test:obj:1"));
+	result = SEXP_list_new(hdr, NULL);
+	SEXP_free(hdr);
+
+	for (i = 0; i < count; ++i) {
+		SEXP_t *item;
+
+		hdr = SEXP_list_new(NULL);
+		add_free(hdr, SEXP_string_newf("file_item"));
+		add_free(hdr, SEXP_string_newf(":id"));
+		add_free(hdr, SEXP_number_newu_64(1000 + i));
+		add_free(hdr, SEXP_string_newf(":status"));
+		add_free(hdr, SEXP_number_newi_32(1));
+		item = SEXP_list_new(hdr, NULL);
+		SEXP_free(hdr);
+
+		add_entity(item, "filepath", SEXP_string_newf("/usr/lib64/lib%zu/module-%zu.so", i % 97, i), "string");
+		add_entity(item, "path", SEXP_string_newf("/usr/lib64/lib%zu", i % 97), "string");
+		add_entity(item, "filename", SEXP_string_newf("module-%zu.so", i), "string");
+		add_entity(item, "type", SEXP_string_newf("regular"), "string");
+		add_entity(item, "group_id", SEXP_number_newu_32(0), "int");
+		add_entity(item, "user_id", SEXP_number_newu_32(1000 + i % 7), "int");
+		add_entity(item, "a_time", SEXP_number_newi_64(1496300000 + i), "int");
+		add_entity(item, "c_time", SEXP_number_newi_64(1496200000 + i), "int");
+		add_entity(item, "m_time", SEXP_number_newi_64(1496100000 + i), "int");
+		add_entity(item, "size", SEXP_number_newu_64(4096 * (i % 513)), "int");
+		add_entity(item, "suid", SEXP_number_newb(false), "bool");
+		add_entity(item, "uread", SEXP_number_newb(true), "bool");
+		add_entity(item, "uwrite", SEXP_number_newb(true), "bool");
+		add_entity(item, "uexec", SEXP_number_newb(i % 2), "bool");
+		add_entity(item, "has_extended_acl", SEXP_number_newb(false), "bool");
+		add_entity(item, "ratio", SEXP_number_newf((i % 1000) / 4.0 + 0.125), "float");
+
+		add_free(result, item);
+	}
+
+	return result;
+}
+
+static SEXP_t *text_decode(const char *buf, size_t len)
+{
+	SEXP_psetup_t *psetup = SEXP_psetup_new();
+	SEXP_pstate_t *pstate = NULL;
+	SEXP_t *list, *s_exp = NULL;
+
+	list = SEXP_parse(psetup, (char *)buf, len, &pstate);
+	if (list != NULL) {
+		s_exp = SEXP_list_first(list);
+		SEXP_free(list);
+	}
+	SEXP_psetup_free(psetup);
+
+	return s_exp;
+}
+
+static char *frame_copy(SEXP_t *s_exp, int binary, size_t *len)
+{
+	strbuf_t *sb = strbuf_new(SEAP_STRBUF_MAX);
+	char *buf = NULL;
+
+	if ((binary ? SEXP_bframe_sbprint(s_exp, sb) : SEXP_sbprintf_t(s_exp, sb)) == 0) {
+		*len = strbuf_size(sb);
+		/* one spare byte for the trailing data test */
+		buf = calloc(*len + 1, 1);
+		strbuf_copy(sb, buf, *len);
+	}
+	strbuf_free(sb);
+
+	return buf;
+}
+
+static SEXP_t *frame_decode(const char *buf, size_t len, int binary)
+{
+	uint32_t plen;
+
+	if (!binary)
+		return text_decode(buf, len);
+
+	if (len < SEXP_BFRAME_HDRSIZE || SEXP_bframe_hdrparse(buf, &plen) != 0 ||
+	    plen != len - SEXP_BFRAME_HDRSIZE)
+		return NULL;
+
+	return SEXP_bdecode(buf + SEXP_BFRAME_HDRSIZE, plen);
+}
+
+static int bench(SEXP_t *s_exp, int binary, int rounds)
+{
+	const char *name = binary ? "binary" : "text";
+	struct timespec start;
+	double enc_ms = 0, dec_ms = 0;
+	size_t len = 0;
+	int r;
+
+	for (r = 0; r < rounds; ++r) {
+		SEXP_t *decoded;
+		char *buf;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		buf = frame_copy(s_exp, binary, &len);
+		enc_ms += oscap_elapsed_ms(&start);
+
+		if (buf == NULL) {
+			fprintf(stderr, "%s: encoding failed\n", name);
+			return 1;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		decoded = frame_decode(buf, len, binary);
+		dec_ms += oscap_elapsed_ms(&start);
+		free(buf);
+
+		if (decoded == NULL || SEXP_deepcmp(s_exp, decoded) != true) {
+			fprintf(stderr, "%s: the decoded S-exp differs from the original\n", name);
+			SEXP_free(decoded);
+			return 1;
+		}
+		SEXP_free(decoded);
+	}
+
+	printf("%-6s: %zu bytes, encode %.3f ms (%.1f MB/s), decode %.3f ms (%.1f MB/s)\n",
+	       name, len, enc_ms / rounds, len * rounds / enc_ms / 1e3,
+	       dec_ms / rounds, len * rounds / dec_ms / 1e3);
+
+	return 0;
+}
+
+static int test_damaged(SEXP_t *s_exp)
+{
+	size_t len, i;
+	char *buf = frame_copy(s_exp, 1, &len);
+	SEXP_t *decoded;
+	int ret = 0;
+
+	/* truncated frames */
+	for (i = 0; i < len - SEXP_BFRAME_HDRSIZE; i += 1 + len / 64) {
+		if ((decoded = frame_decode(buf, i, 1)) != NULL ||
+		    (decoded = SEXP_bdecode(buf + SEXP_BFRAME_HDRSIZE, i)) != NULL) {
+			fprintf(stderr, "A frame truncated to %zu bytes was accepted.\n", i);
+			SEXP_free(decoded);
+			ret = 1;
+		}
+	}
+
+	/* trailing garbage */
+	if ((decoded = SEXP_bdecode(buf + SEXP_BFRAME_HDRSIZE, len - SEXP_BFRAME_HDRSIZE + 1)) != NULL) {
+		fprintf(stderr, "A frame with trailing data was accepted.\n");
+		SEXP_free(decoded);
+		ret = 1;
+	}
+
+	/* bad magic */
+	buf[0] = '(';
+	if ((decoded = frame_decode(buf, len, 1)) != NULL) {
+		fprintf(stderr, "A text S-exp was accepted as a binary frame.\n");
+		SEXP_free(decoded);
+		ret = 1;
+	}
+
+	free(buf);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 10000;
+	int rounds = argc > 2 ? atoi(argv[2]) : 3;
+	SEXP_t *s_exp, *empty, *str, *list;
+	int ret = 0;
+
+	if (rounds < 1)
+		rounds = 1;
+
+	/* corner cases */
+	str = SEXP_string_new("", 0);
+	list = SEXP_list_new(NULL);
+	empty = SEXP_list_new(str, list, NULL);
+	ret |= bench(empty, 1, 1);
+	SEXP_vfree(empty, str, list, NULL);
+
+	s_exp = file_object_result(count);
+	printf("file_object with %zu items\n", count);
+	ret |= bench(s_exp, 0, rounds);
+	ret |= bench(s_exp, 1, rounds);
+	ret |= test_damaged(s_exp);
+	SEXP_free(s_exp);
+
+	return ret;
+}
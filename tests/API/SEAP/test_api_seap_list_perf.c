@@ -0,0 +1,194 @@
+/*
+ * S-exp list micro-benchmark.
+ *
+ * Builds a list of the given number of members (10^6 by default) by
+ * appending to it, then measures SEXP_list_length, sequential and random
+ * SEXP_list_nth and SEXP_list_last on it. The members are checked while
+ * reading them back. Before that, lists sharing their blocks through
+ * SEXP_list_rest are modified and checked to stay independent.
+ *
+ * Usage: test_api_seap_list_perf [members]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <sexp.h>
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *what, size_t ops, double sec)
+{
+	printf("%-28s %10zu ops %9.3f s %12.0f ops/s\n", what, ops, sec, sec > 0 ? ops / sec : 0);
+}
+
+static int check_nth(const SEXP_t *list, uint32_t n, uint32_t expected)
+{
+	SEXP_t *memb;
+	uint32_t value;
+
+	memb = SEXP_list_nth(list, n);
+
+	if (memb == NULL) {
+		fprintf(stderr, "nth(%u): missing, expected %u\n", n, expected);
+		return 1;
+	}
+
+	value = SEXP_number_getu_32(memb);
+	SEXP_free(memb);
+
+	if (value != expected) {
+		fprintf(stderr, "nth(%u): %u, expected %u\n", n, value, expected);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int check_list(const SEXP_t *list, uint32_t first, uint32_t count)
+{
+	uint32_t i;
+
+	if (SEXP_list_length(list) != count) {
+		fprintf(stderr, "length: %zu, expected %u\n", SEXP_list_length(list), count);
+		return 1;
+	}
+
+	for (i = 1; i <= count; ++i)
+		if (check_nth(list, i, first + i - 1) != 0)
+			return 1;
+
+	if (SEXP_list_nth(list, count + 1) != NULL) {
+		fprintf(stderr, "nth(%u): expected the end of the list\n", count + 1);
+		return 1;
+	}
+
+	return 0;
+}
+
+static void list_append(SEXP_t *list, uint32_t first, uint32_t count)
+{
+	SEXP_t *memb;
+	uint32_t i;
+
+	for (i = 0; i < count; ++i) {
+		memb = SEXP_number_newu_32(first + i);
+		SEXP_list_add(list, memb);
+		SEXP_free(memb);
+	}
+}
+
+/*
+ * Lists created by SEXP_list_rest share blocks with the original
+ * list; appending to, replacing in or popping from either of them
+ * must not be visible in the other one.
+ */
+static int test_shared(void)
+{
+	SEXP_t *list, *rest, *rest2, *memb, *old;
+	int ret = 0;
+
+	list = SEXP_list_new(NULL);
+	list_append(list, 1, 100);
+
+	rest = SEXP_list_rest(list);
+	ret |= check_list(rest, 2, 99);
+
+	list_append(list, 101, 50);
+	ret |= check_list(list, 1, 150);
+	ret |= check_list(rest, 2, 99);
+
+	list_append(rest, 101, 10);
+	ret |= check_list(rest, 2, 109);
+	ret |= check_list(list, 1, 150);
+
+	rest2 = SEXP_list_rest(rest);
+	memb  = SEXP_number_newu_32(1000);
+	old   = SEXP_list_replace(rest2, 107, memb);
+	ret  |= check_nth(rest2, 107, 1000);
+	ret  |= check_list(rest, 2, 109);
+	SEXP_free(old);
+
+	old = SEXP_list_pop(rest);
+	ret |= check_list(rest, 3, 108);
+	ret |= check_nth(rest2, 1, 3);
+	SEXP_free(old);
+
+	old = SEXP_list_last(list);
+	if (old == NULL || SEXP_number_getu_32(old) != 150) {
+		fprintf(stderr, "last: wrong member\n");
+		ret = 1;
+	}
+
+	SEXP_vfree(list, rest, rest2, memb, old, NULL);
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	SEXP_t *list, *memb;
+	uint32_t count, i, n;
+	size_t length;
+	double t;
+
+	count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+
+	if (test_shared() != 0)
+		return 1;
+
+	list = SEXP_list_new(NULL);
+
+	t = now();
+	list_append(list, 0, count);
+	report("append", count, now() - t);
+
+	t = now();
+	for (i = 0, length = 0; i < count; ++i)
+		length += SEXP_list_length(list);
+	report("length", count, now() - t);
+
+	if (length != (size_t)count * count) {
+		fprintf(stderr, "length: wrong value\n");
+		return 1;
+	}
+
+	t = now();
+	for (i = 1; i <= count; ++i)
+		if (check_nth(list, i, i - 1) != 0)
+			return 1;
+	report("nth (sequential)", count, now() - t);
+
+	srand(1);
+	t = now();
+	for (i = 0; i < count; ++i) {
+		n = 1 + (uint32_t)(((uint64_t)rand() * count) / ((uint64_t)RAND_MAX + 1));
+		if (check_nth(list, n, n - 1) != 0)
+			return 1;
+	}
+	report("nth (random)", count, now() - t);
+
+	t = now();
+	for (i = 0; i < count; ++i) {
+		memb = SEXP_list_last(list);
+		SEXP_free(memb);
+	}
+	report("last", count, now() - t);
+
+	t = now();
+	SEXP_free(list);
+	report("free", count, now() - t);
+
+	return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * S-exp allocation benchmark.
+ *
+ * Each thread builds items shaped like those of the file probe (a list
+ * of entities with string and number values), keeps them in one large
+ * list and frees the list at the end. The number of items (10^6 by
+ * default) is split between the threads (4 by default). Once all the
+ * threads are done, every object taken from the slabs must have been
+ * given back and no slab may remain in use.
+ *
+ * Usage: test_api_seap_slab [items [threads]]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <sexp.h>
+#include <sm_alloc.h>
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static SEXP_t *item_new(uint32_t i)
+{
+	SEXP_t *item, *name, *value;
+
+	item = SEXP_list_new(NULL);
+
+	name  = SEXP_string_newf("filepath");
+	value = SEXP_string_newf("/var/lib/data/dir%u/file%u", i / 1000, i);
+	SEXP_list_add(item, name);
+	SEXP_list_add(item, value);
+	SEXP_vfree(name, value, NULL);
+
+	name  = SEXP_string_newf("size");
+	value = SEXP_number_newu_64((uint64_t)i * 4096);
+	SEXP_list_add(item, name);
+	SEXP_list_add(item, value);
+	SEXP_vfree(name, value, NULL);
+
+	name  = SEXP_string_newf("uid");
+	value = SEXP_number_newu_32(i % 1000);
+	SEXP_list_add(item, name);
+	SEXP_list_add(item, value);
+	SEXP_vfree(name, value, NULL);
+
+	return (item);
+}
+
+static void *worker(void *arg)
+{
+	uint32_t count = *(uint32_t *)arg, i;
+	SEXP_t *items, *item;
+
+	items = SEXP_list_new(NULL);
+
+	for (i = 0; i < count; ++i) {
+		item = item_new(i);
+		SEXP_list_add(items, item);
+		SEXP_free(item);
+	}
+
+	SEXP_free(items);
+	sm_slab_flush();
+
+	return (NULL);
+}
+
+int main(int argc, char *argv[])
+{
+	struct sm_slab_stats stats;
+	pthread_t *threads;
+	uint32_t count, nthreads, per_thread, i;
+	double t;
+
+	count    = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+	nthreads = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 4;
+
+	if (nthreads == 0)
+		nthreads = 1;
+
+	per_thread = count / nthreads;
+	threads    = malloc(sizeof(pthread_t) * nthreads);
+
+	t = now();
+
+	for (i = 0; i < nthreads; ++i) {
+		if (pthread_create(threads + i, NULL, &worker, &per_thread) != 0) {
+			fprintf(stderr, "pthread_create failed\n");
+			return 1;
+		}
+	}
+
+	for (i = 0; i < nthreads; ++i)
+		pthread_join(threads[i], NULL);
+
+	t = now() - t;
+	free(threads);
+
+	sm_slab_stats(&stats);
+
+	printf("items: %u, threads: %u, time: %.3f s, %.0f items/s\n",
+	       per_thread * nthreads, nthreads, t, t > 0 ? per_thread * nthreads / t : 0);
+	printf("slab objects: %llu allocated, %llu freed, %llu large allocations\n",
+	       (unsigned long long)stats.alloc, (unsigned long long)stats.free,
+	       (unsigned long long)stats.large);
+	printf("slabs: %llu allocated in total, %llu left\n",
+	       (unsigned long long)stats.slabs_total, (unsigned long long)stats.slabs);
+
+	if (stats.alloc != stats.free) {
+		fprintf(stderr, "objects allocated from the slabs were not given back\n");
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Bandwidth benchmark of the SEAP transport schemes.
+ *
+ * Starts a copy of itself as the peer through the pipe and shm schemes
+ * (the same way the library starts the probes), asks it for messages of
+ * several sizes, checks their contents and reports the throughput of both
+ * schemes. The largest message doesn't fit into the shared memory ring.
+ *
+ * Usage: test_api_seap_transport [rounds]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <seap.h>
+
+#define PEER_ENV "SEAP_TEST_TRANSPORT_PEER"
+
+static const size_t sizes[] = { 4096, 256 * 1024, 4 * 1024 * 1024 };
+
+static char *payload(size_t len)
+{
+	char *buf = malloc(len);
+	size_t i;
+
+	for (i = 0; i < len; ++i)
+		buf[i] = 'a' + (i * 7) % 26;
+
+	return buf;
+}
+
+static int peer(void)
+{
+	SEAP_CTX_t *ctx = SEAP_CTX_new();
+	SEXP_t *req, *rep = NULL;
+	char *buf;
+	size_t len;
+	int sd;
+
+	sd = SEAP_openfd2(ctx, STDIN_FILENO, STDOUT_FILENO, 0);
+	if (sd < 0)
+		return 1;
+
+	while (SEAP_recvsexp(ctx, sd, &req) == 0) {
+		len = SEXP_number_getu_64(req);
+		SEXP_free(req);
+
+		/* the same message is requested repeatedly, build it once */
+		if (rep == NULL || SEXP_string_length(rep) != len) {
+			SEXP_free(rep);
+			buf = payload(len);
+			rep = SEXP_string_new(buf, len);
+			free(buf);
+		}
+
+		if (SEAP_sendsexp(ctx, sd, rep) != 0)
+			return 1;
+	}
+
+	SEXP_free(rep);
+	SEAP_CTX_free(ctx);
+	return 0;
+}
+
+static int check_payload(SEXP_t *s_exp, const char *expected, size_t len)
+{
+	char *buf;
+	int ret;
+
+	if (s_exp == NULL || !SEXP_stringp(s_exp) || SEXP_string_length(s_exp) != len)
+		return 1;
+
+	buf = SEXP_string_cstr(s_exp);
+	ret = memcmp(buf, expected, len) != 0;
+	free(buf);
+
+	return ret;
+}
+
+static int bench(const char *scheme, const char *self, int rounds)
+{
+	char uri[PATH_MAX + 16];
+	SEAP_CTX_t *ctx;
+	SEXP_t *req, *rep;
+	char *expected;
+	struct timespec t0, t1;
+	size_t s;
+	int sd, r, ret = 0;
+
+	snprintf(uri, sizeof uri, "%s://%s", scheme, self);
+
+	ctx = SEAP_CTX_new();
+	sd = SEAP_connect(ctx, uri, 0);
+	if (sd < 0) {
+		fprintf(stderr, "%s: can't connect to the peer\n", scheme);
+		SEAP_CTX_free(ctx);
+		return 1;
+	}
+
+	for (s = 0; s < sizeof sizes / sizeof sizes[0] && ret == 0; ++s) {
+		req = SEXP_number_newu_64(sizes[s]);
+		expected = payload(sizes[s]);
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+
+		for (r = 0; r < rounds; ++r) {
+			rep = NULL;
+			if (SEAP_sendsexp(ctx, sd, req) != 0 || SEAP_recvsexp(ctx, sd, &rep) != 0 ||
+			    check_payload(rep, expected, sizes[s]) != 0) {
+				fprintf(stderr, "%s: message of %zu bytes not received\n", scheme, sizes[s]);
+				ret = 1;
+				SEXP_free(rep);
+				break;
+			}
+			SEXP_free(rep);
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		SEXP_free(req);
+		free(expected);
+
+		if (ret == 0) {
+			double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+
+			printf("%-4s: %8zu bytes, %.3f ms per message, %.1f MB/s\n", scheme, sizes[s],
+			       ms / rounds, sizes[s] * rounds / ms / 1e3);
+		}
+	}
+
+	SEAP_close(ctx, sd);
+	SEAP_CTX_free(ctx);
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	char self[PATH_MAX];
+	int rounds, ret = 0;
+
+	if (getenv(PEER_ENV) != NULL)
+		return peer();
+
+	rounds = argc > 1 ? atoi(argv[1]) : 20;
+	if (rounds < 1)
+		rounds = 1;
+
+	if (realpath("/proc/self/exe", self) == NULL) {
+		perror("realpath");
+		return 1;
+	}
+	setenv(PEER_ENV, "1", 1);
+
+	ret |= bench("pipe", self, rounds);
+	ret |= bench("shm", self, rounds);
+
+	return ret;
+}
@@ -49,6 +49,35 @@ function test_generate_report_custom {
     return 1
 }
 
+# Writes a benchmark of 2,000 rules checked by OVAL, half of them fail.
+function generate_benchmark {
+    local OUTPUT=$1
+
+    cp $srcdir/../unittests/test_default_selector.oval.xml test_report_cache.oval.xml
+    {
+        echo '<?xml version="1.0" encoding="UTF-8"?>'
+        echo '<Benchmark xmlns="http://checklists.nist.gov/xccdf/1.2" id="xccdf_moc.elpmaxe.www_benchmark_report" resolved="1">'
+        echo '  <status>accepted</status>'
+        echo '  <version>1.0</version>'
+        for i in $(seq 2000); do
+            echo "  <Rule selected=\"true\" id=\"xccdf_moc.elpmaxe.www_rule_$i\">"
+            echo "    <title>Rule $i</title>"
+            echo "    <description>Description of the rule $i.</description>"
+            echo '    <check system="http://oval.mitre.org/XMLSchema/oval-definitions-5">'
+            echo "      <check-content-ref href=\"test_report_cache.oval.xml\" name=\"oval:x:def:$((i % 2 + 1))\"/>"
+            echo '    </check>'
+            echo '  </Rule>'
+        done
+        echo '</Benchmark>'
+    } > $OUTPUT
+}
+
+function test_report_cache {
+    generate_benchmark test_report_cache.xccdf.xml
+    ./test_report_cache test_report_cache.xccdf.xml
+    grep -q xccdf_moc.elpmaxe.www_rule_2000 test_report_cache.html.out
+}
+
 # Testing.
 
 test_init "test_api_xccdf_report.log"
@@ -63,5 +92,6 @@ test_run "test_api_xccdf_report_idents" test_generate_report results-idents-refs
 test_run "test_api_xccdf_report_refs" test_generate_report results-idents-refs.xml referencereferencereference
 test_run "test_api_xccdf_report_no_title" test_generate_report results-xccdf12.xml "ID: xccdf_moc.elpmaxe.www_rule_1"
 test_run "test_api_xccdf_report_title" test_generate_report results-title.xml "RULETITLE"
+test_run "test_api_xccdf_report_cache" test_report_cache
 
 test_exit
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Evaluates the given XCCDF benchmark, exports the results and the HTML
+ * report to files and renders the report in memory repeatedly, then
+ * transforms the results from several threads at once and checks that
+ * a changed stylesheet, or a stylesheet whose included file changed, is
+ * compiled again. Reports the times.
+ *
+ * Usage: test_report_cache <xccdf>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <oscap.h>
+#include <oscap_error.h>
+#include <xccdf_session.h>
+#include "common/oscap_timing.h"
+
+#define ROUNDS 5
+#define THREADS 4
+
+#define RESULTS_FILE "test_report_cache.results.out"
+#define REPORT_FILE "test_report_cache.html.out"
+
+static const char stylesheet[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<xsl:stylesheet version=\"1.0\" xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\">\n"
+	"  <xsl:output method=\"text\"/>\n"
+	"  <xsl:template match=\"/\">%s</xsl:template>\n"
+	"</xsl:stylesheet>\n";
+
+#define INCLUDED_FILE "test_report_cache.inc.out"
+
+static const char including_stylesheet[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<xsl:stylesheet version=\"1.0\" xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\">\n"
+	"  <xsl:include href=\"" INCLUDED_FILE "\"/>\n"
+	"</xsl:stylesheet>\n";
+
+static char *read_file(const char *file)
+{
+	FILE *f = fopen(file, "r");
+	char *buf = NULL;
+	long size;
+
+	if (f == NULL) {
+		fprintf(stderr, "%s: can't open\n", file);
+		return NULL;
+	}
+	if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+		buf = malloc(size + 1);
+		if (fread(buf, 1, size, f) != (size_t) size) {
+			free(buf);
+			buf = NULL;
+		} else {
+			buf[size] = '\0';
+		}
+	}
+	fclose(f);
+	return buf;
+}
+
+static int compare_file(const char *file, const char *expected)
+{
+	char *content = read_file(file);
+	int ret = content == NULL || strcmp(content, expected) != 0;
+
+	if (ret)
+		fprintf(stderr, "%s: unexpected content\n", file);
+	free(content);
+	return ret;
+}
+
+static int test_session(const char *xccdf)
+{
+	struct xccdf_session *session = xccdf_session_new(xccdf);
+	struct timespec start;
+	double first, cached = 0;
+	char *report;
+	int r, ret = 0;
+
+	if (session == NULL)
+		return 1;
+	xccdf_session_set_xccdf_export(session, RESULTS_FILE);
+	xccdf_session_set_report_export(session, REPORT_FILE);
+	if (xccdf_session_load(session) != 0 || xccdf_session_evaluate(session) != 0) {
+		fprintf(stderr, "%s: can't evaluate: %s\n", xccdf, oscap_err_desc());
+		xccdf_session_free(session);
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (xccdf_session_export_xccdf(session) != 0)
+		ret = 1;
+	first = oscap_elapsed_ms(&start);
+	report = read_file(REPORT_FILE);
+	if (report == NULL) {
+		xccdf_session_free(session);
+		return 1;
+	}
+
+	for (r = 0; r < ROUNDS; ++r) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		char *html = xccdf_session_get_html_report(session);
+		cached += oscap_elapsed_ms(&start);
+		if (html == NULL || strcmp(html, report) != 0) {
+			fprintf(stderr, "%s: report rendered in memory differs from %s\n", xccdf, REPORT_FILE);
+			ret = 1;
+		}
+		free(html);
+	}
+	printf("%s: first report: %.3f ms, rendered in memory: %.3f ms\n", xccdf, first, cached / ROUNDS);
+
+	free(report);
+	xccdf_session_free(session);
+	return ret;
+}
+
+struct thread_arg {
+	char output[64];
+};
+
+static void *thread_fn(void *arg)
+{
+	struct thread_arg *targ = arg;
+	const char *params[] = { "show", "", NULL };
+
+	return oscap_apply_xslt(RESULTS_FILE, "xccdf-report.xsl", targ->output, params) == -1 ? arg : NULL;
+}
+
+static int test_threads(void)
+{
+	struct thread_arg args[THREADS];
+	pthread_t threads[THREADS];
+	struct timespec start;
+	char *expected;
+	void *failed;
+	int i, ret = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < THREADS; ++i) {
+		snprintf(args[i].output, sizeof(args[i].output), "test_report_cache.%d.out", i);
+		pthread_create(&threads[i], NULL, thread_fn, &args[i]);
+	}
+	for (i = 0; i < THREADS; ++i) {
+		pthread_join(threads[i], &failed);
+		if (failed != NULL) {
+			fprintf(stderr, "%s: transformation failed: %s\n", RESULTS_FILE, oscap_err_desc());
+			ret = 1;
+		}
+	}
+	printf("%s: %d threads: %.3f ms\n", RESULTS_FILE, THREADS, oscap_elapsed_ms(&start));
+
+	expected = read_file(args[0].output);
+	if (expected == NULL)
+		return 1;
+	for (i = 1; i < THREADS; ++i)
+		ret |= compare_file(args[i].output, expected);
+	free(expected);
+	return ret;
+}
+
+/* writes the stylesheet printing @text, or the one including INCLUDED_FILE if @text is NULL */
+static int write_stylesheet(const char *xsl, const char *text, char *path)
+{
+	FILE *f = fopen(xsl, "w");
+	if (f == NULL || realpath(xsl, path) == NULL) {
+		if (f != NULL)
+			fclose(f);
+		fprintf(stderr, "%s: can't write the stylesheet\n", xsl);
+		return 1;
+	}
+	if (text != NULL)
+		fprintf(f, stylesheet, text);
+	else
+		fputs(including_stylesheet, f);
+	fclose(f);
+	return 0;
+}
+
+static int transform(const char *path, const char *text)
+{
+	const char *params[] = { NULL };
+	int ret;
+
+	if (oscap_apply_xslt(RESULTS_FILE, path, "test_report_cache.txt.out", params) == -1) {
+		fprintf(stderr, "%s: transformation failed: %s\n", path, oscap_err_desc());
+		return 1;
+	}
+	ret = compare_file("test_report_cache.txt.out", text);
+	if (ret)
+		fprintf(stderr, "%s: the stylesheet has not been compiled again\n", path);
+	return ret;
+}
+
+static int apply_stylesheet(const char *text)
+{
+	char path[PATH_MAX];
+
+	if (write_stylesheet("test_report_cache.xsl.out", text, path) != 0)
+		return 1;
+	return transform(path, text);
+}
+
+/* only the included file is rewritten, the stylesheet itself doesn't change */
+static int apply_included_stylesheet(const char *path, const char *text)
+{
+	char included[PATH_MAX];
+
+	if (write_stylesheet(INCLUDED_FILE, text, included) != 0)
+		return 1;
+	return transform(path, text);
+}
+
+int main(int argc, char *argv[])
+{
+	int ret;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <xccdf>\n", argv[0]);
+		return 1;
+	}
+
+	oscap_init();
+
+	ret = test_session(argv[1]);
+	if (ret != 0) {
+		oscap_cleanup();
+		return ret;
+	}
+
+	/* all the threads start with the stylesheet not compiled */
+	oscap_cleanup();
+	oscap_init();
+	ret |= test_threads();
+
+	/* the stylesheet is rewritten with a different size */
+	ret |= apply_stylesheet("first");
+	ret |= apply_stylesheet("second one");
+
+	/* the included file is rewritten with a different size */
+	char path[PATH_MAX];
+	ret |= write_stylesheet("test_report_cache.main.xsl.out", NULL, path);
+	ret |= apply_included_stylesheet(path, "first");
+	ret |= apply_included_stylesheet(path, "second one");
+
+	oscap_cleanup();
+	return ret;
+}
@@ -24,6 +24,7 @@ fi
 test_run "Test unscored roles" $srcdir/test_xccdf_role_unscored.sh
 test_run "Fix containing unresolved elements" $srcdir/test_remediate_unresolved.sh
 test_run "Empty XCCDF variable element" $srcdir/test_empty_variable.sh
+test_run "Parallel collection of OVAL objects" $srcdir/test_eval_threads.sh
 test_run "Test xccdf:fix/xccdf:instance elements" $srcdir/test_fix_instance.sh
 test_run "Escaping of xml &amp within xccdf:value" $srcdir/test_xccdf_xml_escaping_value.sh
 test_run "check/@negate" $srcdir/test_xccdf_check_negate.sh
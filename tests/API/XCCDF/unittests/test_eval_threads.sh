@@ -0,0 +1,27 @@
+#!/bin/bash
+
+# Parallel collection of OVAL objects must not change the results
+# and it must not collect objects of rules which are not evaluated.
+
+set -e
+set -o pipefail
+
+name=$(basename $0 .sh)
+
+sequential=$(mktemp -t ${name}.arf.out.XXXXXX)
+parallel=$(mktemp -t ${name}.arf.out.XXXXXX)
+stderr=$(mktemp -t ${name}.err.XXXXXX)
+
+$OSCAP xccdf eval --results-arf $sequential $srcdir/${name}.xccdf.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]
+$OSCAP xccdf eval --threads 3 --results-arf $parallel $srcdir/${name}.xccdf.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; rm $stderr
+
+for result in $sequential $parallel; do
+	assert_exists 2 '//rule-result/result[text()="pass"]'
+	assert_exists 1 '//rule-result/result[text()="notselected"]'
+	assert_exists 5 '//collected_objects/object'
+	assert_exists 0 '//collected_objects/object[@id="oval:x:obj:6"]'
+done
+
+rm $sequential $parallel
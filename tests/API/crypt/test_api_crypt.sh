@@ -80,6 +80,28 @@ function test_crapi_mdigest {
     return 0
 }
 
+function test_crapi_throughput {
+    local TEMPDIR="$(mktemp -d -t -q tmp.XXXXXX)"
+    local i
+
+    # mixed sizes, from a few bytes to 16 MB
+    for i in $(seq 1 200); do
+        dd if=/dev/urandom of="${TEMPDIR}/small$i" count=1 bs=$((i * 37)) 2>/dev/null || return 2
+    done
+    for i in $(seq 1 40); do
+        dd if=/dev/urandom of="${TEMPDIR}/medium$i" count=$i bs=16k 2>/dev/null || return 2
+    done
+    for i in 1 2 4 8 16; do
+        dd if=/dev/urandom of="${TEMPDIR}/large$i" count=$i bs=1024k 2>/dev/null || return 2
+    done
+
+    ./test_crapi_throughput "${TEMPDIR}" || return 1
+
+    rm -rf "$TEMPDIR"
+
+    return 0
+}
+
 # Testing.
 
 test_init "test_api_crypt.log"
@@ -87,6 +109,7 @@ test_init "test_api_crypt.log"
 if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "test_crapi_digest" test_crapi_digest
     test_run "test_crapi_mdigest" test_crapi_mdigest
+    test_run "test_crapi_throughput" test_crapi_throughput
 fi
 
 test_exit
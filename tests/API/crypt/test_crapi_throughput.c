@@ -0,0 +1,206 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Hashes the regular files of a directory by MD5, SHA-1, SHA-256 and
+ * SHA-512 with a pass over each file per algorithm, with one pass per
+ * file and with one pass per file on several threads. Checks that the
+ * digests are the same and reports the throughput in MB/s.
+ *
+ * Usage: test_crapi_throughput <directory>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <dirent.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <crapi/crapi.h>
+#include <crapi/digest.h>
+#include "common/oscap_timing.h"
+
+static const crapi_alg_t algs[] = {
+        CRAPI_DIGEST_MD5,
+        CRAPI_DIGEST_SHA1,
+        CRAPI_DIGEST_SHA256,
+        CRAPI_DIGEST_SHA512
+};
+
+#define ALG_CNT (sizeof algs / sizeof algs[0])
+
+static void prepare (struct crapi_file_digest *files, char **paths, size_t count)
+{
+        size_t i, a;
+
+        memset (files, 0, count * sizeof (struct crapi_file_digest));
+
+        for (i = 0; i < count; ++i) {
+                files[i].path = paths[i];
+                files[i].num  = ALG_CNT;
+
+                for (a = 0; a < ALG_CNT; ++a)
+                        files[i].alg[a] = algs[a];
+        }
+}
+
+/* the way filehash58 used to hash, the file is read once per algorithm */
+static int hash_per_algorithm (struct crapi_file_digest *files, size_t count)
+{
+        size_t i, a;
+        int fd;
+
+        for (i = 0; i < count; ++i) {
+                for (a = 0; a < ALG_CNT; ++a) {
+                        files[i].size[a] = sizeof files[i].dst[a];
+
+                        if ((fd = open (files[i].path, O_RDONLY)) < 0) {
+                                perror (files[i].path);
+                                return (-1);
+                        }
+
+                        if (crapi_mdigest_fd (fd, 1, algs[a], files[i].dst[a], &files[i].size[a]) != 0) {
+                                perror (files[i].path);
+                                close (fd);
+                                return (-1);
+                        }
+
+                        close (fd);
+                }
+        }
+
+        return (0);
+}
+
+static int compare (const struct crapi_file_digest *ref, const struct crapi_file_digest *files,
+                    size_t count, const char *name)
+{
+        size_t i, a;
+
+        for (i = 0; i < count; ++i) {
+                if (files[i].error != 0) {
+                        fprintf (stderr, "%s: %s: %s\n", name, files[i].path, strerror (files[i].error));
+                        return (1);
+                }
+
+                for (a = 0; a < ALG_CNT; ++a) {
+                        if (files[i].size[a] == 0 ||
+                            memcmp (ref[i].dst[a], files[i].dst[a], files[i].size[a]) != 0) {
+                                fprintf (stderr, "%s: %s: digest %zu differs\n", name, files[i].path, a);
+                                return (1);
+                        }
+                }
+        }
+
+        return (0);
+}
+
+int main (int argc, char *argv[])
+{
+        struct crapi_file_digest *ref, *files;
+        struct timespec start;
+        struct dirent *de;
+        struct stat st;
+        char   path[PATH_MAX], **paths = NULL;
+        size_t count = 0, i;
+        double mb = 0, ms;
+        DIR   *dir;
+        int    ret = 0;
+
+        if (argc != 2) {
+                fprintf (stderr, "Usage: %s <directory>\n", argv[0]);
+                return (1);
+        }
+
+        if (crapi_init (NULL) != 0) {
+                fprintf (stderr, "crapi_init() != 0\n");
+                return (1);
+        }
+
+        if ((dir = opendir (argv[1])) == NULL) {
+                perror (argv[1]);
+                return (2);
+        }
+
+        while ((de = readdir (dir)) != NULL) {
+                snprintf (path, sizeof path, "%s/%s", argv[1], de->d_name);
+
+                if (stat (path, &st) != 0 || !S_ISREG (st.st_mode))
+                        continue;
+
+                paths = realloc (paths, (count + 1) * sizeof (char *));
+                paths[count++] = strdup (path);
+                mb += st.st_size / (1024.0 * 1024.0);
+        }
+
+        closedir (dir);
+
+        ref   = malloc (count * sizeof (struct crapi_file_digest));
+        files = malloc (count * sizeof (struct crapi_file_digest));
+
+        /* warm up the page cache */
+        prepare (files, paths, count);
+        crapi_mdigest_files (files, count, 1);
+
+        printf ("%zu files, %.1f MB, %zu algorithms\n", count, mb, ALG_CNT);
+
+        prepare (ref, paths, count);
+        clock_gettime (CLOCK_MONOTONIC, &start);
+        if (hash_per_algorithm (ref, count) != 0)
+                return (1);
+        ms = oscap_elapsed_ms (&start);
+        printf ("pass per algorithm: %.3f ms, %.1f MB/s\n", ms, mb * 1e3 / ms);
+
+        prepare (files, paths, count);
+        clock_gettime (CLOCK_MONOTONIC, &start);
+        crapi_mdigest_files (files, count, 1);
+        ms = oscap_elapsed_ms (&start);
+        printf ("pass per file: %.3f ms, %.1f MB/s\n", ms, mb * 1e3 / ms);
+        ret |= compare (ref, files, count, "pass per file");
+
+        prepare (files, paths, count);
+        clock_gettime (CLOCK_MONOTONIC, &start);
+        crapi_mdigest_files (files, count, 0);
+        ms = oscap_elapsed_ms (&start);
+        printf ("pass per file, %ld threads: %.3f ms, %.1f MB/s\n",
+                sysconf (_SC_NPROCESSORS_ONLN), ms, mb * 1e3 / ms);
+        ret |= compare (ref, files, count, "threads");
+
+        prepare (files, paths, count);
+        crapi_mdigest_files (files, count, 4);
+        ret |= compare (ref, files, count, "4 threads");
+
+        for (i = 0; i < count; ++i)
+                free (paths[i]);
+        free (paths);
+        free (ref);
+        free (files);
+
+        return (ret);
+}
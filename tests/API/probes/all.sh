@@ -6,7 +6,13 @@ test_init "test_api_probes.log"
 
 if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "fts test" $srcdir/fts.sh
+    test_run "fts test with the parallel walker" OSCAP_PROBE_FTS_THREADS=4 $srcdir/fts.sh
+    test_run "parallel directory walk" ./test_api_probes_fts_walk 20000 4
     test_run "probe api smoke test" ./test_api_probes_smoke
+    test_run "probe item cache" ./test_api_probes_icache 2000
+    test_run "probe set operations" ./test_api_probes_setop 100000
+    test_run "probe keepalive" ./test_api_probes_keepalive $srcdir/keepalive.xml 10
+    test_run "probe keepalive over shared memory" OSCAP_PROBE_SHM=all ./test_api_probes_keepalive $srcdir/keepalive.xml 3
 fi
 
 test_exit
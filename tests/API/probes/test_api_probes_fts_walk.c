@@ -0,0 +1,225 @@
+/*
+ * Parallel directory walk benchmark.
+ *
+ * Generates a synthetic tree with the given number of files (100 per
+ * directory, 10 subdirectories per directory, a few symlinks to files,
+ * directories and nowhere, and symlinks making cycles) and lists it with
+ * oval_fts using fts and the parallel walker with the given number of
+ * threads. Both have to return the same entries in the same order. The
+ * time of every walk is reported. Finally the parallel walk is closed
+ * before reading all of the entries.
+ *
+ * Usage: test_api_probes_fts_walk [files] [threads]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <ftw.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "sexp.h"
+#include "oval_fts.h"
+#include "probe-api.h"
+
+#define FILES_PER_DIR 100
+#define SUBDIRS       10
+
+struct walk_result {
+	size_t   count;
+	uint64_t hash;
+	double   ms;
+};
+
+static size_t gen_files;
+
+static int gen_dir(const char *path, size_t level, size_t files)
+{
+	char sub[PATH_MAX];
+	size_t i, n, per_sub;
+	int fd;
+
+	if (mkdir(path, 0755) != 0)
+		return -1;
+
+	n = files < FILES_PER_DIR ? files : FILES_PER_DIR;
+	for (i = 0; i < n; ++i) {
+		snprintf(sub, sizeof sub, "%s/f%zu", path, i);
+		if ((fd = open(sub, O_CREAT | O_WRONLY, 0644)) < 0)
+			return -1;
+		close(fd);
+	}
+	gen_files += n;
+	files -= n;
+
+	if (level % 3 == 1) {
+		snprintf(sub, sizeof sub, "%s/lf", path);
+		symlink("f0", sub);
+		snprintf(sub, sizeof sub, "%s/ln", path);
+		symlink("nowhere", sub);
+		snprintf(sub, sizeof sub, "%s/lp", path);
+		symlink("..", sub);
+	}
+
+	if (files == 0)
+		return 0;
+
+	per_sub = (files + SUBDIRS - 1) / SUBDIRS;
+	for (i = 0; i < SUBDIRS && files > 0; ++i) {
+		n = files < per_sub ? files : per_sub;
+		snprintf(sub, sizeof sub, "%s/d%zu", path, i);
+		if (gen_dir(sub, level + 1, n) != 0)
+			return -1;
+		files -= n;
+	}
+
+	if (level % 3 == 2) {
+		snprintf(sub, sizeof sub, "%s/ld", path);
+		symlink("d0", sub);
+	}
+
+	return 0;
+}
+
+static int rm_ent(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+	return remove(path);
+}
+
+static SEXP_t *parse(const char *str)
+{
+	SEXP_psetup_t *psetup = SEXP_psetup_new();
+	SEXP_pstate_t *pstate = NULL;
+	SEXP_t *list, *first;
+
+	list = SEXP_parse(psetup, (char *)str, strlen(str), &pstate);
+	first = SEXP_list_first(list);
+
+	SEXP_free(list);
+	SEXP_psetup_free(psetup);
+	return first;
+}
+
+static int walk(const char *root, const char *filename, const char *recurse, const char *max_depth,
+                const char *threads, size_t limit, struct walk_result *res)
+{
+	char buf[PATH_MAX + 128];
+	SEXP_t *path, *fname, *behaviors, *result;
+	OVAL_FTS *ofts;
+	OVAL_FTSENT *ent;
+	struct timespec t0, t1;
+	const char *s;
+
+	setenv(OVAL_FTS_WALK_ENV_THREADS, threads, 1);
+
+	snprintf(buf, sizeof buf, "((path :operation 5) \"%s\")", root);
+	path = parse(buf);
+	fname = parse(filename);
+	snprintf(buf, sizeof buf, "((behaviors :max_depth \"%s\" :recurse \"%s\" "
+	         ":recurse_direction \"down\" :recurse_file_system \"all\"))", max_depth, recurse);
+	behaviors = parse(buf);
+	result = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, NULL, NULL);
+
+	res->count = 0;
+	res->hash = UINT64_C(14695981039346656037);
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	ofts = oval_fts_open(path, fname, NULL, behaviors, result);
+	if (ofts == NULL)
+		return -1;
+
+	while ((ent = oval_fts_read(ofts)) != NULL) {
+		for (s = ent->path; *s != '\0'; ++s)
+			res->hash = (res->hash ^ (unsigned char)*s) * UINT64_C(1099511628211);
+		res->hash = (res->hash ^ '/') * UINT64_C(1099511628211);
+		for (s = ent->file != NULL ? ent->file : ""; *s != '\0'; ++s)
+			res->hash = (res->hash ^ (unsigned char)*s) * UINT64_C(1099511628211);
+		res->hash = (res->hash ^ ent->fts_info) * UINT64_C(1099511628211);
+		++res->count;
+		oval_ftsent_free(ent);
+		if (res->count == limit)
+			break;
+	}
+
+	oval_fts_close(ofts);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	res->ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+
+	SEXP_free(path);
+	SEXP_free(fname);
+	SEXP_free(behaviors);
+	SEXP_free(result);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct {
+		const char *filename;
+		const char *recurse;
+		const char *max_depth;
+	} cases[] = {
+		{ "((filename :operation 11) \"^f\")", "symlinks and directories", "-1" },
+		{ "((filename :operation 11) \"^l\")", "symlinks and directories", "-1" },
+		{ "((filename :operation 5))", "symlinks and directories", "-1" },
+		{ "((filename :operation 5))", "files and directories", "2" },
+		{ "((filename :operation 11) \"^f1\")", "directories", "3" },
+		{ "((filename :operation 11) \".*\")", "symlinks", "-1" },
+	};
+	size_t files = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+	const char *threads = argc > 2 ? argv[2] : "4";
+	char tmpl[] = "/tmp/fts_walk.XXXXXX", root[PATH_MAX];
+	struct walk_result seq, par;
+	size_t i;
+	int ret = 0;
+
+	if (mkdtemp(tmpl) == NULL) {
+		perror("mkdtemp");
+		return 2;
+	}
+	snprintf(root, sizeof root, "%s/root", tmpl);
+
+	if (gen_dir(root, 0, files) != 0) {
+		perror("generating the tree");
+		ret = 2;
+		goto cleanup;
+	}
+	printf("tree: %zu files\n", gen_files);
+
+	for (i = 0; i < sizeof cases / sizeof cases[0]; ++i) {
+		if (walk(root, cases[i].filename, cases[i].recurse, cases[i].max_depth, "1", 0, &seq) != 0 ||
+		    walk(root, cases[i].filename, cases[i].recurse, cases[i].max_depth, threads, 0, &par) != 0) {
+			fprintf(stderr, "%s: oval_fts_open() failed\n", cases[i].filename);
+			ret = 1;
+			continue;
+		}
+
+		printf("%-36s %-26s %3s: %8zu entries, fts %9.1f ms, %s threads %9.1f ms\n",
+		       cases[i].filename, cases[i].recurse, cases[i].max_depth, seq.count,
+		       seq.ms, threads, par.ms);
+
+		if (seq.count != par.count || seq.hash != par.hash) {
+			fprintf(stderr, "The parallel walk differs: %zu entries instead of %zu\n",
+			        par.count, seq.count);
+			ret = 1;
+		}
+	}
+
+	if (walk(root, cases[2].filename, cases[2].recurse, cases[2].max_depth, threads, 10, &par) != 0 ||
+	    par.count != 10) {
+		fprintf(stderr, "Closing the parallel walk early failed\n");
+		ret = 1;
+	}
+
+cleanup:
+	nftw(tmpl, rm_ent, 64, FTW_DEPTH | FTW_PHYS);
+	return ret;
+}
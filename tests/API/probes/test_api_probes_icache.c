@@ -0,0 +1,196 @@
+/*
+ * Item cache benchmark.
+ *
+ * Every collecting thread submits the same set of items twice to its own
+ * collected object through the item cache, one by one and in batches. The
+ * program reports the throughput in items per second for 1, 2, 4 and 8
+ * collecting threads and checks that duplicate items were merged. Items
+ * have one entity unless a larger number of entities is requested; the
+ * extra entities hold path-like strings, as file items do.
+ *
+ * Usage: test_api_probes_icache [items-per-thread [entities]]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sexp.h>
+#include <probe-api.h>
+#include "OVAL/probes/probe/probe.h"
+
+#define BATCH_SIZE 64
+
+struct collector {
+	pthread_t thread;
+	struct probe_ctx ctx;
+	SEXP_t **items;
+	size_t count;
+	int batch;
+	int failed;
+};
+
+static unsigned int entities = 1;
+
+static SEXP_t *item_new(size_t value)
+{
+	char name[32], path[96];
+	SEXP_t *item, *val;
+	unsigned int e;
+
+	snprintf(name, sizeof(name), "item%zu", value);
+
+	item = probe_item_create(OVAL_INDEPENDENT_FAMILY, NULL,
+	                         "family", OVAL_DATATYPE_STRING, name,
+	                         NULL);
+
+	for (e = 1; e < entities; ++e) {
+		snprintf(name, sizeof(name), "entity%u", e);
+		snprintf(path, sizeof(path), "/usr/share/doc/package%zu/subdirectory%u/file%zu.txt",
+		         value / 100, e, value);
+		val = SEXP_string_new(path, strlen(path));
+		probe_item_ent_add(item, name, NULL, val);
+		SEXP_free(val);
+	}
+
+	return item;
+}
+
+static void *collect(void *arg)
+{
+	struct collector *c = arg;
+	size_t i, n;
+
+	if (!c->batch) {
+		for (i = 0; i < c->count; ++i)
+			if (probe_item_collect(&c->ctx, c->items[i]) != 0)
+				c->failed = 1;
+	} else {
+		for (i = 0; i < c->count; i += n) {
+			n = c->count - i < BATCH_SIZE ? c->count - i : BATCH_SIZE;
+			if (probe_item_collect_batch(&c->ctx, c->items + i, n) != 0)
+				c->failed = 1;
+		}
+	}
+
+	return NULL;
+}
+
+static char *item_id(SEXP_t *items, size_t n)
+{
+	SEXP_t *item = SEXP_list_nth(items, n + 1);
+	SEXP_t *id = probe_obj_getattrval(item, "id");
+	char *str = SEXP_string_cstr(id);
+
+	SEXP_free(id);
+	SEXP_free(item);
+	return str;
+}
+
+/*
+ * The second half of every collected object repeats the first half, so
+ * both halves must refer to the same cached items.
+ */
+static int check_cobj(SEXP_t *cobj, size_t count)
+{
+	SEXP_t *items = probe_cobj_get_items(cobj);
+	size_t i, half = count / 2;
+	int ret = 0;
+
+	if (SEXP_list_length(items) != count) {
+		fprintf(stderr, "Expected %zu items, got %zu.\n", count, SEXP_list_length(items));
+		ret = 1;
+	}
+	for (i = 0; ret == 0 && i < half; i += half / 8 + 1) {
+		char *first = item_id(items, i), *second = item_id(items, i + half);
+		char *next = item_id(items, (i + 1) % half);
+
+		if (strcmp(first, second) != 0 || (half > 1 && strcmp(first, next) == 0)) {
+			fprintf(stderr, "Item %zu was not merged correctly: %s %s %s\n",
+			        i, first, second, next);
+			ret = 1;
+		}
+		free(first);
+		free(second);
+		free(next);
+	}
+	SEXP_free(items);
+	return ret;
+}
+
+static int run(unsigned int threads, size_t count, int batch)
+{
+	struct collector collectors[threads];
+	struct timespec start, end;
+	unsigned int t;
+	size_t i;
+	int ret = 0;
+
+	probe_icache_t *cache = probe_icache_new();
+
+	for (t = 0; t < threads; ++t) {
+		struct collector *c = &collectors[t];
+
+		c->ctx.probe_in = NULL;
+		c->ctx.probe_out = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, NULL, NULL);
+		c->ctx.filters = NULL;
+		c->ctx.icache = cache;
+		c->count = count;
+		c->batch = batch;
+		c->failed = 0;
+		c->items = malloc(count * sizeof(SEXP_t *));
+		for (i = 0; i < count; ++i)
+			c->items[i] = item_new(i % (count / 2));
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (t = 0; t < threads; ++t)
+		pthread_create(&collectors[t].thread, NULL, collect, &collectors[t]);
+	for (t = 0; t < threads; ++t)
+		pthread_join(collectors[t].thread, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("threads: %u, %-8s %10.0f items/s\n", threads, batch ? "batch:" : "single:",
+	       threads * count / elapsed);
+
+	for (t = 0; t < threads; ++t) {
+		struct collector *c = &collectors[t];
+
+		if (c->failed || check_cobj(c->ctx.probe_out, count) != 0)
+			ret = 1;
+		SEXP_free(c->ctx.probe_out);
+		free(c->items);
+	}
+	probe_icache_free(cache);
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	static const unsigned int threads[] = { 1, 2, 4, 8 };
+	size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+	unsigned int i;
+	int ret = 0;
+
+	if (argc > 2)
+		entities = strtoul(argv[2], NULL, 10);
+	if (entities < 1)
+		entities = 1;
+	if (count < 2)
+		count = 2;
+	count &= ~(size_t)1;
+
+	for (i = 0; i < sizeof(threads) / sizeof(threads[0]); ++i) {
+		ret |= run(threads[i], count, 0);
+		ret |= run(threads[i], count, 1);
+	}
+
+	return ret;
+}
@@ -0,0 +1,220 @@
+/*
+ * Probe keepalive test.
+ *
+ * Evaluates the given OVAL definitions repeatedly, every time by a new OVAL
+ * agent session, first with the probes terminated together with the session
+ * and then with the probes kept alive. Checks that the running probes are
+ * reused by the next session, that a killed or a stopped probe is replaced
+ * and that the results don't change. Reports the time per scan in both modes.
+ *
+ * Usage: test_api_probes_keepalive definitions.xml [rounds]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <dirent.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <oscap.h>
+#include <oscap_error.h>
+#include <oscap_source.h>
+#include <oval_agent_api.h>
+#include <oval_probe_session.h>
+
+#define MAX_DEFS   16
+#define MAX_PROBES 64
+
+static const char *def_ids[MAX_DEFS];
+static size_t def_count = 0;
+
+/* collects the probes, i.e. the child processes of this process */
+static size_t probe_pids(pid_t *pids)
+{
+	DIR *dir = opendir("/proc");
+	struct dirent *ent;
+	size_t count = 0;
+
+	while (dir != NULL && (ent = readdir(dir)) != NULL && count < MAX_PROBES) {
+		char path[PATH_MAX], buf[512], *p;
+		FILE *fp;
+		int ppid;
+
+		if (ent->d_name[0] < '0' || ent->d_name[0] > '9')
+			continue;
+		snprintf(path, sizeof(path), "/proc/%s/stat", ent->d_name);
+		if ((fp = fopen(path, "r")) == NULL)
+			continue;
+		p = fgets(buf, sizeof(buf), fp);
+		fclose(fp);
+		/* pid (comm) state ppid ... */
+		if (p == NULL || (p = strrchr(buf, ')')) == NULL)
+			continue;
+		if (sscanf(p + 1, " %*c %d", &ppid) == 1 && ppid == getpid())
+			pids[count++] = atoi(ent->d_name);
+	}
+	if (dir != NULL)
+		closedir(dir);
+
+	return count;
+}
+
+static int pid_cmp(const void *a, const void *b)
+{
+	return *(const pid_t *)a - *(const pid_t *)b;
+}
+
+static int scan(const char *path, oval_result_t *results, double *ms)
+{
+	struct oscap_source *source = oscap_source_new_from_file(path);
+	struct oval_definition_model *model = oval_definition_model_import_source(source);
+	oval_agent_session_t *session;
+	struct timespec start, end;
+	size_t i;
+	int ret = 0;
+
+	oscap_source_free(source);
+	if (model == NULL) {
+		fprintf(stderr, "Failed to import '%s'.\n", path);
+		return 1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	session = oval_agent_new_session(model, "keepalive");
+	if (session == NULL || oval_agent_eval_system(session, NULL, NULL) != 0) {
+		fprintf(stderr, "Evaluation failed: %s\n", oscap_err_desc());
+		ret = 1;
+	}
+
+	for (i = 0; ret == 0 && i < def_count; ++i) {
+		if (oval_agent_get_definition_result(session, def_ids[i], &results[i]) != 0) {
+			fprintf(stderr, "No result of '%s'.\n", def_ids[i]);
+			ret = 1;
+		}
+	}
+
+	oval_agent_destroy_session(session);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	*ms += (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+	oval_definition_model_free(model);
+	return ret;
+}
+
+static int check_results(const oval_result_t *expected, const oval_result_t *results)
+{
+	size_t i;
+
+	for (i = 0; i < def_count; ++i) {
+		if (results[i] != expected[i]) {
+			fprintf(stderr, "Result of '%s' changed: %s -> %s\n", def_ids[i],
+			        oval_result_get_text(expected[i]), oval_result_get_text(results[i]));
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	oval_result_t expected[MAX_DEFS], results[MAX_DEFS];
+	pid_t pids[MAX_PROBES], pids_prev[MAX_PROBES];
+	size_t count, count_prev;
+	double ms_off = 0, ms_on = 0;
+	int rounds, r, ret = 0;
+
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s definitions.xml [rounds]\n", argv[0]);
+		return 2;
+	}
+	rounds = argc > 2 ? atoi(argv[2]) : 10;
+	if (rounds < 1)
+		rounds = 1;
+
+	def_ids[def_count++] = "oval:x:def:1";
+	def_ids[def_count++] = "oval:x:def:2";
+	def_ids[def_count++] = "oval:x:def:3";
+
+	/* probes terminated with the session */
+	for (r = 0; r < rounds && ret == 0; ++r) {
+		ret |= scan(argv[1], r == 0 ? expected : results, &ms_off);
+		if (r > 0)
+			ret |= check_results(expected, results);
+		if (probe_pids(pids) != 0) {
+			fprintf(stderr, "Probes are running after the session was destroyed.\n");
+			ret = 1;
+		}
+	}
+	if (ret != 0)
+		return ret;
+
+	/* probes kept alive and reused */
+	oval_probe_session_set_keepalive(true);
+	ret |= scan(argv[1], results, &ms_on);
+	ret |= check_results(expected, results);
+	count_prev = probe_pids(pids_prev);
+	qsort(pids_prev, count_prev, sizeof(pid_t), pid_cmp);
+	if (count_prev == 0) {
+		fprintf(stderr, "No probe is kept alive.\n");
+		ret = 1;
+	}
+
+	for (r = 1; r < rounds && ret == 0; ++r) {
+		ret |= scan(argv[1], results, &ms_on);
+		ret |= check_results(expected, results);
+		count = probe_pids(pids);
+		qsort(pids, count, sizeof(pid_t), pid_cmp);
+		if (count != count_prev || memcmp(pids, pids_prev, count * sizeof(pid_t)) != 0) {
+			fprintf(stderr, "The probes were not reused.\n");
+			ret = 1;
+		}
+	}
+	printf("keepalive off: %.3f ms per scan\n", ms_off / rounds);
+	printf("keepalive on:  %.3f ms per scan\n", ms_on / rounds);
+
+	/* a probe which died while idle is restarted */
+	if (ret == 0) {
+		kill(pids_prev[0], SIGKILL);
+		usleep(100000);
+		ret |= scan(argv[1], results, &ms_on);
+		ret |= check_results(expected, results);
+		count = probe_pids(pids);
+		qsort(pids, count, sizeof(pid_t), pid_cmp);
+		if (count != count_prev || bsearch(&pids_prev[0], pids, count, sizeof(pid_t), pid_cmp) != NULL) {
+			fprintf(stderr, "The killed probe was not restarted.\n");
+			ret = 1;
+		}
+	}
+
+	/* a probe which doesn't respond is killed and replaced */
+	if (ret == 0) {
+		count_prev = probe_pids(pids_prev);
+		qsort(pids_prev, count_prev, sizeof(pid_t), pid_cmp);
+		kill(pids_prev[0], SIGSTOP);
+		ret |= scan(argv[1], results, &ms_on);
+		ret |= check_results(expected, results);
+		count = probe_pids(pids);
+		qsort(pids, count, sizeof(pid_t), pid_cmp);
+		if (count != count_prev || bsearch(&pids_prev[0], pids, count, sizeof(pid_t), pid_cmp) != NULL) {
+			fprintf(stderr, "The stopped probe was not replaced.\n");
+			kill(pids_prev[0], SIGKILL);
+			ret = 1;
+		}
+	}
+
+	oval_probe_session_close_idle();
+	if (probe_pids(pids) != 0) {
+		fprintf(stderr, "Probes are running after the idle probes were closed.\n");
+		ret = 1;
+	}
+
+	oscap_cleanup();
+	return ret;
+}
@@ -0,0 +1,165 @@
+/*
+ * Set operation benchmark.
+ *
+ * Combines two unsorted collected objects which share half of their items
+ * using union, intersection and complement, reports the time spent by each
+ * operation and checks the results. The operations on empty and identical
+ * operands are checked as well.
+ *
+ * Usage: test_api_probes_setop [items-per-operand]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sexp.h>
+#include <probe-api.h>
+#include "OVAL/probes/probe/setop.h"
+
+static SEXP_t *item_new(size_t value)
+{
+	char name[32];
+
+	snprintf(name, sizeof(name), "item%zu", value);
+
+	return probe_item_create(OVAL_INDEPENDENT_FAMILY, NULL,
+	                         "family", OVAL_DATATYPE_STRING, name,
+	                         NULL);
+}
+
+static size_t item_value(const SEXP_t *item)
+{
+	SEXP_t *ent = probe_obj_getent(item, "family", 1);
+	SEXP_t *val = probe_ent_getval(ent);
+	char *str = SEXP_string_cstr(val);
+	size_t value = strtoul(str + strlen("item"), NULL, 10);
+
+	free(str);
+	SEXP_free(val);
+	SEXP_free(ent);
+	return value;
+}
+
+/* collected object with items [first, first + count) in random order */
+static SEXP_t *cobj_new(SEXP_t **items, size_t first, size_t count)
+{
+	SEXP_t **memb = malloc(count * sizeof(SEXP_t *));
+	SEXP_t *list, *cobj, *tmp;
+	size_t i, j;
+
+	for (i = 0; i < count; ++i)
+		memb[i] = items[first + i];
+	for (i = count; i > 1; --i) {
+		j = (size_t)rand() % i;
+		tmp = memb[i - 1];
+		memb[i - 1] = memb[j];
+		memb[j] = tmp;
+	}
+
+	list = SEXP_list_new_array(memb, count);
+	cobj = probe_cobj_new(SYSCHAR_FLAG_COMPLETE, NULL, list, NULL);
+
+	SEXP_free(list);
+	free(memb);
+	return cobj;
+}
+
+/*
+ * Check that the result has the expected number of items, that the items
+ * are within [lo, hi) and that no item is there twice.
+ */
+static int check(const char *name, SEXP_t *cobj, size_t count, size_t lo, size_t hi)
+{
+	SEXP_t *items = probe_cobj_get_items(cobj);
+	SEXP_t *item;
+	size_t value, n = 0;
+	char *seen = calloc(hi - lo + 1, 1);
+	int ret = 0;
+
+	SEXP_list_foreach(item, items) {
+		++n;
+		value = item_value(item);
+		if (value < lo || value >= hi) {
+			fprintf(stderr, "%s: unexpected item%zu\n", name, value);
+			ret = 1;
+		} else if (seen[value - lo]++ != 0) {
+			fprintf(stderr, "%s: repeated item%zu\n", name, value);
+			ret = 1;
+		}
+	}
+	if (n != count) {
+		fprintf(stderr, "%s: expected %zu items, got %zu\n", name, count, n);
+		ret = 1;
+	}
+
+	free(seen);
+	SEXP_free(items);
+	return ret;
+}
+
+static int run(const char *name, SEXP_t *cobj0, SEXP_t *cobj1, oval_setobject_operation_t op,
+               size_t count, size_t lo, size_t hi)
+{
+	struct timespec start, end;
+	SEXP_t *res;
+	int ret;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	res = probe_set_combine(cobj0, cobj1, op);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	printf("%-24s %8.3f ms\n", name,
+	       (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+
+	ret = check(name, res, count, lo, hi);
+	SEXP_free(res);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t count = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+	size_t half, i;
+	SEXP_t **items, *cobj0, *cobj1, *empty;
+	int ret = 0;
+
+	if (count < 2)
+		count = 2;
+	count &= ~(size_t)1;
+	half = count / 2;
+
+	srand(1);
+	items = malloc((count + half) * sizeof(SEXP_t *));
+	for (i = 0; i < count + half; ++i)
+		items[i] = item_new(i);
+
+	cobj0 = cobj_new(items, 0, count);
+	cobj1 = cobj_new(items, half, count);
+	empty = cobj_new(items, 0, 0);
+
+	ret |= run("union", cobj0, cobj1, OVAL_SET_OPERATION_UNION, count + half, 0, count + half);
+	ret |= run("intersection", cobj0, cobj1, OVAL_SET_OPERATION_INTERSECTION, half, half, count);
+	ret |= run("complement", cobj0, cobj1, OVAL_SET_OPERATION_COMPLEMENT, half, 0, half);
+
+	ret |= run("union (identical)", cobj0, cobj0, OVAL_SET_OPERATION_UNION, count, 0, count);
+	ret |= run("intersection (identical)", cobj0, cobj0, OVAL_SET_OPERATION_INTERSECTION, count, 0, count);
+	ret |= run("complement (identical)", cobj0, cobj0, OVAL_SET_OPERATION_COMPLEMENT, 0, 0, 0);
+
+	ret |= run("union (empty)", empty, cobj1, OVAL_SET_OPERATION_UNION, count, half, count + half);
+	ret |= run("intersection (empty)", cobj0, empty, OVAL_SET_OPERATION_INTERSECTION, 0, 0, 0);
+	ret |= run("complement (empty)", cobj0, empty, OVAL_SET_OPERATION_COMPLEMENT, count, 0, count);
+
+	SEXP_free(cobj0);
+	SEXP_free(cobj1);
+	SEXP_free(empty);
+	for (i = 0; i < count + half; ++i)
+		SEXP_free(items[i]);
+	free(items);
+
+	return ret;
+}
@@ -9,4 +9,6 @@ test_run "Ensure loguid returns unsigned int (cat /proc/ID/loginuid)" $srcdir/lo
 test_run "Ensure sessionid is correct" $srcdir/sessionid.sh
 test_run "Ensure capabilities with OVAL 5.11" $srcdir/capability.sh
 test_run "Ensure that command_line is collected" $srcdir/command_line.sh
+test_run "Ensure that processes are read from the proc snapshot offline" $srcdir/proc_snapshot.sh
+test_run "Ensure that an empty proc directory is not an error offline" $srcdir/proc_snapshot_empty.sh
 test_exit
@@ -0,0 +1,65 @@
+#!/bin/bash
+
+# Evaluates the process58, process and inetlisteningservers probes in the
+# offline mode over a generated proc directory and reports the time of the
+# evaluation. The number of processes can be given as an argument.
+
+set -e -o pipefail
+
+[ -f $OVAL_PROBE_DIR/probe_process58 ] || exit 255
+[ -f $OVAL_PROBE_DIR/probe_process ] || exit 255
+[ -f $OVAL_PROBE_DIR/probe_inetlisteningservers ] || exit 255
+# the probes which don't support the own offline mode chroot to the root
+[ "$(id -u)" -eq 0 ] || exit 255
+
+name=$(basename $0 .sh)
+count=${1:-2000}
+root=$(mktemp -d ${name}.root.XXXXXX)
+result=$(mktemp ${name}.out.XXXXXX)
+stderr=$(mktemp ${name}.err.XXXXXX)
+trap 'rm -rf $root' EXIT
+
+# pid, state, ppid, comm
+function make_stat {
+	echo "$1 ($4) $2 $3 $1 1 0 -1 4194560 100 0 0 0 12 3 0 0 20 0 1 0 5000 1000000 100 18446744073709551615 1 1 0 0 0 0 0 0 0 0 0 0 17 0 0 0 0 0 0"
+}
+
+mkdir -p $root/proc/net
+printf "cpu  1 2 3 4\nintr 0\nbtime 1496311200\nprocesses 1\n" > $root/proc/stat
+
+for i in $(seq 0 $((count - 1))); do
+	dir=$root/proc/$((1000 + i))
+	mkdir -p $dir/fd
+	make_stat $((1000 + i)) S 1 worker > $dir/stat
+	printf "Name:\tworker\nState:\tS (sleeping)\nUid:\t%d\t%d\t%d\t%d\nGid:\t0\t0\t0\t0\n" $((1000 + i)) $i $i $i > $dir/status
+	printf "/usr/bin/worker\0--id\0%s\0" $i > $dir/cmdline
+	echo -n 1000 > $dir/loginuid
+done
+
+# zombie without the command line
+mkdir -p $root/proc/999/fd
+make_stat 999 Z 1 zombie > $root/proc/999/stat
+printf "Name:\tzombie\nUid:\t0\t0\t0\t0\n" > $root/proc/999/status
+: > $root/proc/999/cmdline
+
+# the listening socket is shared by two processes, the lower pid is reported
+# as the sockets of the snapshot are sorted by pid
+ln -s "socket:[5003]" $root/proc/1003/fd/3
+ln -s "socket:[5003]" $root/proc/1005/fd/4
+ln -s "/dev/null" $root/proc/1005/fd/0
+printf "  sl  local_address rem_address   st tx_queue rx_queue tr tm->when retrnsmt   uid  timeout inode\n" > $root/proc/net/tcp
+printf "   0: 0100007F:1F90 00000000:0000 0A 00000000:00000000 00:00000000 00000000     3        0 5003 1 0000000000000000 100 0 0 10 0\n" >> $root/proc/net/tcp
+printf "   1: 0100007F:1F91 00000000:0000 01 00000000:00000000 00:00000000 00000000     3        0 5004 1 0000000000000000 100 0 0 10 0\n" >> $root/proc/net/tcp
+
+start=$(date +%s%N)
+OSCAP_PROBE_ROOT=$(readlink -f $root) $OSCAP oval eval --results $result $srcdir/$name.oval.xml > $name.stdout 2> $stderr
+end=$(date +%s%N)
+echo "$count processes: $(( (end - start) / 1000000 )) ms"
+
+[ ! -s $stderr ]
+for def in 1 2 3 4 5 6; do
+	grep -q "^Definition oval:x:def:$def: true$" $name.stdout
+done
+[ "$(grep -c '<unix-sys:process58_item' $result)" -eq $((count + 1)) ]
+
+rm $result $stderr $name.stdout
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# Evaluates the process58, process and inetlisteningservers probes in the
+# offline mode over a root with an empty and with no proc directory, as
+# offline targets usually have. The objects must be reported as not
+# collected, not as errors.
+
+set -e -o pipefail
+
+[ -f $OVAL_PROBE_DIR/probe_process58 ] || exit 255
+[ -f $OVAL_PROBE_DIR/probe_process ] || exit 255
+[ -f $OVAL_PROBE_DIR/probe_inetlisteningservers ] || exit 255
+# the probes which don't support the own offline mode chroot to the root
+[ "$(id -u)" -eq 0 ] || exit 255
+
+name=$(basename $0 .sh)
+root=$(mktemp -d ${name}.root.XXXXXX)
+result=$(mktemp ${name}.out.XXXXXX)
+stdout=$(mktemp ${name}.stdout.XXXXXX)
+stderr=$(mktemp ${name}.err.XXXXXX)
+trap 'rm -rf $root' EXIT
+
+function check_not_collected {
+	OSCAP_PROBE_ROOT=$(readlink -f $root) $OSCAP oval eval --results $result $srcdir/proc_snapshot.oval.xml > $stdout 2> $stderr
+
+	[ ! -s $stderr ]
+	for def in 1 2 3 4 5 6; do
+		grep -q "^Definition oval:x:def:$def: unknown$" $stdout
+	done
+	[ "$(grep -c '<object id="oval:x:obj:[0-9]*" version="1" flag="not collected"/>' $result)" -eq 7 ]
+}
+
+mkdir $root/proc
+check_not_collected
+
+rmdir $root/proc
+check_not_collected
+
+rm $result $stdout $stderr
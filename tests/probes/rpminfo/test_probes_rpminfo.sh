@@ -43,10 +43,105 @@ function test_probes_rpminfo {
     return $ret_val
 }
 
+# Builds the packages synth-pkg0000 ... synth-pkgNNNN in <dir>/RPMS and
+# installs them into the rpm database <dir>/db.
+#
+# Usage: rpminfo_synth_db <dir> <packages>
+function rpminfo_synth_db {
+
+    local DIR=$1
+    local PACKAGES=$2
+    local SPEC="$DIR/synth.spec"
+
+    printf "Name: synth\nVersion: 1.0\nRelease: 1\nSummary: synthetic package\nLicense: LGPLv2+\nBuildArch: noarch\n%%description\nsynthetic package\n" > $SPEC
+    for ((i = 0; i < PACKAGES; i++)); do
+        printf "%%package -n synth-pkg%04d\nSummary: synthetic package\n%%description -n synth-pkg%04d\nsynthetic package\n%%files -n synth-pkg%04d\n" $i $i $i >> $SPEC
+    done
+
+    rpmbuild --quiet -bb --define "_topdir $DIR" $SPEC > /dev/null 2>&1 || return 1
+
+    rpm --dbpath $DIR/db --initdb
+    find $DIR/RPMS -name 'synth-pkg*.rpm' | xargs rpm --dbpath $DIR/db -i --justdb --nodeps --noscripts --nosignature --ignoresize
+}
+
+# Evaluates objects against a synthetic rpm database of RPMINFO_PACKAGES
+# packages and reports the time of the evaluation.
+function test_probes_rpminfo_snapshot {
+
+    probecheck "rpminfo" || return 255
+    require "rpm" || return 255
+    require "rpmbuild" || return 255
+
+    local ret_val=0;
+    local PACKAGES=${RPMINFO_PACKAGES:-3000}
+    local OBJECTS=200
+    local DIR=`mktemp -d -t rpminfo_snapshot.XXXXXX`
+    local DF="test_probes_rpminfo_snapshot.xml"
+    local RF="results_snapshot.xml"
+
+    [ -f $RF ] && rm -f $RF
+
+    if ! rpminfo_synth_db $DIR $PACKAGES; then
+        rm -rf $DIR
+        return 255
+    fi
+
+    bash ${srcdir}/test_probes_rpminfo_snapshot.xml.sh $PACKAGES $OBJECTS > $DF
+
+    local START=`date +%s%N`
+    OSCAP_PROBE_RPMDB_PATH=$DIR/db $OSCAP oval eval --results $RF $DF
+    local END=`date +%s%N`
+    echo "$OBJECTS objects, $PACKAGES packages: $(( (END - START) / 1000000 )) ms"
+
+    if [ -f $RF ]; then
+	verify_results "def" $DF $RF 1 && verify_results "tst" $DF $RF $OBJECTS
+	ret_val=$?
+    else
+	ret_val=1
+    fi
+
+    rm -rf $DIR
+    return $ret_val
+}
+
+# Evaluates an object three times by a kept-alive rpminfo probe, with its
+# package removed from the rpm database after the first scan and installed
+# again after the second one. Every scan has to see the current database.
+function test_probes_rpminfo_rescan {
+
+    probecheck "rpminfo" || return 255
+    require "rpm" || return 255
+    require "rpmbuild" || return 255
+
+    local ret_val=0;
+    local DIR=`mktemp -d -t rpminfo_rescan.XXXXXX`
+    local DF="test_probes_rpminfo_rescan.xml"
+    local RESULTS
+
+    if ! rpminfo_synth_db $DIR 3; then
+        rm -rf $DIR
+        return 255
+    fi
+
+    # The only object is synth-pkg0002.
+    bash ${srcdir}/test_probes_rpminfo_snapshot.xml.sh 3 1 > $DF
+
+    RESULTS=`OSCAP_PROBE_RPMDB_PATH=$DIR/db ./test_probes_rpminfo_rescan $DF oval:1:def:1 \
+        "rpm --dbpath $DIR/db -e --justdb --nodeps --noscripts synth-pkg0002" \
+        "rpm --dbpath $DIR/db -i --justdb --nodeps --noscripts --nosignature --ignoresize $DIR/RPMS/noarch/synth-pkg0002-1.0-1.noarch.rpm"`
+    echo "rescan results: $RESULTS"
+    [ "$RESULTS" == "true false true" ] || ret_val=1
+
+    rm -rf $DIR
+    return $ret_val
+}
+
 # Testing.
 
 test_init "test_probes_rpminfo.log"
 
 test_run "test_probes_rpminfo" test_probes_rpminfo
+test_run "test_probes_rpminfo_snapshot" test_probes_rpminfo_snapshot
+test_run "test_probes_rpminfo_rescan" test_probes_rpminfo_rescan
 
 test_exit
@@ -0,0 +1,82 @@
+/*
+ * Rescan test of the rpminfo probe.
+ *
+ * Evaluates the given OVAL definitions once, then runs every given command
+ * and evaluates them again after each one. The probes are kept alive, so
+ * every scan is answered by the same rpminfo probe. Prints the result of
+ * the given definition in every scan on one line.
+ *
+ * Usage: test_probes_rpminfo_rescan definitions.xml definition_id [command...]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <oscap.h>
+#include <oscap_error.h>
+#include <oscap_source.h>
+#include <oval_agent_api.h>
+#include <oval_probe_session.h>
+
+static int scan(struct oval_definition_model *model, const char *def_id, oval_result_t *result)
+{
+	oval_agent_session_t *session = oval_agent_new_session(model, "rescan");
+	int ret = 0;
+
+	if (session == NULL || oval_agent_eval_system(session, NULL, NULL) != 0) {
+		fprintf(stderr, "Evaluation failed: %s\n", oscap_err_desc());
+		ret = 1;
+	} else if (oval_agent_get_definition_result(session, def_id, result) != 0) {
+		fprintf(stderr, "No result of '%s'.\n", def_id);
+		ret = 1;
+	}
+
+	oval_agent_destroy_session(session);
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	struct oscap_source *source;
+	struct oval_definition_model *model;
+	oval_result_t result;
+	int i, ret;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s definitions.xml definition_id [command...]\n", argv[0]);
+		return 2;
+	}
+
+	source = oscap_source_new_from_file(argv[1]);
+	model = oval_definition_model_import_source(source);
+	oscap_source_free(source);
+	if (model == NULL) {
+		fprintf(stderr, "Failed to import '%s'.\n", argv[1]);
+		return 1;
+	}
+
+	oval_probe_session_set_keepalive(true);
+	ret = scan(model, argv[2], &result);
+	if (ret == 0)
+		printf("%s", oval_result_get_text(result));
+
+	for (i = 3; i < argc && ret == 0; ++i) {
+		if (system(argv[i]) != 0) {
+			fprintf(stderr, "Command '%s' failed.\n", argv[i]);
+			ret = 1;
+			break;
+		}
+		ret = scan(model, argv[2], &result);
+		if (ret == 0)
+			printf(" %s", oval_result_get_text(result));
+	}
+	printf("\n");
+
+	oval_probe_session_close_idle();
+	oval_definition_model_free(model);
+	oscap_cleanup();
+	return ret;
+}
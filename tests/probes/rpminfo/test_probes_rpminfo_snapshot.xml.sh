@@ -0,0 +1,77 @@
+#!/usr/bin/env bash
+
+# Definitions for the synthetic rpm database of test_probes_rpminfo.sh,
+# packages are named synth-pkgNNNN.
+#
+# Usage: test_probes_rpminfo_snapshot.xml.sh <packages> <objects>
+
+PACKAGES=$1
+OBJECTS=$2
+
+cat <<EOF2
+<?xml version="1.0"?>
+<oval_definitions xmlns:oval-def="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xmlns:lin-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#linux" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xsi:schemaLocation="http://oval.mitre.org/XMLSchema/oval-definitions-5#linux linux-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-definitions-5 oval-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-common-5 oval-common-schema.xsd">
+
+      <generator>
+            <oval:product_name>rpminfo</oval:product_name>
+            <oval:product_version>1.0</oval:product_version>
+            <oval:schema_version>5.10</oval:schema_version>
+            <oval:timestamp>2017-03-31T00:00:00-00:00</oval:timestamp>
+      </generator>
+
+  <definitions>
+    <definition class="compliance" version="1" id="oval:1:def:1">  <!-- comment="true" -->
+      <metadata>
+        <title></title>
+        <description></description>
+      </metadata>
+      <criteria operator="AND">
+EOF2
+
+for ((i = 1; i <= OBJECTS; i++)); do
+    echo "        <criterion test_ref=\"oval:1:tst:$i\"/>"
+done
+
+cat <<EOF2
+      </criteria>
+    </definition>
+  </definitions>
+
+  <tests>
+EOF2
+
+for ((i = 1; i <= OBJECTS; i++)); do
+    cat <<EOF2
+    <lin-def:rpminfo_test check="all" check_existence="at_least_one_exists" version="1" id="oval:1:tst:$i" comment="true">
+      <lin-def:object object_ref="oval:1:obj:$i"/>
+    </lin-def:rpminfo_test>
+EOF2
+done
+
+cat <<EOF2
+  </tests>
+
+  <objects>
+EOF2
+
+# Every tenth object selects the packages by a pattern, every tenth but
+# one excludes a package, the rest asks for a single package.
+for ((i = 1; i <= OBJECTS; i++)); do
+    n=$(printf "%04d" $(( (i * 7919) % PACKAGES )))
+    case $((i % 10)) in
+        0) name="<lin-def:name operation=\"pattern match\">^synth-pkg${n:0:3}[0-9]\$</lin-def:name>" ;;
+        5) name="<lin-def:name operation=\"not equal\">synth-pkg$n</lin-def:name>" ;;
+        *) name="<lin-def:name>synth-pkg$n</lin-def:name>" ;;
+    esac
+    cat <<EOF2
+    <lin-def:rpminfo_object version="1" id="oval:1:obj:$i">
+      $name
+    </lin-def:rpminfo_object>
+EOF2
+done
+
+cat <<EOF2
+  </objects>
+
+</oval_definitions>
+EOF2
@@ -5,4 +5,6 @@
 test_init test_probes_sysctl.log
 test_run "test sysctl probe" $srcdir/test_sysctl_probe.sh
 test_run "test sysctl probe that collects everything" $srcdir/test_sysctl_probe_all.sh
+test_run "test sysctl probe with many network interfaces" $srcdir/test_sysctl_probe_interfaces.sh
+test_run "test sysctl probe with names leaving /proc/sys" $srcdir/test_sysctl_probe_traversal.sh
 test_exit
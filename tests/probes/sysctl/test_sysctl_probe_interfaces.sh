@@ -0,0 +1,86 @@
+#!/bin/bash
+
+# Collects sysctls in a network namespace with many interfaces, where
+# /proc/sys/net is large, and reports the time of the evaluation. The
+# interfaces come in pairs named svN and svN.p, so that the MIB names of
+# the latter contain an extra dot. SYSCTL_INTERFACES sets the number of
+# pairs (200 by default).
+
+. $srcdir/../../test_common.sh
+
+set -e -o pipefail
+
+probecheck "sysctl" || exit 255
+require "unshare" || exit 255
+require "ip" || exit 255
+
+if [ -z "$SYSCTL_NETNS" ]; then
+	unshare -n true 2> /dev/null || exit 255
+	SYSCTL_NETNS=1 exec unshare -n bash $0 "$@"
+fi
+
+INTERFACES=${SYSCTL_INTERFACES:-200}
+name=$(basename $0 .sh)
+dir=$(mktemp -d -t ${name}.XXXXXX)
+names=$dir/names
+result=$dir/results.xml
+stderr=$dir/stderr
+
+# system_info needs an interface which is up
+echo "link set lo up" > $dir/links
+for ((i = 0; i < INTERFACES; i++)); do
+	echo "link add sv$i type veth peer name sv$i.p"
+done >> $dir/links
+ip -batch $dir/links || exit 255
+
+# names checked by common security profiles
+for mib in kernel.randomize_va_space kernel.dmesg_restrict kernel.kptr_restrict \
+	kernel.yama.ptrace_scope kernel.kexec_load_disabled kernel.sysrq \
+	kernel.core_uses_pid kernel.perf_event_paranoid kernel.unprivileged_bpf_disabled \
+	fs.suid_dumpable fs.protected_hardlinks fs.protected_symlinks \
+	net.ipv4.ip_forward net.ipv4.tcp_syncookies net.ipv4.icmp_echo_ignore_broadcasts \
+	net.ipv4.icmp_ignore_bogus_error_responses net.ipv4.tcp_timestamps \
+	net.ipv4.conf.all.accept_redirects net.ipv4.conf.default.accept_redirects \
+	net.ipv4.conf.all.secure_redirects net.ipv4.conf.default.secure_redirects \
+	net.ipv4.conf.all.send_redirects net.ipv4.conf.default.send_redirects \
+	net.ipv4.conf.all.accept_source_route net.ipv4.conf.default.accept_source_route \
+	net.ipv4.conf.all.log_martians net.ipv4.conf.default.log_martians \
+	net.ipv4.conf.all.rp_filter net.ipv4.conf.default.rp_filter \
+	net.ipv6.conf.all.accept_ra net.ipv6.conf.default.accept_ra \
+	net.ipv6.conf.all.accept_redirects net.ipv6.conf.default.accept_redirects \
+	net.ipv6.conf.all.accept_source_route net.ipv6.conf.default.accept_source_route \
+	net.ipv6.conf.all.forwarding net.ipv6.conf.all.disable_ipv6; do
+	[ -r /proc/sys/${mib//.//} ] && echo $mib
+done > $names
+
+for ((i = 0; i < INTERFACES && i < 20; i++)); do
+	echo "net.ipv4.conf.sv$i.forwarding"
+	echo "net.ipv6.conf.sv$i.p.disable_ipv6"
+done >> $names
+
+bash $srcdir/$name.xml.sh $names > $dir/defs.xml
+
+files=$(find /proc/sys -type f 2> /dev/null | wc -l)
+start=$(date +%s%N)
+$OSCAP oval eval --results $result $dir/defs.xml > /dev/null 2> $stderr
+end=$(date +%s%N)
+echo "$(wc -l < $names) equals objects, 3 other objects, $files files in /proc/sys: $(( (end - start) / 1000000 )) ms"
+
+sed -i -E "/^E: lt-probe_sysctl: Can't read sysctl value from /d" $stderr
+[ ! -s $stderr ]
+
+# every name is collected once
+while read mib; do
+	[ `grep -c "<unix-sys:name>$mib</unix-sys:name>" $result` -eq 1 ]
+done < $names
+
+# the value is read from the file of the interface with the dot
+value=`grep -A1 "<unix-sys:name>net.ipv6.conf.sv0.p.disable_ipv6</unix-sys:name>" $result | sed -n "s;.*<unix-sys:value>\([^<]*\)<.*;\1;p"`
+[ "$value" = "$(cat /proc/sys/net/ipv6/conf/sv0.p/disable_ipv6)" ]
+
+# pattern match finds the interfaces, including those not named by any equals object
+[ `grep -c "<unix-sys:name>net\.ipv4\.conf\.[^<]*\.rp_filter</unix-sys:name>" $result` -eq `ls /proc/sys/net/ipv4/conf | wc -l` ]
+[ `grep -c "<unix-sys:name>net\.ipv6\.conf\.[^.<]*\.p\.disable_ipv6</unix-sys:name>" $result` -eq $INTERFACES ]
+[ `grep -c "<unix-sys:name>kernel\.hostname</unix-sys:name>" $result` -eq 1 ]
+
+rm -rf $dir
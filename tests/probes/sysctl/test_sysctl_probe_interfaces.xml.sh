@@ -0,0 +1,53 @@
+#!/usr/bin/env bash
+
+# Usage: test_sysctl_probe_interfaces.xml.sh <names file>
+#
+# One "equals" sysctl_object per name from the names file, and two
+# "pattern match" objects over the interfaces and one "case insensitive
+# equals" object.
+
+NAMES=$1
+
+cat <<EOF_HEADER
+<?xml version="1.0"?>
+<oval_definitions xmlns:oval-def="http://oval.mitre.org/XMLSchema/oval-definitions-5" xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xmlns:unix-def="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5" xsi:schemaLocation="http://oval.mitre.org/XMLSchema/oval-definitions-5#unix unix-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-definitions-5 oval-definitions-schema.xsd http://oval.mitre.org/XMLSchema/oval-common-5 oval-common-schema.xsd">
+  <generator>
+    <oval:schema_version>5.10</oval:schema_version>
+    <oval:timestamp>2017-01-12T10:41:00-05:00</oval:timestamp>
+  </generator>
+EOF_HEADER
+
+COUNT=`wc -l < $NAMES`
+TOTAL=$((COUNT + 3))
+
+echo "  <definitions>"
+echo "    <definition class=\"compliance\" id=\"oval:x:def:1\" version=\"1\">"
+echo "      <metadata><title>sysctl objects</title><description>sysctl objects</description></metadata>"
+echo "      <criteria operator=\"AND\">"
+for ((i = 1; i <= TOTAL; i++)); do
+	echo "        <criterion test_ref=\"oval:x:tst:$i\"/>"
+done
+echo "      </criteria>"
+echo "    </definition>"
+echo "  </definitions>"
+
+echo "  <tests>"
+for ((i = 1; i <= TOTAL; i++)); do
+	echo "    <sysctl_test xmlns=\"http://oval.mitre.org/XMLSchema/oval-definitions-5#unix\" check=\"all\" check_existence=\"any_exist\" comment=\"sysctl\" id=\"oval:x:tst:$i\" version=\"1\"><object object_ref=\"oval:x:obj:$i\"/></sysctl_test>"
+done
+echo "  </tests>"
+
+echo "  <objects>"
+i=1
+while read name; do
+	echo "    <sysctl_object xmlns=\"http://oval.mitre.org/XMLSchema/oval-definitions-5#unix\" id=\"oval:x:obj:$i\" version=\"1\"><name operation=\"equals\">$name</name></sysctl_object>"
+	i=$((i + 1))
+done < $NAMES
+echo "    <sysctl_object xmlns=\"http://oval.mitre.org/XMLSchema/oval-definitions-5#unix\" id=\"oval:x:obj:$i\" version=\"1\"><name operation=\"pattern match\">^net\.ipv4\.conf\..*\.rp_filter$</name></sysctl_object>"
+i=$((i + 1))
+echo "    <sysctl_object xmlns=\"http://oval.mitre.org/XMLSchema/oval-definitions-5#unix\" id=\"oval:x:obj:$i\" version=\"1\"><name operation=\"pattern match\">^net\.ipv6\.conf\.[^.]+\.p\.disable_ipv6$</name></sysctl_object>"
+i=$((i + 1))
+echo "    <sysctl_object xmlns=\"http://oval.mitre.org/XMLSchema/oval-definitions-5#unix\" id=\"oval:x:obj:$i\" version=\"1\"><name operation=\"case insensitive equals\">KERNEL.HOSTNAME</name></sysctl_object>"
+echo "  </objects>"
+
+echo "</oval_definitions>"
@@ -0,0 +1,23 @@
+#!/bin/bash
+
+# The names of "equals" objects are mapped to paths below /proc/sys,
+# their "." and ".." components must not lead out of it.
+
+. $srcdir/../../test_common.sh
+
+set -e -o pipefail
+
+probecheck "sysctl" || return 255
+
+name=$(basename $0 .sh)
+result=$(mktemp $name.res.out.XXXXXX)
+stdout=$(mktemp $name.std.out.XXXXXX)
+stderr=$(mktemp $name.err.out.XXXXXX)
+
+$OSCAP oval eval --results $result $srcdir/$name.oval.xml >$stdout 2>$stderr
+
+[ ! -s $stderr ]
+grep -q "^Definition oval:oscap:def:1: true$" $stdout
+! grep -q "sysctl_item" $result
+
+rm $result $stdout $stderr
@@ -7,4 +7,6 @@ test_run "textfilecontent54 general functionality" $srcdir/test_probes_textfilec
 test_run "validate OVAL definitions of various schema versions" $srcdir/test_validation_of_various_oval_versions.sh
 test_run "test behavior on symlinks" $srcdir/test_symlinks.sh
 test_run "test multiline behavior" $srcdir/test_behavior_multiline.sh
+test_run "test memory limit" $srcdir/test_memory_limit.sh
+test_run "test matching a large audit log" $srcdir/test_audit_log.sh
 test_exit
@@ -0,0 +1,54 @@
+#!/bin/bash
+
+# Greps a large synthetic audit log (TFC54_AUDIT_LOG_MB megabytes,
+# 300 by default) and reports how long the evaluation took.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+tpl=${srcdir}/${name}.xml.tpl
+input=${tmpdir}/${name}.xml
+result=${tmpdir}/${name}.results.xml
+size_mb=${TFC54_AUDIT_LOG_MB:-300}
+echo "Temp dir: $tmpdir"
+
+# prepare the environment; every 10000th record is a failed login
+sed "s@%PATH%@${tmpdir}@" $tpl > $input
+awk -v limit=$((size_mb * 1024 * 1024)) 'BEGIN {
+	for (n = 1; size < limit; n++) {
+		if (n % 10000 == 0) {
+			line = sprintf("type=USER_AUTH msg=audit(1500000000.%03d:%d): pid=%d uid=0 auid=4294967295 ses=4294967295 msg='\''op=PAM:authentication acct=\"user%d\" exe=\"/usr/sbin/sshd\" hostname=10.0.0.%d addr=10.0.0.%d terminal=ssh res=failed'\''", n % 1000, n, n % 32768, ++failed, n % 256, n % 256)
+		} else {
+			line = sprintf("type=SYSCALL msg=audit(1500000000.%03d:%d): arch=c000003e syscall=59 success=yes exit=0 a0=55d0c0a0 a1=55d0c0b0 a2=55d0c0c0 a3=0 items=2 ppid=%d pid=%d auid=1000 uid=0 gid=0 euid=0 suid=0 fsuid=0 egid=0 sgid=0 fsgid=0 tty=pts0 ses=1 comm=\"bash\" exe=\"/usr/bin/bash\" key=\"exec\"", n % 1000, n, n % 32768, (n + 1) % 32768)
+		}
+		print line
+		size += length(line) + 1
+	}
+	print failed > "/dev/stderr"
+}' > "${tmpdir}/audit.log" 2> "${tmpdir}/failed"
+failed=$(cat "${tmpdir}/failed")
+echo "Audit log: $(du -m "${tmpdir}/audit.log" | cut -f1) MB, $failed failed logins"
+
+echo "Evaluating content."
+start=$(date +%s%N)
+$OSCAP oval eval --results $result $input
+end=$(date +%s%N)
+echo "Evaluated in $(( (end - start) / 1000000 )) ms"
+
+echo "Testing results."
+for i in 1 2 3 4; do
+	[ "$($XPATH $result 'string(/oval_results/results/system/tests/test[@test_id="oval:x:tst:'$i'"]/@result)')" == "true" ]
+done
+
+echo "Testing syschar values."
+items() {
+	$XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:'$1'"]/reference)'
+}
+[ "$(items 1)" == "1" ]
+[ "$(items 2)" == "$failed" ]
+[ "$(items 3)" == "2" ]
+[ "$(items 4)" == "$((failed - 1))" ]
+[ "$($XPATH $result 'string(/oval_results/results/system/oval_system_characteristics/system_data/*[*[local-name()="subexpression"] and *[local-name()="instance"]="1"]/*[local-name()="subexpression"])')" == "user1" ]
+
+rm -rf $tmpdir
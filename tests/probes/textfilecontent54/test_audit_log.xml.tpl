@@ -0,0 +1,63 @@
+<?xml version="1.0"?>
+<oval_definitions xmlns:oval="http://oval.mitre.org/XMLSchema/oval-common-5" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5">
+    <generator>
+        <oval:schema_version>5.10.1</oval:schema_version>
+        <oval:timestamp>0001-01-01T00:00:00+00:00</oval:timestamp>
+    </generator>
+    <definitions>
+        <definition class="compliance" version="1" id="oval:x:def:1">
+            <metadata>
+                <title>x</title>
+                <description>x</description>
+            </metadata>
+            <criteria>
+                <criterion test_ref="oval:x:tst:1"/>
+                <criterion test_ref="oval:x:tst:2"/>
+                <criterion test_ref="oval:x:tst:3"/>
+                <criterion test_ref="oval:x:tst:4"/>
+            </criteria>
+        </definition>
+    </definitions>
+    <tests>
+        <textfilecontent54_test id="oval:x:tst:1" check="all" check_existence="at_least_one_exists" comment="x" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:1"/>
+        </textfilecontent54_test>
+        <textfilecontent54_test id="oval:x:tst:2" check="all" check_existence="at_least_one_exists" comment="x" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:2"/>
+        </textfilecontent54_test>
+        <textfilecontent54_test id="oval:x:tst:3" check="all" check_existence="at_least_one_exists" comment="x" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:3"/>
+        </textfilecontent54_test>
+        <textfilecontent54_test id="oval:x:tst:4" check="all" check_existence="at_least_one_exists" comment="x" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <object object_ref="oval:x:obj:4"/>
+        </textfilecontent54_test>
+    </tests>
+    <objects>
+        <!-- the first failed authentication -->
+        <textfilecontent54_object id="oval:x:obj:1" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <behaviors multiline="true"/>
+            <filepath>%PATH%/audit.log</filepath>
+            <pattern operation="pattern match">^type=USER_AUTH msg=audit\([0-9.:]+\): .* acct="([a-z0-9]+)" .* res=failed'$</pattern>
+            <instance datatype="int" operation="equals">1</instance>
+        </textfilecontent54_object>
+        <!-- all of them -->
+        <textfilecontent54_object id="oval:x:obj:2" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <behaviors multiline="true"/>
+            <filepath>%PATH%/audit.log</filepath>
+            <pattern operation="pattern match">^type=USER_AUTH msg=audit\([0-9.:]+\): .* acct="([a-z0-9]+)" .* res=failed'$</pattern>
+            <instance datatype="int" operation="greater than or equal">1</instance>
+        </textfilecontent54_object>
+        <!-- the first two, the rest of the file isn't matched -->
+        <textfilecontent54_object id="oval:x:obj:3" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <filepath>%PATH%/audit.log</filepath>
+            <pattern operation="pattern match">res=failed</pattern>
+            <instance datatype="int" operation="less than">3</instance>
+        </textfilecontent54_object>
+        <!-- not a range, every instance is compared as an entity -->
+        <textfilecontent54_object id="oval:x:obj:4" version="1" xmlns="http://oval.mitre.org/XMLSchema/oval-definitions-5#independent">
+            <filepath>%PATH%/audit.log</filepath>
+            <pattern operation="pattern match">res=failed</pattern>
+            <instance datatype="int" operation="not equal">1</instance>
+        </textfilecontent54_object>
+    </objects>
+</oval_definitions>
@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# The probe must stop collecting items when its memory budget
+# set by OSCAP_PROBE_MEMORY_LIMIT is exhausted.
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+tmpdir=$(mktemp -t -d "${name}.XXXXXX")
+tpl=${srcdir}/${name}.xml.tpl
+input=${tmpdir}/${name}.xml
+result=${tmpdir}/${name}.results.xml
+stderr=${tmpdir}/${name}.stderr
+echo "Temp dir: $tmpdir"
+
+# prepare the environment; memory constraints are not checked
+# until an object has more than 32768 items
+sed "s@%PATH%@${tmpdir}@" $tpl > $input
+seq -f "line%.0f" 1 33000 > "${tmpdir}/textfile"
+
+echo "Evaluating content."
+OSCAP_PROBE_MEMORY_LIMIT=1 $OSCAP oval eval --results $result $input 2> $stderr
+grep -q "Memory limit reached" $stderr
+
+echo "Testing syschar values."
+[ "$($XPATH $result 'string(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:1"]/@flag)')" == "incomplete" ]
+[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:1"]/message)')" == "1" ]
+
+rm -rf $tmpdir
@@ -23,10 +23,16 @@ function test_config_h(){
 	done
 }
 
+function test_validation_cache(){
+	./test_validation_cache $top_srcdir/tests/DS/sds_multiple_oval/multiple-oval-xccdf.xml \
+		$top_srcdir/tests/DS/sds_multiple_oval/first-oval.xml
+}
+
 test_init "test_config_h.log"
 
 if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "Check existence including config.h in every .c file" test_config_h
+    test_run "Validation with parsed schemas kept" test_validation_cache
 fi
 
 test_exit
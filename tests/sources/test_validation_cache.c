@@ -0,0 +1,158 @@
+/*
+ * Copyright 2017 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Validates the given documents repeatedly, with the schemas parsed by the
+ * first validation and parsed in advance, from several threads at once, and
+ * an invalid document. Reports the times of the validations.
+ *
+ * Usage: test_validation_cache <document>...
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <oscap.h>
+#include <oscap_error.h>
+#include <oscap_source.h>
+#include "common/oscap_timing.h"
+
+#define ROUNDS 5
+#define THREADS 4
+
+static const char invalid_xccdf[] =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<Benchmark xmlns=\"http://checklists.nist.gov/xccdf/1.2\" id=\"xccdf_org.example_benchmark_invalid\">\n"
+	"  <status>draft</status>\n"
+	"  <unexpected/>\n"
+	"</Benchmark>\n";
+
+static int reporter(const char *file, int line, const char *msg, void *arg)
+{
+	++*(int *)arg;
+	return 0;
+}
+
+static double validate(const char *file, int *ret)
+{
+	struct oscap_source *source = oscap_source_new_from_file(file);
+	struct timespec start;
+	int messages = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	if (oscap_source_validate(source, reporter, &messages) != 0 || messages != 0) {
+		fprintf(stderr, "%s: not valid, %d messages: %s\n", file, messages, oscap_err_desc());
+		*ret = 1;
+	}
+	oscap_source_free(source);
+	return oscap_elapsed_ms(&start);
+}
+
+static int test_invalid(void)
+{
+	int i, ret = 0;
+
+	/* the messages are reported also when the schema has been parsed before */
+	for (i = 0; i < 2; ++i) {
+		struct oscap_source *source = oscap_source_new_from_memory(invalid_xccdf, strlen(invalid_xccdf), "invalid.xml");
+		int messages = 0;
+
+		if (oscap_source_validate(source, reporter, &messages) != 1 || messages == 0) {
+			fprintf(stderr, "invalid.xml: not invalid, %d messages\n", messages);
+			ret = 1;
+		}
+		oscap_source_free(source);
+	}
+	oscap_clearerr();
+	return ret;
+}
+
+static void *thread_fn(void *arg)
+{
+	int ret = 0;
+
+	validate(arg, &ret);
+	return ret ? arg : NULL;
+}
+
+static int test_threads(const char *file)
+{
+	pthread_t threads[THREADS];
+	struct timespec start;
+	void *failed;
+	int i, ret = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < THREADS; ++i)
+		pthread_create(&threads[i], NULL, thread_fn, (void *)file);
+	for (i = 0; i < THREADS; ++i) {
+		pthread_join(threads[i], &failed);
+		if (failed != NULL)
+			ret = 1;
+	}
+	printf("%s: %d threads: %.3f ms\n", file, THREADS, oscap_elapsed_ms(&start));
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int i, r, ret = 0;
+
+	oscap_init();
+
+	for (i = 1; i < argc; ++i) {
+		double first, cached = 0;
+
+		first = validate(argv[i], &ret);
+		for (r = 0; r < ROUNDS; ++r)
+			cached += validate(argv[i], &ret);
+		printf("%s: first validation: %.3f ms, next ones: %.3f ms\n", argv[i], first, cached / ROUNDS);
+	}
+
+	ret |= test_invalid();
+
+	/* start with the schemas parsed in advance */
+	oscap_cleanup();
+	if (oscap_schema_cache_warm(OSCAP_DOCUMENT_XCCDF, "1.2") != 0 ||
+	    oscap_schema_cache_warm(OSCAP_DOCUMENT_OVAL_DEFINITIONS, NULL) != 0) {
+		fprintf(stderr, "Can't parse the schemas: %s\n", oscap_err_desc());
+		ret = 1;
+	}
+	if (oscap_schema_cache_warm(OSCAP_DOCUMENT_XCCDF, "0.9") == 0) {
+		fprintf(stderr, "Parsed a schema of a nonexistent version\n");
+		ret = 1;
+	}
+	oscap_clearerr();
+	for (i = 1; i < argc; ++i)
+		printf("%s: validation with parsed schemas: %.3f ms\n", argv[i], validate(argv[i], &ret));
+
+	/* all the threads start with the schema not parsed */
+	oscap_cleanup();
+	for (i = 1; i < argc; ++i)
+		ret |= test_threads(argv[i]);
+
+	oscap_cleanup();
+	return ret;
+}
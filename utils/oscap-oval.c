@@ -121,6 +121,8 @@ static struct oscap_module OVAL_EVAL = {
         "   --oval-id <id> \r\t\t\t\t - ID of the OVAL component ref in the datastream to use.\n"
         "                  \r\t\t\t\t   (only applicable for source datastreams)\n"
 	"   --probe-root <dir>\r\t\t\t\t - Change the root directory before scanning the system.\n"
+	"   --threads <n>\r\t\t\t\t - Collect objects independent of variables using <n> threads.\n"
+	"   --object-cache <dir>\r\t\t\t\t - Reuse objects collected by previous scans while their files don't change.\n"
 	"   --verbose <verbosity_level>\r\t\t\t\t - Turn on verbose mode at specified verbosity level.\n"
 	"   --verbose-log-file <file>\r\t\t\t\t - Write verbose information into file.\n",
     .opt_parser = getopt_oval_eval,
@@ -374,6 +376,8 @@ int app_evaluate_oval(const struct oscap_action *action)
 	oval_session_set_variables(session, action->f_variables);
 
 	oval_session_set_remote_resources(session, action->remote_resources, download_reporting_callback);
+	oval_session_set_eval_threads(session, action->eval_threads);
+	oval_session_set_object_cache(session, action->object_cache);
 	/* load all necesary OVAL Definitions and bind OVAL Variables if provided */
 	if ((oval_session_load(session)) != 0)
 		goto cleanup;
@@ -548,13 +552,16 @@ enum oval_opt {
     OVAL_OPT_OUTPUT = 'o',
 	OVAL_OPT_PROBE_ROOT,
 	OVAL_OPT_VERBOSE,
-	OVAL_OPT_VERBOSE_LOG_FILE
+	OVAL_OPT_VERBOSE_LOG_FILE,
+	OVAL_OPT_THREADS,
+	OVAL_OPT_OBJECT_CACHE
 };
 
 bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 {
 	action->doctype = OSCAP_DOCUMENT_OVAL_DEFINITIONS;
 	action->probe_root = NULL;
+	action->eval_threads = 1;
 
 	/* Command-options */
 	struct option long_options[] = {
@@ -571,6 +578,8 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		{ "verbose", required_argument, NULL, OVAL_OPT_VERBOSE },
 		{ "verbose-log-file", required_argument, NULL, OVAL_OPT_VERBOSE_LOG_FILE },
 		{ "fetch-remote-resources", no_argument, &action->remote_resources, 1},
+		{ "threads", required_argument, NULL, OVAL_OPT_THREADS },
+		{ "object-cache", required_argument, NULL, OVAL_OPT_OBJECT_CACHE },
 		{ 0, 0, 0, 0 }
 	};
 
@@ -591,6 +600,13 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		case OVAL_OPT_VERBOSE_LOG_FILE:
 			action->f_verbose_log = optarg;
 			break;
+		case OVAL_OPT_THREADS:
+			if (!getopt_eval_threads(action, optarg))
+				return false;
+			break;
+		case OVAL_OPT_OBJECT_CACHE:
+			action->object_cache = optarg;
+			break;
 		case 0: break;
 		default: return oscap_module_usage(action->module, stderr, NULL);
 		}
@@ -392,6 +392,20 @@ bool check_verbose_options(struct oscap_action *action)
 	return true;
 }
 
+bool getopt_eval_threads(struct oscap_action *action, const char *threads)
+{
+	char *end;
+	long value = strtol(threads, &end, 10);
+
+	if (*threads == '\0' || *end != '\0' || value < 1 || value > OSCAP_EVAL_THREADS_MAX) {
+		oscap_module_usage(action->module, stderr,
+			"Invalid number of threads: '%s'. It must be a number from 1 to %d.", threads, OSCAP_EVAL_THREADS_MAX);
+		return false;
+	}
+	action->eval_threads = value;
+	return true;
+}
+
 void download_reporting_callback(bool warning, const char *format, ...)
 {
 	FILE *dest = stderr;
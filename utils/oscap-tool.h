@@ -45,6 +45,7 @@
 
 #define OSCAP_PRODUCTNAME "cpe:/a:open-scap:oscap"
 #define OSCAP_ERR_MSG "OpenSCAP Error:"
+#define OSCAP_EVAL_THREADS_MAX 256
 
 struct oscap_action;
 struct oscap_module;
@@ -165,6 +166,8 @@ struct oscap_action {
 	int check_engine_results;
 	int export_variables;
         int list_dynamic;
+	unsigned int eval_threads;
+	char *object_cache;
 	char *probe_root;
 	char *verbosity_level;
 	char *fix_type;
@@ -179,6 +182,7 @@ int oscap_module_call(struct oscap_action *action);
 
 void oscap_print_error(void);
 bool check_verbose_options(struct oscap_action *action);
+bool getopt_eval_threads(struct oscap_action *action, const char *threads);
 void download_reporting_callback(bool warning, const char *format, ...);
 
 
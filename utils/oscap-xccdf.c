@@ -175,6 +175,8 @@ static struct oscap_module XCCDF_EVAL = {
 	"                   \r\t\t\t\t   (only applicable when datastream-id AND xccdf-id are not specified)\n"
 	"   --remediate \r\t\t\t\t - Automatically execute XCCDF fix elements for failed rules.\n"
 	"               \r\t\t\t\t   Use of this option is always at your own risk.\n"
+	"   --threads <n>\r\t\t\t\t - Collect OVAL objects independent of variables using <n> threads.\n"
+	"   --object-cache <dir>\r\t\t\t\t - Reuse OVAL objects collected by previous scans while their files don't change.\n"
 	"   --verbose <verbosity_level>\r\t\t\t\t - Turn on verbose mode at specified verbosity level.\n"
 	"   --verbose-log-file <file>\r\t\t\t\t - Write verbose informations into file.\n",
     .opt_parser = getopt_xccdf,
@@ -536,6 +538,8 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	xccdf_session_set_remote_resources(session, action->remote_resources, download_reporting_callback);
 	xccdf_session_set_custom_oval_files(session, action->f_ovals);
 	xccdf_session_set_product_cpe(session, OSCAP_PRODUCTNAME);
+	xccdf_session_set_oval_eval_threads(session, action->eval_threads);
+	xccdf_session_set_oval_object_cache(session, action->object_cache);
 	xccdf_session_set_rule(session, action->rule);
 
 	if (xccdf_session_load(session) != 0)
@@ -1035,7 +1039,9 @@ enum oval_opt {
     XCCDF_OPT_RESULT_ID = 'i',
 	XCCDF_OPT_VERBOSE,
 	XCCDF_OPT_VERBOSE_LOG_FILE,
-	XCCDF_OPT_FIX_TYPE
+	XCCDF_OPT_FIX_TYPE,
+	XCCDF_OPT_THREADS,
+	XCCDF_OPT_OBJECT_CACHE
 };
 
 bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
@@ -1070,6 +1076,8 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		{ "verbose", required_argument, NULL, XCCDF_OPT_VERBOSE },
 		{ "verbose-log-file", required_argument, NULL, XCCDF_OPT_VERBOSE_LOG_FILE },
 		{"fix-type", required_argument, NULL, XCCDF_OPT_FIX_TYPE},
+		{"threads", required_argument, NULL, XCCDF_OPT_THREADS},
+		{"object-cache", required_argument, NULL, XCCDF_OPT_OBJECT_CACHE},
 	// flags
 		{"force",		no_argument, &action->force, 1},
 		{"oval-results",	no_argument, &action->oval_results, 1},
@@ -1127,6 +1135,13 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		case XCCDF_OPT_FIX_TYPE:
 			action->fix_type = optarg;
 			break;
+		case XCCDF_OPT_THREADS:
+			if (!getopt_eval_threads(action, optarg))
+				return false;
+			break;
+		case XCCDF_OPT_OBJECT_CACHE:
+			action->object_cache = optarg;
+			break;
 		case 0: break;
 		default: return oscap_module_usage(action->module, stderr, NULL);
 		}
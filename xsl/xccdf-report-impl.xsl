@@ -383,19 +383,16 @@ Authors:
     <xsl:param name="profile"/>
     <xsl:param name="indent"/>
 
-    <xsl:param name="failed_rule_results"/>
-    <xsl:param name="error_rule_results"/>
-    <xsl:param name="unknown_rule_results"/>
-    <xsl:param name="notchecked_rule_results"/>
-    <xsl:param name="notselected_rule_results"/>
-
     <xsl:variable name="descendant_rules" select="$item/descendant::cdf:Rule"/>
 
-    <xsl:variable name="contained_rules_fail" select="count($descendant_rules[@id = $failed_rule_results/@idref])"/>
-    <xsl:variable name="contained_rules_error" select="count($descendant_rules[@id = $error_rule_results/@idref])"/>
-    <xsl:variable name="contained_rules_unknown" select="count($descendant_rules[@id = $unknown_rule_results/@idref])"/>
-    <xsl:variable name="contained_rules_notchecked" select="count($descendant_rules[@id = $notchecked_rule_results/@idref])"/>
-    <xsl:variable name="contained_rules_notselected" select="count($descendant_rules[@id = $notselected_rule_results/@idref])"/>
+    <!-- results of the rules are looked up by the key, comparing the rules
+         with all the rule-results would be quadratic -->
+    <xsl:variable name="key_prefix" select="concat($testresult/@id, '|')"/>
+    <xsl:variable name="contained_rules_fail" select="count($descendant_rules[key('testresult_ruleresults', concat($key_prefix, @id))/cdf:result/text() = 'fail'])"/>
+    <xsl:variable name="contained_rules_error" select="count($descendant_rules[key('testresult_ruleresults', concat($key_prefix, @id))/cdf:result/text() = 'error'])"/>
+    <xsl:variable name="contained_rules_unknown" select="count($descendant_rules[key('testresult_ruleresults', concat($key_prefix, @id))/cdf:result/text() = 'unknown'])"/>
+    <xsl:variable name="contained_rules_notchecked" select="count($descendant_rules[key('testresult_ruleresults', concat($key_prefix, @id))/cdf:result/text() = 'notchecked'])"/>
+    <xsl:variable name="contained_rules_notselected" select="count($descendant_rules[key('testresult_ruleresults', concat($key_prefix, @id))/cdf:result/text() = 'notselected'])"/>
     <xsl:variable name="contained_rules_need_attention" select="$contained_rules_fail + $contained_rules_error + $contained_rules_unknown + $contained_rules_notchecked"/>
 
     <xsl:if test="$contained_rules_notselected &lt; count($descendant_rules)">
@@ -439,12 +436,6 @@ Authors:
             <xsl:with-param name="item" select="."/>
             <xsl:with-param name="profile" select="$profile"/>
             <xsl:with-param name="indent" select="$indent + 1"/>
-
-            <xsl:with-param name="failed_rule_results" select="$failed_rule_results"/>
-            <xsl:with-param name="error_rule_results" select="$error_rule_results"/>
-            <xsl:with-param name="unknown_rule_results" select="$unknown_rule_results"/>
-            <xsl:with-param name="notchecked_rule_results" select="$notchecked_rule_results"/>
-            <xsl:with-param name="notselected_rule_results" select="$notselected_rule_results"/>
         </xsl:call-template>
     </xsl:for-each>
 
@@ -593,23 +584,11 @@ Authors:
                 </tr>
             </thead>
             <tbody>
-                <xsl:variable name="failed_rule_results" select="$testresult/cdf:rule-result[cdf:result/text() = 'fail']"/>
-                <xsl:variable name="error_rule_results" select="$testresult/cdf:rule-result[cdf:result/text() = 'error']"/>
-                <xsl:variable name="unknown_rule_results" select="$testresult/cdf:rule-result[cdf:result/text() = 'unknown']"/>
-                <xsl:variable name="notchecked_rule_results" select="$testresult/cdf:rule-result[cdf:result/text() = 'notchecked']"/>
-                <xsl:variable name="notselected_rule_results" select="$testresult/cdf:rule-result[cdf:result/text() = 'notselected']"/>
-
                 <xsl:call-template name="rule-overview-inner-node">
                     <xsl:with-param name="testresult" select="$testresult"/>
                     <xsl:with-param name="item" select="$benchmark"/>
                     <xsl:with-param name="profile" select="$profile"/>
                     <xsl:with-param name="indent" select="0"/>
-
-                    <xsl:with-param name="failed_rule_results" select="$failed_rule_results"/>
-                    <xsl:with-param name="error_rule_results" select="$error_rule_results"/>
-                    <xsl:with-param name="unknown_rule_results" select="$unknown_rule_results"/>
-                    <xsl:with-param name="notchecked_rule_results" select="$notchecked_rule_results"/>
-                    <xsl:with-param name="notselected_rule_results" select="$notselected_rule_results"/>
                 </xsl:call-template>
             </tbody>
         </table>